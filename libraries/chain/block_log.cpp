@@ -1,22 +1,52 @@
 #include <steem/chain/block_log.hpp>
+#include <steem/chain/block_log_compression.hpp>
 #include <fstream>
 #include <fc/io/raw.hpp>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/interprocess/sync/lock_options.hpp>
 
-#define LOG_READ  (std::ios::in | std::ios::binary)
+#include <atomic>
+
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
 
+// Address space mapped past the end of each file so appends rarely require a new mapping
+#define BLOCK_LOG_MAP_RESERVE (uint64_t(1) << 30)
+#define BLOCK_INDEX_MAP_RESERVE (uint64_t(1) << 26)
+
 namespace steem { namespace chain {
 
    typedef boost::interprocess::scoped_lock< boost::mutex > scoped_lock;
 
    boost::interprocess::defer_lock_type defer_lock;
 
+   namespace bip = boost::interprocess;
+
    namespace detail {
-      class block_log_impl {
+      /* A read only view of the block log and its index. Each view maps more than the current
+       * file sizes, and the writer flushes every append before publishing it, so readers see new
+       * blocks through the page cache without remapping. When the files outgrow a view the writer
+       * creates a larger one. Old views are kept until the log is closed because a reader may still
+       * be using one.
+       */
+      struct block_log_view
+      {
+         bip::file_mapping    block_mapping;
+         bip::mapped_region   block_region;
+         bip::file_mapping    index_mapping;
+         bip::mapped_region   index_region;
+
+         const char*          block_data = nullptr;
+         uint64_t             block_capacity = 0;
+         const uint64_t*      index_data = nullptr;
+         uint64_t             index_capacity = 0;
+      };
+
+      class block_log_impl
+      {
          public:
             optional< signed_block > head;
             block_id_type            head_id;
@@ -24,67 +54,84 @@ namespace steem { namespace chain {
             std::fstream             index_stream;
             fc::path                 block_file;
             fc::path                 index_file;
-            bool                     block_write = false;
-            bool                     index_write = false;
+            uint64_t                 block_size = 0;   ///< Bytes written to block_stream
+            uint64_t                 index_size = 0;   ///< Bytes written to index_stream
+            uint32_t                 version = 1;
+            block_log_compression    compression = no_compression;
+            int                      compression_level = 0;
 
             bool                     use_locking = true;
+            bool                     read_only = false;
 
             boost::mutex             mtx;
 
-            inline void check_block_read()
+            std::vector< std::unique_ptr< block_log_view > > views;
+
+            // State published to lock free readers. A reader loads head_num first, everything
+            // published before it is then visible.
+            std::atomic< const block_log_view* >   current_view{ nullptr };
+            std::atomic< uint64_t >                published_block_size{ 0 };
+            std::atomic< uint32_t >                published_head_num{ 0 };
+
+            /// Remap when the files outgrow the current view or when force is set because a file was recreated
+            void ensure_view( uint64_t needed_block_size, uint64_t needed_index_size, bool force = false )
             {
-               try
-               {
-                  if( block_write )
-                  {
-                     block_stream.close();
-                     block_stream.open( block_file.generic_string().c_str(), LOG_READ );
-                     block_write = false;
-                  }
-               }
-               FC_LOG_AND_RETHROW()
+               const block_log_view* view = current_view.load( std::memory_order_relaxed );
+               if( !force && view != nullptr && view->block_capacity >= needed_block_size && view->index_capacity >= needed_index_size )
+                  return;
+
+               std::unique_ptr< block_log_view > v( new block_log_view() );
+               v->block_capacity = needed_block_size + BLOCK_LOG_MAP_RESERVE;
+               v->index_capacity = needed_index_size + BLOCK_INDEX_MAP_RESERVE;
+               v->block_mapping = bip::file_mapping( block_file.generic_string().c_str(), bip::read_only );
+               v->block_region = bip::mapped_region( v->block_mapping, bip::read_only, 0, v->block_capacity );
+               v->index_mapping = bip::file_mapping( index_file.generic_string().c_str(), bip::read_only );
+               v->index_region = bip::mapped_region( v->index_mapping, bip::read_only, 0, v->index_capacity );
+               v->block_data = static_cast< const char* >( v->block_region.get_address() );
+               v->index_data = static_cast< const uint64_t* >( v->index_region.get_address() );
+
+               current_view.store( v.get(), std::memory_order_release );
+               views.push_back( std::move( v ) );
             }
 
-            inline void check_block_write()
+            /// Make everything appended so far visible to readers
+            void publish()
             {
-               try
-               {
-                  if( !block_write )
-                  {
-                     block_stream.close();
-                     block_stream.open( block_file.generic_string().c_str(), LOG_WRITE );
-                     block_write = true;
-                  }
-               }
-               FC_LOG_AND_RETHROW()
+               block_stream.flush();
+               index_stream.flush();
+               ensure_view( block_size, index_size );
+               published_block_size.store( block_size, std::memory_order_release );
+               published_head_num.store( head.valid() ? protocol::block_header::num_from_id( head_id ) : 0, std::memory_order_release );
             }
 
-            inline void check_index_read()
+            /// Publish the blocks another process appended to a read only log
+            void refresh()
             {
-               try
-               {
-                  if( index_write )
-                  {
-                     index_stream.close();
-                     index_stream.open( index_file.generic_string().c_str(), LOG_READ );
-                     index_write = false;
-                  }
-               }
-               FC_LOG_AND_RETHROW()
+               scoped_lock lock( mtx );
+
+               // Every block is flushed before its index entry, so the log covers all indexed blocks
+               uint64_t new_index_size = fc::file_size( index_file ) / sizeof( uint64_t ) * sizeof( uint64_t );
+               uint64_t new_block_size = fc::file_size( block_file );
+               if( new_index_size <= index_size )
+                  return;
+
+               index_size = new_index_size;
+               block_size = new_block_size;
+               ensure_view( block_size, index_size );
+               published_block_size.store( block_size, std::memory_order_release );
+               published_head_num.store( uint32_t( index_size / sizeof( uint64_t ) ), std::memory_order_release );
             }
 
-            inline void check_index_write()
+            uint64_t read_tail( const char* data, uint64_t size )const
             {
-               try
-               {
-                  if( !index_write )
-                  {
-                     index_stream.close();
-                     index_stream.open( index_file.generic_string().c_str(), LOG_WRITE );
-                     index_write = true;
-                  }
-               }
-               FC_LOG_AND_RETHROW()
+               uint64_t pos;
+               memcpy( (char*)&pos, data + size - sizeof( pos ), sizeof( pos ) );
+               return block_log_format::position( pos );
+            }
+
+            uint64_t header_size()const
+            {
+               return version == 2 ? block_log_format::v2_header_size : 0;
             }
       };
    }
@@ -113,8 +160,6 @@ namespace steem { namespace chain {
 
       my->block_stream.open( my->block_file.generic_string().c_str(), LOG_WRITE );
       my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
-      my->block_write = true;
-      my->index_write = true;
 
       /* On startup of the block log, there are several states the log file and the index file can be
        * in relation to eachother.
@@ -134,28 +179,37 @@ namespace steem { namespace chain {
        *  - If the index file head is not in the log file, delete the index and replay.
        *  - If the index file head is in the log, but not up to date, replay from index head.
        */
-      auto log_size = fc::file_size( my->block_file );
-      auto index_size = fc::file_size( my->index_file );
+      my->block_size = fc::file_size( my->block_file );
+      my->index_size = fc::file_size( my->index_file );
 
-      if( log_size )
+      if( my->block_size == 0 && my->compression != no_compression )
+      {
+         ilog( "Creating compressed block log using ${c}", ("c", block_log_format::to_string( my->compression )) );
+         char header[ block_log_format::v2_header_size ];
+         block_log_format::write_file_header( header );
+         my->block_stream.write( header, sizeof( header ) );
+         my->block_stream.flush();
+         my->block_size = sizeof( header );
+      }
+
+      my->ensure_view( my->block_size, my->index_size );
+      my->version = block_log_format::detect_version( my->current_view.load()->block_data, my->block_size );
+
+      if( my->version == 1 && my->block_size && my->compression != no_compression )
+         wlog( "Block log is in the uncompressed format, new blocks will not be compressed. Use convert_block_log to compress it." );
+
+      if( my->block_size > my->header_size() )
       {
          ilog( "Log is nonempty" );
-         my->head = read_head();
+         const auto* view = my->current_view.load();
+         uint64_t block_pos = my->read_tail( view->block_data, my->block_size );
+         my->head = read_block_helper( block_pos, my->block_size ).first;
          my->head_id = my->head->id();
 
-         if( index_size )
+         if( my->index_size )
          {
-            my->check_block_read();
-            my->check_index_read();
-
             ilog( "Index is nonempty" );
-            uint64_t block_pos;
-            my->block_stream.seekg( -sizeof( uint64_t), std::ios::end );
-            my->block_stream.read( (char*)&block_pos, sizeof( block_pos ) );
-
-            uint64_t index_pos;
-            my->index_stream.seekg( -sizeof( uint64_t), std::ios::end );
-            my->index_stream.read( (char*)&index_pos, sizeof( index_pos ) );
+            uint64_t index_pos = my->read_tail( (const char*)view->index_data, my->index_size );
 
             if( block_pos < index_pos )
             {
@@ -174,30 +228,77 @@ namespace steem { namespace chain {
             construct_index();
          }
       }
-      else if( index_size )
+      else if( my->index_size )
       {
          ilog( "Index is nonempty, remove and recreate it" );
          my->index_stream.close();
          fc::remove_all( my->index_file );
          my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
-         my->index_write = true;
+         my->index_size = 0;
+         my->ensure_view( my->block_size, my->index_size, true );
       }
+
+      my->publish();
+   }
+
+   void block_log::open_read_only( const fc::path& file )
+   {
+      try
+      {
+         close();
+
+         my->read_only = true;
+         my->block_file = file;
+         my->index_file = fc::path( file.generic_string() + ".index" );
+
+         FC_ASSERT( fc::exists( my->block_file ) && fc::exists( my->index_file ), "Block log ${f} does not exist", ("f", file) );
+
+         my->block_size = fc::file_size( my->block_file );
+         my->ensure_view( my->block_size, 0 );
+         my->version = block_log_format::detect_version( my->current_view.load()->block_data, my->block_size );
+
+         my->refresh();
+
+         uint32_t head_num = my->published_head_num.load();
+         if( head_num )
+         {
+            my->head = read_block_by_num( head_num );
+            my->head_id = my->head->id();
+         }
+      }
+      FC_CAPTURE_AND_RETHROW( (file) )
    }
 
    void block_log::close()
    {
+      auto compression = my->compression;
+      auto compression_level = my->compression_level;
       my.reset( new detail::block_log_impl() );
+      my->compression = compression;
+      my->compression_level = compression_level;
    }
 
    bool block_log::is_open()const
    {
-      return my->block_stream.is_open();
+      return my->block_stream.is_open() || my->read_only;
    }
 
    uint64_t block_log::append( const signed_block& b )
    {
       try
       {
+         auto data = fc::raw::pack_to_vector( b );
+
+         // Compress before taking the lock, the entry only depends on the block
+         block_log_format::entry_header header;
+         std::vector< char > stored;
+         if( my->version == 2 )
+         {
+            header.compression = block_log_format::compress( my->compression, my->compression_level, data, stored );
+            header.stored_size = stored.size();
+            header.raw_size = data.size();
+         }
+
          scoped_lock lock( my->mtx, defer_lock );
 
          if( my->use_locking )
@@ -205,20 +306,33 @@ namespace steem { namespace chain {
             lock.lock();;
          }
 
-         my->check_block_write();
-         my->check_index_write();
-
-         uint64_t pos = my->block_stream.tellp();
-         FC_ASSERT( static_cast<uint64_t>(my->index_stream.tellp()) == sizeof( uint64_t ) * ( b.block_num() - 1 ),
+         uint64_t pos = my->block_size;
+         FC_ASSERT( my->index_size == sizeof( uint64_t ) * ( b.block_num() - 1 ),
             "Append to index file occuring at wrong position.",
-            ( "position", (uint64_t) my->index_stream.tellp() )( "expected",( b.block_num() - 1 ) * sizeof( uint64_t ) ) );
-         auto data = fc::raw::pack_to_vector( b );
-         my->block_stream.write( data.data(), data.size() );
-         my->block_stream.write( (char*)&pos, sizeof( pos ) );
-         my->index_stream.write( (char*)&pos, sizeof( pos ) );
+            ( "position", my->index_size )( "expected",( b.block_num() - 1 ) * sizeof( uint64_t ) ) );
+
+         if( my->version == 2 )
+         {
+            uint64_t entry = block_log_format::make_index_entry( pos, block_log_compression( header.compression ) );
+            my->block_stream.write( (char*)&header, sizeof( header ) );
+            my->block_stream.write( stored.data(), stored.size() );
+            my->block_stream.write( (char*)&entry, sizeof( entry ) );
+            my->index_stream.write( (char*)&entry, sizeof( entry ) );
+            my->block_size += sizeof( header ) + stored.size() + sizeof( entry );
+         }
+         else
+         {
+            my->block_stream.write( data.data(), data.size() );
+            my->block_stream.write( (char*)&pos, sizeof( pos ) );
+            my->index_stream.write( (char*)&pos, sizeof( pos ) );
+            my->block_size += data.size() + sizeof( pos );
+         }
+         my->index_size += sizeof( pos );
          my->head = b;
          my->head_id = b.id();
 
+         my->publish();
+
          return pos;
       }
       FC_LOG_AND_RETHROW()
@@ -239,26 +353,31 @@ namespace steem { namespace chain {
 
    std::pair< signed_block, uint64_t > block_log::read_block( uint64_t pos )const
    {
-      scoped_lock lock( my->mtx, defer_lock );
-
-      if( my->use_locking )
-      {
-         lock.lock();;
-      }
-
-      return read_block_helper( pos );
+      return read_block_helper( pos, my->published_block_size.load( std::memory_order_acquire ) );
    }
 
-   std::pair< signed_block, uint64_t > block_log::read_block_helper( uint64_t pos )const
+   std::pair< signed_block, uint64_t > block_log::read_block_helper( uint64_t pos, uint64_t log_size )const
    {
       try
       {
-         my->check_block_read();
+         const auto* view = my->current_view.load( std::memory_order_acquire );
+         FC_ASSERT( view != nullptr && pos < log_size, "Block position is past the end of the block log",
+            ("pos", pos)("size", log_size) );
+         FC_ASSERT( pos >= my->header_size(), "Block position is inside the block log header", ("pos", pos) );
 
-         my->block_stream.seekg( pos );
          std::pair<signed_block,uint64_t> result;
-         fc::raw::unpack( my->block_stream, result.first );
-         result.second = uint64_t(my->block_stream.tellg()) + 8;
+         if( my->version == 2 )
+         {
+            // Reused across reads on the same thread to avoid an allocation per block
+            static thread_local std::vector< char > buffer;
+            result.second = pos + block_log_format::unpack_entry( view->block_data + pos, log_size - pos, result.first, buffer ) + 8;
+         }
+         else
+         {
+            fc::datastream< const char* > ds( view->block_data + pos, log_size - pos );
+            fc::raw::unpack( ds, result.first );
+            result.second = pos + uint64_t( ds.tellp() ) + 8;
+         }
          return result;
       }
       FC_LOG_AND_RETHROW()
@@ -268,18 +387,17 @@ namespace steem { namespace chain {
    {
       try
       {
-         scoped_lock lock( my->mtx, defer_lock );
-
-         if( my->use_locking )
+         optional< signed_block > b;
+         uint32_t head_num = my->published_head_num.load( std::memory_order_acquire );
+         if( my->read_only && block_num > head_num )
          {
-            lock.lock();;
+            my->refresh();
+            head_num = my->published_head_num.load( std::memory_order_acquire );
          }
-
-         optional< signed_block > b;
-         uint64_t pos = get_block_pos_helper( block_num );
+         uint64_t pos = get_block_pos_helper( block_num, head_num );
          if( pos != npos )
          {
-            b = read_block_helper( pos ).first;
+            b = read_block_helper( pos, my->published_block_size.load( std::memory_order_acquire ) ).first;
             FC_ASSERT( b->block_num() == block_num , "Wrong block was read from block log.", ( "returned", b->block_num() )( "expected", block_num ));
          }
          return b;
@@ -289,28 +407,18 @@ namespace steem { namespace chain {
 
    uint64_t block_log::get_block_pos( uint32_t block_num ) const
    {
-      scoped_lock lock( my->mtx, defer_lock );
-
-      if( my->use_locking )
-      {
-         lock.lock();;
-      }
-
-      return get_block_pos_helper( block_num );
+      return get_block_pos_helper( block_num, my->published_head_num.load( std::memory_order_acquire ) );
    }
 
-   uint64_t block_log::get_block_pos_helper( uint32_t block_num ) const
+   uint64_t block_log::get_block_pos_helper( uint32_t block_num, uint32_t head_num ) const
    {
       try
       {
-         my->check_index_read();
-
-         if( !( my->head.valid() && block_num <= protocol::block_header::num_from_id( my->head_id ) && block_num > 0 ) )
+         if( !( block_num <= head_num && block_num > 0 ) )
             return npos;
-         my->index_stream.seekg( sizeof( uint64_t ) * ( block_num - 1 ) );
-         uint64_t pos;
-         my->index_stream.read( (char*)&pos, sizeof( pos ) );
-         return pos;
+
+         const auto* view = my->current_view.load( std::memory_order_acquire );
+         return block_log_format::position( view->index_data[ block_num - 1 ] );
       }
       FC_LOG_AND_RETHROW()
    }
@@ -319,19 +427,9 @@ namespace steem { namespace chain {
    {
       try
       {
-         scoped_lock lock( my->mtx, defer_lock );
-
-         if( my->use_locking )
-         {
-            lock.lock();;
-         }
-
-         my->check_block_read();
-
-         uint64_t pos;
-         my->block_stream.seekg( -sizeof(pos), std::ios::end );
-         my->block_stream.read( (char*)&pos, sizeof(pos) );
-         return read_block_helper( pos ).first;
+         uint32_t head_num = my->published_head_num.load( std::memory_order_acquire );
+         FC_ASSERT( head_num > 0, "Block log is empty" );
+         return read_block_helper( get_block_pos_helper( head_num, head_num ), my->published_block_size.load( std::memory_order_acquire ) ).first;
       }
       FC_LOG_AND_RETHROW()
    }
@@ -348,6 +446,14 @@ namespace steem { namespace chain {
       return my->head;
    }
 
+   uint32_t block_log::head_block_num()const
+   {
+      if( my->read_only )
+         my->refresh();
+
+      return my->published_head_num.load( std::memory_order_acquire );
+   }
+
    void block_log::construct_index()
    {
       try
@@ -356,30 +462,60 @@ namespace steem { namespace chain {
          my->index_stream.close();
          fc::remove_all( my->index_file );
          my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
-         my->index_write = true;
-
-         uint64_t pos = 0;
-         uint64_t end_pos;
-         my->check_block_read();
-
-         my->block_stream.seekg( -sizeof( uint64_t), std::ios::end );
-         my->block_stream.read( (char*)&end_pos, sizeof( end_pos ) );
-         signed_block tmp;
+         my->index_size = 0;
 
-         my->block_stream.seekg( pos );
+         const auto* view = my->current_view.load();
+         uint64_t end_pos = my->read_tail( view->block_data, my->block_size );
+         uint64_t pos = my->header_size();
 
-         while( pos < end_pos )
+         while( pos <= end_pos )
          {
-            fc::raw::unpack( my->block_stream, tmp );
-            my->block_stream.read( (char*)&pos, sizeof( pos ) );
-            my->index_stream.write( (char*)&pos, sizeof( pos ) );
+            uint64_t entry_size;
+            if( my->version == 2 )
+            {
+               // Compressed entries carry their size, there is no need to decompress them
+               block_log_format::entry_header header;
+               memcpy( (char*)&header, view->block_data + pos, sizeof( header ) );
+               entry_size = sizeof( header ) + header.stored_size;
+            }
+            else
+            {
+               fc::datastream< const char* > ds( view->block_data + pos, my->block_size - pos );
+               signed_block tmp;
+               fc::raw::unpack( ds, tmp );
+               entry_size = ds.tellp();
+            }
+
+            // The trailing copy of the index entry follows each block
+            uint64_t entry;
+            memcpy( (char*)&entry, view->block_data + pos + entry_size, sizeof( entry ) );
+            FC_ASSERT( block_log_format::position( entry ) == pos, "Corrupt block log entry", ("pos", pos)("entry", entry) );
+            my->index_stream.write( (char*)&entry, sizeof( entry ) );
+            my->index_size += sizeof( entry );
+            pos += entry_size + sizeof( entry );
          }
+
+         my->index_stream.flush();
+         my->ensure_view( my->block_size, my->index_size, true );
       }
       FC_LOG_AND_RETHROW()
    }
 
    void block_log::set_locking( bool use_locking )
    {
-      my->use_locking = true;
+      my->use_locking = use_locking;
+   }
+
+   void block_log::set_compression( block_log_compression c, int level )
+   {
+      FC_ASSERT( block_log_format::is_supported( c ), "This build does not support ${c} block log compression",
+         ("c", block_log_format::to_string( c )) );
+      my->compression = c;
+      my->compression_level = level;
+   }
+
+   uint32_t block_log::get_format_version()const
+   {
+      return my->version;
    }
 } } // steem::chain
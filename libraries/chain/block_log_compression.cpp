@@ -0,0 +1,177 @@
+#include <steem/chain/block_log_compression.hpp>
+
+#include <fc/io/raw.hpp>
+
+#ifdef STEEM_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef STEEM_HAS_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#include <cstring>
+
+namespace steem { namespace chain { namespace block_log_format {
+
+   static const char     v2_magic[8] = { 'S', 'T', 'E', 'E', 'M', 'B', 'L', '2' };
+   static const uint32_t v2_version = 2;
+
+   void write_file_header( char* out )
+   {
+      memset( out, 0, v2_header_size );
+      memcpy( out, v2_magic, sizeof( v2_magic ) );
+      memcpy( out + sizeof( v2_magic ), (const char*)&v2_version, sizeof( v2_version ) );
+   }
+
+   uint32_t detect_version( const char* data, uint64_t size )
+   {
+      if( size >= v2_header_size && memcmp( data, v2_magic, sizeof( v2_magic ) ) == 0 )
+      {
+         uint32_t version;
+         memcpy( (char*)&version, data + sizeof( v2_magic ), sizeof( version ) );
+         FC_ASSERT( version == v2_version, "Unsupported block log version", ("version", version) );
+         return version;
+      }
+
+      return 1;
+   }
+
+   bool is_supported( block_log_compression c )
+   {
+      switch( c )
+      {
+         case no_compression:
+            return true;
+#ifdef STEEM_HAS_ZSTD
+         case zstd_compression:
+            return true;
+#endif
+#ifdef STEEM_HAS_LZ4
+         case lz4_compression:
+            return true;
+#endif
+         default:
+            return false;
+      }
+   }
+
+   block_log_compression from_string( const std::string& name )
+   {
+      if( name == "none" )
+         return no_compression;
+      if( name == "zstd" )
+         return zstd_compression;
+      if( name == "lz4" )
+         return lz4_compression;
+
+      FC_THROW_EXCEPTION( fc::invalid_arg_exception, "Unknown block log compression '${n}', expected none, zstd or lz4", ("n", name) );
+   }
+
+   std::string to_string( block_log_compression c )
+   {
+      switch( c )
+      {
+         case no_compression:
+            return "none";
+         case zstd_compression:
+            return "zstd";
+         case lz4_compression:
+            return "lz4";
+      }
+
+      return "unknown";
+   }
+
+   block_log_compression compress( block_log_compression c, int level, const std::vector< char >& raw, std::vector< char >& out )
+   {
+      FC_ASSERT( is_supported( c ), "This build does not support ${c} block log compression", ("c", to_string( c )) );
+
+      size_t stored_size = 0;
+
+      switch( c )
+      {
+#ifdef STEEM_HAS_ZSTD
+         case zstd_compression:
+         {
+            out.resize( ZSTD_compressBound( raw.size() ) );
+            stored_size = ZSTD_compress( out.data(), out.size(), raw.data(), raw.size(), level ? level : 3 );
+            FC_ASSERT( !ZSTD_isError( stored_size ), "zstd compression failed: ${e}", ("e", ZSTD_getErrorName( stored_size )) );
+            break;
+         }
+#endif
+#ifdef STEEM_HAS_LZ4
+         case lz4_compression:
+         {
+            out.resize( LZ4_compressBound( raw.size() ) );
+            int result = level > 0
+               ? LZ4_compress_HC( raw.data(), out.data(), raw.size(), out.size(), level )
+               : LZ4_compress_default( raw.data(), out.data(), raw.size(), out.size() );
+            FC_ASSERT( result > 0, "lz4 compression failed" );
+            stored_size = result;
+            break;
+         }
+#endif
+         default:
+            break;
+      }
+
+      if( c == no_compression || stored_size >= raw.size() )
+      {
+         out = raw;
+         return no_compression;
+      }
+
+      out.resize( stored_size );
+      return c;
+   }
+
+   uint64_t unpack_entry( const char* data, uint64_t size, signed_block& b, std::vector< char >& buffer )
+   {
+      entry_header header;
+      FC_ASSERT( size >= sizeof( header ), "Truncated block log entry" );
+      memcpy( (char*)&header, data, sizeof( header ) );
+      FC_ASSERT( sizeof( header ) + header.stored_size <= size, "Truncated block log entry",
+         ("stored_size", header.stored_size)("available", size) );
+
+      const char* stored = data + sizeof( header );
+      const char* raw = stored;
+
+      switch( block_log_compression( header.compression ) )
+      {
+         case no_compression:
+            FC_ASSERT( header.stored_size == header.raw_size, "Corrupt uncompressed block log entry" );
+            break;
+#ifdef STEEM_HAS_ZSTD
+         case zstd_compression:
+         {
+            buffer.resize( header.raw_size );
+            size_t result = ZSTD_decompress( buffer.data(), buffer.size(), stored, header.stored_size );
+            FC_ASSERT( !ZSTD_isError( result ) && result == header.raw_size, "zstd decompression failed" );
+            raw = buffer.data();
+            break;
+         }
+#endif
+#ifdef STEEM_HAS_LZ4
+         case lz4_compression:
+         {
+            buffer.resize( header.raw_size );
+            int result = LZ4_decompress_safe( stored, buffer.data(), header.stored_size, buffer.size() );
+            FC_ASSERT( result >= 0 && uint32_t( result ) == header.raw_size, "lz4 decompression failed" );
+            raw = buffer.data();
+            break;
+         }
+#endif
+         default:
+            FC_ASSERT( false, "This build cannot read ${c} compressed blocks",
+               ("c", to_string( block_log_compression( header.compression ) )) );
+      }
+
+      fc::datastream< const char* > ds( raw, header.raw_size );
+      fc::raw::unpack( ds, b );
+
+      return sizeof( header ) + header.stored_size;
+   }
+
+} } } // steem::chain::block_log_format
@@ -0,0 +1,409 @@
+#include <steem/chain/block_log_scanner.hpp>
+#include <steem/chain/block_log_compression.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/io/datastream.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace steem { namespace chain {
+
+   namespace bip = boost::interprocess;
+
+   namespace detail {
+
+      struct scan_counters
+      {
+         uint64_t blocks = 0;
+         uint64_t transactions = 0;
+         uint64_t operations = 0;
+         uint64_t bytes = 0;
+      };
+
+      struct decoded_chunk
+      {
+         std::vector< signed_block >                        blocks;
+         std::vector< std::vector< transaction_id_type > >  transaction_ids;
+         uint64_t                                           bytes = 0;
+         fc::exception_ptr                                  except;
+      };
+
+      class block_log_scanner_impl
+      {
+         public:
+            block_log_scanner_impl( const fc::path& block_log_file )
+            {
+               fc::path index_file( block_log_file.generic_string() + ".index" );
+
+               block_mapping = bip::file_mapping( block_log_file.generic_string().c_str(), bip::read_only );
+               block_region = bip::mapped_region( block_mapping, bip::read_only );
+               index_mapping = bip::file_mapping( index_file.generic_string().c_str(), bip::read_only );
+               index_region = bip::mapped_region( index_mapping, bip::read_only );
+
+               block_region.advise( bip::mapped_region::advice_sequential );
+
+               block_data = static_cast< const char* >( block_region.get_address() );
+               block_data_size = block_region.get_size();
+               index_data = static_cast< const uint64_t* >( index_region.get_address() );
+               index_entries = index_region.get_size() / sizeof( uint64_t );
+               version = block_log_format::detect_version( block_data, block_data_size );
+            }
+
+            /// Returns [begin, end) of the serialized block in the mapped block log
+            std::pair< uint64_t, uint64_t > block_range( uint32_t block_num )const
+            {
+               uint64_t begin = block_log_format::position( index_data[ block_num - 1 ] );
+               uint64_t end = block_num < index_entries ? block_log_format::position( index_data[ block_num ] ) : block_data_size;
+               // Every block is followed by its own 8 byte position
+               FC_ASSERT( begin + sizeof( uint64_t ) <= end && end <= block_data_size, "Corrupt block log index entry",
+                  ("block_num", block_num)("begin", begin)("end", end)("size", block_data_size) );
+               return std::make_pair( begin, end - sizeof( uint64_t ) );
+            }
+
+            /// Returns the size of the block in the log
+            uint64_t decode( uint32_t block_num, signed_block& b, std::vector< char >& buffer )const
+            {
+               auto range = block_range( block_num );
+               b = signed_block();
+               if( version == 2 )
+               {
+                  block_log_format::unpack_entry( block_data + range.first, range.second - range.first, b, buffer );
+               }
+               else
+               {
+                  fc::datastream< const char* > ds( block_data + range.first, range.second - range.first );
+                  fc::raw::unpack( ds, b );
+               }
+               FC_ASSERT( b.block_num() == block_num, "Wrong block was read from block log.",
+                  ("returned", b.block_num())("expected", block_num) );
+               return range.second - range.first + sizeof( uint64_t );
+            }
+
+            bip::file_mapping             block_mapping;
+            bip::mapped_region            block_region;
+            bip::file_mapping             index_mapping;
+            bip::mapped_region            index_region;
+            const char*                   block_data = nullptr;
+            uint64_t                      block_data_size = 0;
+            const uint64_t*               index_data = nullptr;
+            uint64_t                      index_entries = 0;
+            uint32_t                      version = 1;
+      };
+
+      void compute_ids( const signed_block& b, std::vector< transaction_id_type >& ids )
+      {
+         ids.clear();
+         ids.reserve( b.transactions.size() );
+         for( const auto& trx : b.transactions )
+            ids.push_back( trx.id() );
+      }
+
+      void visit_block( const block_log_scan_visitor& visitor, uint32_t thread, uint32_t block_num, const signed_block& b,
+         const std::vector< transaction_id_type >& ids, scan_counters& counters )
+      {
+         if( visitor.on_block )
+            visitor.on_block( thread, block_num, b );
+
+         for( uint32_t trx_in_block = 0; trx_in_block < b.transactions.size(); ++trx_in_block )
+         {
+            const auto& trx = b.transactions[ trx_in_block ];
+
+            if( visitor.on_transaction )
+               visitor.on_transaction( thread, block_num, trx_in_block, ids[ trx_in_block ], trx );
+
+            if( visitor.on_operation )
+            {
+               for( uint32_t op_in_trx = 0; op_in_trx < trx.operations.size(); ++op_in_trx )
+                  visitor.on_operation( thread, block_num, trx_in_block, op_in_trx, trx.operations[ op_in_trx ] );
+            }
+
+            counters.operations += trx.operations.size();
+         }
+
+         counters.transactions += b.transactions.size();
+         ++counters.blocks;
+      }
+
+      /// State shared by the threads of one scan
+      struct scan_context
+      {
+         scan_context( const block_log_scanner_impl& s, const block_log_scan_visitor& v, uint32_t first, uint32_t last, uint32_t chunk ) :
+            scanner( s ), visitor( v ), first_block( first ), last_block( last ), chunk_blocks( chunk ),
+            chunks( ( last - first ) / chunk + 1 ) {}
+
+         std::pair< uint32_t, uint32_t > chunk_range( uint32_t chunk )const
+         {
+            uint32_t begin = first_block + chunk * chunk_blocks;
+            return std::make_pair( begin, std::min( last_block, begin + ( chunk_blocks - 1 ) ) );
+         }
+
+         void fail( const fc::exception& e )
+         {
+            std::lock_guard< std::mutex > lock( mtx );
+            if( !except )
+               except = e.dynamic_copy_exception();
+            running = false;
+            cv.notify_all();
+         }
+
+         void add( const scan_counters& c )
+         {
+            std::lock_guard< std::mutex > lock( mtx );
+            counters.blocks += c.blocks;
+            counters.transactions += c.transactions;
+            counters.operations += c.operations;
+            counters.bytes += c.bytes;
+         }
+
+         void stop()
+         {
+            {
+               std::lock_guard< std::mutex > lock( mtx );
+               running = false;
+               cv.notify_all();
+            }
+
+            for( auto& t : threads )
+               t.join();
+            threads.clear();
+         }
+
+         const block_log_scanner_impl&          scanner;
+         const block_log_scan_visitor&          visitor;
+         const uint32_t                         first_block;
+         const uint32_t                         last_block;
+         const uint32_t                         chunk_blocks;
+         const uint32_t                         chunks;
+
+         std::mutex                             mtx;
+         std::condition_variable                cv;
+         std::atomic< bool >                    running{ true };
+         fc::exception_ptr                      except;
+         scan_counters                          counters;
+
+         // Unordered delivery
+         std::atomic< uint32_t >                next_chunk{ 0 };
+
+         // Ordered delivery
+         uint32_t                               next_decode = 0;
+         uint32_t                               next_deliver = 0;
+         uint32_t                               max_pending = 0;
+         std::map< uint32_t, decoded_chunk >    decoded;
+
+         std::vector< std::thread >             threads;
+      };
+
+      void scan_unordered( scan_context& ctx, uint32_t thread )
+      {
+         scan_counters counters;
+         signed_block b;
+         std::vector< char > buffer;
+         std::vector< transaction_id_type > ids;
+
+         try
+         {
+            while( ctx.running.load( std::memory_order_relaxed ) )
+            {
+               uint32_t chunk = ctx.next_chunk++;
+               if( chunk >= ctx.chunks )
+                  break;
+
+               auto range = ctx.chunk_range( chunk );
+               for( uint32_t n = range.first; n <= range.second && ctx.running.load( std::memory_order_relaxed ); ++n )
+               {
+                  counters.bytes += ctx.scanner.decode( n, b, buffer );
+                  if( ctx.visitor.on_transaction )
+                     compute_ids( b, ids );
+                  visit_block( ctx.visitor, thread, n, b, ids, counters );
+               }
+            }
+         }
+         catch( const fc::exception& e )
+         {
+            ctx.fail( e );
+         }
+         catch( ... )
+         {
+            ctx.fail( fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unexpected exception while scanning block log." ),
+                                               std::current_exception() ) );
+         }
+
+         ctx.add( counters );
+      }
+
+      void decode_ordered( scan_context& ctx )
+      {
+         std::vector< char > buffer;
+
+         while( true )
+         {
+            uint32_t chunk;
+            {
+               std::unique_lock< std::mutex > lock( ctx.mtx );
+               ctx.cv.wait( lock, [&]()
+               {
+                  return !ctx.running || ctx.next_decode >= ctx.chunks || ctx.next_decode < ctx.next_deliver + ctx.max_pending;
+               });
+               if( !ctx.running || ctx.next_decode >= ctx.chunks )
+                  return;
+               chunk = ctx.next_decode++;
+            }
+
+            decoded_chunk result;
+            try
+            {
+               auto range = ctx.chunk_range( chunk );
+               result.blocks.resize( range.second - range.first + 1 );
+               result.transaction_ids.resize( result.blocks.size() );
+
+               for( uint32_t n = range.first; n <= range.second; ++n )
+               {
+                  auto& b = result.blocks[ n - range.first ];
+                  result.bytes += ctx.scanner.decode( n, b, buffer );
+                  if( ctx.visitor.on_transaction )
+                     compute_ids( b, result.transaction_ids[ n - range.first ] );
+               }
+            }
+            catch( const fc::exception& e )
+            {
+               result.except = e.dynamic_copy_exception();
+            }
+            catch( ... )
+            {
+               result.except = std::make_shared< fc::unhandled_exception >( FC_LOG_MESSAGE( warn, "Unexpected exception while decoding block." ),
+                                                                             std::current_exception() );
+            }
+
+            std::lock_guard< std::mutex > lock( ctx.mtx );
+            ctx.decoded[ chunk ] = std::move( result );
+            ctx.cv.notify_all();
+         }
+      }
+
+      void deliver_ordered( scan_context& ctx )
+      {
+         scan_counters counters;
+
+         for( uint32_t chunk = 0; chunk < ctx.chunks; ++chunk )
+         {
+            decoded_chunk result;
+            {
+               std::unique_lock< std::mutex > lock( ctx.mtx );
+               ctx.cv.wait( lock, [&](){ return ctx.decoded.count( chunk ) > 0; } );
+               auto itr = ctx.decoded.find( chunk );
+               result = std::move( itr->second );
+               ctx.decoded.erase( itr );
+               ctx.next_deliver = chunk + 1;
+               ctx.cv.notify_all();
+            }
+
+            // Rethrown with its original type
+            if( result.except )
+               result.except->dynamic_rethrow_exception();
+
+            uint32_t first = ctx.chunk_range( chunk ).first;
+            for( size_t i = 0; i < result.blocks.size(); ++i )
+               visit_block( ctx.visitor, 0, first + uint32_t( i ), result.blocks[i], result.transaction_ids[i], counters );
+
+            counters.bytes += result.bytes;
+         }
+
+         ctx.add( counters );
+      }
+
+   } // detail
+
+   block_log_scanner::block_log_scanner( const fc::path& block_log_file )
+   {
+      try
+      {
+         my.reset( new detail::block_log_scanner_impl( block_log_file ) );
+      }
+      FC_CAPTURE_AND_RETHROW( (block_log_file) )
+   }
+
+   block_log_scanner::~block_log_scanner() {}
+
+   uint32_t block_log_scanner::head_block_num()const
+   {
+      return my->index_entries;
+   }
+
+   uint32_t block_log_scanner::get_format_version()const
+   {
+      return my->version;
+   }
+
+   block_log_scanner::scan_stats block_log_scanner::scan( const scan_options& options, const block_log_scan_visitor& visitor )const
+   {
+      try
+      {
+         uint32_t last_block = options.last_block ? options.last_block : head_block_num();
+
+         FC_ASSERT( options.first_block > 0 && options.first_block <= last_block, "Invalid scan range",
+            ("first", options.first_block)("last", last_block) );
+         FC_ASSERT( last_block <= head_block_num(), "Block log index does not cover the scan range",
+            ("index_entries", head_block_num())("last", last_block) );
+         FC_ASSERT( options.chunk_blocks > 0, "Chunks must hold at least one block" );
+
+         detail::scan_context ctx( *my, visitor, options.first_block, last_block, options.chunk_blocks );
+
+         uint32_t threads = options.threads ? options.threads : std::max( std::thread::hardware_concurrency(), 1u );
+         threads = std::min( threads, ctx.chunks );
+         ctx.max_pending = options.max_pending_chunks ? options.max_pending_chunks : 2 * threads;
+
+         auto start = fc::time_point::now();
+
+         try
+         {
+            if( options.delivery == ordered )
+            {
+               for( uint32_t i = 0; i < threads; ++i )
+                  ctx.threads.emplace_back( [&ctx](){ detail::decode_ordered( ctx ); } );
+
+               detail::deliver_ordered( ctx );
+            }
+            else
+            {
+               for( uint32_t i = 0; i < threads; ++i )
+                  ctx.threads.emplace_back( [&ctx, i](){ detail::scan_unordered( ctx, i ); } );
+            }
+         }
+         catch( ... )
+         {
+            ctx.stop();
+            throw;
+         }
+
+         if( options.delivery == unordered )
+         {
+            for( auto& t : ctx.threads )
+               t.join();
+            ctx.threads.clear();
+         }
+         ctx.stop();
+
+         if( ctx.except )
+            ctx.except->dynamic_rethrow_exception();
+
+         scan_stats stats;
+         stats.blocks = ctx.counters.blocks;
+         stats.transactions = ctx.counters.transactions;
+         stats.operations = ctx.counters.operations;
+         stats.bytes = ctx.counters.bytes;
+         stats.chunks = ctx.chunks;
+         stats.threads = threads;
+         stats.elapsed_us = ( fc::time_point::now() - start ).count();
+         return stats;
+      }
+      FC_CAPTURE_AND_RETHROW( (options) )
+   }
+
+} } // steem::chain
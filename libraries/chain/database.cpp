@@ -1,5 +1,6 @@
 
 #include <steem/protocol/steem_operations.hpp>
+#include <steem/protocol/transaction_util.hpp>
 
 #include <steem/chain/block_summary_object.hpp>
 #include <steem/chain/compound.hpp>
@@ -19,6 +20,7 @@
 #include <steem/chain/steem_objects.hpp>
 #include <steem/chain/transaction_object.hpp>
 #include <steem/chain/shared_db_merkle.hpp>
+#include <steem/chain/state_snapshot.hpp>
 #include <steem/chain/witness_schedule.hpp>
 
 #include <steem/chain/util/asset.hpp>
@@ -114,14 +116,31 @@ void database::open( const open_args& args )
       initialize_indexes();
       initialize_evaluators();
 
+      if( is_read_only() )
+      {
+         // The node writing the state owns the block log as well, this process only serves reads
+         with_read_lock( [&]()
+         {
+            FC_ASSERT( find< dynamic_global_property_object >() != nullptr, "Shared memory has not been initialized by the writing node" );
+            init_hardforks();
+         });
+
+         _block_log.open_read_only( args.data_dir / "block_log" );
+         return;
+      }
+
       if( !find< dynamic_global_property_object >() )
          with_write_lock( [&]()
          {
-            init_genesis( args.initial_supply );
+            if( args.snapshot_file != fc::path() )
+               load_state_snapshot( *this, args.snapshot_file, args.snapshot_threads );
+            else
+               init_genesis( args.initial_supply );
          });
 
       _benchmark_dumper.set_enabled( args.benchmark_is_enabled );
 
+      _block_log.set_compression( args.block_log_codec, args.block_log_compression_level );
       _block_log.open( args.data_dir / "block_log" );
 
       auto log_head = _block_log.head();
@@ -160,17 +179,20 @@ void database::open( const open_args& args )
       _shared_file_full_threshold = args.shared_file_full_threshold;
       _shared_file_scale_rate = args.shared_file_scale_rate;
 
-      auto account = find< account_object, by_name >( "nijeah" );
-      if( account != nullptr && account->to_withdraw < 0 )
+      with_write_lock( [&]()
       {
-         auto session = start_undo_session();
-         modify( *account, []( account_object& a )
+         auto account = find< account_object, by_name >( "nijeah" );
+         if( account != nullptr && account->to_withdraw < 0 )
          {
-            a.to_withdraw = 0;
-            a.next_vesting_withdrawal = fc::time_point_sec::maximum();
-         });
-         session.squash();
-      }
+            auto session = start_undo_session();
+            modify( *account, []( account_object& a )
+            {
+               a.to_withdraw = 0;
+               a.next_vesting_withdrawal = fc::time_point_sec::maximum();
+            });
+            session.squash();
+         }
+      });
    }
    FC_CAPTURE_LOG_AND_RETHROW( (args.data_dir)(args.shared_mem_dir)(args.shared_file_size) )
 }
@@ -212,30 +234,80 @@ uint32_t database::reindex( const open_args& args )
       with_write_lock( [&]()
       {
          _block_log.set_locking( false );
-         auto itr = _block_log.read_block( 0 );
+         // Replay resumes after the head block of a loaded snapshot, or from block 1
+         auto first_block_num = head_block_num() + 1;
          auto last_block_num = _block_log.head()->block_num();
          if( args.stop_replay_at > 0 && args.stop_replay_at < last_block_num )
             last_block_num = args.stop_replay_at;
+         note.last_block_number = head_block_num();
          if( args.benchmark.first > 0 )
          {
             args.benchmark.second( 0, get_abstract_index_cntr() );
          }
 
-         while( itr.first.block_num() != last_block_num )
+         auto report_progress = [&]( uint32_t cur_block_num )
          {
-            auto cur_block_num = itr.first.block_num();
             if( cur_block_num % 100000 == 0 )
                std::cerr << "   " << double( cur_block_num * 100 ) / last_block_num << "%   " << cur_block_num << " of " << last_block_num <<
                "   (" << (get_free_memory() / (1024*1024)) << "M free)\n";
-            apply_block( itr.first, skip_flags );
+         };
 
-            if( (args.benchmark.first > 0) && (cur_block_num % args.benchmark.first == 0) )
-               args.benchmark.second( cur_block_num, get_abstract_index_cntr() );
-            itr = _block_log.read_block( itr.second );
+         if( first_block_num > last_block_num )
+         {
+            ilog( "State is already at block ${b}, no blocks to replay", ("b", head_block_num()) );
          }
+         else if( args.replay_decode_threads > 0 )
+         {
+            // The pipeline maps the block log files, make sure the index built by open() is on disk
+            _block_log.flush();
+            replay_pipeline pipeline( args.data_dir / "block_log", first_block_num, last_block_num, args.replay_decode_threads );
+            uint64_t apply_us = 0;
+
+            while( !pipeline.done() )
+            {
+               const replay_block& next = pipeline.next();
+               auto cur_block_num = next.block.block_num();
+               report_progress( cur_block_num );
 
-         apply_block( itr.first, skip_flags );
-         note.last_block_number = itr.first.block_num();
+               auto apply_start = fc::time_point::now();
+               apply_block( next.block, skip_flags, &next.ids );
+               apply_us += ( fc::time_point::now() - apply_start ).count();
+
+               if( cur_block_num != last_block_num && (args.benchmark.first > 0) && (cur_block_num % args.benchmark.first == 0) )
+                  args.benchmark.second( cur_block_num, get_abstract_index_cntr() );
+               note.last_block_number = cur_block_num;
+            }
+
+            pipeline.stop();
+            auto stats = pipeline.get_stats();
+            auto rate = [&]( uint64_t us ) { return us ? double( note.last_block_number - first_block_num + 1 ) * 1000000.0 / us : 0.0; };
+            ilog( "Replay pipeline with ${t} decode threads: read ${r} blocks/sec, decode ${d} blocks/sec (${dt} per thread), apply ${a} blocks/sec, overall ${o} blocks/sec. Apply thread waited ${w} ms for decoded blocks.",
+               ("t", stats.decode_threads)
+               ("r", stats.read.blocks_per_sec())
+               ("d", stats.decode.blocks_per_sec() * stats.decode_threads)
+               ("dt", stats.decode.blocks_per_sec())
+               ("a", rate( apply_us ))
+               ("o", rate( stats.elapsed_us ))
+               ("w", stats.apply_wait_us / 1000) );
+         }
+         else
+         {
+            auto itr = _block_log.read_block( _block_log.get_block_pos( first_block_num ) );
+
+            while( itr.first.block_num() != last_block_num )
+            {
+               auto cur_block_num = itr.first.block_num();
+               report_progress( cur_block_num );
+               apply_block( itr.first, skip_flags );
+
+               if( (args.benchmark.first > 0) && (cur_block_num % args.benchmark.first == 0) )
+                  args.benchmark.second( cur_block_num, get_abstract_index_cntr() );
+               itr = _block_log.read_block( itr.second );
+            }
+
+            apply_block( itr.first, skip_flags );
+            note.last_block_number = itr.first.block_num();
+         }
 
          if( (args.benchmark.first > 0) && (note.last_block_number % args.benchmark.first == 0) )
             args.benchmark.second( note.last_block_number, get_abstract_index_cntr() );
@@ -418,7 +490,7 @@ void database::foreach_block(std::function<bool(const signed_block_header&, cons
    if(!_block_log.head())
       return;
 
-   auto itr = _block_log.read_block( 0 );
+   auto itr = _block_log.read_block( _block_log.get_block_pos( 1 ) );
    auto last_block_num = _block_log.head()->block_num();
    signed_block_header previousBlockHeader = itr.first;
    while( itr.first.block_num() != last_block_num )
@@ -2862,13 +2934,13 @@ void database::set_flush_interval( uint32_t flush_blocks )
 
 //////////////////// private methods ////////////////////
 
-void database::apply_block( const signed_block& next_block, uint32_t skip )
+void database::apply_block( const signed_block& next_block, uint32_t skip, const precomputed_block_ids* ids )
 { try {
    //fc::time_point begin_time = fc::time_point::now();
 
    detail::with_skip_flags( *this, skip, [&]()
    {
-      _apply_block( next_block );
+      _apply_block( next_block, ids );
    } );
 
    /*try
@@ -2951,9 +3023,9 @@ void database::check_free_memory( bool force_print, uint32_t current_block_num )
    }
 }
 
-void database::_apply_block( const signed_block& next_block )
+void database::_apply_block( const signed_block& next_block, const precomputed_block_ids* ids )
 { try {
-   block_notification note( next_block );
+   block_notification note = ids != nullptr ? block_notification( next_block, ids->block_id ) : block_notification( next_block );
 
    notify_pre_apply_block( note );
 
@@ -3071,7 +3143,10 @@ void database::_apply_block( const signed_block& next_block )
        * for transactions when validating broadcast transactions or
        * when building a block.
        */
-      apply_transaction( trx, skip );
+      if( ids != nullptr )
+         _apply_transaction( trx, &ids->transaction_ids[ _current_trx_in_block ] );
+      else
+         apply_transaction( trx, skip );
       ++_current_trx_in_block;
    }
 
@@ -3281,9 +3356,9 @@ void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
    detail::with_skip_flags( *this, skip, [&]() { _apply_transaction(trx); });
 }
 
-void database::_apply_transaction(const signed_transaction& trx)
+void database::_apply_transaction(const signed_transaction& trx, const transaction_id_type* trx_id_ptr)
 { try {
-   transaction_notification note(trx);
+   transaction_notification note = trx_id_ptr != nullptr ? transaction_notification( trx, *trx_id_ptr ) : transaction_notification( trx );
    _current_trx_id = note.transaction_id;
    const transaction_id_type& trx_id = note.transaction_id;
    _current_virtual_op = 0;
@@ -3306,12 +3381,27 @@ void database::_apply_transaction(const signed_transaction& trx)
       auto get_owner   = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).owner );  };
       auto get_posting = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).posting );  };
 
+      uint32_t max_membership = has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_AUTHORITY_MEMBERSHIP : 0;
+      uint32_t max_account_auths = has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_SIG_CHECK_ACCOUNTS : 0;
+      fc::ecc::canonical_signature_type canon_type = has_hardfork( STEEM_HARDFORK_0_20__1944 ) ? fc::ecc::bip_0062 : fc::ecc::fc_canonical;
+      flat_set< public_key_type > recovered_keys;
+
       try
       {
-         trx.verify_authority( chain_id, get_active, get_owner, get_posting, STEEM_MAX_SIG_CHECK_DEPTH,
-            has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_AUTHORITY_MEMBERSHIP : 0,
-            has_hardfork( STEEM_HARDFORK_0_20 ) || is_producing() ? STEEM_MAX_SIG_CHECK_ACCOUNTS : 0,
-            has_hardfork( STEEM_HARDFORK_0_20__1944 ) ? fc::ecc::bip_0062 : fc::ecc::fc_canonical );
+         if( _signature_key_cache.find( trx_id, trx, canon_type, recovered_keys ) )
+         {
+            try
+            {
+               protocol::verify_authority( trx.operations, recovered_keys, get_active, get_owner, get_posting,
+                  STEEM_MAX_SIG_CHECK_DEPTH, max_membership, max_account_auths );
+            }
+            FC_CAPTURE_AND_RETHROW( (trx) )
+         }
+         else
+         {
+            trx.verify_authority( chain_id, get_active, get_owner, get_posting, STEEM_MAX_SIG_CHECK_DEPTH,
+               max_membership, max_account_auths, canon_type );
+         }
       }
       catch( protocol::tx_missing_active_auth& e )
       {
@@ -3690,7 +3780,7 @@ void database::create_block_summary(const signed_block& next_block)
 { try {
    block_summary_id_type sid( next_block.block_num() & 0xffff );
    modify( get< block_summary_object >( sid ), [&](block_summary_object& p) {
-         p.block_id = next_block.id();
+         p.block_id = *_currently_processing_block_id;
    });
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -1,6 +1,7 @@
 #pragma once
 #include <fc/filesystem.hpp>
 #include <steem/protocol/block.hpp>
+#include <steem/chain/block_log_compression.hpp>
 
 namespace steem { namespace chain {
 
@@ -31,6 +32,16 @@ namespace steem { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * Reads are served from read only memory mappings of both files and do not take the lock. Appends are
+    * flushed and then published by storing the new head block number, so a reader never sees a block
+    * that is only partially written. Only appends, flush and head() are serialized by the lock.
+    *
+    * A log opened with open_read_only() follows a log that another process appends to. It never writes
+    * and picks up appended blocks from the file sizes when a read asks for a block past its head.
+    *
+    * The layout above is format v1. A log created with compression enabled uses format v2, which stores
+    * each block compressed and keeps the same O(1) index. See block_log_compression.hpp.
     */
 
    class block_log {
@@ -39,6 +50,7 @@ namespace steem { namespace chain {
          ~block_log();
 
          void open( const fc::path& file );
+         void open_read_only( const fc::path& file );
          void close();
          bool is_open()const;
 
@@ -54,19 +66,33 @@ namespace steem { namespace chain {
          signed_block read_head()const;
          const optional< signed_block >& head()const;
 
+         /**
+          * Number of the last block visible to readers, 0 if the log is empty. Lock free.
+          */
+         uint32_t head_block_num()const;
+
          /*
           * Used by the database to skip locking when reindexing
           * APIs don't work at this point, so there is no danger.
           */
          void set_locking( bool );
 
+         /**
+          * Compress blocks appended by this instance. Must be called before open(). A new log is created
+          * in the compressed (v2) format; an existing v1 log stays uncompressed.
+          */
+         void set_compression( block_log_compression c, int level = 0 );
+
+         /// 1 for the raw format, 2 for the compressed format
+         uint32_t get_format_version()const;
+
          static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
       private:
          void construct_index();
 
-         std::pair< signed_block, uint64_t > read_block_helper( uint64_t file_pos )const;
-         uint64_t get_block_pos_helper( uint32_t block_num ) const;
+         std::pair< signed_block, uint64_t > read_block_helper( uint64_t file_pos, uint64_t log_size )const;
+         uint64_t get_block_pos_helper( uint32_t block_num, uint32_t head_num ) const;
 
          std::unique_ptr<detail::block_log_impl> my;
    };
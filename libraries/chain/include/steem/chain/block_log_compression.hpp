@@ -0,0 +1,74 @@
+#pragma once
+#include <steem/protocol/block.hpp>
+
+#include <vector>
+
+namespace steem { namespace chain {
+
+   using namespace steem::protocol;
+
+   enum block_log_compression : uint8_t
+   {
+      no_compression    = 0,
+      zstd_compression  = 1,
+      lz4_compression   = 2
+   };
+
+   /* Layout of the v2 (compressed) block log.
+    *
+    * A v2 log starts with a 16 byte file header holding the magic "STEEMBL2" and the format version.
+    * v1 logs have no header. They start with block 1, whose previous id is all zeros, so the two
+    * formats cannot be confused.
+    *
+    * +-------------+---------------+--------------------+-------------+---------------+-----+
+    * | File Header | Entry Header  | Compressed Block 1 | Index Entry | Entry Header  | ... |
+    * +-------------+---------------+--------------------+-------------+---------------+-----+
+    *
+    * Each block is preceded by an entry header with its stored size, uncompressed size and codec,
+    * and is followed by its 8 byte index entry so the log can still be walked in either direction.
+    * An index entry is the position of the block with the codec in the top byte. The .index file
+    * holds the same entries, so random access by block number stays O(1).
+    */
+   namespace block_log_format
+   {
+      const uint64_t v2_header_size = 16;
+      const uint32_t flag_shift = 56;
+      const uint64_t position_mask = ( uint64_t(1) << flag_shift ) - 1;
+
+      struct entry_header
+      {
+         uint32_t stored_size = 0;
+         uint32_t raw_size = 0;
+         uint8_t  compression = no_compression;
+         uint8_t  reserved[3] = { 0, 0, 0 };
+      };
+      static_assert( sizeof( entry_header ) == 12, "block_log entry header must be packed" );
+
+      inline uint64_t position( uint64_t index_entry ) { return index_entry & position_mask; }
+      inline block_log_compression compression( uint64_t index_entry ) { return block_log_compression( index_entry >> flag_shift ); }
+      inline uint64_t make_index_entry( uint64_t pos, block_log_compression c ) { return pos | ( uint64_t( c ) << flag_shift ); }
+
+      /// Writes the v2 file header into out, which must hold v2_header_size bytes
+      void write_file_header( char* out );
+
+      /// Returns 2 if data starts with a v2 file header, 1 otherwise
+      uint32_t detect_version( const char* data, uint64_t size );
+
+      bool is_supported( block_log_compression c );
+      block_log_compression from_string( const std::string& name );
+      std::string to_string( block_log_compression c );
+
+      /**
+       * Compresses a packed block. Falls back to storing the block uncompressed when the codec does
+       * not make it smaller. Returns the codec that was actually used.
+       */
+      block_log_compression compress( block_log_compression c, int level, const std::vector< char >& raw, std::vector< char >& out );
+
+      /**
+       * Unpacks the v2 entry starting at data into b, decompressing through buffer so callers can reuse
+       * its allocation. Returns the size of the entry excluding the trailing index entry.
+       */
+      uint64_t unpack_entry( const char* data, uint64_t size, signed_block& b, std::vector< char >& buffer );
+   }
+
+} } // steem::chain
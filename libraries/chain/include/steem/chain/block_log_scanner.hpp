@@ -0,0 +1,98 @@
+#pragma once
+#include <fc/filesystem.hpp>
+#include <steem/protocol/block.hpp>
+
+#include <functional>
+#include <memory>
+
+namespace steem { namespace chain {
+
+   using namespace steem::protocol;
+
+   namespace detail { class block_log_scanner_impl; }
+
+   /**
+    * Callbacks of a block log scan. Unset callbacks are skipped, transaction ids are only computed
+    * when on_transaction is set.
+    *
+    * thread is the index of the scan thread making the call, in [0, threads). Visitors can keep one
+    * accumulator per thread and merge them after the scan instead of synchronizing every call. With
+    * ordered delivery all calls are made from the thread calling scan() and thread is always 0.
+    */
+   struct block_log_scan_visitor
+   {
+      std::function< void( uint32_t thread, uint32_t block_num, const signed_block& block ) > on_block;
+      std::function< void( uint32_t thread, uint32_t block_num, uint32_t trx_in_block,
+         const transaction_id_type& id, const signed_transaction& trx ) > on_transaction;
+      std::function< void( uint32_t thread, uint32_t block_num, uint32_t trx_in_block,
+         uint32_t op_in_trx, const operation& op ) > on_operation;
+   };
+
+   /* Reads a block log on several threads to build offline indexes and statistics.
+    *
+    * The log and its index are memory mapped read only. The range of blocks is split into chunks of
+    * consecutive blocks, whose bounds come from the index. Each thread takes the next chunk and reads
+    * it sequentially, so the device sees several sequential streams at once and the kernel read ahead
+    * works for each of them. Both the raw (v1) and the compressed (v2) formats are supported.
+    *
+    * With unordered delivery the callbacks run on the scan threads as blocks are decoded, blocks of
+    * one chunk in order but chunks in any order. With ordered delivery the scan threads decode whole
+    * chunks ahead and the callbacks run on the calling thread strictly in block order, at most
+    * max_pending_chunks chunks ahead of the visitor.
+    *
+    * An exception thrown while decoding or by a callback stops the scan and is rethrown by scan().
+    * The block log must not be appended to during a scan.
+    */
+   class block_log_scanner
+   {
+      public:
+         enum delivery_mode
+         {
+            unordered,
+            ordered
+         };
+
+         struct scan_options
+         {
+            uint32_t       first_block = 1;
+            uint32_t       last_block = 0;            ///< 0 scans to the head of the log
+            uint32_t       threads = 0;               ///< 0 uses one thread per core
+            uint32_t       chunk_blocks = 10000;
+            delivery_mode  delivery = unordered;
+            uint32_t       max_pending_chunks = 0;    ///< Ordered delivery only, 0 is twice the threads
+         };
+
+         struct scan_stats
+         {
+            uint64_t blocks = 0;
+            uint64_t transactions = 0;
+            uint64_t operations = 0;
+            uint64_t bytes = 0;                       ///< Size of the scanned blocks in the log
+            uint32_t chunks = 0;
+            uint32_t threads = 0;
+            uint64_t elapsed_us = 0;
+
+            double mb_per_sec()const { return elapsed_us ? double( bytes ) / elapsed_us : 0.0; }
+            double blocks_per_sec()const { return elapsed_us ? double( blocks ) * 1000000.0 / elapsed_us : 0.0; }
+         };
+
+         block_log_scanner( const fc::path& block_log_file );
+         ~block_log_scanner();
+
+         /// Number of blocks in the index of the log
+         uint32_t head_block_num()const;
+
+         /// 1 for the raw format, 2 for the compressed format
+         uint32_t get_format_version()const;
+
+         scan_stats scan( const scan_options& options, const block_log_scan_visitor& visitor )const;
+
+      private:
+         std::unique_ptr< detail::block_log_scanner_impl > my;
+   };
+
+} }
+
+FC_REFLECT_ENUM( steem::chain::block_log_scanner::delivery_mode, (unordered)(ordered) )
+FC_REFLECT( steem::chain::block_log_scanner::scan_options, (first_block)(last_block)(threads)(chunk_blocks)(delivery)(max_pending_chunks) )
+FC_REFLECT( steem::chain::block_log_scanner::scan_stats, (blocks)(transactions)(operations)(bytes)(chunks)(threads)(elapsed_us) )
@@ -8,6 +8,8 @@
 #include <steem/chain/hardfork_property_object.hpp>
 #include <steem/chain/node_property_object.hpp>
 #include <steem/chain/notifications.hpp>
+#include <steem/chain/replay_pipeline.hpp>
+#include <steem/chain/signature_key_cache.hpp>
 
 #include <steem/chain/util/advanced_benchmark_dumper.hpp>
 #include <steem/chain/util/signal.hpp>
@@ -105,12 +107,17 @@ namespace steem { namespace chain {
             uint64_t shared_file_size = 0;
             uint16_t shared_file_full_threshold = 0;
             uint16_t shared_file_scale_rate = 0;
-            uint32_t chainbase_flags = 0;
+            uint32_t chainbase_flags = 0;       ///< chainbase::database::read_only attaches to the state of another node
             bool do_validate_invariants = false;
             bool benchmark_is_enabled = false;
+            block_log_compression block_log_codec = no_compression; ///< Only applies when a new block log is created
+            int block_log_compression_level = 0;
+            fc::path snapshot_file;             ///< Initializes an empty database from this state snapshot instead of genesis
+            uint32_t snapshot_threads = 1;
 
             // The following fields are only used on reindexing
             uint32_t stop_replay_at = 0;
+            uint32_t replay_decode_threads = 0; ///< 0 reads and decodes blocks on the apply thread
             TBenchmark benchmark = TBenchmark(0, []( uint32_t, const abstract_index_cntr_t& ){});
          };
 
@@ -160,6 +167,9 @@ namespace steem { namespace chain {
          const signed_transaction   get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
+         /// Irreversible blocks. Reads from the block log are lock free and do not require the database lock.
+         const block_log&           get_block_log()const { return _block_log; }
+
          chain_id_type steem_chain_id = STEEM_CHAIN_ID;
          chain_id_type get_chain_id() const;
          void set_chain_id( const chain_id_type& chain_id );
@@ -480,6 +490,12 @@ namespace steem { namespace chain {
 
          optional< chainbase::database::session >& pending_transaction_session();
 
+         /**
+          * Signing keys recovered ahead of apply, see signature_key_cache. Safe to use
+          * from any thread without holding a database lock.
+          */
+         signature_key_cache& get_signature_key_cache() { return _signature_key_cache; }
+
 #ifdef IS_TEST_NET
          bool liquidity_rewards_enabled = true;
          bool skip_price_feed_limit_check = true;
@@ -502,9 +518,9 @@ namespace steem { namespace chain {
       private:
          optional< chainbase::database::session > _pending_tx_session;
 
-         void apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
-         void _apply_block( const signed_block& next_block );
-         void _apply_transaction( const signed_transaction& trx );
+         void apply_block( const signed_block& next_block, uint32_t skip = skip_nothing, const precomputed_block_ids* ids = nullptr );
+         void _apply_block( const signed_block& next_block, const precomputed_block_ids* ids = nullptr );
+         void _apply_transaction( const signed_transaction& trx, const transaction_id_type* trx_id = nullptr );
          void apply_operation( const operation& op );
 
          void process_required_actions( const required_automated_actions& actions );
@@ -561,6 +577,8 @@ namespace steem { namespace chain {
 
          block_log                     _block_log;
 
+         signature_key_cache           _signature_key_cache;
+
          // this function needs access to _plugin_index_signal
          template< typename MultiIndexType >
          friend void add_plugin_index( database& db );
@@ -5,6 +5,10 @@
 #include <steem/chain/schema_types.hpp>
 
 #include <steem/chain/database.hpp>
+#include <steem/chain/state_snapshot.hpp>
+
+#include <fc/io/datastream.hpp>
+#include <fc/io/raw.hpp>
 
 namespace steem { namespace chain {
 
@@ -16,6 +20,13 @@ struct index_info
    index_info();
    virtual ~index_info();
    virtual std::shared_ptr< abstract_schema > get_schema() = 0;
+
+   /// Number of bytes dump_snapshot() writes
+   virtual uint64_t snapshot_size( const database& db ) = 0;
+   virtual void     dump_snapshot( const database& db, snapshot_writer& out ) = 0;
+
+   /// Recreates count objects with their original ids. The index must be empty.
+   virtual void     load_snapshot( database& db, fc::datastream< const char* >& in, uint64_t count ) = 0;
 };
 
 template< typename MultiIndexType >
@@ -31,6 +42,53 @@ struct index_info_impl
    virtual std::shared_ptr< abstract_schema > get_schema() override
    {   return _schema;   }
 
+   virtual uint64_t snapshot_size( const database& db ) override
+   {
+      fc::datastream< size_t > ds;
+      dump_objects( db, ds );
+      return ds.tellp();
+   }
+
+   virtual void dump_snapshot( const database& db, snapshot_writer& out ) override
+   {
+      dump_objects( db, out );
+   }
+
+   virtual void load_snapshot( database& db, fc::datastream< const char* >& in, uint64_t count ) override
+   {
+      auto& idx = db.get_mutable_index< MultiIndexType >();
+      FC_ASSERT( idx.indices().size() == 0, "Cannot load a snapshot into a non-empty index" );
+
+      typename value_type::id_type next_id;
+      typename value_type::id_type id;
+      fc::raw::unpack( in, next_id );
+
+      idx.reserve( count );
+      for( uint64_t i = 0; i < count; ++i )
+      {
+         fc::raw::unpack( in, id );
+         idx.bulk_restore( id, [&]( value_type& o )
+         {
+            fc::raw::unpack( in, o );
+         });
+      }
+
+      idx.set_next_id( next_id );
+   }
+
+   template< typename Stream >
+   void dump_objects( const database& db, Stream& s )
+   {
+      const auto& idx = db.get_index< MultiIndexType >();
+      fc::raw::pack( s, idx.next_id() );
+
+      for( const auto& o : idx.indices() )
+      {
+         fc::raw::pack( s, o.id );
+         fc::raw::pack( s, o );
+      }
+   }
+
    std::shared_ptr< abstract_schema > _schema;
 };
 
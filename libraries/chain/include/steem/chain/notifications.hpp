@@ -12,6 +12,12 @@ struct block_notification
       block_num = block_header::num_from_id( block_id );
    }
 
+   block_notification( const steem::protocol::signed_block& b, const steem::protocol::block_id_type& id ) :
+      block_id(id), block(b)
+   {
+      block_num = block_header::num_from_id( block_id );
+   }
+
    steem::protocol::block_id_type          block_id;
    uint32_t                                block_num = 0;
    const steem::protocol::signed_block&    block;
@@ -24,6 +30,9 @@ struct transaction_notification
       transaction_id = tx.id();
    }
 
+   transaction_notification( const steem::protocol::signed_transaction& tx, const steem::protocol::transaction_id_type& id ) :
+      transaction_id(id), transaction(tx) {}
+
    steem::protocol::transaction_id_type          transaction_id;
    const steem::protocol::signed_transaction&    transaction;
 };
@@ -0,0 +1,88 @@
+#pragma once
+#include <fc/filesystem.hpp>
+#include <steem/protocol/block.hpp>
+
+#include <memory>
+
+namespace steem { namespace chain {
+
+   using namespace steem::protocol;
+
+   namespace detail { class replay_pipeline_impl; }
+
+   /**
+    * Identifiers of a block and its transactions computed ahead of block application.
+    * When passed to database::apply_block() they are used instead of hashing the
+    * block header and every transaction again on the apply thread.
+    */
+   struct precomputed_block_ids
+   {
+      block_id_type                    block_id;
+      vector< transaction_id_type >    transaction_ids;
+   };
+
+   struct replay_block
+   {
+      signed_block            block;
+      precomputed_block_ids   ids;
+   };
+
+   /* The replay pipeline feeds blocks from the block log to the thread applying them during reindex.
+    *
+    *   reader  -->  decoders (N threads)  -->  ring of decoded blocks  -->  apply thread
+    *
+    * The block log and its index are memory mapped. The reader stage walks the index ahead of the
+    * decoders and faults in the pages of upcoming blocks so decoders do not stall on IO. Decoders
+    * unpack signed_block and compute the block and transaction ids, neither of which touch chain
+    * state. Decoded blocks are placed in a bounded ring keyed by block number so the apply thread
+    * consumes them strictly in order while decoders run at most ring_size blocks ahead.
+    *
+    * The block log must not be appended to while a pipeline is open on it.
+    */
+   class replay_pipeline
+   {
+      public:
+         struct stage_stats
+         {
+            uint64_t blocks = 0;
+            uint64_t busy_us = 0;   ///< Summed over all threads of the stage
+
+            double blocks_per_sec()const { return busy_us ? double( blocks ) * 1000000.0 / busy_us : 0.0; }
+         };
+
+         struct stats
+         {
+            stage_stats read;
+            stage_stats decode;
+            uint64_t    apply_wait_us = 0;   ///< Time the consumer spent waiting on decoders
+            uint64_t    elapsed_us = 0;
+            uint32_t    decode_threads = 0;
+         };
+
+         replay_pipeline( const fc::path& block_log_file, uint32_t first_block, uint32_t last_block,
+            uint32_t decode_threads, uint32_t ring_size = 1024 );
+         ~replay_pipeline();
+
+         /**
+          * Returns the next block in order, waiting for it to be decoded if necessary. The returned
+          * reference is valid until the following call. Exceptions raised while decoding are rethrown
+          * here, on the consumer thread, for the block that caused them.
+          */
+         const replay_block& next();
+
+         bool done()const;
+
+         /// Stops all pipeline threads. Called by the destructor.
+         void stop();
+
+         stats get_stats()const;
+
+      private:
+         std::unique_ptr< detail::replay_pipeline_impl > my;
+   };
+
+} }
+
+FC_REFLECT( steem::chain::precomputed_block_ids, (block_id)(transaction_ids) )
+FC_REFLECT( steem::chain::replay_pipeline::stage_stats, (blocks)(busy_us) )
+FC_REFLECT( steem::chain::replay_pipeline::stats, (read)(decode)(apply_wait_us)(elapsed_us)(decode_threads) )
@@ -0,0 +1,59 @@
+#pragma once
+#include <steem/protocol/transaction.hpp>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace steem { namespace chain {
+
+   using namespace steem::protocol;
+
+   /**
+    * Holds signing keys recovered from transaction signatures before the transaction is applied.
+    *
+    * Public key recovery is pure secp256k1 work that does not depend on chain state, so it can be
+    * done on other threads before a block or transaction reaches the write queue. database uses
+    * the cached keys when checking authority instead of recovering them under the write lock.
+    *
+    * Keys are recovered without a canonicality check because the required canonical form depends
+    * on the hardfork in effect when the transaction is applied. find() checks the signatures against
+    * the canonical form requested by the caller and misses on any mismatch, leaving the uncached
+    * path to report the error.
+    *
+    * The cache holds at most max_entries transactions and evicts the oldest first. All methods are
+    * thread safe.
+    */
+   class signature_key_cache
+   {
+      public:
+         signature_key_cache( size_t max_entries = 65536 ) : _max_entries( max_entries ) {}
+
+         /**
+          * Recover and store the signing keys of trx. Nothing is stored when a signature cannot be
+          * recovered or two signatures recover to the same key.
+          *
+          * @return true if keys were stored or were already present
+          */
+         bool recover( const signed_transaction& trx, const chain_id_type& chain_id );
+
+         bool find( const transaction_id_type& trx_id, const signed_transaction& trx,
+            canonical_signature_type canon_type, flat_set< public_key_type >& keys )const;
+
+         size_t size()const;
+         void   clear();
+
+      private:
+         struct entry
+         {
+            vector< signature_type >      signatures;
+            flat_set< public_key_type >   keys;
+         };
+
+         const size_t                                          _max_entries;
+         mutable std::mutex                                    _mutex;
+         std::unordered_map< transaction_id_type, entry >      _entries;
+         std::deque< transaction_id_type >                     _insertion_order;
+   };
+
+} } // steem::chain
@@ -0,0 +1,91 @@
+#pragma once
+#include <steem/protocol/types.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/filesystem.hpp>
+
+#include <fstream>
+#include <vector>
+
+namespace steem { namespace chain {
+
+   using namespace steem::protocol;
+
+   class database;
+
+   /* A state snapshot holds every chainbase index of a database, core and plugin, in a portable form.
+    *
+    * +-------+-----------+-----------+-----+----------+---------------+-------------------+
+    * | Magic | Section 1 | Section 2 | ... | Manifest | Manifest Size | Manifest Checksum |
+    * +-------+-----------+-----------+-----+----------+---------------+-------------------+
+    *
+    * Each section is one index: its next object id followed by the id and fc::raw serialization of
+    * every object in id order. The manifest lists the sections by schema name with their offsets,
+    * object counts and sha256 checksums, along with the chain id and head block of the state.
+    *
+    * Indexes are dumped and loaded in parallel, one index per thread at a time. A snapshot can only be
+    * loaded into an empty database with the same set of indexes and by a node whose block log contains
+    * the snapshot head block.
+    */
+   struct snapshot_section
+   {
+      std::string    name;
+      uint64_t       object_count = 0;
+      uint64_t       offset = 0;
+      uint64_t       size = 0;
+      fc::sha256     checksum;
+   };
+
+   struct snapshot_manifest
+   {
+      uint32_t                         version = 0;
+      chain_id_type                    chain_id;
+      uint32_t                         head_block_num = 0;
+      block_id_type                    head_block_id;
+      std::vector< snapshot_section >  sections;
+   };
+
+   /**
+    * Buffered output stream for fc::raw that writes one section of a snapshot and hashes it.
+    */
+   class snapshot_writer
+   {
+      public:
+         snapshot_writer( const fc::path& file, uint64_t offset );
+         ~snapshot_writer();
+
+         bool write( const char* data, size_t size );
+         bool put( char c ) { return write( &c, 1 ); }
+
+         /// Flushes the stream and returns the checksum of everything written
+         fc::sha256 finish();
+         uint64_t   written()const { return _written; }
+
+      private:
+         void flush_buffer();
+
+         std::ofstream           _stream;
+         fc::sha256::encoder     _encoder;
+         std::vector< char >     _buffer;
+         uint64_t                _written = 0;
+   };
+
+   /**
+    * Writes a snapshot of db to file. The caller must hold the database read lock.
+    *
+    * @return the manifest of the written snapshot
+    */
+   snapshot_manifest dump_state_snapshot( const database& db, const fc::path& file, uint32_t threads );
+
+   /**
+    * Fills the indexes of an empty db from a snapshot and sets the revision to the snapshot head block.
+    * The caller must hold the database write lock.
+    *
+    * @return the manifest of the loaded snapshot
+    */
+   snapshot_manifest load_state_snapshot( database& db, const fc::path& file, uint32_t threads );
+
+} } // steem::chain
+
+FC_REFLECT( steem::chain::snapshot_section, (name)(object_count)(offset)(size)(checksum) )
+FC_REFLECT( steem::chain::snapshot_manifest, (version)(chain_id)(head_block_num)(head_block_id)(sections) )
@@ -0,0 +1,293 @@
+#include <steem/chain/replay_pipeline.hpp>
+#include <steem/chain/block_log_compression.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/io/datastream.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace steem { namespace chain {
+
+   namespace bip = boost::interprocess;
+
+   namespace detail {
+
+      struct replay_slot
+      {
+         replay_block                     data;
+         uint32_t                         block_num = 0;
+         bool                             ready = false;
+         fc::optional< fc::exception >    except;
+      };
+
+      class replay_pipeline_impl
+      {
+         public:
+            replay_pipeline_impl( const fc::path& block_log_file, uint32_t first, uint32_t last, uint32_t threads, uint32_t ring ) :
+               first_block( first ), last_block( last ), ring_size( ring ), slots( ring )
+            {
+               fc::path index_file( block_log_file.generic_string() + ".index" );
+
+               block_mapping = bip::file_mapping( block_log_file.generic_string().c_str(), bip::read_only );
+               block_region = bip::mapped_region( block_mapping, bip::read_only );
+               index_mapping = bip::file_mapping( index_file.generic_string().c_str(), bip::read_only );
+               index_region = bip::mapped_region( index_mapping, bip::read_only );
+
+               block_region.advise( bip::mapped_region::advice_sequential );
+
+               block_data = static_cast< const char* >( block_region.get_address() );
+               block_data_size = block_region.get_size();
+               index_data = static_cast< const uint64_t* >( index_region.get_address() );
+               index_entries = index_region.get_size() / sizeof( uint64_t );
+               version = block_log_format::detect_version( block_data, block_data_size );
+
+               FC_ASSERT( first_block > 0 && first_block <= last_block, "Invalid replay range",
+                  ("first", first_block)("last", last_block) );
+               FC_ASSERT( index_entries >= last_block, "Block log index does not cover the replay range",
+                  ("index_entries", index_entries)("last", last_block) );
+               FC_ASSERT( ring_size > 1, "Replay ring must hold at least two blocks" );
+
+               next_read = first_block;
+               next_decode = first_block;
+               next_consume = first_block;
+               start_time = fc::time_point::now();
+
+               reader_thread = std::thread( [this](){ read_loop(); } );
+               for( uint32_t i = 0; i < threads; ++i )
+                  decode_threads.emplace_back( [this](){ decode_loop(); } );
+               stats.decode_threads = threads;
+            }
+
+            /// Returns [begin, end) of the serialized block in the mapped block log
+            std::pair< uint64_t, uint64_t > block_range( uint32_t block_num )const
+            {
+               uint64_t begin = block_log_format::position( index_data[ block_num - 1 ] );
+               uint64_t end = block_num < index_entries ? block_log_format::position( index_data[ block_num ] ) : block_data_size;
+               // Every block is followed by its own 8 byte position
+               FC_ASSERT( begin + sizeof( uint64_t ) <= end && end <= block_data_size, "Corrupt block log index entry",
+                  ("block_num", block_num)("begin", begin)("end", end)("size", block_data_size) );
+               return std::make_pair( begin, end - sizeof( uint64_t ) );
+            }
+
+            void read_loop()
+            {
+               static const uint64_t page_size = bip::mapped_region::get_page_size();
+
+               while( true )
+               {
+                  uint32_t block_num;
+                  {
+                     std::unique_lock< std::mutex > lock( mtx );
+                     // Read ahead of the decoders by up to twice the ring
+                     cv.wait( lock, [&](){ return !running || next_read < next_consume + 2 * ring_size; } );
+                     if( !running || next_read > last_block )
+                        return;
+                     block_num = next_read;
+                  }
+
+                  auto start = fc::time_point::now();
+                  volatile char sink = 0;
+                  try
+                  {
+                     auto range = block_range( block_num );
+                     for( uint64_t p = range.first; p < range.second; p += page_size )
+                        sink += block_data[ p ];
+                     sink += block_data[ range.second - 1 ];
+                  }
+                  catch( ... ) {} // Reported by the decoder of this block
+                  (void)sink;
+
+                  std::lock_guard< std::mutex > lock( mtx );
+                  stats.read.busy_us += ( fc::time_point::now() - start ).count();
+                  ++stats.read.blocks;
+                  ++next_read;
+                  cv.notify_all();
+               }
+            }
+
+            void decode_loop()
+            {
+               std::vector< char > buffer;
+
+               while( true )
+               {
+                  uint32_t block_num;
+                  {
+                     std::unique_lock< std::mutex > lock( mtx );
+                     // The consumer holds the slot of next_consume - 1 until its following call to next()
+                     cv.wait( lock, [&]()
+                     {
+                        return !running || next_decode > last_block
+                           || ( next_decode < next_read && next_decode + 1 < next_consume + ring_size );
+                     });
+                     if( !running || next_decode > last_block )
+                        return;
+                     block_num = next_decode++;
+                  }
+
+                  auto start = fc::time_point::now();
+                  replay_slot& slot = slots[ block_num % ring_size ];
+                  slot.except.reset();
+
+                  try
+                  {
+                     auto range = block_range( block_num );
+                     slot.data.block = signed_block();
+                     if( version == 2 )
+                     {
+                        block_log_format::unpack_entry( block_data + range.first, range.second - range.first, slot.data.block, buffer );
+                     }
+                     else
+                     {
+                        fc::datastream< const char* > ds( block_data + range.first, range.second - range.first );
+                        fc::raw::unpack( ds, slot.data.block );
+                     }
+                     FC_ASSERT( slot.data.block.block_num() == block_num, "Wrong block was read from block log.",
+                        ("returned", slot.data.block.block_num())("expected", block_num) );
+
+                     slot.data.ids.block_id = slot.data.block.id();
+                     slot.data.ids.transaction_ids.clear();
+                     slot.data.ids.transaction_ids.reserve( slot.data.block.transactions.size() );
+                     for( const auto& trx : slot.data.block.transactions )
+                        slot.data.ids.transaction_ids.push_back( trx.id() );
+                  }
+                  catch( const fc::exception& e )
+                  {
+                     slot.except = e;
+                  }
+                  catch( ... )
+                  {
+                     slot.except = fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unexpected exception while decoding block." ),
+                                                            std::current_exception() );
+                  }
+
+                  std::lock_guard< std::mutex > lock( mtx );
+                  stats.decode.busy_us += ( fc::time_point::now() - start ).count();
+                  ++stats.decode.blocks;
+                  slot.block_num = block_num;
+                  slot.ready = true;
+                  cv.notify_all();
+               }
+            }
+
+            const replay_block& next()
+            {
+               std::unique_lock< std::mutex > lock( mtx );
+
+               FC_ASSERT( next_consume <= last_block, "Replay pipeline is exhausted" );
+
+               if( next_consume > first_block )
+                  slots[ ( next_consume - 1 ) % ring_size ].ready = false;
+
+               replay_slot& slot = slots[ next_consume % ring_size ];
+               auto start = fc::time_point::now();
+               cv.notify_all();
+               cv.wait( lock, [&](){ return slot.ready && slot.block_num == next_consume; } );
+               stats.apply_wait_us += ( fc::time_point::now() - start ).count();
+
+               ++next_consume;
+               cv.notify_all();
+
+               if( slot.except )
+                  throw *slot.except;
+
+               return slot.data;
+            }
+
+            void stop()
+            {
+               {
+                  std::lock_guard< std::mutex > lock( mtx );
+                  if( !running )
+                     return;
+                  running = false;
+                  stats.elapsed_us = ( fc::time_point::now() - start_time ).count();
+                  cv.notify_all();
+               }
+
+               if( reader_thread.joinable() )
+                  reader_thread.join();
+               for( auto& t : decode_threads )
+                  t.join();
+               decode_threads.clear();
+            }
+
+            const uint32_t                first_block;
+            const uint32_t                last_block;
+            const uint32_t                ring_size;
+
+            bip::file_mapping             block_mapping;
+            bip::mapped_region            block_region;
+            bip::file_mapping             index_mapping;
+            bip::mapped_region            index_region;
+            const char*                   block_data = nullptr;
+            uint64_t                      block_data_size = 0;
+            const uint64_t*               index_data = nullptr;
+            uint64_t                      index_entries = 0;
+            uint32_t                      version = 1;
+
+            std::vector< replay_slot >    slots;
+
+            mutable std::mutex            mtx;
+            std::condition_variable       cv;
+            bool                          running = true;
+            uint32_t                      next_read = 0;
+            uint32_t                      next_decode = 0;
+            uint32_t                      next_consume = 0;
+
+            std::thread                   reader_thread;
+            std::vector< std::thread >    decode_threads;
+
+            fc::time_point                start_time;
+            replay_pipeline::stats        stats;
+      };
+
+   } // detail
+
+   replay_pipeline::replay_pipeline( const fc::path& block_log_file, uint32_t first_block, uint32_t last_block,
+      uint32_t decode_threads, uint32_t ring_size )
+   {
+      try
+      {
+         FC_ASSERT( decode_threads > 0, "Replay pipeline requires at least one decode thread" );
+         my.reset( new detail::replay_pipeline_impl( block_log_file, first_block, last_block, decode_threads, ring_size ) );
+      }
+      FC_CAPTURE_AND_RETHROW( (block_log_file)(first_block)(last_block)(decode_threads)(ring_size) )
+   }
+
+   replay_pipeline::~replay_pipeline()
+   {
+      stop();
+   }
+
+   const replay_block& replay_pipeline::next()
+   {
+      return my->next();
+   }
+
+   bool replay_pipeline::done()const
+   {
+      std::lock_guard< std::mutex > lock( my->mtx );
+      return my->next_consume > my->last_block;
+   }
+
+   void replay_pipeline::stop()
+   {
+      my->stop();
+   }
+
+   replay_pipeline::stats replay_pipeline::get_stats()const
+   {
+      std::lock_guard< std::mutex > lock( my->mtx );
+      auto result = my->stats;
+      if( my->running )
+         result.elapsed_us = ( fc::time_point::now() - my->start_time ).count();
+      return result;
+   }
+
+} } // steem::chain
@@ -0,0 +1,88 @@
+#include <steem/chain/signature_key_cache.hpp>
+
+namespace steem { namespace chain {
+
+bool signature_key_cache::recover( const signed_transaction& trx, const chain_id_type& chain_id )
+{
+   auto trx_id = trx.id();
+
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      auto itr = _entries.find( trx_id );
+      if( itr != _entries.end() && itr->second.signatures == trx.signatures )
+         return true;
+   }
+
+   entry e;
+   e.signatures = trx.signatures;
+
+   try
+   {
+      auto d = trx.sig_digest( chain_id );
+      for( const auto& sig : trx.signatures )
+      {
+         if( !e.keys.insert( fc::ecc::public_key( sig, d, fc::ecc::non_canonical ) ).second )
+            return false;
+      }
+   }
+   catch( const fc::exception& )
+   {
+      return false;
+   }
+
+   std::lock_guard< std::mutex > lock( _mutex );
+   auto itr = _entries.find( trx_id );
+
+   if( itr != _entries.end() )
+   {
+      // Same transaction id with different signatures, keep the latest
+      itr->second = std::move( e );
+      return true;
+   }
+
+   _entries.emplace( trx_id, std::move( e ) );
+   _insertion_order.push_back( trx_id );
+   while( _insertion_order.size() > _max_entries )
+   {
+      _entries.erase( _insertion_order.front() );
+      _insertion_order.pop_front();
+   }
+
+   return true;
+}
+
+bool signature_key_cache::find( const transaction_id_type& trx_id, const signed_transaction& trx,
+   canonical_signature_type canon_type, flat_set< public_key_type >& keys )const
+{
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      auto itr = _entries.find( trx_id );
+      if( itr == _entries.end() || itr->second.signatures != trx.signatures )
+         return false;
+
+      keys = itr->second.keys;
+   }
+
+   for( const auto& sig : trx.signatures )
+   {
+      if( !fc::ecc::public_key::is_canonical( sig, canon_type ) )
+         return false;
+   }
+
+   return true;
+}
+
+size_t signature_key_cache::size()const
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   return _entries.size();
+}
+
+void signature_key_cache::clear()
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   _entries.clear();
+   _insertion_order.clear();
+}
+
+} } // steem::chain
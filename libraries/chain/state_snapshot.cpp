@@ -0,0 +1,325 @@
+#include <steem/chain/state_snapshot.hpp>
+#include <steem/chain/database.hpp>
+#include <steem/chain/index.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#define STEEM_SNAPSHOT_VERSION 1
+#define SNAPSHOT_WRITE_BUFFER_SIZE ( 1 << 20 )
+
+namespace steem { namespace chain {
+
+   namespace bip = boost::interprocess;
+
+   namespace detail {
+
+      static const char     snapshot_magic[8] = { 'S', 'T', 'E', 'E', 'M', 'S', 'N', 'P' };
+      static const uint64_t snapshot_trailer_size = sizeof( uint64_t ) + sizeof( fc::sha256 );
+
+      struct snapshot_index
+      {
+         std::string                         name;
+         std::shared_ptr< index_info >       info;
+         const chainbase::abstract_index*    index;
+      };
+
+      std::vector< snapshot_index > get_snapshot_indexes( const database& db )
+      {
+         std::vector< snapshot_index > result;
+
+         for( const auto* idx : db.get_abstract_index_cntr() )
+         {
+            std::shared_ptr< index_info > info;
+            for( const auto& ext : idx->get_index_extensions() )
+            {
+               info = std::dynamic_pointer_cast< index_info >( ext );
+               if( info )
+                  break;
+            }
+
+            FC_ASSERT( info, "Index with type id ${t} was not added with add_core_index or add_plugin_index and cannot be snapshotted",
+               ("t", idx->type_id()) );
+
+            snapshot_index entry;
+            info->get_schema()->get_name( entry.name );
+            entry.info = info;
+            entry.index = idx;
+            result.push_back( entry );
+         }
+
+         return result;
+      }
+
+      fc::sha256 hash_region( const char* data, uint64_t size )
+      {
+         fc::sha256::encoder enc;
+         while( size > 0 )
+         {
+            uint32_t chunk = uint32_t( std::min< uint64_t >( size, uint64_t(1) << 30 ) );
+            enc.write( data, chunk );
+            data += chunk;
+            size -= chunk;
+         }
+         return enc.result();
+      }
+
+      /// Calls work( i ) for every i in [0, count) from up to threads threads and rethrows the first failure
+      void run_parallel( uint32_t count, uint32_t threads, const std::function< void( uint32_t ) >& work )
+      {
+         std::atomic< uint32_t >          next( 0 );
+         std::atomic< bool >              failed( false );
+         std::mutex                       mtx;
+         fc::optional< fc::exception >    except;
+
+         auto worker = [&]()
+         {
+            while( !failed )
+            {
+               uint32_t i = next++;
+               if( i >= count )
+                  return;
+
+               try
+               {
+                  work( i );
+               }
+               catch( const fc::exception& e )
+               {
+                  std::lock_guard< std::mutex > lock( mtx );
+                  if( !except )
+                     except = e;
+                  failed = true;
+               }
+               catch( ... )
+               {
+                  std::lock_guard< std::mutex > lock( mtx );
+                  if( !except )
+                     except = fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unexpected exception processing snapshot index." ),
+                                                       std::current_exception() );
+                  failed = true;
+               }
+            }
+         };
+
+         std::vector< std::thread > pool;
+         for( uint32_t t = 1; t < std::min( threads, count ); ++t )
+            pool.emplace_back( worker );
+
+         worker();
+
+         for( auto& t : pool )
+            t.join();
+
+         if( except )
+            throw *except;
+      }
+
+   } // detail
+
+   snapshot_writer::snapshot_writer( const fc::path& file, uint64_t offset )
+   {
+      _stream.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+      // Open for update so other sections of the file are preserved
+      _stream.open( file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary );
+      _stream.seekp( offset );
+      _buffer.reserve( SNAPSHOT_WRITE_BUFFER_SIZE );
+   }
+
+   snapshot_writer::~snapshot_writer() {}
+
+   bool snapshot_writer::write( const char* data, size_t size )
+   {
+      if( _buffer.size() + size > SNAPSHOT_WRITE_BUFFER_SIZE )
+         flush_buffer();
+
+      if( size > SNAPSHOT_WRITE_BUFFER_SIZE )
+      {
+         _encoder.write( data, size );
+         _stream.write( data, size );
+      }
+      else
+      {
+         _buffer.insert( _buffer.end(), data, data + size );
+      }
+
+      _written += size;
+      return true;
+   }
+
+   void snapshot_writer::flush_buffer()
+   {
+      if( _buffer.empty() )
+         return;
+
+      _encoder.write( _buffer.data(), _buffer.size() );
+      _stream.write( _buffer.data(), _buffer.size() );
+      _buffer.clear();
+   }
+
+   fc::sha256 snapshot_writer::finish()
+   {
+      flush_buffer();
+      _stream.flush();
+      return _encoder.result();
+   }
+
+   snapshot_manifest dump_state_snapshot( const database& db, const fc::path& file, uint32_t threads )
+   {
+      try
+      {
+         auto start = fc::time_point::now();
+         auto indexes = detail::get_snapshot_indexes( db );
+
+         snapshot_manifest manifest;
+         manifest.version = STEEM_SNAPSHOT_VERSION;
+         manifest.chain_id = db.get_chain_id();
+         manifest.head_block_num = db.head_block_num();
+         manifest.head_block_id = db.head_block_id();
+         manifest.sections.resize( indexes.size() );
+
+         // Sizing the sections first lets every index be written straight to its place in the file
+         detail::run_parallel( indexes.size(), threads, [&]( uint32_t i )
+         {
+            auto& section = manifest.sections[i];
+            section.name = indexes[i].name;
+            section.object_count = indexes[i].index->size();
+            section.size = indexes[i].info->snapshot_size( db );
+         });
+
+         uint64_t offset = sizeof( detail::snapshot_magic );
+         for( auto& section : manifest.sections )
+         {
+            section.offset = offset;
+            offset += section.size;
+         }
+
+         {
+            std::ofstream out;
+            out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+            out.open( file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+            out.write( detail::snapshot_magic, sizeof( detail::snapshot_magic ) );
+         }
+         fc::resize_file( file, offset );
+
+         detail::run_parallel( indexes.size(), threads, [&]( uint32_t i )
+         {
+            auto& section = manifest.sections[i];
+            snapshot_writer writer( file, section.offset );
+            indexes[i].info->dump_snapshot( db, writer );
+            section.checksum = writer.finish();
+            FC_ASSERT( writer.written() == section.size, "Index ${n} changed while the snapshot was written", ("n", section.name) );
+         });
+
+         auto manifest_data = fc::raw::pack_to_vector( manifest );
+         uint64_t manifest_size = manifest_data.size();
+         fc::sha256 manifest_checksum = fc::sha256::hash( manifest_data.data(), manifest_data.size() );
+
+         std::ofstream out;
+         out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+         out.open( file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary );
+         out.seekp( offset );
+         out.write( manifest_data.data(), manifest_data.size() );
+         out.write( (const char*)&manifest_size, sizeof( manifest_size ) );
+         out.write( manifest_checksum.data(), sizeof( manifest_checksum ) );
+         out.close();
+
+         ilog( "Wrote snapshot of ${n} indexes at block ${b} to ${f} in ${t} ms",
+            ("n", indexes.size())("b", manifest.head_block_num)("f", file)("t", ( fc::time_point::now() - start ).count() / 1000) );
+
+         return manifest;
+      }
+      FC_CAPTURE_AND_RETHROW( (file)(threads) )
+   }
+
+   snapshot_manifest load_state_snapshot( database& db, const fc::path& file, uint32_t threads )
+   {
+      try
+      {
+         auto start = fc::time_point::now();
+
+         bip::file_mapping mapping( file.generic_string().c_str(), bip::read_only );
+         bip::mapped_region region( mapping, bip::read_only );
+         const char* data = static_cast< const char* >( region.get_address() );
+         uint64_t size = region.get_size();
+
+         FC_ASSERT( size >= sizeof( detail::snapshot_magic ) + detail::snapshot_trailer_size
+            && memcmp( data, detail::snapshot_magic, sizeof( detail::snapshot_magic ) ) == 0,
+            "File is not a state snapshot" );
+
+         uint64_t manifest_size;
+         fc::sha256 manifest_checksum;
+         const char* trailer = data + size - detail::snapshot_trailer_size;
+         memcpy( (char*)&manifest_size, trailer, sizeof( manifest_size ) );
+         memcpy( manifest_checksum.data(), trailer + sizeof( manifest_size ), sizeof( manifest_checksum ) );
+
+         uint64_t sections_end = size - detail::snapshot_trailer_size - sizeof( detail::snapshot_magic );
+         FC_ASSERT( manifest_size <= sections_end, "Snapshot is truncated" );
+         sections_end = size - detail::snapshot_trailer_size - manifest_size;
+         const char* manifest_data = data + sections_end;
+         FC_ASSERT( detail::hash_region( manifest_data, manifest_size ) == manifest_checksum, "Snapshot manifest is corrupt" );
+
+         snapshot_manifest manifest;
+         fc::datastream< const char* > ds( manifest_data, manifest_size );
+         fc::raw::unpack( ds, manifest );
+
+         FC_ASSERT( manifest.version == STEEM_SNAPSHOT_VERSION, "Unsupported snapshot version",
+            ("version", manifest.version)("expected", STEEM_SNAPSHOT_VERSION) );
+         FC_ASSERT( manifest.chain_id == db.get_chain_id(), "Snapshot is for a different chain",
+            ("snapshot", manifest.chain_id)("node", db.get_chain_id()) );
+
+         auto indexes = detail::get_snapshot_indexes( db );
+         std::map< std::string, const snapshot_section* > sections;
+         for( const auto& section : manifest.sections )
+         {
+            FC_ASSERT( section.offset >= sizeof( detail::snapshot_magic ) && section.offset + section.size <= sections_end,
+               "Snapshot section ${n} is out of bounds", ("n", section.name) );
+            sections[ section.name ] = &section;
+         }
+
+         std::vector< const snapshot_section* > to_load;
+         for( const auto& idx : indexes )
+         {
+            auto itr = sections.find( idx.name );
+            FC_ASSERT( itr != sections.end(), "Snapshot does not contain index ${n}. Was it created with a different set of plugins?",
+               ("n", idx.name) );
+            to_load.push_back( itr->second );
+            sections.erase( itr );
+         }
+
+         for( const auto& unused : sections )
+            wlog( "Ignoring snapshot index ${n}, it is not used by this node", ("n", unused.first) );
+
+         detail::run_parallel( indexes.size(), threads, [&]( uint32_t i )
+         {
+            const auto& section = *to_load[i];
+            const char* section_data = data + section.offset;
+            FC_ASSERT( detail::hash_region( section_data, section.size ) == section.checksum, "Snapshot section ${n} is corrupt",
+               ("n", section.name) );
+
+            fc::datastream< const char* > in( section_data, section.size );
+            indexes[i].info->load_snapshot( db, in, section.object_count );
+            FC_ASSERT( in.remaining() == 0, "Snapshot section ${n} has trailing data", ("n", section.name) );
+         });
+
+         db.set_revision( manifest.head_block_num );
+         FC_ASSERT( db.head_block_num() == manifest.head_block_num && db.head_block_id() == manifest.head_block_id,
+            "Loaded state does not match the snapshot head block" );
+
+         ilog( "Loaded snapshot of ${n} indexes at block ${b} from ${f} in ${t} ms",
+            ("n", indexes.size())("b", manifest.head_block_num)("f", file)("t", ( fc::time_point::now() - start ).count() / 1000) );
+
+         return manifest;
+      }
+      FC_CAPTURE_AND_RETHROW( (file)(threads) )
+   }
+
+} } // steem::chain
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <boost/interprocess/managed_mapped_file.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/containers/map.hpp>
 #include <boost/interprocess/containers/set.hpp>
 #include <boost/interprocess/containers/flat_map.hpp>
@@ -12,6 +14,7 @@
 #include <boost/interprocess/sync/file_lock.hpp>
 
 #include <boost/multi_index_container.hpp>
+#include <boost/mpl/size.hpp>
 
 #include <boost/chrono.hpp>
 #include <boost/config.hpp>
@@ -137,28 +140,191 @@ namespace chainbase {
    template<typename Constructor, typename Allocator> \
    OBJECT_TYPE( Constructor&& c, Allocator&&  ) { c(*this); }
 
+   /**
+    *  The undo records of one revision.
+    *
+    *  The first time an object that existed before the revision is modified or removed, its old value is
+    *  copied into an append-only log. The log is a list of chunks allocated from the shared segment, each
+    *  twice the size of the previous one, so a revision makes a handful of allocations no matter how many
+    *  objects it touches. A small open addressing table of logged ids, also one allocation, keeps each
+    *  object logged once. Objects created during the revision are not recorded at all, they are the ones
+    *  with ids from old_next_id up. Everything is released at once when the revision is committed,
+    *  undone or squashed.
+    */
    template< typename value_type >
    class undo_state
    {
       public:
-         typedef typename value_type::id_type                      id_type;
-         typedef allocator< std::pair<const id_type, value_type> > id_value_allocator_type;
-         typedef allocator< id_type >                              id_allocator_type;
+         typedef typename value_type::id_type                                    id_type;
+         typedef allocator< char >                                               char_allocator_type;
+         typedef typename std::allocator_traits< char_allocator_type >::pointer  char_pointer;
+         typedef allocator< int64_t >                                            id_allocator_type;
 
          template<typename T>
          undo_state( allocator<T> al )
-         :old_values( id_value_allocator_type( al ) ),
-          removed_values( id_value_allocator_type( al ) ),
-          new_ids( id_allocator_type( al ) ){}
+         :_alloc( al ), _logged_ids( id_allocator_type( al ) ){}
+
+         undo_state( const undo_state& ) = delete;
+         undo_state& operator=( const undo_state& ) = delete;
+
+         ~undo_state() { clear(); }
+
+         /// True if the object was created during this revision
+         bool is_new( const id_type& id )const { return !( id < old_next_id ); }
+
+         /// True if the old value of the object is already in the log
+         bool contains( const id_type& id )const
+         {
+            if( _logged_ids.empty() ) return false;
+
+            size_t mask = _logged_ids.size() - 1;
+            for( size_t i = slot( id._id, mask ); ; i = ( i + 1 ) & mask )
+            {
+               if( _logged_ids[i] == id._id ) return true;
+               if( _logged_ids[i] == int64_t( empty_slot ) ) return false;
+            }
+         }
+
+         /**
+          * Appends the old value of an object that is not yet in the log.
+          * @return the number of segment allocations made
+          */
+         template< typename V >
+         uint32_t record( V&& v )
+         {
+            uint32_t allocations = 0;
+
+            if( ( _size + 1 ) * 2 > _logged_ids.size() )
+            {
+               grow_ids();
+               ++allocations;
+            }
+
+            chunk_header* tail = header( _tail );
+            if( !tail || tail->size == tail->capacity )
+            {
+               add_chunk( tail ? std::min< uint32_t >( tail->capacity * 2, max_chunk_capacity() ) : min_chunk_capacity() );
+               tail = header( _tail );
+               ++allocations;
+            }
+
+            int64_t id = v.id._id;
+            new( values( tail ) + tail->size ) value_type( std::forward< V >( v ) );
+            ++tail->size;
+            insert_id( id );
+            ++_size;
+
+            return allocations;
+         }
+
+         /// Calls l( value_type& ) for every logged value
+         template< typename Lambda >
+         void for_each( Lambda&& l )
+         {
+            for( chunk_header* c = header( _tail ); c != nullptr; c = header( c->prev ) )
+            {
+               value_type* v = values( c );
+               for( uint32_t i = 0; i < c->size; ++i )
+                  l( v[i] );
+            }
+         }
+
+         size_t size()const { return _size; }
+
+         /// Destroys the logged values and releases all memory of the revision
+         void clear()
+         {
+            while( _tail )
+            {
+               chunk_header* c = header( _tail );
+               char_pointer prev = c->prev;
+               value_type* v = values( c );
+               for( uint32_t i = 0; i < c->size; ++i )
+                  v[i].~value_type();
+
+               size_t bytes = chunk_bytes( c->capacity );
+               c->~chunk_header();
+               _alloc.deallocate( _tail, bytes );
+               _tail = prev;
+            }
 
-         typedef boost::interprocess::map< id_type, value_type, std::less<id_type>, id_value_allocator_type >  id_value_type_map;
-         typedef boost::interprocess::set< id_type, std::less<id_type>, id_allocator_type >                    id_type_set;
+            _logged_ids.clear();
+            _logged_ids.shrink_to_fit();
+            _size = 0;
+         }
 
-         id_value_type_map            old_values;
-         id_value_type_map            removed_values;
-         id_type_set                  new_ids;
          id_type                      old_next_id = 0;
          int64_t                      revision = 0;
+
+      private:
+         struct chunk_header
+         {
+            char_pointer   prev;
+            uint32_t       size = 0;
+            uint32_t       capacity = 0;
+         };
+
+         enum : int64_t { empty_slot = -1 };
+
+         static constexpr size_t header_bytes()
+         {
+            return ( sizeof( chunk_header ) + alignof( value_type ) - 1 ) / alignof( value_type ) * alignof( value_type );
+         }
+
+         static constexpr size_t chunk_bytes( uint32_t capacity ) { return header_bytes() + size_t( capacity ) * sizeof( value_type ); }
+         static constexpr uint32_t min_chunk_capacity() { return sizeof( value_type ) >= 1024 ? 1 : 1024 / sizeof( value_type ); }
+         static constexpr uint32_t max_chunk_capacity() { return sizeof( value_type ) >= 65536 ? 1 : 65536 / sizeof( value_type ); }
+
+         static size_t slot( int64_t id, size_t mask )
+         {
+            uint64_t h = uint64_t( id ) * 0x9E3779B97F4A7C15ull;
+            return size_t( h ^ ( h >> 32 ) ) & mask;
+         }
+
+         static chunk_header* header( const char_pointer& p ) { return p ? reinterpret_cast< chunk_header* >( &*p ) : nullptr; }
+         static value_type* values( chunk_header* c ) { return reinterpret_cast< value_type* >( reinterpret_cast< char* >( c ) + header_bytes() ); }
+
+         void add_chunk( uint32_t capacity )
+         {
+            char_pointer p = _alloc.allocate( chunk_bytes( capacity ) );
+            chunk_header* c = new( &*p ) chunk_header();
+            c->prev = _tail;
+            c->capacity = capacity;
+            _tail = p;
+         }
+
+         void insert_id( int64_t id )
+         {
+            size_t mask = _logged_ids.size() - 1;
+            size_t i = slot( id, mask );
+            while( _logged_ids[i] != int64_t( empty_slot ) )
+               i = ( i + 1 ) & mask;
+            _logged_ids[i] = id;
+         }
+
+         void grow_ids()
+         {
+            boost::container::vector< int64_t, id_allocator_type > old( _logged_ids.get_allocator() );
+            old.swap( _logged_ids );
+            _logged_ids.assign( std::max< size_t >( 64, old.size() * 2 ), int64_t( empty_slot ) );
+            for( int64_t id : old )
+               if( id != int64_t( empty_slot ) )
+                  insert_id( id );
+         }
+
+         char_allocator_type                                       _alloc;
+         char_pointer                                              _tail = char_pointer();
+         boost::container::vector< int64_t, id_allocator_type >    _logged_ids;
+         size_t                                                    _size = 0;
+   };
+
+   /**
+    * Counters of undo bookkeeping work since the index was created
+    */
+   struct undo_statistics
+   {
+      uint64_t records = 0;      ///< Old values logged
+      uint64_t allocations = 0;  ///< Shared segment allocations made by undo logs
    };
 
    /**
@@ -188,6 +354,32 @@ namespace chainbase {
          int32_t& _target;
    };
 
+   namespace detail
+   {
+      /// Hashed indices can size their bucket arrays up front, ordered indices have nothing to reserve
+      template< typename Index >
+      auto reserve_index( Index& idx, size_t n, int ) -> decltype( idx.reserve( n ), void() ) { idx.reserve( n ); }
+
+      template< typename Index >
+      void reserve_index( Index&, size_t, long ) {}
+
+      template< typename MultiIndexType, size_t N = boost::mpl::size< typename MultiIndexType::index_type_list >::value >
+      struct index_reserver
+      {
+         static void reserve( MultiIndexType& indices, size_t n )
+         {
+            reserve_index( indices.template get< N - 1 >(), n, 0 );
+            index_reserver< MultiIndexType, N - 1 >::reserve( indices, n );
+         }
+      };
+
+      template< typename MultiIndexType >
+      struct index_reserver< MultiIndexType, 0 >
+      {
+         static void reserve( MultiIndexType&, size_t ) {}
+      };
+   }
+
    /**
     *  The value_type stored in the multiindex container must have a integer field with the name 'id'.  This will
     *  be the primary key and it will be assigned and managed by generic_index.
@@ -235,6 +427,56 @@ namespace chainbase {
             return *insert_result.first;
          }
 
+         /**
+          * Appends a new element for bulk loading. Ids are assigned in increasing order, so the element is
+          * inserted at the end of the id index with a hint instead of searched for. No undo state is kept
+          * when the index has none, which makes bulk loaded objects permanent. When an undo session is
+          * active the element is tracked exactly as emplace() would.
+          */
+         template<typename Constructor>
+         const value_type& bulk_emplace( Constructor&& c ) {
+            if( enabled() )
+               return emplace( std::forward<Constructor>(c) );
+
+            return bulk_restore( _next_id, std::forward<Constructor>(c) );
+         }
+
+         /**
+          * Appends an element with a given id, such as one read from a snapshot. The id must be at least
+          * next_id(), and next_id() moves past it. Restoring is never undoable, so the index must not have
+          * undo state.
+          */
+         template<typename Constructor>
+         const value_type& bulk_restore( typename value_type::id_type id, Constructor&& c ) {
+            if( enabled() )
+               BOOST_THROW_EXCEPTION( std::logic_error( "cannot bulk restore objects while undo state is present" ) );
+            if( id < _next_id )
+               BOOST_THROW_EXCEPTION( std::logic_error( "bulk restored objects must be appended in id order" ) );
+
+            auto constructor = [&]( value_type& v ) {
+               v.id = id;
+               c( v );
+            };
+
+            auto insert_result = _indices.emplace_hint( _indices.end(), constructor, _indices.get_allocator() );
+
+            if( insert_result->id != id ) {
+               BOOST_THROW_EXCEPTION( std::logic_error("could not insert object, most likely a uniqueness constraint was violated") );
+            }
+
+            _next_id = id;
+            ++_next_id;
+            return *insert_result;
+         }
+
+         /**
+          * Prepares the index for n more elements. Hashed indices are resized once instead of rehashing
+          * repeatedly while they grow.
+          */
+         void reserve( size_t n ) {
+            detail::index_reserver< index_type >::reserve( _indices, _indices.size() + n );
+         }
+
          template<typename Modifier>
          void modify( const value_type& obj, Modifier&& m ) {
             on_modify( obj );
@@ -263,6 +505,19 @@ namespace chainbase {
 
          const index_type& indices()const { return _indices; }
 
+         /**
+          * The id the next emplaced object will receive. Restoring it along with the objects reproduces the
+          * ids a source database would assign.
+          */
+         typename value_type::id_type next_id()const { return _next_id; }
+
+         void set_next_id( typename value_type::id_type id )
+         {
+            if( _stack.size() )
+               BOOST_THROW_EXCEPTION( std::logic_error( "cannot set next id while undo state is present" ) );
+            _next_id = id;
+         }
+
          class session {
             public:
                session( session&& mv )
@@ -314,6 +569,7 @@ namespace chainbase {
 
          const index_type& indicies()const { return _indices; }
          int64_t revision()const { return _revision; }
+         const undo_statistics& get_undo_statistics()const { return _undo_stats; }
 
 
          /**
@@ -323,25 +579,29 @@ namespace chainbase {
          void undo() {
             if( !enabled() ) return;
 
-            const auto& head = _stack.back();
+            auto& head = _stack.back();
+
+            // Objects that still exist are modified back first, then objects created in the revision are
+            // erased, then removed objects are restored.
+            head.for_each( [&]( value_type& old ) {
+               auto itr = _indices.find( old.id );
+               if( itr == _indices.end() ) return;
 
-            for( auto& item : head.old_values ) {
-               auto ok = _indices.modify( _indices.find( item.second.id ), [&]( value_type& v ) {
-                  v = std::move( item.second );
+               auto ok = _indices.modify( itr, [&]( value_type& v ) {
+                  v = std::move( old );
                });
                if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not modify object, most likely a uniqueness constraint was violated" ) );
-            }
+            });
 
-            for( const auto& id : head.new_ids )
-            {
-               _indices.erase( _indices.find( id ) );
-            }
+            _indices.erase( _indices.lower_bound( head.old_next_id ), _indices.end() );
             _next_id = head.old_next_id;
 
-            for( auto& item : head.removed_values ) {
-               bool ok = _indices.emplace( std::move( item.second ) ).second;
+            head.for_each( [&]( value_type& old ) {
+               if( _indices.find( old.id ) != _indices.end() ) return;
+
+               bool ok = _indices.emplace( std::move( old ) ).second;
                if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not restore object, most likely a uniqueness constraint was violated" ) );
-            }
+            });
 
             _stack.pop_back();
             --_revision;
@@ -364,92 +624,22 @@ namespace chainbase {
             auto& state = _stack.back();
             auto& prev_state = _stack[_stack.size()-2];
 
-            // An object's relationship to a state can be:
-            // in new_ids            : new
-            // in old_values (was=X) : upd(was=X)
-            // in removed (was=X)    : del(was=X)
-            // not in any of above   : nop
-            //
-            // When merging A=prev_state and B=state we have a 4x4 matrix of all possibilities:
-            //
-            //                   |--------------------- B ----------------------|
-            //
-            //                +------------+------------+------------+------------+
-            //                | new        | upd(was=Y) | del(was=Y) | nop        |
-            //   +------------+------------+------------+------------+------------+
-            // / | new        | N/A        | new       A| nop       C| new       A|
-            // | +------------+------------+------------+------------+------------+
-            // | | upd(was=X) | N/A        | upd(was=X)A| del(was=X)C| upd(was=X)A|
-            // A +------------+------------+------------+------------+------------+
-            // | | del(was=X) | N/A        | N/A        | N/A        | del(was=X)A|
-            // | +------------+------------+------------+------------+------------+
-            // \ | nop        | new       B| upd(was=Y)B| del(was=Y)B| nop      AB|
-            //   +------------+------------+------------+------------+------------+
-            //
-            // Each entry was composed by labelling what should occur in the given case.
-            //
-            // Type A means the composition of states contains the same entry as the first of the two merged states for that object.
-            // Type B means the composition of states contains the same entry as the second of the two merged states for that object.
-            // Type C means the composition of states contains an entry different from either of the merged states for that object.
-            // Type N/A means the composition of states violates causal timing.
-            // Type AB means both type A and type B simultaneously.
+            // An object's relationship to a state can be new (its id is at least the state's old_next_id),
+            // logged (the state holds its value from before the state, whether it was modified or removed
+            // since) or nop. Merging A=prev_state and B=state:
             //
-            // The merge() operation is defined as modifying prev_state in-place to be the state object which represents the composition of
-            // state A and B.
+            //    new in A    : stays new in the merged state whatever B did, B's record is dropped
+            //    logged in A : A already holds the oldest value, B's record is dropped
+            //    nop in A    : B's record, if any, moves to A
             //
-            // Type A (and AB) can be implemented as a no-op; prev_state already contains the correct value for the merged state.
-            // Type B (and AB) can be implemented by copying from state to prev_state.
-            // Type C needs special case-by-case logic.
-            // Type N/A can be ignored or assert(false) as it can only occur if prev_state and state have illegal values
-            // (a serious logic error which should never happen).
-            //
-
-            // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
-
-            for( const auto& item : state.old_values )
-            {
-               if( prev_state.new_ids.find( item.second.id ) != prev_state.new_ids.end() )
-               {
-                  // new+upd -> new, type A
-                  continue;
-               }
-               if( prev_state.old_values.find( item.second.id ) != prev_state.old_values.end() )
-               {
-                  // upd(was=X) + upd(was=Y) -> upd(was=X), type A
-                  continue;
-               }
-               // del+upd -> N/A
-               assert( prev_state.removed_values.find(item.second.id) == prev_state.removed_values.end() );
-               // nop+upd(was=Y) -> upd(was=Y), type B
-               prev_state.old_values.emplace( std::move(item) );
-            }
+            // Objects new in B are new in A as well, since A's old_next_id is lower.
 
-            // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-            for( const auto& id : state.new_ids )
-               prev_state.new_ids.insert(id);
+            state.for_each( [&]( value_type& v ) {
+               if( prev_state.is_new( v.id ) || prev_state.contains( v.id ) )
+                  return;
 
-            // *+del
-            for( auto& obj : state.removed_values )
-            {
-               if( prev_state.new_ids.find(obj.second.id) != prev_state.new_ids.end() )
-               {
-                  // new + del -> nop (type C)
-                  prev_state.new_ids.erase(obj.second.id);
-                  continue;
-               }
-               auto it = prev_state.old_values.find(obj.second.id);
-               if( it != prev_state.old_values.end() )
-               {
-                  // upd(was=X) + del(was=Y) -> del(was=X)
-                  prev_state.removed_values.emplace( std::move(*it) );
-                  prev_state.old_values.erase(obj.second.id);
-                  continue;
-               }
-               // del + del -> N/A
-               assert( prev_state.removed_values.find( obj.second.id ) == prev_state.removed_values.end() );
-               // nop + del(was=Y) -> del(was=Y)
-               prev_state.removed_values.emplace( std::move(obj) ); //[obj.second->id] = std::move(obj.second);
-            }
+               _undo_stats.allocations += prev_state.record( std::move( v ) );
+            });
 
             _stack.pop_back();
             --_revision;
@@ -488,45 +678,19 @@ namespace chainbase {
             if( !enabled() ) return;
 
             auto& head = _stack.back();
-
-            if( head.new_ids.find( v.id ) != head.new_ids.end() )
-               return;
-
-            auto itr = head.old_values.find( v.id );
-            if( itr != head.old_values.end() )
+            if( head.is_new( v.id ) || head.contains( v.id ) )
                return;
 
-            head.old_values.emplace( std::pair< typename value_type::id_type, const value_type& >( v.id, v ) );
+            _undo_stats.allocations += head.record( v );
+            ++_undo_stats.records;
          }
 
+         /// The log stores a removed object's value the same way as a modified one's, undo() tells them apart
          void on_remove( const value_type& v ) {
-            if( !enabled() ) return;
-
-            auto& head = _stack.back();
-            if( head.new_ids.count(v.id) ) {
-               head.new_ids.erase( v.id );
-               return;
-            }
-
-            auto itr = head.old_values.find( v.id );
-            if( itr != head.old_values.end() ) {
-               head.removed_values.emplace( std::move( *itr ) );
-               head.old_values.erase( v.id );
-               return;
-            }
-
-            if( head.removed_values.count( v.id ) )
-               return;
-
-            head.removed_values.emplace( std::pair< typename value_type::id_type, const value_type& >( v.id, v ) );
+            on_modify( v );
          }
 
-         void on_create( const value_type& v ) {
-            if( !enabled() ) return;
-            auto& head = _stack.back();
-
-            head.new_ids.insert( v.id );
-         }
+         void on_create( const value_type& v ) {}
 
          boost::interprocess::deque< undo_state_type, allocator<undo_state_type> > _stack;
 
@@ -538,6 +702,7 @@ namespace chainbase {
           */
          int64_t                         _revision = 0;
          typename value_type::id_type    _next_id = 0;
+         undo_statistics                 _undo_stats;
          index_type                      _indices;
          uint32_t                        _size_of_value_type = 0;
          uint32_t                        _size_of_this = 0;
@@ -673,6 +838,46 @@ namespace chainbase {
          std::atomic< uint32_t >                                    _current_lock;
    };
 
+   /**
+    * Published in shared_memory.meta by the process that writes shared_memory.bin so that read only
+    * processes on the same host can serve reads from the same file.
+    *
+    * sequence is odd while the writer modifies the segment. A reader marks its slot active and then
+    * checks that sequence is even, the writer makes sequence odd and then waits for the active slots
+    * to drain. Either the writer sees the reader or the reader sees the writer, so reads never overlap
+    * a write. Each reader process has its own slot so readers never contend with each other.
+    */
+   struct shared_memory_meta
+   {
+      static const uint32_t max_readers = 64;
+      static const uint64_t current_magic = 0x31415445534d4243; // "CBMSETA1"
+
+      struct alignas( 64 ) reader_slot
+      {
+         std::atomic< int32_t >     pid;
+         std::atomic< uint32_t >    active;   ///< Threads of pid reading the segment
+      };
+
+      shared_memory_meta()
+      {
+         sequence = 0;
+         revision = -1;
+         file_size = 0;
+         for( auto& r : readers )
+         {
+            r.pid = 0;
+            r.active = 0;
+         }
+         magic = current_magic;
+      }
+
+      uint64_t                   magic;
+      std::atomic< uint64_t >    sequence;
+      std::atomic< int64_t >     revision;   ///< Revision of the segment after the last write
+      std::atomic< uint64_t >    file_size;  ///< Readers remap when the writer grows the file
+      reader_slot                readers[ max_readers ];
+   };
+
    struct lock_exception : public std::exception
    {
       explicit lock_exception() {}
@@ -706,7 +911,17 @@ namespace chainbase {
          };
 
       public:
-         void open( const bfs::path& dir, uint32_t flags = 0, size_t shared_file_size = 0 );
+         enum open_flags
+         {
+            read_write  = 0,
+            /**
+             * Attach to a database written by another process. The segment is mapped read only, reads
+             * wait for the writer through shared_memory.meta and writes are rejected.
+             */
+            read_only   = 1
+         };
+
+         void open( const bfs::path& dir, uint32_t flags = read_write, size_t shared_file_size = 0 );
          void close();
          void flush();
          void wipe( const bfs::path& dir );
@@ -799,10 +1014,13 @@ namespace chainbase {
          template<typename MultiIndexType>
          void add_index()
          {
-            _index_types.push_back( unique_ptr< abstract_index_type >( new index_type_impl< MultiIndexType >() ) );
-            _index_types.back()->add_index( *this );
+            unique_ptr< abstract_index_type > type( new index_type_impl< MultiIndexType >() );
+            type->add_index( *this );
+            _index_types.push_back( std::move( type ) );
          }
 
+         bool is_read_only()const { return _read_only; }
+
 #ifndef ENABLE_STD_ALLOCATOR
          auto get_segment_manager() -> decltype( ((bip::managed_mapped_file*)nullptr)->get_segment_manager()) {
             return _segment->get_segment_manager();
@@ -967,6 +1185,17 @@ namespace chainbase {
              return get_mutable_index<index_type>().emplace( std::forward<Constructor>(con) );
          }
 
+         /**
+          * Creates an object through the index's bulk loading path, see generic_index::bulk_emplace
+          */
+         template<typename ObjectType, typename Constructor>
+         const ObjectType& bulk_create( Constructor&& con )
+         {
+             CHAINBASE_REQUIRE_WRITE_LOCK("bulk_create", ObjectType);
+             typedef typename get_index_type<ObjectType>::type index_type;
+             return get_mutable_index<index_type>().bulk_emplace( std::forward<Constructor>(con) );
+         }
+
          template< typename ObjectType >
          size_t count()const
          {
@@ -978,6 +1207,9 @@ namespace chainbase {
          auto with_read_lock( Lambda&& callback, uint64_t wait_micro = 1000000 ) -> decltype( (*(Lambda*)nullptr)() )
          {
 #ifndef ENABLE_STD_ALLOCATOR
+            if( _read_only )
+               return with_shared_read_lock( std::forward< Lambda >( callback ), wait_micro );
+
             read_lock lock( _rw_manager.current_lock(), bip::defer_lock_type() );
 #else
             read_lock lock( _rw_manager.current_lock(), boost::defer_lock_t() );
@@ -988,6 +1220,8 @@ namespace chainbase {
             int_incrementer ii( _read_lock_count );
 #endif
 
+            _waiting_readers.fetch_add( 1, std::memory_order_relaxed );
+
             if( !wait_micro )
             {
                lock.lock();
@@ -995,15 +1229,23 @@ namespace chainbase {
             else
             {
                if( !lock.timed_lock( boost::posix_time::microsec_clock::universal_time() + boost::posix_time::microseconds( wait_micro ) ) )
+               {
+                  _waiting_readers.fetch_sub( 1, std::memory_order_relaxed );
                   BOOST_THROW_EXCEPTION( lock_exception() );
+               }
             }
 
+            _waiting_readers.fetch_sub( 1, std::memory_order_relaxed );
+
             return callback();
          }
 
          template< typename Lambda >
          auto with_write_lock( Lambda&& callback, uint64_t wait_micro = 1000000 ) -> decltype( (*(Lambda*)nullptr)() )
          {
+            if( _read_only )
+               BOOST_THROW_EXCEPTION( std::logic_error( "cannot write to a database opened read only" ) );
+
             write_lock lock( _rw_manager.current_lock(), boost::defer_lock_t() );
 #ifdef CHAINBASE_CHECK_LOCKING
             BOOST_ATTRIBUTE_UNUSED
@@ -1024,6 +1266,7 @@ namespace chainbase {
                }
             }
 
+            shared_write_guard shared( *this );
             return callback();
          }
 
@@ -1042,12 +1285,89 @@ namespace chainbase {
             }
          }
 
+         /**
+          * Number of threads currently blocked in with_read_lock. Lets the writer decide when to give up the lock.
+          */
+         uint32_t waiting_readers()const
+         {
+            return _waiting_readers.load( std::memory_order_relaxed );
+         }
+
          typedef vector<abstract_index*> abstract_index_cntr_t;
 
          const abstract_index_cntr_t& get_abstract_index_cntr() const
             { return _index_list; }
 
       private:
+         void open_read_only( const bfs::path& dir );
+
+         /// Marks the segment as being written for read only processes, see shared_memory_meta
+         void begin_shared_write();
+         /// Publishes the revision and file size and lets read only processes in again
+         void end_shared_write();
+         void wait_for_shared_readers();
+
+         /**
+          * Enters this process' reader slot once the writer is outside of a write. Returns false when the
+          * writer has grown the file since it was mapped, the caller must then remap and try again.
+          */
+         bool enter_shared_read( uint64_t wait_micro, bool check_size = true );
+         void leave_shared_read();
+         void remap_read_only( uint64_t wait_micro );
+
+         struct shared_write_guard
+         {
+            shared_write_guard( database& db ) : _db( db ) { _db.begin_shared_write(); }
+            ~shared_write_guard() { _db.end_shared_write(); }
+
+            database& _db;
+         };
+
+         struct shared_read_guard
+         {
+            shared_read_guard( database& db, bool leave = true ) : _db( db ), _leave( leave ) {}
+            ~shared_read_guard() { if( _leave ) _db.leave_shared_read(); }
+
+            database& _db;
+            bool      _leave;
+         };
+
+         template< typename Lambda >
+         auto with_shared_read_lock( Lambda&& callback, uint64_t wait_micro ) -> decltype( (*(Lambda*)nullptr)() )
+         {
+#ifdef CHAINBASE_CHECK_LOCKING
+            BOOST_ATTRIBUTE_UNUSED
+            int_incrementer ii( _read_lock_count );
+#endif
+
+            while( true )
+            {
+               {
+                  read_lock lock( _rw_manager.current_lock(), bip::defer_lock_type() );
+
+                  _waiting_readers.fetch_add( 1, std::memory_order_relaxed );
+                  if( !wait_micro )
+                  {
+                     lock.lock();
+                  }
+                  else if( !lock.timed_lock( boost::posix_time::microsec_clock::universal_time() + boost::posix_time::microseconds( wait_micro ) ) )
+                  {
+                     _waiting_readers.fetch_sub( 1, std::memory_order_relaxed );
+                     BOOST_THROW_EXCEPTION( lock_exception() );
+                  }
+                  _waiting_readers.fetch_sub( 1, std::memory_order_relaxed );
+
+                  if( enter_shared_read( wait_micro ) )
+                  {
+                     shared_read_guard shared( *this );
+                     return callback();
+                  }
+               }
+
+               remap_read_only( wait_micro );
+            }
+         }
+
          template<typename MultiIndexType>
          void add_index_helper() {
              const uint16_t type_id = generic_index<MultiIndexType>::value_type::type_id;
@@ -1062,7 +1382,28 @@ namespace chainbase {
 
              index_type* idx_ptr =  nullptr;
 #ifndef ENABLE_STD_ALLOCATOR
-             idx_ptr = _segment->find_or_construct< index_type >( type_name.c_str() )( index_alloc( _segment->get_segment_manager() ) );
+             if( _read_only )
+             {
+                // The writer may be creating named objects, the segment index is only read outside of writes.
+                // remap_read_only() is already inside a read when it reattaches indexes.
+                if( !_remapping )
+                {
+                   while( !enter_shared_read( 0 ) )
+                      remap_read_only( 0 );
+                }
+
+                {
+                   shared_read_guard shared( *this, !_remapping );
+                   idx_ptr = _segment->find_no_lock< index_type >( type_name.c_str() ).first;
+                }
+
+                if( idx_ptr == nullptr )
+                   BOOST_THROW_EXCEPTION( std::runtime_error( "unable to find index for " + type_name + " in read only database" ) );
+             }
+             else
+             {
+                idx_ptr = _segment->find_or_construct< index_type >( type_name.c_str() )( index_alloc( _segment->get_segment_manager() ) );
+             }
 #else
              idx_ptr = new index_type( index_alloc() );
 #endif
@@ -1079,9 +1420,14 @@ namespace chainbase {
          read_write_mutex_manager                                    _rw_manager;
 #ifndef ENABLE_STD_ALLOCATOR
          unique_ptr<bip::managed_mapped_file>                        _segment;
-         unique_ptr<bip::managed_mapped_file>                        _meta;
+         unique_ptr<bip::mapped_region>                              _meta;
+         shared_memory_meta*                                         _shared_meta = nullptr;
          bip::file_lock                                              _flock;
+         int32_t                                                     _reader_slot = -1;
+         bool                                                        _shared_write_active = false;
+         bool                                                        _remapping = false;
 #endif
+         bool                                                        _read_only = false;
 
          /**
           * This is a sparse list of known indicies kept to accelerate creation of undo sessions
@@ -1100,6 +1446,7 @@ namespace chainbase {
          int32_t                                                     _read_lock_count = 0;
          int32_t                                                     _write_lock_count = 0;
          bool                                                        _enable_require_locking = false;
+         std::atomic< uint32_t >                                     _waiting_readers = { 0 };
 
          int32_t                                                     _undo_session_count = 0;
          size_t                                                      _file_size = 0;
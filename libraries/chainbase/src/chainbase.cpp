@@ -1,7 +1,19 @@
 #include <chainbase/chainbase.hpp>
 #include <boost/array.hpp>
 
+#include <cerrno>
+#include <chrono>
 #include <iostream>
+#include <thread>
+
+#include <signal.h>
+#include <unistd.h>
+
+// Yields before a waiting reader or writer of a read only database starts sleeping
+#define CHAINBASE_SHARED_SPINS 100
+#define CHAINBASE_SHARED_SLEEP_MICRO 50
+// How long a read only process waits for the writer to leave a write when it attaches
+#define CHAINBASE_READ_ONLY_OPEN_WAIT 10000000
 
 namespace chainbase {
 
@@ -32,6 +44,12 @@ namespace chainbase {
 
    void database::open( const bfs::path& dir, uint32_t flags, size_t shared_file_size )
    {
+      if( flags & read_only )
+      {
+         open_read_only( dir );
+         return;
+      }
+
       bfs::create_directories( dir );
       if( _data_dir != dir ) close();
 
@@ -39,8 +57,47 @@ namespace chainbase {
 
 #ifndef ENABLE_STD_ALLOCATOR
       auto abs_path = bfs::absolute( dir / "shared_memory.bin" );
+      bool existing = bfs::exists( abs_path );
+
+      if( !existing )
+      {
+         _file_size = shared_file_size;
+         _segment.reset( new bip::managed_mapped_file( bip::create_only,
+                                                       abs_path.generic_string().c_str(), shared_file_size
+                                                       ) );
+         _segment->find_or_construct< environment_check >( "environment" )();
+      }
+
+      _flock = bip::file_lock( abs_path.generic_string().c_str() );
+      if( !_flock.try_lock() )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "could not gain write access to the shared memory file" ) );
+
+      if( !_meta )
+      {
+         auto meta_path = bfs::absolute( dir / "shared_memory.meta" );
+         bool valid = bfs::exists( meta_path ) && bfs::file_size( meta_path ) == sizeof( shared_memory_meta );
+
+         if( !valid )
+         {
+            std::ofstream( meta_path.generic_string(), std::ios::binary | std::ios::trunc );
+            bfs::resize_file( meta_path, sizeof( shared_memory_meta ) );
+         }
+
+         bip::file_mapping mapping( meta_path.generic_string().c_str(), bip::read_write );
+         _meta.reset( new bip::mapped_region( mapping, bip::read_write ) );
+         _shared_meta = static_cast< shared_memory_meta* >( _meta->get_address() );
 
-      if( bfs::exists( abs_path ) )
+         // Keep the slots of readers that stay attached across a restart of the writer
+         if( !valid || _shared_meta->magic != shared_memory_meta::current_magic )
+            new( _shared_meta ) shared_memory_meta();
+      }
+
+      // Growing the file rewrites the segment header, which attached readers may be using.
+      // resize() is called inside a write and publishes the new size when that write ends.
+      bool in_write = _shared_write_active;
+      begin_shared_write();
+
+      if( existing )
       {
          _file_size = bfs::file_size( abs_path );
          if( shared_file_size > _file_size )
@@ -59,22 +116,97 @@ namespace chainbase {
          if( !env.first || !( *env.first == environment_check()) ) {
             BOOST_THROW_EXCEPTION( std::runtime_error( "database created by a different compiler, build, or operating system" ) );
          }
-      } else {
-         _file_size = shared_file_size;
-         _segment.reset( new bip::managed_mapped_file( bip::create_only,
-                                                       abs_path.generic_string().c_str(), shared_file_size
-                                                       ) );
-         _segment->find_or_construct< environment_check >( "environment" )();
       }
 
-      _flock = bip::file_lock( abs_path.generic_string().c_str() );
-      if( !_flock.try_lock() )
-         BOOST_THROW_EXCEPTION( std::runtime_error( "could not gain write access to the shared memory file" ) );
+      if( !in_write )
+         end_shared_write();
+#endif
+   }
+
+   void database::open_read_only( const bfs::path& dir )
+   {
+      if( _data_dir != dir ) close();
+
+#ifndef ENABLE_STD_ALLOCATOR
+      auto abs_path = bfs::absolute( dir / "shared_memory.bin" );
+      auto meta_path = bfs::absolute( dir / "shared_memory.meta" );
+
+      if( !bfs::exists( abs_path ) || !bfs::exists( meta_path ) || bfs::file_size( meta_path ) != sizeof( shared_memory_meta ) )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "no database to attach to in " + dir.generic_string() ) );
+
+      bip::file_mapping mapping( meta_path.generic_string().c_str(), bip::read_write );
+      _meta.reset( new bip::mapped_region( mapping, bip::read_write ) );
+      _shared_meta = static_cast< shared_memory_meta* >( _meta->get_address() );
+
+      if( _shared_meta->magic != shared_memory_meta::current_magic )
+      {
+         close();
+         BOOST_THROW_EXCEPTION( std::runtime_error( "shared_memory.meta was not written by a compatible chainbase" ) );
+      }
+
+      int32_t pid = getpid();
+      for( int pass = 0; pass < 2 && _reader_slot < 0; ++pass )
+      {
+         for( uint32_t i = 0; i < shared_memory_meta::max_readers; ++i )
+         {
+            auto& slot = _shared_meta->readers[i];
+            int32_t expected = 0;
+
+            // The second pass takes over slots of readers that exited without closing
+            if( pass == 1 )
+            {
+               expected = slot.pid.load( std::memory_order_relaxed );
+               if( expected == 0 || kill( expected, 0 ) == 0 || errno != ESRCH )
+                  continue;
+            }
+
+            if( slot.pid.compare_exchange_strong( expected, pid ) )
+            {
+               slot.active.store( 0, std::memory_order_release );
+               _reader_slot = i;
+               break;
+            }
+         }
+      }
+
+      if( _reader_slot < 0 )
+      {
+         close();
+         BOOST_THROW_EXCEPTION( std::runtime_error( "too many read only processes are attached to the database" ) );
+      }
+
+      _read_only = true;
+      _data_dir = dir;
+
+      try
+      {
+         enter_shared_read( CHAINBASE_READ_ONLY_OPEN_WAIT, false );
+      }
+      catch( const lock_exception& )
+      {
+         close();
+         BOOST_THROW_EXCEPTION( std::runtime_error( "timed out waiting for the writer to publish the database" ) );
+      }
+
+      shared_read_guard shared( *this );
+
+      _file_size = _shared_meta->file_size.load( std::memory_order_relaxed );
+      _segment.reset( new bip::managed_mapped_file( bip::open_read_only, abs_path.generic_string().c_str() ) );
+
+      auto env = _segment->find_no_lock< environment_check >( "environment" );
+      if( !env.first || !( *env.first == environment_check()) ) {
+         BOOST_THROW_EXCEPTION( std::runtime_error( "database created by a different compiler, build, or operating system" ) );
+      }
+#else
+      BOOST_THROW_EXCEPTION( std::runtime_error( "read only databases require a shared memory file" ) );
 #endif
    }
 
    void database::flush() {
 #ifndef ENABLE_STD_ALLOCATOR
+      if( _read_only )
+         return;
+
       if( _segment )
          _segment->flush();
       if( _meta )
@@ -85,20 +217,38 @@ namespace chainbase {
    void database::close()
    {
 #ifndef ENABLE_STD_ALLOCATOR
+      if( _shared_meta )
+      {
+         if( _read_only )
+         {
+            if( _reader_slot >= 0 )
+            {
+               _shared_meta->readers[ _reader_slot ].active.store( 0, std::memory_order_release );
+               _shared_meta->readers[ _reader_slot ].pid.store( 0, std::memory_order_release );
+            }
+         }
+         else if( _segment )
+         {
+            end_shared_write();
+         }
+      }
+
       _segment.reset();
       _meta.reset();
+      _shared_meta = nullptr;
+      _reader_slot = -1;
+      _shared_write_active = false;
       _data_dir = bfs::path();
 #endif
+      _read_only = false;
    }
 
    void database::wipe( const bfs::path& dir )
    {
 #ifndef ENABLE_STD_ALLOCATOR
-      _segment.reset();
-      _meta.reset();
+      close();
       bfs::remove_all( dir / "shared_memory.bin" );
       bfs::remove_all( dir / "shared_memory.meta" );
-      _data_dir = bfs::path();
 #endif
       _index_list.clear();
       _index_map.clear();
@@ -106,11 +256,14 @@ namespace chainbase {
 
    void database::resize( size_t new_shared_file_size )
    {
+      if( _read_only )
+         BOOST_THROW_EXCEPTION( std::logic_error( "cannot resize a database opened read only" ) );
+
       if( _undo_session_count )
          BOOST_THROW_EXCEPTION( std::runtime_error( "Cannot resize shared memory file while undo session is active" ) );
 
+      // shared_memory.meta stays mapped, read only processes remap when they see the new size
       _segment.reset();
-      _meta.reset();
 
       open( _data_dir, 0, new_shared_file_size );
 
@@ -123,6 +276,145 @@ namespace chainbase {
       }
    }
 
+   void database::begin_shared_write()
+   {
+#ifndef ENABLE_STD_ALLOCATOR
+      if( _shared_meta == nullptr || _shared_write_active )
+         return;
+
+      // Already odd if a previous writer stopped in the middle of a write
+      if( !( _shared_meta->sequence.load( std::memory_order_relaxed ) & 1 ) )
+         _shared_meta->sequence.fetch_add( 1, std::memory_order_seq_cst );
+
+      _shared_write_active = true;
+      wait_for_shared_readers();
+#endif
+   }
+
+   void database::end_shared_write()
+   {
+#ifndef ENABLE_STD_ALLOCATOR
+      if( _shared_meta == nullptr || !_shared_write_active )
+         return;
+
+      _shared_meta->revision.store( revision(), std::memory_order_relaxed );
+      _shared_meta->file_size.store( _file_size, std::memory_order_relaxed );
+      _shared_meta->sequence.fetch_add( 1, std::memory_order_release );
+      _shared_write_active = false;
+#endif
+   }
+
+   void database::wait_for_shared_readers()
+   {
+#ifndef ENABLE_STD_ALLOCATOR
+      for( auto& slot : _shared_meta->readers )
+      {
+         for( uint32_t spins = 0; slot.active.load( std::memory_order_seq_cst ); ++spins )
+         {
+            if( spins < CHAINBASE_SHARED_SPINS )
+            {
+               std::this_thread::yield();
+               continue;
+            }
+
+            // A reader that died in the middle of a read would block the writer forever
+            int32_t pid = slot.pid.load( std::memory_order_relaxed );
+            if( pid == 0 || ( kill( pid, 0 ) == -1 && errno == ESRCH ) )
+            {
+               slot.active.store( 0, std::memory_order_relaxed );
+               slot.pid.compare_exchange_strong( pid, 0 );
+               break;
+            }
+
+            std::this_thread::sleep_for( std::chrono::microseconds( CHAINBASE_SHARED_SLEEP_MICRO ) );
+         }
+      }
+#endif
+   }
+
+   bool database::enter_shared_read( uint64_t wait_micro, bool check_size )
+   {
+#ifndef ENABLE_STD_ALLOCATOR
+      auto& slot = _shared_meta->readers[ _reader_slot ];
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds( wait_micro );
+
+      for( uint32_t spins = 0; ; ++spins )
+      {
+         if( !( _shared_meta->sequence.load( std::memory_order_acquire ) & 1 ) )
+         {
+            slot.active.fetch_add( 1, std::memory_order_seq_cst );
+            if( !( _shared_meta->sequence.load( std::memory_order_seq_cst ) & 1 ) )
+               break;
+            slot.active.fetch_sub( 1, std::memory_order_release );
+         }
+
+         if( spins < CHAINBASE_SHARED_SPINS )
+         {
+            std::this_thread::yield();
+            continue;
+         }
+
+         if( wait_micro && std::chrono::steady_clock::now() > deadline )
+            BOOST_THROW_EXCEPTION( lock_exception() );
+
+         std::this_thread::sleep_for( std::chrono::microseconds( CHAINBASE_SHARED_SLEEP_MICRO ) );
+      }
+
+      if( check_size && _shared_meta->file_size.load( std::memory_order_relaxed ) != _file_size )
+      {
+         leave_shared_read();
+         return false;
+      }
+#endif
+      return true;
+   }
+
+   void database::leave_shared_read()
+   {
+#ifndef ENABLE_STD_ALLOCATOR
+      _shared_meta->readers[ _reader_slot ].active.fetch_sub( 1, std::memory_order_release );
+#endif
+   }
+
+   void database::remap_read_only( uint64_t wait_micro )
+   {
+#ifndef ENABLE_STD_ALLOCATOR
+      // Readers of this process use the current mapping until they release the lock
+      write_lock lock( _rw_manager.current_lock(), boost::defer_lock_t() );
+      if( !wait_micro )
+         lock.lock();
+      else if( !lock.timed_lock( boost::posix_time::microsec_clock::universal_time() + boost::posix_time::microseconds( wait_micro ) ) )
+         BOOST_THROW_EXCEPTION( lock_exception() );
+
+      enter_shared_read( wait_micro, false );
+      shared_read_guard shared( *this );
+
+      uint64_t file_size = _shared_meta->file_size.load( std::memory_order_relaxed );
+      if( file_size == _file_size )
+         return;
+
+      _index_list.clear();
+      _index_map.clear();
+
+      auto abs_path = bfs::absolute( _data_dir / "shared_memory.bin" );
+      _segment.reset( new bip::managed_mapped_file( bip::open_read_only, abs_path.generic_string().c_str() ) );
+      _file_size = file_size;
+
+      _remapping = true;
+      try
+      {
+         for( auto& index_type : _index_types )
+            index_type->add_index( *this );
+      }
+      catch( ... )
+      {
+         _remapping = false;
+         throw;
+      }
+      _remapping = false;
+#endif
+   }
+
    void database::set_require_locking( bool enable_require_locking )
    {
 #ifdef CHAINBASE_CHECK_LOCKING
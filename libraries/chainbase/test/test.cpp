@@ -7,7 +7,9 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
 
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 using namespace chainbase;
 using namespace boost::multi_index;
@@ -45,12 +47,12 @@ BOOST_AUTO_TEST_CASE( open_and_create ) {
       std::cerr << temp.native() << " \n";
 
       chainbase::database db;
-      BOOST_CHECK_THROW( db.open( temp ), std::runtime_error ); /// temp does not exist
+      BOOST_CHECK_THROW( db.open( temp, chainbase::database::read_only ), std::runtime_error ); /// temp does not exist
 
       db.open( temp, 0, 1024*1024*8 );
 
       chainbase::database db2; /// open an already created db
-      db2.open( temp );
+      db2.open( temp, chainbase::database::read_only );
       BOOST_CHECK_THROW( db2.add_index< book_index >(), std::runtime_error ); /// index does not exist in read only database
 
       db.add_index< book_index >();
@@ -136,4 +138,190 @@ BOOST_AUTO_TEST_CASE( open_and_create ) {
    }
 }
 
+BOOST_AUTO_TEST_CASE( bulk_create ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db;
+      db.open( temp, 0, 1024*1024*8 );
+      db.add_index< book_index >();
+
+      BOOST_TEST_MESSAGE( "Bulk creating books without undo state" );
+      db.get_mutable_index< book_index >().reserve( 100 );
+      for( int i = 0; i < 100; ++i )
+      {
+         const auto& b = db.bulk_create<book>( [&]( book& b ) {
+            b.a = 100 - i;
+            b.b = i % 7;
+         });
+         BOOST_REQUIRE_EQUAL( b.id._id, i );
+      }
+      BOOST_REQUIRE_EQUAL( db.count<book>(), 100 );
+      BOOST_REQUIRE_EQUAL( db.get< book >( book::id_type(42) ).a, 58 );
+
+      const auto& by_a = db.get_index< book_index >().indices().get< 1 >();
+      BOOST_REQUIRE_EQUAL( by_a.begin()->a, 1 );
+      BOOST_REQUIRE_EQUAL( by_a.rbegin()->a, 100 );
+
+      BOOST_TEST_MESSAGE( "Bulk creating books in an undo session" );
+      {
+         auto session = db.start_undo_session();
+         const auto& b = db.bulk_create<book>( [&]( book& b ) { b.a = 1000; } );
+         BOOST_REQUIRE_EQUAL( b.id._id, 100 );
+         BOOST_CHECK_THROW( db.get_mutable_index< book_index >().bulk_restore( book::id_type(200), []( book& ) {} ), std::logic_error );
+      }
+      BOOST_REQUIRE_EQUAL( db.count<book>(), 100 );
+
+      BOOST_TEST_MESSAGE( "Restoring books with their own ids" );
+      auto& idx = db.get_mutable_index< book_index >();
+      idx.bulk_restore( book::id_type(150), []( book& b ) { b.a = 150; } );
+      BOOST_CHECK_THROW( idx.bulk_restore( book::id_type(120), []( book& ) {} ), std::logic_error );
+      BOOST_REQUIRE_EQUAL( idx.next_id()._id, 151 );
+      BOOST_REQUIRE_EQUAL( db.create<book>( []( book& ) {} ).id._id, 151 );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( undo_log ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db;
+      db.open( temp, 0, 1024*1024*32 );
+      db.add_index< book_index >();
+
+      for( int i = 0; i < 1000; ++i )
+         db.create<book>( [&]( book& b ) { b.a = i; b.b = i; } );
+
+      auto snapshot = [&]() {
+         std::vector< std::pair< int64_t, std::pair< int, int > > > books;
+         for( const auto& b : db.get_index< book_index >().indices() )
+            books.push_back( std::make_pair( b.id._id, std::make_pair( b.a, b.b ) ) );
+         return books;
+      };
+      auto before = snapshot();
+      const auto& idx = db.get_index< book_index >();
+
+      BOOST_TEST_MESSAGE( "Undoing modifies, removes and creates across squashed sessions" );
+      {
+         auto block = db.start_undo_session();
+         for( int t = 0; t < 10; ++t )
+         {
+            auto trx = db.start_undo_session();
+            for( int i = t * 90; i < t * 90 + 100; ++i )
+            {
+               const auto& b = db.get( book::id_type( i ) );
+               db.modify( b, [&]( book& b ) { b.a += 1000; } );
+               db.modify( b, [&]( book& b ) { b.b += 1000; } );
+            }
+            for( int i = 0; i < 5; ++i )
+            {
+               const auto& b = db.create<book>( [&]( book& b ) { b.a = -t; } );
+               if( i % 2 )
+                  db.remove( b );
+            }
+            const auto* r = db.find< book >( book::id_type( 950 + t * 5 ) );
+            if( r != nullptr )
+               db.remove( *r );
+            trx.squash();
+         }
+
+         BOOST_REQUIRE_EQUAL( db.get( book::id_type( 95 ) ).a, 2095 );
+         BOOST_REQUIRE( db.find< book >( book::id_type( 955 ) ) == nullptr );
+         BOOST_REQUIRE_EQUAL( idx.get_undo_statistics().records, 1010u );
+         BOOST_REQUIRE_LT( idx.get_undo_statistics().allocations, 100u );
+      }
+      BOOST_REQUIRE( snapshot() == before );
+      BOOST_REQUIRE_EQUAL( idx.next_id()._id, 1000 );
+
+      BOOST_TEST_MESSAGE( "Committing pushed sessions" );
+      for( int r = 0; r < 3; ++r )
+      {
+         auto session = db.start_undo_session();
+         db.modify( db.get( book::id_type( r ) ), [&]( book& b ) { b.a = -1; } );
+         db.create<book>( []( book& ) {} );
+         session.push();
+      }
+      db.undo();
+      BOOST_REQUIRE_EQUAL( db.get( book::id_type( 2 ) ).a, 2 );
+      BOOST_REQUIRE_EQUAL( db.count<book>(), 1002 );
+      db.commit( db.revision() );
+      db.undo();
+      BOOST_REQUIRE_EQUAL( db.get( book::id_type( 1 ) ).a, -1 );
+      BOOST_REQUIRE_EQUAL( db.count<book>(), 1002 );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( read_only_attach ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db;
+      db.open( temp, 0, 1024*1024*8 );
+      db.add_index< book_index >();
+      db.with_write_lock( [&]() {
+         db.create<book>( []( book& b ) { b.a = 1; b.b = -1; } );
+         db.create<book>( []( book& b ) { b.a = 2; b.b = -2; } );
+      });
+
+      chainbase::database reader;
+      reader.open( temp, chainbase::database::read_only );
+      reader.add_index< book_index >();
+      BOOST_REQUIRE( reader.is_read_only() );
+      BOOST_REQUIRE_EQUAL( reader.with_read_lock( [&]() { return reader.count< book >(); } ), 2u );
+      BOOST_CHECK_THROW( reader.with_write_lock( []() {} ), std::logic_error );
+
+      BOOST_TEST_MESSAGE( "Reading while another database object writes" );
+      std::atomic< bool > done( false );
+      std::thread writer( [&]()
+      {
+         for( int i = 0; i < 2000; ++i )
+         {
+            db.with_write_lock( [&]()
+            {
+               // Each write keeps a + b of every book at zero
+               for( int64_t id = 0; id < 2; ++id )
+                  db.modify( db.get( book::id_type( id ) ), [&]( book& b ) { b.a += 1; b.b -= 1; } );
+            });
+         }
+         done = true;
+      });
+
+      uint32_t reads = 0;
+      while( !done )
+      {
+         reader.with_read_lock( [&]()
+         {
+            for( const auto& b : reader.get_index< book_index >().indices() )
+               BOOST_REQUIRE_EQUAL( b.a + b.b, 0 );
+         });
+         ++reads;
+      }
+      writer.join();
+      BOOST_TEST_MESSAGE( reads << " reads" );
+      BOOST_REQUIRE_EQUAL( reader.with_read_lock( [&]() { return reader.get( book::id_type( 1 ) ).a; } ), 2002 );
+
+      BOOST_TEST_MESSAGE( "Remapping after the writer grows the file" );
+      db.with_write_lock( [&]()
+      {
+         db.resize( 1024*1024*16 );
+         for( int i = 0; i < 10000; ++i )
+            db.create<book>( [&]( book& b ) { b.a = i; } );
+      });
+      BOOST_REQUIRE_EQUAL( reader.with_read_lock( [&]() { return reader.count< book >(); } ), 10002u );
+      BOOST_REQUIRE_EQUAL( reader.get_max_memory(), 1024*1024*16u );
+
+      reader.close();
+      db.close();
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
 // BOOST_AUTO_TEST_SUITE_END()
@@ -38,6 +38,8 @@ namespace fc
          static variant  from_stream( buffered_istream& in, parse_type ptype = legacy_parser, uint32_t depth = 0 );
 
          static variant  from_string( const string& utf8_str, parse_type ptype = legacy_parser, uint32_t depth = 0 );
+         /// from_string without the buffer parser for well formed input, legacy parse types only
+         static variant  from_string_legacy( const string& utf8_str, parse_type ptype = legacy_parser, uint32_t depth = 0 );
          static variants variants_from_string( const string& utf8_str, parse_type ptype = legacy_parser, uint32_t depth = 0 );
          static string   to_string( const variant& v, output_formatting format = stringify_large_ints_and_doubles );
          static string   to_pretty_string( const variant& v, output_formatting format = stringify_large_ints_and_doubles );
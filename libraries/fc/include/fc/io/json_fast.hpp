@@ -0,0 +1,26 @@
+#pragma once
+#include <fc/io/json.hpp>
+
+namespace fc { namespace json_fast {
+
+   /**
+    *  Parses the first JSON value in [begin, end) into out, with the same result as the stream parser
+    *  of json::legacy_parser or json::legacy_parser_with_string_doubles.
+    *
+    *  String contents and bracket positions are found with vector instructions where the CPU has them.
+    *  Only well formed JSON is handled. For anything else, including input the legacy parser accepts
+    *  leniently (missing values between commas, unquoted tokens, numbers followed by letters) and every
+    *  error, false is returned so the caller can parse the input with the legacy parser and get its exact
+    *  result or exception.
+    *
+    *  depth is the depth of the value, as passed to the legacy variant_from_stream.
+    */
+   bool parse( const char* begin, const char* end, json::parse_type ptype, uint32_t depth, variant& out );
+
+   /// Returns the first of '{', '}', '[' or ']' in [begin, end), or end
+   const char* find_bracket( const char* begin, const char* end );
+
+   /// Name of the instruction set used to scan, "avx2", "sse2" or "scalar"
+   const char* scan_backend();
+
+} } // fc::json_fast
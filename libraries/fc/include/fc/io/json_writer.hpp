@@ -0,0 +1,274 @@
+#pragma once
+#include <fc/io/json.hpp>
+#include <fc/optional.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/container/flat_fwd.hpp>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fc
+{
+   /**
+    *  Writes JSON straight into a string buffer.
+    *
+    *  fc::json::to_string( variant( v ) ) builds a variant tree of the whole value before writing it.
+    *  to_json( v, writer ) walks reflected types and containers directly and produces the same text,
+    *  only values without a direct writer are converted through fc::variant, one value at a time.
+    *
+    *  A reflected type is only written field by field once it is marked with FC_REFLECT_JSON_WRITER,
+    *  which states that the type has no to_variant overload of its own. Everything else keeps the
+    *  variant conversion so custom representations (assets, keys, static_variants) are unchanged.
+    */
+   class json_writer
+   {
+      public:
+         json_writer( std::string& out, json::output_formatting format = json::stringify_large_ints_and_doubles )
+            : _out( out ), _format( format ) {}
+
+         void write_null()                { _out.append( "null", 4 ); }
+         void write_bool( bool b )        { b ? _out.append( "true", 4 ) : _out.append( "false", 5 ); }
+         void write_int( int64_t i );
+         void write_uint( uint64_t i );
+         void write_string( const char* s, size_t len );
+         void write_string( const std::string& s ) { write_string( s.data(), s.size() ); }
+         void write_variant( const variant& v );
+
+         /// Appends text that is already JSON
+         void write_raw( const char* s, size_t len ) { _out.append( s, len ); }
+         void write_raw( char c )                    { _out.push_back( c ); }
+
+         /// Writes the separator before the next element of an array or object
+         void next( bool& first )
+         {
+            if( !first )
+               _out.push_back( ',' );
+            first = false;
+         }
+
+         void write_key( const char* key, size_t len )
+         {
+            write_string( key, len );
+            _out.push_back( ':' );
+         }
+
+         std::string&               buffer()       { return _out; }
+         json::output_formatting    format()const  { return _format; }
+
+      private:
+         std::string&               _out;
+         json::output_formatting    _format;
+   };
+
+   template< typename T >
+   struct json_writer_reflected : std::false_type {};
+
+   // Direct writers. All overloads are declared before any is defined so that members and elements
+   // of any type find them regardless of include order.
+   template< typename T > void to_json( const T& v, json_writer& w );
+   inline void to_json( bool v, json_writer& w );
+   inline void to_json( int8_t v, json_writer& w );
+   inline void to_json( int16_t v, json_writer& w );
+   inline void to_json( int32_t v, json_writer& w );
+   inline void to_json( int64_t v, json_writer& w );
+   inline void to_json( uint8_t v, json_writer& w );
+   inline void to_json( uint16_t v, json_writer& w );
+   inline void to_json( uint32_t v, json_writer& w );
+   inline void to_json( uint64_t v, json_writer& w );
+#ifdef __APPLE__
+   inline void to_json( size_t v, json_writer& w );
+#elif !defined(_MSC_VER)
+   inline void to_json( long long v, json_writer& w );
+   inline void to_json( unsigned long long v, json_writer& w );
+#endif
+   inline void to_json( const std::string& v, json_writer& w );
+   inline void to_json( const variant& v, json_writer& w );
+   inline void to_json( const variant_object& v, json_writer& w );
+   inline void to_json( const std::vector< char >& v, json_writer& w );
+   template< typename T > void to_json( const optional< T >& v, json_writer& w );
+   template< typename T > void to_json( const std::vector< T >& v, json_writer& w );
+   template< typename T > void to_json( const std::deque< T >& v, json_writer& w );
+   template< typename... T > void to_json( const std::set< T... >& v, json_writer& w );
+   template< typename... T > void to_json( const std::multiset< T... >& v, json_writer& w );
+   template< typename T > void to_json( const flat_set< T >& v, json_writer& w );
+   template< typename A, typename B > void to_json( const std::pair< A, B >& v, json_writer& w );
+   template< typename K, typename... T > void to_json( const flat_map< K, T... >& v, json_writer& w );
+   template< typename K, typename T > void to_json( const std::map< K, T >& v, json_writer& w );
+   template< typename T > void to_json( const std::map< std::string, T >& v, json_writer& w );
+
+   namespace detail
+   {
+      template< typename T >
+      class to_json_visitor
+      {
+         public:
+            to_json_visitor( json_writer& w, const T& v ) : _w( w ), _val( v ) {}
+
+            template< typename Member, class Class, Member (Class::*member) >
+            void operator()( const char* name )const
+            {
+               add( name, _val.*member );
+            }
+
+         private:
+            // Null optionals are left out, as with to_variant
+            template< typename M >
+            void add( const char* name, const optional< M >& v )const
+            {
+               if( v.valid() )
+                  add( name, *v );
+            }
+
+            template< typename M >
+            void add( const char* name, const M& v )const
+            {
+               _w.next( _first );
+               _w.write_key( name, strlen( name ) );
+               to_json( v, _w );
+            }
+
+            json_writer&   _w;
+            const T&       _val;
+            mutable bool   _first = true;
+      };
+
+      template< typename Itr >
+      void to_json_array( Itr begin, Itr end, json_writer& w )
+      {
+         bool first = true;
+         w.write_raw( '[' );
+         for( ; begin != end; ++begin )
+         {
+            w.next( first );
+            to_json( *begin, w );
+         }
+         w.write_raw( ']' );
+      }
+
+      template< bool Reflected >
+      struct if_json_reflected
+      {
+         template< typename T >
+         static void write( const T& v, json_writer& w ) { w.write_variant( variant( v ) ); }
+      };
+
+      template<>
+      struct if_json_reflected< true >
+      {
+         template< typename T >
+         static void write( const T& v, json_writer& w )
+         {
+            w.write_raw( '{' );
+            fc::reflector< T >::visit( to_json_visitor< T >( w, v ) );
+            w.write_raw( '}' );
+         }
+      };
+   }
+
+   template< typename T >
+   void to_json( const T& v, json_writer& w )
+   {
+      detail::if_json_reflected< json_writer_reflected< T >::value >::write( v, w );
+   }
+
+   inline void to_json( bool v, json_writer& w )                 { w.write_bool( v ); }
+   inline void to_json( int8_t v, json_writer& w )               { w.write_int( v ); }
+   inline void to_json( int16_t v, json_writer& w )              { w.write_int( v ); }
+   inline void to_json( int32_t v, json_writer& w )              { w.write_int( v ); }
+   inline void to_json( int64_t v, json_writer& w )              { w.write_int( v ); }
+   inline void to_json( uint8_t v, json_writer& w )              { w.write_uint( v ); }
+   inline void to_json( uint16_t v, json_writer& w )             { w.write_uint( v ); }
+   inline void to_json( uint32_t v, json_writer& w )             { w.write_uint( v ); }
+   inline void to_json( uint64_t v, json_writer& w )             { w.write_uint( v ); }
+#ifdef __APPLE__
+   inline void to_json( size_t v, json_writer& w )               { w.write_uint( v ); }
+#elif !defined(_MSC_VER)
+   inline void to_json( long long v, json_writer& w )            { w.write_int( v ); }
+   inline void to_json( unsigned long long v, json_writer& w )   { w.write_uint( v ); }
+#endif
+   inline void to_json( const std::string& v, json_writer& w )   { w.write_string( v ); }
+   inline void to_json( const variant& v, json_writer& w )       { w.write_variant( v ); }
+   inline void to_json( const variant_object& v, json_writer& w ){ w.write_variant( variant( v ) ); }
+
+   // Blobs are hex encoded by to_variant
+   inline void to_json( const std::vector< char >& v, json_writer& w ) { w.write_variant( variant( v ) ); }
+
+   template< typename T >
+   void to_json( const optional< T >& v, json_writer& w )
+   {
+      if( v.valid() )
+         to_json( *v, w );
+      else
+         w.write_null();
+   }
+
+   template< typename T >
+   void to_json( const std::vector< T >& v, json_writer& w ) { detail::to_json_array( v.begin(), v.end(), w ); }
+
+   template< typename T >
+   void to_json( const std::deque< T >& v, json_writer& w ) { detail::to_json_array( v.begin(), v.end(), w ); }
+
+   template< typename... T >
+   void to_json( const std::set< T... >& v, json_writer& w ) { detail::to_json_array( v.begin(), v.end(), w ); }
+
+   template< typename... T >
+   void to_json( const std::multiset< T... >& v, json_writer& w ) { detail::to_json_array( v.begin(), v.end(), w ); }
+
+   template< typename T >
+   void to_json( const flat_set< T >& v, json_writer& w ) { detail::to_json_array( v.begin(), v.end(), w ); }
+
+   template< typename A, typename B >
+   void to_json( const std::pair< A, B >& v, json_writer& w )
+   {
+      w.write_raw( '[' );
+      to_json( v.first, w );
+      w.write_raw( ',' );
+      to_json( v.second, w );
+      w.write_raw( ']' );
+   }
+
+   // Maps are arrays of [key, value] pairs, except std::map with string keys which is an object
+   template< typename K, typename... T >
+   void to_json( const flat_map< K, T... >& v, json_writer& w ) { detail::to_json_array( v.begin(), v.end(), w ); }
+
+   template< typename K, typename T >
+   void to_json( const std::map< K, T >& v, json_writer& w ) { detail::to_json_array( v.begin(), v.end(), w ); }
+
+   template< typename T >
+   void to_json( const std::map< std::string, T >& v, json_writer& w )
+   {
+      bool first = true;
+      w.write_raw( '{' );
+      for( const auto& e : v )
+      {
+         w.next( first );
+         w.write_key( e.first.data(), e.first.size() );
+         to_json( e.second, w );
+      }
+      w.write_raw( '}' );
+   }
+
+   /// Serializes v like fc::json::to_string( fc::variant( v ) ). size_hint is reserved up front.
+   template< typename T >
+   std::string to_json_string( const T& v, size_t size_hint = 0, json::output_formatting format = json::stringify_large_ints_and_doubles )
+   {
+      std::string out;
+      out.reserve( size_hint );
+      json_writer w( out, format );
+      to_json( v, w );
+      return out;
+   }
+
+} // fc
+
+/**
+ *  Lets fc::to_json write TYPE field by field. Only use it for types that are converted to variants by
+ *  FC_REFLECT alone, a type with its own to_variant must keep the variant conversion.
+ */
+#define FC_REFLECT_JSON_WRITER( TYPE ) \
+namespace fc { template<> struct json_writer_reflected< TYPE > : std::true_type {}; }
@@ -1,4 +1,5 @@
 #include <fc/io/json.hpp>
+#include <fc/io/json_fast.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/io/iostream.hpp>
 #include <fc/io/buffered_iostream.hpp>
@@ -451,9 +452,11 @@ namespace fc
    {
       int32_t open_object = 0;
       int32_t open_array  = 0;
-      for( auto c : utf8_str )
+      const char* end = utf8_str.data() + utf8_str.size();
+      // Only brackets change the counts, so the check runs on each bracket rather than on every character
+      for( const char* c = json_fast::find_bracket( utf8_str.data(), end ); c != end; c = json_fast::find_bracket( c + 1, end ) )
       {
-         switch( c )
+         switch( *c )
          {
             case '{': open_object++; break;
             case '}': open_object--; break;
@@ -471,6 +474,14 @@ namespace fc
       FC_ASSERT( depth <= JSON_MAX_RECURSION_DEPTH );
       check_string_depth( utf8_str );
 
+      // Well formed input is parsed from the buffer directly, anything else by the stream parser below
+      if( ptype == legacy_parser || ptype == legacy_parser_with_string_doubles )
+      {
+         variant result;
+         if( json_fast::parse( utf8_str.data(), utf8_str.data() + utf8_str.size(), ptype, depth, result ) )
+            return result;
+      }
+
       fc::stringstream in( utf8_str );
       //in.exceptions( std::ifstream::eofbit );
       switch( ptype )
@@ -488,6 +499,24 @@ namespace fc
       }
    } FC_RETHROW_EXCEPTIONS( warn, "", ("str",utf8_str) ) }
 
+   variant json::from_string_legacy( const std::string& utf8_str, parse_type ptype, uint32_t depth )
+   { try {
+      depth++;
+      FC_ASSERT( depth <= JSON_MAX_RECURSION_DEPTH );
+      check_string_depth( utf8_str );
+
+      fc::stringstream in( utf8_str );
+      switch( ptype )
+      {
+          case legacy_parser:
+              return variant_from_stream<fc::stringstream, legacy_parser>( in, depth );
+          case legacy_parser_with_string_doubles:
+              return variant_from_stream<fc::stringstream, legacy_parser_with_string_doubles>( in, depth );
+          default:
+              return from_string( utf8_str, ptype, depth - 1 );
+      }
+   } FC_RETHROW_EXCEPTIONS( warn, "", ("str",utf8_str) ) }
+
    variants json::variants_from_string( const std::string& utf8_str, parse_type ptype, uint32_t depth )
    { try {
       depth++;
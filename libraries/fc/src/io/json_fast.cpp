@@ -0,0 +1,472 @@
+#include <fc/io/json_fast.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/variant_object.hpp>
+
+#include <cctype>
+#include <limits>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define FC_JSON_FAST_X86
+#endif
+
+namespace fc { namespace json_fast {
+
+   namespace
+   {
+      /*
+       * Scanners for the characters that end a run of plain string content ('"', '\\' and the 0x04
+       * end of transmission the legacy parser rejects) and for brackets. Each returns end when
+       * nothing is found. The x86 versions look at 16 or 32 bytes at once and finish with the scalar loop.
+       */
+
+      inline bool is_string_special( char c ) { return c == '"' || c == '\\' || c == 0x04; }
+      inline bool is_bracket( char c )        { return ( c & 0xDF ) == '[' || ( c & 0xDF ) == ']'; }
+
+      const char* find_string_special_scalar( const char* p, const char* end )
+      {
+         while( p != end && !is_string_special( *p ) )
+            ++p;
+         return p;
+      }
+
+      const char* find_bracket_scalar( const char* p, const char* end )
+      {
+         while( p != end && !is_bracket( *p ) )
+            ++p;
+         return p;
+      }
+
+#ifdef FC_JSON_FAST_X86
+      const char* find_string_special_sse2( const char* p, const char* end )
+      {
+         const __m128i quote = _mm_set1_epi8( '"' );
+         const __m128i backslash = _mm_set1_epi8( '\\' );
+         const __m128i eot = _mm_set1_epi8( 0x04 );
+
+         for( ; end - p >= 16; p += 16 )
+         {
+            __m128i chunk = _mm_loadu_si128( (const __m128i*)p );
+            __m128i match = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( chunk, quote ), _mm_cmpeq_epi8( chunk, backslash ) ),
+                                          _mm_cmpeq_epi8( chunk, eot ) );
+            uint32_t mask = (uint32_t)_mm_movemask_epi8( match );
+            if( mask )
+               return p + __builtin_ctz( mask );
+         }
+
+         return find_string_special_scalar( p, end );
+      }
+
+      // '[' and '{' differ only in bit 0x20, as do ']' and '}'
+      const char* find_bracket_sse2( const char* p, const char* end )
+      {
+         const __m128i fold = _mm_set1_epi8( (char)0xDF );
+         const __m128i open = _mm_set1_epi8( '[' );
+         const __m128i close = _mm_set1_epi8( ']' );
+
+         for( ; end - p >= 16; p += 16 )
+         {
+            __m128i chunk = _mm_and_si128( _mm_loadu_si128( (const __m128i*)p ), fold );
+            __m128i match = _mm_or_si128( _mm_cmpeq_epi8( chunk, open ), _mm_cmpeq_epi8( chunk, close ) );
+            uint32_t mask = (uint32_t)_mm_movemask_epi8( match );
+            if( mask )
+               return p + __builtin_ctz( mask );
+         }
+
+         return find_bracket_scalar( p, end );
+      }
+
+      __attribute__((target("avx2")))
+      const char* find_string_special_avx2( const char* p, const char* end )
+      {
+         const __m256i quote = _mm256_set1_epi8( '"' );
+         const __m256i backslash = _mm256_set1_epi8( '\\' );
+         const __m256i eot = _mm256_set1_epi8( 0x04 );
+
+         for( ; end - p >= 32; p += 32 )
+         {
+            __m256i chunk = _mm256_loadu_si256( (const __m256i*)p );
+            __m256i match = _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( chunk, quote ), _mm256_cmpeq_epi8( chunk, backslash ) ),
+                                             _mm256_cmpeq_epi8( chunk, eot ) );
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8( match );
+            if( mask )
+               return p + __builtin_ctz( mask );
+         }
+
+         return find_string_special_sse2( p, end );
+      }
+
+      __attribute__((target("avx2")))
+      const char* find_bracket_avx2( const char* p, const char* end )
+      {
+         const __m256i fold = _mm256_set1_epi8( (char)0xDF );
+         const __m256i open = _mm256_set1_epi8( '[' );
+         const __m256i close = _mm256_set1_epi8( ']' );
+
+         for( ; end - p >= 32; p += 32 )
+         {
+            __m256i chunk = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)p ), fold );
+            __m256i match = _mm256_or_si256( _mm256_cmpeq_epi8( chunk, open ), _mm256_cmpeq_epi8( chunk, close ) );
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8( match );
+            if( mask )
+               return p + __builtin_ctz( mask );
+         }
+
+         return find_bracket_sse2( p, end );
+      }
+#endif
+
+      struct scanner
+      {
+         const char* (*find_string_special)( const char*, const char* );
+         const char* (*find_bracket)( const char*, const char* );
+         const char* name;
+      };
+
+      const scanner& get_scanner()
+      {
+         static const scanner s = []()
+         {
+#ifdef FC_JSON_FAST_X86
+            __builtin_cpu_init();
+            if( __builtin_cpu_supports( "avx2" ) )
+               return scanner{ find_string_special_avx2, find_bracket_avx2, "avx2" };
+            return scanner{ find_string_special_sse2, find_bracket_sse2, "sse2" };
+#else
+            return scanner{ find_string_special_scalar, find_bracket_scalar, "scalar" };
+#endif
+         }();
+         return s;
+      }
+
+      /**
+       * Recursive descent over a buffer that follows the structure of the legacy variant_from_stream,
+       * objectFromStream and arrayFromStream, including their depth accounting. Every method returns
+       * false as soon as the input leaves the well formed subset.
+       */
+      template< json::parse_type parser_type >
+      class parser
+      {
+         public:
+            parser( const char* begin, const char* end )
+               : _pos( begin ), _end( end ), _find_string_special( get_scanner().find_string_special ) {}
+
+            bool parse_value( variant& out, uint32_t depth )
+            {
+               depth++;
+               if( depth > JSON_MAX_RECURSION_DEPTH )
+                  return false;
+
+               skip_white_space();
+               if( _pos == _end )
+                  return false;
+
+               switch( *_pos )
+               {
+                  case '"':
+                  {
+                     std::string str;
+                     if( !parse_string( str ) )
+                        return false;
+                     out = variant( std::move( str ) );
+                     return true;
+                  }
+                  case '{':
+                     return parse_object( out, depth );
+                  case '[':
+                     return parse_array( out, depth );
+                  case '-':
+                  case '.':
+                  case '0':
+                  case '1':
+                  case '2':
+                  case '3':
+                  case '4':
+                  case '5':
+                  case '6':
+                  case '7':
+                  case '8':
+                  case '9':
+                     return parse_number( out );
+                  case 'n':
+                  case 't':
+                  case 'f':
+                     return parse_token( out );
+                  default:
+                     return false;
+               }
+            }
+
+         private:
+            void skip_white_space()
+            {
+               while( _pos != _end && ( *_pos == ' ' || *_pos == '\t' || *_pos == '\n' || *_pos == '\r' ) )
+                  ++_pos;
+            }
+
+            // Escapes are resolved like the legacy parseEscape, \t \n \r and \\ are translated and any
+            // other escaped character is kept as is, so A becomes u0041
+            bool parse_string( std::string& out )
+            {
+               ++_pos;
+
+               while( true )
+               {
+                  const char* special = _find_string_special( _pos, _end );
+                  if( special == _end )
+                     return false;
+
+                  out.append( _pos, special - _pos );
+                  _pos = special;
+
+                  switch( *_pos )
+                  {
+                     case '"':
+                        ++_pos;
+                        return true;
+                     case '\\':
+                        if( _end - _pos < 2 )
+                           return false;
+                        switch( _pos[1] )
+                        {
+                           case 't': out.push_back( '\t' ); break;
+                           case 'n': out.push_back( '\n' ); break;
+                           case 'r': out.push_back( '\r' ); break;
+                           default:  out.push_back( _pos[1] ); break;
+                        }
+                        _pos += 2;
+                        break;
+                     default:
+                        return false;
+                  }
+               }
+            }
+
+            bool parse_number( variant& out )
+            {
+               const char* start = _pos;
+               bool neg = false;
+               bool dot = false;
+               bool digits = false;
+
+               if( *_pos == '-' )
+               {
+                  neg = true;
+                  ++_pos;
+               }
+
+               for( ; _pos != _end; ++_pos )
+               {
+                  if( *_pos >= '0' && *_pos <= '9' )
+                     digits = true;
+                  else if( *_pos == '.' && !dot )
+                     dot = true;
+                  else
+                     break;
+               }
+
+               // A second '.', exponents and trailing letters are legacy parser territory
+               if( !digits )
+                  return false;
+               if( _pos != _end && ( *_pos == '.' || (unsigned char)*_pos >= 0x80 || isalnum( *_pos ) ) )
+                  return false;
+
+               if( dot )
+               {
+                  std::string str( start, _pos );
+                  if( parser_type == json::legacy_parser_with_string_doubles )
+                     out = variant( std::move( str ) );
+                  else
+                     out = variant( fc::to_double( str ) );
+                  return true;
+               }
+
+               uint64_t value = 0;
+               for( const char* p = start + ( neg ? 1 : 0 ); p != _pos; ++p )
+               {
+                  uint64_t digit = *p - '0';
+                  if( value > ( std::numeric_limits< uint64_t >::max() - digit ) / 10 )
+                     return false;
+                  value = value * 10 + digit;
+               }
+
+               if( neg )
+               {
+                  if( value > uint64_t( std::numeric_limits< int64_t >::max() ) + 1 )
+                     return false;
+                  out = variant( value == uint64_t( std::numeric_limits< int64_t >::max() ) + 1
+                     ? std::numeric_limits< int64_t >::min() : -int64_t( value ) );
+               }
+               else
+               {
+                  out = variant( value );
+               }
+               return true;
+            }
+
+            // The legacy token_from_stream reads every following character of "nultreafs"
+            bool parse_token( variant& out )
+            {
+               const char* start = _pos;
+               while( _pos != _end )
+               {
+                  switch( *_pos )
+                  {
+                     case 'n': case 'u': case 'l': case 't': case 'r': case 'e': case 'f': case 'a': case 's':
+                        ++_pos;
+                        continue;
+                  }
+                  break;
+               }
+
+               size_t len = _pos - start;
+               if( len == 4 && memcmp( start, "null", 4 ) == 0 )
+                  out = variant();
+               else if( len == 4 && memcmp( start, "true", 4 ) == 0 )
+                  out = variant( true );
+               else if( len == 5 && memcmp( start, "false", 5 ) == 0 )
+                  out = variant( false );
+               else
+                  return false;
+
+               return true;
+            }
+
+            bool parse_object( variant& out, uint32_t depth )
+            {
+               depth++;
+               if( depth > JSON_MAX_RECURSION_DEPTH )
+                  return false;
+
+               mutable_variant_object obj;
+               ++_pos;
+               skip_white_space();
+
+               if( _pos != _end && *_pos == '}' )
+               {
+                  ++_pos;
+                  out = variant( std::move( obj ) );
+                  return true;
+               }
+
+               while( true )
+               {
+                  if( _pos == _end || *_pos != '"' )
+                     return false;
+
+                  std::string key;
+                  if( !parse_string( key ) )
+                     return false;
+
+                  skip_white_space();
+                  if( _pos == _end || *_pos != ':' )
+                     return false;
+                  ++_pos;
+
+                  variant value;
+                  if( !parse_value( value, depth ) )
+                     return false;
+
+                  obj( std::move( key ), std::move( value ) );
+
+                  skip_white_space();
+                  if( _pos == _end )
+                     return false;
+
+                  if( *_pos == '}' )
+                  {
+                     ++_pos;
+                     out = variant( std::move( obj ) );
+                     return true;
+                  }
+
+                  if( *_pos != ',' )
+                     return false;
+                  ++_pos;
+                  skip_white_space();
+               }
+            }
+
+            bool parse_array( variant& out, uint32_t depth )
+            {
+               depth++;
+               if( depth > JSON_MAX_RECURSION_DEPTH )
+                  return false;
+
+               variants arr;
+               ++_pos;
+               skip_white_space();
+
+               if( _pos != _end && *_pos == ']' )
+               {
+                  ++_pos;
+                  out = variant( std::move( arr ) );
+                  return true;
+               }
+
+               while( true )
+               {
+                  // A ',' here would be skipped by the legacy parser
+                  if( _pos == _end || *_pos == ',' )
+                     return false;
+
+                  arr.emplace_back();
+                  if( !parse_value( arr.back(), depth ) )
+                     return false;
+
+                  skip_white_space();
+                  if( _pos == _end )
+                     return false;
+
+                  if( *_pos == ']' )
+                  {
+                     ++_pos;
+                     out = variant( std::move( arr ) );
+                     return true;
+                  }
+
+                  if( *_pos != ',' )
+                     return false;
+                  ++_pos;
+                  skip_white_space();
+               }
+            }
+
+            const char*    _pos;
+            const char*    _end;
+            const char*    (*_find_string_special)( const char*, const char* );
+      };
+   }
+
+   bool parse( const char* begin, const char* end, json::parse_type ptype, uint32_t depth, variant& out )
+   {
+      try
+      {
+         switch( ptype )
+         {
+            case json::legacy_parser:
+               return parser< json::legacy_parser >( begin, end ).parse_value( out, depth );
+            case json::legacy_parser_with_string_doubles:
+               return parser< json::legacy_parser_with_string_doubles >( begin, end ).parse_value( out, depth );
+            default:
+               return false;
+         }
+      }
+      catch( const fc::exception& )
+      {
+         // Numbers the legacy parser rejects as well, let it report them
+         return false;
+      }
+   }
+
+   const char* find_bracket( const char* begin, const char* end )
+   {
+      return get_scanner().find_bracket( begin, end );
+   }
+
+   const char* scan_backend()
+   {
+      return get_scanner().name;
+   }
+
+} } // fc::json_fast
@@ -0,0 +1,142 @@
+#include <fc/io/json_writer.hpp>
+#include <fc/variant_object.hpp>
+
+namespace fc
+{
+   namespace
+   {
+      // Escape sequence of every character below 0x20, '"' and '\\', matching fc::escape_string
+      const char* escape_sequence( unsigned char c )
+      {
+         static const char* control[ 0x20 ] =
+         {
+            "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+            "\\b",     "\\t",     "\\n",     "\\u000b", "\\f",     "\\r",     "\\u000e", "\\u000f",
+            "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+            "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f"
+         };
+
+         if( c < 0x20 )
+            return control[ c ];
+         if( c == '"' )
+            return "\\\"";
+         if( c == '\\' )
+            return "\\\\";
+         return nullptr;
+      }
+   }
+
+   void json_writer::write_int( int64_t i )
+   {
+      if( _format == json::stringify_large_ints_and_doubles && i > 0xffffffff )
+      {
+         _out.push_back( '"' );
+         _out += std::to_string( i );
+         _out.push_back( '"' );
+      }
+      else
+      {
+         _out += std::to_string( i );
+      }
+   }
+
+   void json_writer::write_uint( uint64_t i )
+   {
+      if( _format == json::stringify_large_ints_and_doubles && i > 0xffffffff )
+      {
+         _out.push_back( '"' );
+         _out += std::to_string( i );
+         _out.push_back( '"' );
+      }
+      else
+      {
+         _out += std::to_string( i );
+      }
+   }
+
+   void json_writer::write_string( const char* s, size_t len )
+   {
+      _out.reserve( _out.size() + len + 2 );
+      _out.push_back( '"' );
+
+      // Copy runs of characters that need no escaping at once
+      const char* run = s;
+      const char* end = s + len;
+      for( const char* c = s; c != end; ++c )
+      {
+         const char* esc = escape_sequence( (unsigned char)*c );
+         if( esc == nullptr )
+            continue;
+
+         _out.append( run, c - run );
+         _out.append( esc );
+         run = c + 1;
+      }
+      _out.append( run, end - run );
+
+      _out.push_back( '"' );
+   }
+
+   void json_writer::write_variant( const variant& v )
+   {
+      switch( v.get_type() )
+      {
+         case variant::null_type:
+            write_null();
+            return;
+         case variant::int64_type:
+            write_int( v.as_int64() );
+            return;
+         case variant::uint64_type:
+            write_uint( v.as_uint64() );
+            return;
+         case variant::double_type:
+            if( _format == json::stringify_large_ints_and_doubles )
+            {
+               _out.push_back( '"' );
+               _out += v.as_string();
+               _out.push_back( '"' );
+            }
+            else
+            {
+               _out += v.as_string();
+            }
+            return;
+         case variant::bool_type:
+            write_bool( v.as_bool() );
+            return;
+         case variant::string_type:
+            write_string( v.get_string() );
+            return;
+         case variant::blob_type:
+            write_string( v.as_string() );
+            return;
+         case variant::array_type:
+         {
+            bool first = true;
+            _out.push_back( '[' );
+            for( const auto& e : v.get_array() )
+            {
+               next( first );
+               write_variant( e );
+            }
+            _out.push_back( ']' );
+            return;
+         }
+         case variant::object_type:
+         {
+            bool first = true;
+            _out.push_back( '{' );
+            for( const auto& e : v.get_object() )
+            {
+               next( first );
+               write_key( e.key().data(), e.key().size() );
+               write_variant( e.value() );
+            }
+            _out.push_back( '}' );
+            return;
+         }
+      }
+   }
+
+} // fc
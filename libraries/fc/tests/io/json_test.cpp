@@ -0,0 +1,263 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/io/json_fast.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/variant_object.hpp>
+
+#include <random>
+
+using namespace fc;
+
+namespace
+{
+   // Unlike operator==, distinguishes types, so "1" and 1 or int64 and uint64 are different
+   bool same_variant( const variant& a, const variant& b )
+   {
+      if( a.get_type() != b.get_type() )
+         return false;
+
+      switch( a.get_type() )
+      {
+         case variant::null_type:
+            return true;
+         case variant::int64_type:
+            return a.as_int64() == b.as_int64();
+         case variant::uint64_type:
+            return a.as_uint64() == b.as_uint64();
+         case variant::double_type:
+            return a.as_double() == b.as_double();
+         case variant::bool_type:
+            return a.as_bool() == b.as_bool();
+         case variant::string_type:
+            return a.get_string() == b.get_string();
+         case variant::array_type:
+         {
+            const auto& x = a.get_array();
+            const auto& y = b.get_array();
+            if( x.size() != y.size() )
+               return false;
+            for( size_t i = 0; i < x.size(); ++i )
+               if( !same_variant( x[i], y[i] ) )
+                  return false;
+            return true;
+         }
+         case variant::object_type:
+         {
+            const auto& x = a.get_object();
+            const auto& y = b.get_object();
+            if( x.size() != y.size() )
+               return false;
+            for( auto i = x.begin(), j = y.begin(); i != x.end(); ++i, ++j )
+               if( i->key() != j->key() || !same_variant( i->value(), j->value() ) )
+                  return false;
+            return true;
+         }
+         default:
+            return false;
+      }
+   }
+
+   // from_string must give the legacy result, or throw when the legacy parser throws
+   void check_equivalent( const std::string& json, json::parse_type ptype )
+   {
+      optional< variant > legacy;
+      try
+      {
+         legacy = json::from_string_legacy( json, ptype );
+      }
+      catch( const fc::exception& ) {}
+
+      optional< variant > fast;
+      try
+      {
+         fast = json::from_string( json, ptype );
+      }
+      catch( const fc::exception& ) {}
+
+      BOOST_CHECK_MESSAGE( legacy.valid() == fast.valid(), "mismatch on " + json );
+      if( legacy.valid() && fast.valid() )
+         BOOST_CHECK_MESSAGE( same_variant( *legacy, *fast ), "mismatch on " + json );
+   }
+
+   const std::vector< std::string > well_formed =
+   {
+      "null",
+      "true",
+      "false",
+      "0",
+      "-0",
+      "42",
+      "-42",
+      "18446744073709551615",
+      "-9223372036854775808",
+      "1.5",
+      "-0.25",
+      ".5",
+      "1.",
+      "\"\"",
+      "\"plain\"",
+      "\"esc \\\" \\\\ \\/ \\t \\n \\r \\b \\u0041\"",
+      "\"utf8 \xc3\xa9\xe2\x82\xac\"",
+      "\"a string longer than thirty two bytes so the vector loop runs more than once\"",
+      "[]",
+      "{}",
+      "[1,2,3]",
+      " [ 1 , \"two\" , 3.0 , null , true , false ] ",
+      "{\"a\":1,\"b\":[{\"c\":\"d\"}],\"e\":{}}",
+      "{\"dup\":1,\"dup\":2}",
+      "{\"jsonrpc\":\"2.0\",\"method\":\"call\",\"params\":[\"database_api\",\"get_dynamic_global_properties\",{}],\"id\":1}",
+      "\t\r\n{ \"k\" :\n[ [ [ ] ] ] }",
+      "1 trailing input is ignored",
+      "nullx",
+   };
+
+   const std::vector< std::string > not_handled =
+   {
+      "",
+      "   ",
+      "[",
+      "{",
+      "]",
+      "\"unterminated",
+      "\"trailing escape\\",
+      "\"eot \x04\"",
+      "[1,]",
+      "[,1]",
+      "[1 2]",
+      "{\"a\":1,}",
+      "{\"a\" 1}",
+      "{\"a\":1 \"b\":2}",
+      "{a:1}",
+      "1.2.3",
+      "12abc",
+      "1e5",
+      "-",
+      ".",
+      "-.",
+      "18446744073709551616",
+      "-9223372036854775809",
+      "tru",
+      "nul",
+      "falsey",
+      "[nullx]",
+      "undefined",
+      "#",
+      "\x04",
+   };
+}
+
+BOOST_AUTO_TEST_SUITE(fc)
+
+BOOST_AUTO_TEST_CASE(json_fast_well_formed)
+{
+   BOOST_TEST_MESSAGE( std::string( "scan backend: " ) + json_fast::scan_backend() );
+
+   for( auto ptype : { json::legacy_parser, json::legacy_parser_with_string_doubles } )
+   {
+      for( const auto& json : well_formed )
+      {
+         variant fast;
+         BOOST_CHECK_MESSAGE( json_fast::parse( json.data(), json.data() + json.size(), ptype, 1, fast ), "not parsed: " + json );
+         BOOST_CHECK_MESSAGE( same_variant( fast, json::from_string_legacy( json, ptype ) ), "mismatch on " + json );
+         check_equivalent( json, ptype );
+      }
+   }
+
+   BOOST_CHECK( json::from_string( "1.5", json::legacy_parser_with_string_doubles ).is_string() );
+   BOOST_CHECK( json::from_string( "1.5" ).is_double() );
+   BOOST_CHECK( json::from_string( "-1" ).is_int64() );
+   BOOST_CHECK( json::from_string( "1" ).is_uint64() );
+}
+
+BOOST_AUTO_TEST_CASE(json_fast_falls_back)
+{
+   for( auto ptype : { json::legacy_parser, json::legacy_parser_with_string_doubles } )
+   {
+      for( const auto& json : not_handled )
+      {
+         check_equivalent( json, ptype );
+      }
+   }
+}
+
+BOOST_AUTO_TEST_CASE(json_fast_depth)
+{
+   for( uint32_t levels : { 98, 99, 100, 101 } )
+   {
+      check_equivalent( std::string( levels, '[' ) + std::string( levels, ']' ), json::legacy_parser );
+      check_equivalent( std::string( levels, '{' ) + std::string( levels, '}' ), json::legacy_parser );
+   }
+
+   // Brackets inside strings still count
+   check_equivalent( "\"" + std::string( 100, '[' ) + "\"", json::legacy_parser );
+   BOOST_CHECK_THROW( json::from_string( std::string( 100, '[' ) + std::string( 100, ']' ) ), fc::exception );
+
+   // Alternating objects and arrays reach the recursion limit before check_string_depth
+   std::string nested;
+   for( int i = 0; i < 60; ++i )
+      nested += "[{\"k\":";
+   nested += "1";
+   for( int i = 0; i < 60; ++i )
+      nested += "}]";
+   check_equivalent( nested, json::legacy_parser );
+   BOOST_CHECK_THROW( json::from_string( nested ), fc::exception );
+
+   // The caller's depth counts as well
+   check_equivalent( "[[[1]]]", json::legacy_parser );
+   BOOST_CHECK_THROW( json::from_string( "[[[1]]]", json::legacy_parser, JSON_MAX_RECURSION_DEPTH - 4 ), fc::exception );
+}
+
+BOOST_AUTO_TEST_CASE(json_fast_fuzz)
+{
+   static const char alphabet[] = "{}[]\":,.-0123456789 \t\nnulltruefalse\\x\x04";
+   std::mt19937 rng( 1234 );
+
+   std::vector< std::string > seeds( well_formed );
+   seeds.insert( seeds.end(), not_handled.begin(), not_handled.end() );
+
+   for( int i = 0; i < 20000; ++i )
+   {
+      std::string json = seeds[ rng() % seeds.size() ];
+
+      // Mutate a few bytes: replace, insert, delete or splice in another seed
+      for( uint32_t m = 0, count = 1 + rng() % 4; m < count; ++m )
+      {
+         size_t pos = json.empty() ? 0 : rng() % ( json.size() + 1 );
+         switch( rng() % 4 )
+         {
+            case 0:
+               if( pos < json.size() )
+                  json[ pos ] = alphabet[ rng() % ( sizeof( alphabet ) - 1 ) ];
+               break;
+            case 1:
+               json.insert( pos, 1, alphabet[ rng() % ( sizeof( alphabet ) - 1 ) ] );
+               break;
+            case 2:
+               if( pos < json.size() )
+                  json.erase( pos, 1 );
+               break;
+            default:
+               json.insert( pos, seeds[ rng() % seeds.size() ] );
+               break;
+         }
+      }
+
+      check_equivalent( json, i % 2 ? json::legacy_parser : json::legacy_parser_with_string_doubles );
+   }
+}
+
+BOOST_AUTO_TEST_CASE(json_fast_find_bracket)
+{
+   std::string text( 100, 'a' );
+   text[ 37 ] = '{';
+   text[ 70 ] = ']';
+   text[ 71 ] = '{' | 0x80; // Must not match after the case fold
+
+   const char* end = text.data() + text.size();
+   BOOST_CHECK_EQUAL( json_fast::find_bracket( text.data(), end ) - text.data(), 37 );
+   BOOST_CHECK_EQUAL( json_fast::find_bracket( text.data() + 38, end ) - text.data(), 70 );
+   BOOST_CHECK( json_fast::find_bracket( text.data() + 71, end ) == end );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,29 +3,44 @@
 
 #include <steem/plugins/account_history_rocksdb/account_history_rocksdb_plugin.hpp>
 
+#include <steem/chain/block_log_scanner.hpp>
 #include <steem/chain/database.hpp>
+#include <steem/chain/database_exceptions.hpp>
 #include <steem/chain/history_object.hpp>
 #include <steem/chain/index.hpp>
 #include <steem/chain/util/impacted.hpp>
 
 #include <steem/plugins/chain/chain_plugin.hpp>
+#include <steem/plugins/statsd/utility.hpp>
 
 #include <steem/utilities/benchmark_dumper.hpp>
 #include <steem/utilities/plugin_utilities.hpp>
 
 #include <appbase/application.hpp>
 
+#include <rocksdb/cache.h>
+#include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
+#include <rocksdb/filter_policy.h>
 #include <rocksdb/options.h>
 #include <rocksdb/slice.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/sst_file_writer.h>
+#include <rocksdb/table.h>
 #include <rocksdb/utilities/write_batch_with_index.h>
 
 #include <boost/type.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/container/flat_set.hpp>
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
 #include <limits>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <typeindex>
 #include <typeinfo>
 
@@ -42,10 +57,16 @@ namespace bpo = boost::program_options;
 #define OPERATION_BY_BLOCK 3
 #define AH_INFO_BY_NAME 4
 #define AH_OPERATION_BY_ID 5
+#define AH_CHUNK_BY_ID 6
 
 #define WRITE_BUFFER_FLUSH_LIMIT     10
+/// Blocks prepared by the import threads before they are merged into SST files
+#define IMPORT_WINDOW_BLOCKS         20000
+#define IMPORT_CHUNK_BLOCKS          500
 #define ACCOUNT_HISTORY_LENGTH_LIMIT 30
 #define ACCOUNT_HISTORY_TIME_LIMIT   30
+/// Number of consecutive account history entries summarized by one account_history_chunk_info
+#define ACCOUNT_HISTORY_CHUNK_SIZE   1000
 #define VIRTUAL_OP_FLAG              0x8000000000000000
 
 /** Because localtion_id_pair stores block_number paired with (VIRTUAL_OP_FLAG|operation_id),
@@ -54,7 +75,7 @@ namespace bpo = boost::program_options;
 #define MAX_OPERATION_ID             std::numeric_limits<int64_t>::max()
 
 #define STORE_MAJOR_VERSION          1
-#define STORE_MINOR_VERSION          0
+#define STORE_MINOR_VERSION          2
 
 namespace steem { namespace plugins { namespace account_history_rocksdb {
 
@@ -81,6 +102,7 @@ using ::rocksdb::ColumnFamilyDescriptor;
 using ::rocksdb::ColumnFamilyOptions;
 using ::rocksdb::ColumnFamilyHandle;
 using ::rocksdb::WriteBatch;
+using ::rocksdb::SstFileWriter;
 
 /** Represents an AH entry in mapped to account name.
  *  Holds additional informations, which are needed to simplify pruning process.
@@ -101,6 +123,44 @@ public:
    }
 };
 
+/** Summary of ACCOUNT_HISTORY_CHUNK_SIZE consecutive entries of an account history, stored by account history id
+ *  and chunk number. Filtered queries use it to skip whole chunks without reading their operations.
+ */
+class account_history_chunk_info
+{
+public:
+   /// Bit n is set when the chunk holds an operation of type n, opTypesHigh holding the types from 64.
+   uint64_t       opTypesLow = 0;
+   uint64_t       opTypesHigh = 0;
+   uint32_t       firstBlock = 0;
+   uint32_t       lastBlock = 0;
+   time_point_sec firstTimestamp;
+   time_point_sec lastTimestamp;
+
+   void addOperation(const rocksdb_operation_object& obj)
+   {
+      /// The operation type is the static_variant tag, packed first.
+      fc::unsigned_int type;
+      fc::datastream<const char*> ds(obj.serialized_op.data(), obj.serialized_op.size());
+      fc::raw::unpack(ds, type);
+
+      FC_ASSERT(type.value < 128, "Operation type ${t} does not fit the chunk bitmap", ("t", type.value));
+      if(type.value < 64)
+         opTypesLow |= uint64_t(1) << type.value;
+      else
+         opTypesHigh |= uint64_t(1) << (type.value - 64);
+
+      if(firstBlock == 0)
+      {
+         firstBlock = obj.block;
+         firstTimestamp = obj.timestamp;
+      }
+
+      lastBlock = obj.block;
+      lastTimestamp = obj.timestamp;
+   }
+};
+
 namespace
 {
    template <class T>
@@ -134,8 +194,11 @@ template <typename T>
 class PrimitiveTypeSlice final : public Slice
 {
 public:
-   explicit PrimitiveTypeSlice(T value) : _value(value)
+   explicit PrimitiveTypeSlice(T value)
    {
+      /// The bloom filters hash the raw key bytes, so padding between pair members must not hold garbage.
+      std::memset(&_value, 0, sizeof(T));
+      store(value);
       data_ = reinterpret_cast<const char*>(&_value);
       size_ = sizeof(T);
    }
@@ -153,6 +216,19 @@ public:
    }
 
 private:
+   template <typename U>
+   void store(const U& value)
+   {
+      _value = value;
+   }
+
+   template <typename First, typename Second>
+   void store(const std::pair<First, Second>& value)
+   {
+      std::memcpy(&_value.first, &value.first, sizeof(First));
+      std::memcpy(&_value.second, &value.second, sizeof(Second));
+   }
+
    T _value;
 };
 
@@ -341,9 +417,41 @@ public:
       checkStatus(s);
    }
 
+   bool getChunkInfo(const ah_op_id_pair& key, account_history_chunk_info* chunk) const
+   {
+      auto fi = _chunkInfoCache.find(key);
+      if(fi != _chunkInfoCache.end())
+      {
+         *chunk = fi->second;
+         return true;
+      }
+
+      ah_op_by_id_slice_t keySlice(key);
+      PinnableSlice buffer;
+      auto s = _storage->Get(ReadOptions(), _columnHandles[AH_CHUNK_BY_ID], keySlice, &buffer);
+      if(s.ok())
+      {
+         load(*chunk, buffer.data(), buffer.size());
+         return true;
+      }
+
+      FC_ASSERT(s.IsNotFound());
+      return false;
+   }
+
+   void putChunkInfo(const ah_op_id_pair& key, const account_history_chunk_info& chunk)
+   {
+      _chunkInfoCache[key] = chunk;
+      auto serializeBuf = dump(chunk);
+      ah_op_by_id_slice_t keySlice(key);
+      auto s = Put(_columnHandles[AH_CHUNK_BY_ID], keySlice, Slice(serializeBuf.data(), serializeBuf.size()));
+      checkStatus(s);
+   }
+
    void Clear()
    {
       _ahInfoCache.clear();
+      _chunkInfoCache.clear();
       WriteBatch::Clear();
    }
 
@@ -351,9 +459,65 @@ private:
    const std::unique_ptr<DB>&                        _storage;
    const std::vector<ColumnFamilyHandle*>&           _columnHandles;
    std::map<account_name_type, account_history_info> _ahInfoCache;
+   std::map<ah_op_id_pair, account_history_chunk_info> _chunkInfoCache;
 };
 
 
+/// An operation with its impacted accounts. Its ids are assigned when it is written to the storage.
+struct prepared_import_op
+{
+   rocksdb_operation_object         obj;
+   std::vector<account_name_type>   impacted;
+};
+
+/// Operations which became irreversible with a block, waiting for the writer thread
+struct irreversible_block_ops
+{
+   /// The operations come from blocks [first_block_num, block_num]
+   uint32_t                         first_block_num = 0;
+   uint32_t                         block_num = 0;
+   std::vector<prepared_import_op>  ops;
+};
+
+typedef std::shared_ptr<const irreversible_block_ops> irreversible_block_ops_ptr;
+
+/// Operations of one import window, by chunk of IMPORT_CHUNK_BLOCKS blocks
+typedef std::vector<std::vector<prepared_import_op>> import_window_t;
+
+/// Key-value pairs collected for one column family and written to an SST file
+typedef std::vector<std::pair<std::string, std::string>> sst_entries_t;
+
+void addSstEntry(sst_entries_t* entries, const Slice& key, const Slice& value)
+{
+   entries->emplace_back(key.ToString(), value.ToString());
+}
+
+/// Converts a compression name of the options, failing when it is unknown or not built into RocksDB.
+::rocksdb::CompressionType parseCompressionType(std::string name)
+{
+   static const std::map<std::string, ::rocksdb::CompressionType> compressionNames = {
+      { "none", ::rocksdb::kNoCompression },
+      { "snappy", ::rocksdb::kSnappyCompression },
+      { "zlib", ::rocksdb::kZlibCompression },
+      { "bzip2", ::rocksdb::kBZip2Compression },
+      { "lz4", ::rocksdb::kLZ4Compression },
+      { "lz4hc", ::rocksdb::kLZ4HCCompression },
+      { "xpress", ::rocksdb::kXpressCompression },
+      { "zstd", ::rocksdb::kZSTD }
+   };
+
+   boost::trim(name);
+   auto nameItr = compressionNames.find(name);
+   FC_ASSERT(nameItr != compressionNames.end(), "Unknown compression `${c}'", ("c", name));
+
+   auto supported = ::rocksdb::GetSupportedCompressions();
+   supported.push_back(::rocksdb::kNoCompression);
+   FC_ASSERT(std::find(supported.begin(), supported.end(), nameItr->second) != supported.end(),
+      "Compression `${c}' is not supported by this RocksDB build", ("c", name));
+
+   return nameItr->second;
+}
+
 } /// anonymous
 
 class account_history_rocksdb_plugin::impl final
@@ -397,9 +561,9 @@ public:
       /// Optimize RocksDB. This is the easiest way to get RocksDB to perform well
       options.IncreaseParallelism();
       options.OptimizeLevelStyleCompaction();
+      options.max_open_files = OPEN_FILE_LIMIT;
 
       DBOptions dbOptions(options);
-      options.max_open_files = OPEN_FILE_LIMIT;
 
       auto status = DB::Open(dbOptions, strPath, columnDefs, &_columnHandles, &storageDb);
 
@@ -423,6 +587,9 @@ public:
             update_lib( 0 );
          }
 
+         if(_writerQueueSize != 0)
+            startWriter();
+
          _on_post_apply_operation_con = _mainDb.add_post_apply_operation_handler(
             [&]( const operation_notification& note )
             {
@@ -447,15 +614,39 @@ public:
    }
 
    void printReport(uint32_t blockNo, const char* detailText) const;
+   /** Reads the newest operations of accountCount accounts twice, like get_account_history does, and reports
+    *  the latencies. The first pass starts with an empty block cache (drop the OS page cache before startup
+    *  for a fully cold run), the second one reads the same data again from the warm cache.
+    */
+   void runReadBenchmark(uint32_t accountCount, uint32_t limit) const;
+   /// Rewrites all column families with the current compression settings.
+   void compactStorage();
+   /** Reports the disk size of each column family and the speed of a sequential scan of all operations,
+    *  to compare storage layouts and compression settings.
+    */
+   void reportStorage() const;
    void on_pre_reindex( const steem::chain::reindex_notification& note );
    void on_post_reindex( const steem::chain::reindex_notification& note );
 
    /// Allows to start immediate data import (outside replay process).
    void importData(unsigned int blockLimit);
 
-   void find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
-      std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
+   /** Imports the block log into an empty store on _importThreads threads.
+    *
+    *  Windows of IMPORT_WINDOW_BLOCKS blocks are scanned with block_log_scanner. The scan threads
+    *  compute impacted accounts and serialize operations, then the window is merged in block order,
+    *  assigning operation and account history ids exactly like importOperation. Each merged window
+    *  is written to one SST file per column family and ingested, bypassing the memtables and WAL.
+    *  The next window is scanned while the previous one is merged.
+    */
+   void importDataParallel(unsigned int blockLimit);
+
+   /// Operations of blocks still in the writer queue follow the stored ones.
+   fc::optional<uint64_t> find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
+      const account_history_filter& filter, std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
    bool find_operation_object(size_t opId, rocksdb_operation_object* op) const;
+   /// Keeps irreversible blocks in the writer queue. Releasing it waits until the queue is written.
+   void holdWriter(bool hold);
    /// Allows to look for all operations present in given block and call `processor` for them.
    void find_operations_by_block(size_t blockNum,
       std::function<void(const rocksdb_operation_object&)> processor) const;
@@ -467,6 +658,7 @@ public:
    {
       chain::util::disconnect_signal(_on_post_apply_operation_con);
       chain::util::disconnect_signal(_on_irreversible_block_conn);
+      stopWriter();
       flushStorage();
       cleanupColumnHandles();
       _storage.reset();
@@ -478,6 +670,11 @@ private:
 
    typedef std::vector<ColumnFamilyDescriptor> ColumnDefinitions;
    ColumnDefinitions prepareColumnDefinitions(bool addDefaultColumn);
+   /** Table options shared by the column families: the block cache, bloom filters and index layout.
+    *  prefixLength enables prefix bloom filters and prefix seeks over the leading part of the keys,
+    *  which the custom comparators order first.
+    */
+   ColumnFamilyOptions prepareColumnOptions(const Comparator* comparator, size_t prefixLength) const;
 
    /// Returns true if database will need data import.
    bool createDbSchema(const bfs::path& path);
@@ -489,8 +686,9 @@ private:
       _columnHandles.clear();
    }
 
+   /// flushWhenFull false leaves the whole write to the caller, which stores a block in one batch.
    template< typename T >
-   void importOperation( rocksdb_operation_object& obj, const T& impacted )
+   void importOperation( rocksdb_operation_object& obj, const T& impacted, bool flushWhenFull = true )
    {
       if(_lastTx != obj.trx_id)
       {
@@ -527,13 +725,56 @@ private:
       for(const auto& name : impacted)
          buildAccountHistoryRecord( name, obj );
 
-      if(++_collectedOps >= _collectedOpsWriteLimit)
+      if(++_collectedOps >= _collectedOpsWriteLimit && flushWhenFull)
          flushWriteBuffer();
 
       ++_totalOps;
 }
 
    void buildAccountHistoryRecord( const account_name_type& name, const rocksdb_operation_object& obj );
+   void findStoredAccountHistoryData(const account_history_info& ahInfo, uint64_t start, uint32_t limit,
+      std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
+   /// Examines at most scanLimit entries, returns the entry to resume from when it stopped there.
+   fc::optional<uint64_t> findFilteredAccountHistoryData(const account_history_info& ahInfo, uint64_t start,
+      uint32_t limit, uint32_t scanLimit, const account_history_filter& filter,
+      std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
+   void updateChunkInfo(int64_t ahId, uint32_t entryId, const rocksdb_operation_object& obj);
+   bool findChunkInfo(int64_t ahId, uint32_t chunkNo, account_history_chunk_info* chunk) const;
+
+   void scanImportWindow(const steem::chain::block_log_scanner& scanner, uint32_t firstBlock, uint32_t lastBlock,
+      import_window_t* window) const;
+   /// openChunks holds the summary of the last, still growing, chunk of each account history.
+   void mergeImportWindow(import_window_t* window, std::map<account_name_type, account_history_info>* ahInfos,
+      std::map<int64_t, account_history_chunk_info>* openChunks,
+      const bfs::path& sstDir);
+   /// Sorts entries by the comparator of the column, writes them to an SST file and ingests it.
+   void ingestSstFile(uint32_t column, sst_entries_t* entries, const bfs::path& sstDir);
+
+   /** Blocks becoming irreversible are written by a dedicated thread when _writerQueueSize is set, so RocksDB
+    *  reads, writes and pruning do not add to the block apply time. Operations of reversible blocks stay in
+    *  volatile_operation_index, undone with forks. At irreversibility they are copied to a bounded queue and
+    *  block application waits only when the writer is _writerQueueSize blocks behind. Until a block is
+    *  written, its operations are served from the queue. They are removed from volatile_operation_index
+    *  only once written, so blocks lost with a failed write are queued again after a restart.
+    */
+   void startWriter();
+   /// Writes the queued blocks and stops the writer thread.
+   void stopWriter();
+   void writerLoop();
+   void enqueueIrreversibleBlock(irreversible_block_ops_ptr block);
+   /// Puts the operations of the block and the new lib into the write buffer, the caller flushes it.
+   void writeIrreversibleBlock(const irreversible_block_ops& block);
+   /// Removes the operations of blocks up to lib from volatile_operation_index.
+   void removeVolatileOperations(uint32_t lib);
+   uint32_t getWrittenLib() const;
+   /** Copies the queued operations of blocks in [blockRangeBegin, blockRangeEnd).
+    *  Returns the lowest block held in the queue, 0 when it is empty.
+    */
+   uint32_t collectQueuedOperations(uint32_t blockRangeBegin, uint32_t blockRangeEnd, bool virtualOnly,
+      std::vector<rocksdb_operation_object>* ops) const;
+   uint32_t enumStoredVirtualOperations(uint32_t blockRangeBegin,
+      uint32_t blockRangeEnd, std::function<void(const rocksdb_operation_object&)> processor) const;
+
    void prunePotentiallyTooOldItems(account_history_info* ahInfo, const account_name_type& name,
       const fc::time_point_sec& now);
 
@@ -674,13 +915,13 @@ private:
 
    /// Helper member to be able to detect another incomming tx and increment tx-counter.
    transaction_id_type              _lastTx;
-   size_t                           _txNo = 0;
+   std::atomic<size_t>              _txNo{0};
    /// Total processed ops in this session (counts every operation, even excluded by filtering).
-   size_t                           _totalOps = 0;
+   std::atomic<size_t>              _totalOps{0};
    /// Total number of ops being skipped by filtering options.
    size_t                           _excludedOps = 0;
    /// Total number of accounts (impacted by ops) excluded from processing because of filtering.
-   mutable size_t                   _excludedAccountCount = 0;
+   mutable std::atomic<size_t>      _excludedAccountCount{0};
    /// IDs to be assigned to object.id field.
    uint64_t                         _operationSeqId = 0;
    uint64_t                         _accountHistorySeqId = 0;
@@ -694,6 +935,38 @@ private:
     */
    unsigned int                     _collectedOpsWriteLimit = 1;
 
+   /// RocksDB tuning, see set_program_options.
+   std::shared_ptr<::rocksdb::Cache> _blockCache;
+   uint32_t                         _bloomFilterBits = 10;
+   bool                             _partitionedIndex = false;
+   bool                             _prefixExtractor = true;
+   std::vector<::rocksdb::CompressionType> _compressionPerLevel;
+   /// Compression of the bottommost level of operation_by_id, which holds most of the storage.
+   ::rocksdb::CompressionType       _operationCompression = ::rocksdb::kDisableCompressionOption;
+   uint32_t                         _compressionDictionarySize = 0;
+
+   /// Threads of the parallel data import, 0 imports sequentially.
+   uint32_t                         _importThreads = 0;
+   /// Number of SST files written by the parallel data import.
+   uint32_t                         _importFileNo = 0;
+
+   /// Irreversible blocks the writer thread can be behind, 0 writes them on the block apply thread.
+   uint32_t                         _writerQueueSize = 0;
+   std::thread                      _writerThread;
+   /// Blocks waiting for the writer thread, the one being written included.
+   std::deque<irreversible_block_ops_ptr> _writerQueue;
+   mutable std::mutex               _writerMutex;
+   std::condition_variable          _writerWakeUp;
+   std::condition_variable          _writerQueueNotFull;
+   bool                             _stopWriter = false;
+   fc::exception_ptr                _writerError;
+   /// Last irreversible block handed to the writer thread.
+   uint32_t                         _queuedLib = 0;
+   /// Last irreversible block stored by the writer thread.
+   uint32_t                         _writtenLib = 0;
+   /// Set by tests to keep the blocks in the queue.
+   bool                             _holdWriter = false;
+
    account_name_range_index         _tracked_accounts;
    flat_set<std::string>            _op_list;
    flat_set<std::string>            _blacklisted_op_list;
@@ -740,6 +1013,41 @@ void account_history_rocksdb_plugin::impl::collectOptions(const boost::program_o
    if(_blacklisted_op_list.empty() == false)
       ilog( "Account History: blacklisting ops ${o}", ("o", _blacklisted_op_list) );
 
+   uint32_t blockCacheSize = options.at("account-history-rocksdb-block-cache-size").as<uint32_t>();
+   if(blockCacheSize != 0)
+      _blockCache = ::rocksdb::NewLRUCache(uint64_t(blockCacheSize) * 1024 * 1024);
+
+   _bloomFilterBits = options.at("account-history-rocksdb-bloom-filter-bits").as<uint32_t>();
+   _partitionedIndex = options.at("account-history-rocksdb-partitioned-index").as<bool>();
+   _prefixExtractor = options.at("account-history-rocksdb-prefix-extractor").as<bool>();
+
+   if(options.count("account-history-rocksdb-compression"))
+   {
+      std::vector<std::string> levels;
+      auto compression = options.at("account-history-rocksdb-compression").as<std::string>();
+      boost::split(levels, compression, boost::is_any_of(","));
+
+      for(const auto& level : levels)
+         _compressionPerLevel.push_back(parseCompressionType(level));
+   }
+
+   if(options.count("account-history-rocksdb-operation-compression"))
+   {
+      _operationCompression = parseCompressionType(options.at("account-history-rocksdb-operation-compression").as<std::string>());
+      _compressionDictionarySize = options.at("account-history-rocksdb-compression-dictionary-size").as<uint32_t>();
+
+      FC_ASSERT(_compressionDictionarySize == 0 || _operationCompression == ::rocksdb::kZSTD ||
+         _operationCompression == ::rocksdb::kZlibCompression || _operationCompression == ::rocksdb::kLZ4Compression ||
+         _operationCompression == ::rocksdb::kLZ4HCCompression,
+         "Compression dictionaries need zstd, zlib or lz4 operation compression");
+   }
+
+   if(options.count("account-history-rocksdb-writer-queue-size"))
+      _writerQueueSize = options.at("account-history-rocksdb-writer-queue-size").as<uint32_t>();
+
+   if(options.count("account-history-rocksdb-import-threads"))
+      _importThreads = options.at("account-history-rocksdb-import-threads").as<uint32_t>();
+
    appbase::app().get_plugin< chain::chain_plugin >().report_state_options( _self.name(), state_opts );
 }
 
@@ -846,22 +1154,96 @@ void account_history_rocksdb_plugin::impl::storeOpFilteringParameters(const std:
       }
    }
 
-void account_history_rocksdb_plugin::impl::find_account_history_data(const account_name_type& name, uint64_t start,
-   uint32_t limit, std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
+static uint32_t getOperationType(const rocksdb_operation_object& op)
 {
-   ReadOptions rOptions;
+   fc::unsigned_int type;
+   fc::datastream<const char*> ds(op.serialized_op.data(), op.serialized_op.size());
+   fc::raw::unpack(ds, type);
+   return type.value;
+}
 
-   ah_info_by_name_slice_t nameSlice(name.data);
-   PinnableSlice buffer;
-   auto s = _storage->Get(rOptions, _columnHandles[AH_INFO_BY_NAME], nameSlice, &buffer);
+fc::optional<uint64_t> account_history_rocksdb_plugin::impl::find_account_history_data(const account_name_type& name,
+   uint64_t start, uint32_t limit, const account_history_filter& filter,
+   std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
+{
+   account_history_info ahInfo;
+   bool stored = false;
+   std::vector<rocksdb_operation_object> queuedOps;
 
-   if(s.IsNotFound())
-      return;
+   {
+      /// The writer stores a block and removes it from the queue under this lock, so the stored history
+      /// and the queued operations neither overlap nor leave a gap.
+      std::lock_guard<std::mutex> lock(_writerMutex);
 
-   checkStatus(s);
+      ah_info_by_name_slice_t nameSlice(name.data);
+      PinnableSlice buffer;
+      auto s = _storage->Get(ReadOptions(), _columnHandles[AH_INFO_BY_NAME], nameSlice, &buffer);
 
-   account_history_info ahInfo;
-   load(ahInfo, buffer.data(), buffer.size());
+      if(s.IsNotFound() == false)
+      {
+         checkStatus(s);
+         load(ahInfo, buffer.data(), buffer.size());
+         stored = true;
+      }
+
+      for(const auto& block : _writerQueue)
+      {
+         for(const auto& op : block->ops)
+         {
+            if(std::find(op.impacted.begin(), op.impacted.end(), name) != op.impacted.end())
+               queuedOps.push_back(op.obj);
+         }
+      }
+   }
+
+   /// Queued operations get the entry ids the writer will give them, following the stored ones.
+   uint64_t firstQueuedEntry = stored ? ahInfo.newestEntryId + 1 : 0;
+   uint32_t processed = 0;
+   uint32_t scanLimit = account_history_filter::scan_limit(limit);
+   uint32_t examined = 0;
+
+   for(size_t i = queuedOps.size(); i-- > 0;)
+   {
+      uint64_t entry = firstQueuedEntry + i;
+      if(entry > start)
+         continue;
+
+      const auto& op = queuedOps[i];
+
+      if(filter.is_set())
+      {
+         if(examined == scanLimit)
+            return entry;
+         ++examined;
+
+         if(filter.is_before_range(op.block, op.timestamp))
+            return fc::optional<uint64_t>();
+         if(filter.matches(getOperationType(op), op.block, op.timestamp) == false)
+            continue;
+      }
+
+      processor(entry, op);
+      ++processed;
+
+      /// An unfiltered query returns the entries [start-limit, start], a filtered one limit matching entries.
+      if(processed > limit || (filter.is_set() && processed == limit))
+         return fc::optional<uint64_t>();
+   }
+
+   if(stored == false)
+      return fc::optional<uint64_t>();
+
+   if(filter.is_set())
+      return findFilteredAccountHistoryData(ahInfo, start, limit - processed, scanLimit - examined, filter, processor);
+
+   findStoredAccountHistoryData(ahInfo, start, limit - processed, processor);
+   return fc::optional<uint64_t>();
+}
+
+void account_history_rocksdb_plugin::impl::findStoredAccountHistoryData(const account_history_info& ahInfo,
+   uint64_t start, uint32_t limit, std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
+{
+   ReadOptions rOptions;
 
    ah_op_by_id_slice_t lowerBoundSlice(std::make_pair(ahInfo.id, ahInfo.oldestEntryId));
    ah_op_by_id_slice_t upperBoundSlice(std::make_pair(ahInfo.id, ahInfo.newestEntryId+1));
@@ -905,6 +1287,95 @@ void account_history_rocksdb_plugin::impl::find_account_history_data(const accou
    }
 }
 
+fc::optional<uint64_t> account_history_rocksdb_plugin::impl::findFilteredAccountHistoryData(
+   const account_history_info& ahInfo, uint64_t start, uint32_t limit, uint32_t scanLimit,
+   const account_history_filter& filter, std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
+{
+   ah_op_by_id_slice_t lowerBoundSlice(std::make_pair(ahInfo.id, ahInfo.oldestEntryId));
+   ah_op_by_id_slice_t upperBoundSlice(std::make_pair(ahInfo.id, ahInfo.newestEntryId+1));
+
+   ReadOptions rOptions;
+   rOptions.iterate_lower_bound = &lowerBoundSlice;
+   rOptions.iterate_upper_bound = &upperBoundSlice;
+
+   std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(rOptions, _columnHandles[AH_OPERATION_BY_ID]));
+
+   uint32_t startEntry = start < ahInfo.newestEntryId ? start : ahInfo.newestEntryId;
+   it->SeekForPrev(ah_op_by_id_slice_t(std::make_pair(ahInfo.id, startEntry)));
+
+   uint32_t found = 0;
+   uint32_t examined = 0;
+   int64_t checkedChunk = -1;
+
+   /// Entries are in block order, so the walk back stops at the first one before the ranges.
+   /// Skipped chunks are not examined, their operations are not read.
+   while(it->Valid() && found < limit)
+   {
+      auto entry = ah_op_by_id_slice_t::unpackSlice(it->key()).second;
+      uint32_t chunkNo = entry / ACCOUNT_HISTORY_CHUNK_SIZE;
+
+      if(chunkNo != checkedChunk)
+      {
+         checkedChunk = chunkNo;
+
+         account_history_chunk_info chunk;
+         if(findChunkInfo(ahInfo.id, chunkNo, &chunk))
+         {
+            if(filter.is_before_range(chunk.lastBlock, chunk.lastTimestamp))
+               break;
+
+            if(filter.matches_any_type(chunk.opTypesLow, chunk.opTypesHigh) == false ||
+               filter.is_after_range(chunk.firstBlock, chunk.firstTimestamp))
+            {
+               if(chunkNo == 0)
+                  break;
+
+               /// Skip to the last entry of the previous chunk
+               it->SeekForPrev(ah_op_by_id_slice_t(std::make_pair(ahInfo.id, chunkNo * ACCOUNT_HISTORY_CHUNK_SIZE - 1)));
+               continue;
+            }
+         }
+      }
+
+      if(examined == scanLimit)
+         return entry;
+      ++examined;
+
+      const auto& opId = id_slice_t::unpackSlice(it->value());
+      rocksdb_operation_object oObj;
+      bool found_op = find_operation_object(opId, &oObj);
+      FC_ASSERT(found_op, "Missing operation?");
+
+      if(filter.is_before_range(oObj.block, oObj.timestamp))
+         break;
+
+      if(filter.matches(getOperationType(oObj), oObj.block, oObj.timestamp))
+      {
+         processor(entry, oObj);
+         ++found;
+      }
+
+      it->Prev();
+   }
+
+   return fc::optional<uint64_t>();
+}
+
+bool account_history_rocksdb_plugin::impl::findChunkInfo(int64_t ahId, uint32_t chunkNo,
+   account_history_chunk_info* chunk) const
+{
+   ah_op_by_id_slice_t key(std::make_pair(ahId, chunkNo));
+   PinnableSlice buffer;
+   auto s = _storage->Get(ReadOptions(), _columnHandles[AH_CHUNK_BY_ID], key, &buffer);
+
+   if(s.IsNotFound())
+      return false;
+
+   checkStatus(s);
+   load(*chunk, buffer.data(), buffer.size());
+   return true;
+}
+
 bool account_history_rocksdb_plugin::impl::find_operation_object(size_t opId, rocksdb_operation_object* op) const
 {
    std::string data;
@@ -925,6 +1396,17 @@ bool account_history_rocksdb_plugin::impl::find_operation_object(size_t opId, ro
 void account_history_rocksdb_plugin::impl::find_operations_by_block(size_t blockNum,
    std::function<void(const rocksdb_operation_object&)> processor) const
 {
+   /// The queue must be checked first, blocks leave it only once they are in the storage.
+   std::vector<rocksdb_operation_object> queuedOps;
+   uint32_t firstQueuedBlock = collectQueuedOperations(blockNum, blockNum + 1, false, &queuedOps);
+
+   if(firstQueuedBlock != 0 && blockNum >= firstQueuedBlock)
+   {
+      for(const auto& op : queuedOps)
+         processor(op);
+      return;
+   }
+
    std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(ReadOptions(), _columnHandles[OPERATION_BY_BLOCK]));
    by_block_slice_t blockNumSlice(blockNum);
    op_by_block_num_slice_t key(block_op_id_pair(blockNum, 0));
@@ -947,12 +1429,55 @@ uint32_t account_history_rocksdb_plugin::impl::enumVirtualOperationsFromBlockRan
 {
    FC_ASSERT(blockRangeEnd > blockRangeBegin, "Block range must be upward");
 
+   std::vector<rocksdb_operation_object> queuedOps;
+   uint32_t firstQueuedBlock = collectQueuedOperations(blockRangeBegin, std::numeric_limits<uint32_t>::max(), true,
+      &queuedOps);
+
+   if(firstQueuedBlock == 0)
+      return enumStoredVirtualOperations(blockRangeBegin, blockRangeEnd, processor);
+
+   /// Blocks below the queue are in the storage, the others are served from the queue.
+   uint32_t nextBlock = 0;
+   if(firstQueuedBlock > blockRangeBegin)
+   {
+      nextBlock = enumStoredVirtualOperations(blockRangeBegin, std::min(blockRangeEnd, firstQueuedBlock), processor);
+      if(nextBlock >= firstQueuedBlock)
+         nextBlock = 0;
+   }
+
+   for(const auto& op : queuedOps)
+   {
+      if(op.block < firstQueuedBlock)
+         continue;
+
+      if(op.block < blockRangeEnd)
+      {
+         processor(op);
+      }
+      else
+      {
+         if(nextBlock == 0)
+            nextBlock = op.block;
+         break;
+      }
+   }
+
+   return nextBlock;
+}
+
+uint32_t account_history_rocksdb_plugin::impl::enumStoredVirtualOperations(uint32_t blockRangeBegin,
+   uint32_t blockRangeEnd, std::function<void(const rocksdb_operation_object&)> processor) const
+{
+   FC_ASSERT(blockRangeEnd > blockRangeBegin, "Block range must be upward");
+
    op_by_block_num_slice_t upperBoundSlice(block_op_id_pair(blockRangeEnd, 0));
 
    op_by_block_num_slice_t rangeBeginSlice(block_op_id_pair(blockRangeBegin, 0));
 
    ReadOptions rOptions;
    rOptions.iterate_upper_bound = &upperBoundSlice;
+   /// The scan crosses blocks, so it can not rely on the block number prefix.
+   rOptions.total_order_seek = true;
 
    std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(rOptions, _columnHandles[OPERATION_BY_BLOCK]));
 
@@ -981,6 +1506,7 @@ uint32_t account_history_rocksdb_plugin::impl::enumVirtualOperationsFromBlockRan
    op_by_block_num_slice_t lowerBoundSlice(block_op_id_pair(lastFoundBlock, 0));
    rOptions = ReadOptions();
    rOptions.iterate_lower_bound = &lowerBoundSlice;
+   rOptions.total_order_seek = true;
    it.reset(_storage->NewIterator(rOptions, _columnHandles[OPERATION_BY_BLOCK]));
 
    op_by_block_num_slice_t nextRangeBeginSlice(block_op_id_pair(lastFoundBlock + 1, 0));
@@ -1018,29 +1544,75 @@ account_history_rocksdb_plugin::impl::ColumnDefinitions account_history_rocksdb_
 {
    ColumnDefinitions columnDefs;
    if(addDefaultColumn)
-      columnDefs.emplace_back(::rocksdb::kDefaultColumnFamilyName, ColumnFamilyOptions());
+      columnDefs.emplace_back(::rocksdb::kDefaultColumnFamilyName, prepareColumnOptions(nullptr, 0));
 
-   columnDefs.emplace_back("current_lib", ColumnFamilyOptions());
+   columnDefs.emplace_back("current_lib", prepareColumnOptions(nullptr, 0));
 
-   columnDefs.emplace_back("operation_by_id", ColumnFamilyOptions());
+   /// Point lookups by operation id
+   columnDefs.emplace_back("operation_by_id", prepareColumnOptions(by_id_Comparator(), 0));
    auto& byIdColumn = columnDefs.back();
-   byIdColumn.options.comparator = by_id_Comparator();
+   if(_operationCompression != ::rocksdb::kDisableCompressionOption)
+   {
+      /** RocksDB samples the first file of a compaction into the bottommost level to build a dictionary, then
+       *  primes every data block of the following files with it. Serialized operations repeat account names,
+       *  permlinks and json ids across blocks, which a per block compression can not take advantage of.
+       */
+      byIdColumn.options.bottommost_compression = _operationCompression;
+      byIdColumn.options.compression_opts.max_dict_bytes = _compressionDictionarySize;
+   }
 
-   columnDefs.emplace_back("operation_by_block", ColumnFamilyOptions());
-   auto& byLocationColumn = columnDefs.back();
-   byLocationColumn.options.comparator = op_by_block_num_Comparator();
+   /// Scans of the operations of one block, the prefix is the block number
+   columnDefs.emplace_back("operation_by_block",
+      prepareColumnOptions(op_by_block_num_Comparator(), sizeof(block_op_id_pair::first_type)));
 
-   columnDefs.emplace_back("account_history_info_by_name", ColumnFamilyOptions());
-   auto& byAccountNameColumn = columnDefs.back();
-   byAccountNameColumn.options.comparator = by_account_name_Comparator();
+   /// Point lookups by account name
+   columnDefs.emplace_back("account_history_info_by_name", prepareColumnOptions(by_account_name_Comparator(), 0));
 
-   columnDefs.emplace_back("ah_operation_by_id", ColumnFamilyOptions());
-   auto& byAHInfoColumn = columnDefs.back();
-   byAHInfoColumn.options.comparator = ah_op_by_id_Comparator();
+   /// Scans of the history of one account, the prefix is the account history id
+   columnDefs.emplace_back("ah_operation_by_id",
+      prepareColumnOptions(ah_op_by_id_Comparator(), sizeof(ah_op_id_pair::first_type)));
+
+   /// Summaries of account history chunks, read backward with the history of one account
+   columnDefs.emplace_back("ah_chunk_by_id",
+      prepareColumnOptions(ah_op_by_id_Comparator(), sizeof(ah_op_id_pair::first_type)));
 
    return columnDefs;
 }
 
+ColumnFamilyOptions account_history_rocksdb_plugin::impl::prepareColumnOptions(const Comparator* comparator,
+   size_t prefixLength) const
+{
+   ColumnFamilyOptions options;
+   if(comparator != nullptr)
+      options.comparator = comparator;
+
+   ::rocksdb::BlockBasedTableOptions tableOptions;
+   if(_blockCache)
+      tableOptions.block_cache = _blockCache;
+
+   if(_bloomFilterBits != 0)
+      tableOptions.filter_policy.reset(::rocksdb::NewBloomFilterPolicy(_bloomFilterBits, false));
+
+   if(_partitionedIndex)
+   {
+      /// Only the top level index is kept in memory, the partitions go through the block cache.
+      tableOptions.index_type = ::rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+      tableOptions.partition_filters = _bloomFilterBits != 0;
+      tableOptions.cache_index_and_filter_blocks = true;
+      tableOptions.pin_l0_filter_and_index_blocks_in_cache = true;
+   }
+
+   options.table_factory.reset(::rocksdb::NewBlockBasedTableFactory(tableOptions));
+
+   if(_prefixExtractor && prefixLength != 0)
+      options.prefix_extractor.reset(::rocksdb::NewFixedPrefixTransform(prefixLength));
+
+   if(_compressionPerLevel.empty() == false)
+      options.compression_per_level = _compressionPerLevel;
+
+   return options;
+}
+
 bool account_history_rocksdb_plugin::impl::createDbSchema(const bfs::path& path)
 {
    DB* db = nullptr;
@@ -1124,6 +1696,8 @@ void account_history_rocksdb_plugin::impl::buildAccountHistoryRecord( const acco
       id_slice_t valueSlice(obj.id);
       auto s = _writeBuffer.Put(_columnHandles[AH_OPERATION_BY_ID], ahInfoOpSlice, valueSlice);
       checkStatus(s);
+
+      updateChunkInfo(ahInfo.id, nextEntryId, obj);
    }
    else
    {
@@ -1138,9 +1712,25 @@ void account_history_rocksdb_plugin::impl::buildAccountHistoryRecord( const acco
       id_slice_t valueSlice(obj.id);
       auto s = _writeBuffer.Put(_columnHandles[AH_OPERATION_BY_ID], ahInfoOpSlice, valueSlice);
       checkStatus(s);
+
+      updateChunkInfo(ahInfo.id, 0, obj);
    }
 }
 
+void account_history_rocksdb_plugin::impl::updateChunkInfo(int64_t ahId, uint32_t entryId,
+   const rocksdb_operation_object& obj)
+{
+   ah_op_id_pair key(ahId, entryId / ACCOUNT_HISTORY_CHUNK_SIZE);
+   account_history_chunk_info chunk;
+
+   /// The first entry of a chunk starts a new summary
+   if(entryId % ACCOUNT_HISTORY_CHUNK_SIZE != 0)
+      _writeBuffer.getChunkInfo(key, &chunk);
+
+   chunk.addOperation(obj);
+   _writeBuffer.putChunkInfo(key, chunk);
+}
+
 void account_history_rocksdb_plugin::impl::prunePotentiallyTooOldItems(account_history_info* ahInfo, const account_name_type& name,
    const fc::time_point_sec& now)
 {
@@ -1245,6 +1835,11 @@ void account_history_rocksdb_plugin::impl::on_post_reindex(const steem::chain::r
    _collectedOpsWriteLimit = 1;
    _reindexing = false;
    update_lib( note.last_block_number ); // We always reindex irreversible blocks.
+   _queuedLib = note.last_block_number;
+   {
+      std::lock_guard<std::mutex> lock(_writerMutex);
+      _writtenLib = note.last_block_number;
+   }
 
    printReport( note.last_block_number, "RocksDB data reindex finished." );
 }
@@ -1256,13 +1851,143 @@ void account_history_rocksdb_plugin::impl::printReport(uint32_t blockNo, const c
         "${ea} accounts have been filtered out due to configured options.",
       ("t", detailText)
       ("n", blockNo)
-      ("tx", _txNo)
-      ("op", _totalOps)
+      ("tx", _txNo.load())
+      ("op", _totalOps.load())
       ("ep", _excludedOps)
-      ("ea", _excludedAccountCount)
+      ("ea", _excludedAccountCount.load())
       );
 }
 
+void account_history_rocksdb_plugin::impl::runReadBenchmark(uint32_t accountCount, uint32_t limit) const
+{
+   std::vector<account_name_type> accounts;
+
+   {
+      std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(ReadOptions(), _columnHandles[AH_INFO_BY_NAME]));
+      uint64_t step = std::max<uint64_t>(_accountHistorySeqId / accountCount, 1);
+      uint64_t i = 0;
+
+      for(it->SeekToFirst(); it->Valid() && accounts.size() < accountCount; it->Next(), ++i)
+      {
+         if(i % step != 0)
+            continue;
+
+         account_name_type name;
+         name.data = ah_info_by_name_slice_t::unpackSlice(it->key());
+         accounts.push_back(name);
+      }
+   }
+
+   ilog("Starting RocksDB account history read benchmark for ${n} accounts, ${l} operations each...",
+      ("n", accounts.size())("l", limit));
+
+   for(const char* pass : { "cold", "warm" })
+   {
+      std::vector<int64_t> latencies;
+      latencies.reserve(accounts.size());
+      uint64_t operations = 0;
+
+      auto passStart = fc::time_point::now();
+      for(const auto& name : accounts)
+      {
+         auto start = fc::time_point::now();
+         find_account_history_data(name, std::numeric_limits<uint64_t>::max(), limit, account_history_filter(),
+            [&operations](unsigned int, const rocksdb_operation_object&) { ++operations; });
+         latencies.push_back((fc::time_point::now() - start).count());
+      }
+      auto elapsed = (fc::time_point::now() - passStart).count();
+
+      if(latencies.empty())
+         break;
+
+      std::sort(latencies.begin(), latencies.end());
+
+      ilog("RocksDB read benchmark, ${p} cache: ${q} queries, ${o} operations in ${t} ms. "
+           "Latency: ${avg} us (avg), ${p50} us (p50), ${p99} us (p99), ${max} us (max). Block cache usage: ${c} kilobytes.",
+         ("p", pass)
+         ("q", latencies.size())
+         ("o", operations)
+         ("t", elapsed / 1000)
+         ("avg", elapsed / int64_t(latencies.size()))
+         ("p50", latencies[latencies.size() / 2])
+         ("p99", latencies[latencies.size() * 99 / 100])
+         ("max", latencies.back())
+         ("c", _blockCache ? _blockCache->GetUsage() / 1024 : 0) );
+   }
+}
+
+void account_history_rocksdb_plugin::impl::compactStorage()
+{
+   ilog("Compacting RocksDB account history storage...");
+
+   ::rocksdb::CompactRangeOptions options;
+   options.bottommost_level_compaction = ::rocksdb::BottommostLevelCompaction::kForce;
+
+   auto start = fc::time_point::now();
+   for(size_t i = 1; i < _columnHandles.size(); ++i)
+   {
+      auto s = _storage->CompactRange(options, _columnHandles[i], nullptr, nullptr);
+      checkStatus(s);
+   }
+
+   ilog("RocksDB account history storage compacted in ${t} ms.", ("t", (fc::time_point::now() - start).count() / 1000));
+}
+
+void account_history_rocksdb_plugin::impl::reportStorage() const
+{
+   uint64_t totalSize = 0;
+
+   for(size_t i = 1; i < _columnHandles.size(); ++i)
+   {
+      uint64_t size = 0;
+      uint64_t keys = 0;
+      _storage->GetIntProperty(_columnHandles[i], "rocksdb.total-sst-files-size", &size);
+      _storage->GetIntProperty(_columnHandles[i], "rocksdb.estimate-num-keys", &keys);
+      totalSize += size;
+
+      ilog("RocksDB column ${c}: ${s} kilobytes, about ${k} keys.",
+         ("c", _columnHandles[i]->GetName())("s", size / 1024)("k", keys));
+   }
+
+   ilog("RocksDB account history storage: ${s} kilobytes.", ("s", totalSize / 1024));
+
+   uint64_t operationsSize = 0;
+   _storage->GetIntProperty(_columnHandles[OPERATION_BY_ID], "rocksdb.total-sst-files-size", &operationsSize);
+
+   ReadOptions rOptions;
+   /// Measure the disk and decompression, not the block cache
+   rOptions.fill_cache = false;
+
+   std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(rOptions, _columnHandles[OPERATION_BY_ID]));
+
+   uint64_t operations = 0;
+   uint64_t valueBytes = 0;
+   auto start = fc::time_point::now();
+
+   for(it->SeekToFirst(); it->Valid(); it->Next())
+   {
+      auto value = it->value();
+      rocksdb_operation_object op;
+      load(op, value.data(), value.size());
+
+      valueBytes += value.size();
+      ++operations;
+   }
+
+   checkStatus(it->status());
+
+   auto elapsed = std::max<int64_t>((fc::time_point::now() - start).count(), 1);
+
+   ilog("RocksDB operation scan: ${o} operations, ${b} kilobytes uncompressed in ${t} ms, ${r} operations/s, ${m} MB/s. "
+        "Compression ratio: ${x}.",
+      ("o", operations)
+      ("b", valueBytes / 1024)
+      ("t", elapsed / 1000)
+      ("r", operations * 1000000 / elapsed)
+      ("m", double(valueBytes) / elapsed)
+      ("x", operationsSize ? double(valueBytes) / operationsSize : 0.0) );
+}
+
 void account_history_rocksdb_plugin::impl::importData(unsigned int blockLimit)
 {
    if(_storage == nullptr)
@@ -1271,6 +1996,17 @@ void account_history_rocksdb_plugin::impl::importData(unsigned int blockLimit)
       return;
    }
 
+   if(_importThreads != 0)
+   {
+      if(_operationSeqId == 0 && _accountHistorySeqId == 0)
+      {
+         importDataParallel(blockLimit);
+         return;
+      }
+
+      wlog("Parallel data import needs an empty store. Importing sequentially...");
+   }
+
    ilog("Starting data import...");
 
    block_id_type lastBlock;
@@ -1310,7 +2046,7 @@ void account_history_rocksdb_plugin::impl::importData(unsigned int blockLimit)
       obj.block = blockNo;
       obj.trx_in_block = txInBlock;
       obj.op_in_trx = opInTx;
-      obj.timestamp = _mainDb.head_block_time();
+      obj.timestamp = block.timestamp;
       auto size = fc::raw::pack_size( op );
       obj.serialized_op.resize( size );
       fc::datastream< char* > ds( obj.serialized_op.data(), size );
@@ -1336,6 +2072,271 @@ void account_history_rocksdb_plugin::impl::importData(unsigned int blockLimit)
    printReport(blockNo, "RocksDB data import finished. ");
 }
 
+void account_history_rocksdb_plugin::impl::scanImportWindow(const steem::chain::block_log_scanner& scanner,
+   uint32_t firstBlock, uint32_t lastBlock, import_window_t* window) const
+{
+   window->clear();
+   window->resize((lastBlock - firstBlock) / IMPORT_CHUNK_BLOCKS + 1);
+
+   /// The transaction and block of the operations visited by each thread
+   struct thread_state
+   {
+      transaction_id_type  trxId;
+      time_point_sec       timestamp;
+   };
+   std::vector<thread_state> threads(_importThreads);
+
+   steem::chain::block_log_scan_visitor visitor;
+   visitor.on_block = [&](uint32_t thread, uint32_t blockNum, const signed_block& block)
+   {
+      threads[thread].timestamp = block.timestamp;
+   };
+   visitor.on_transaction = [&](uint32_t thread, uint32_t blockNum, uint32_t txInBlock, const transaction_id_type& id,
+      const signed_transaction& tx)
+   {
+      threads[thread].trxId = id;
+   };
+   visitor.on_operation = [&](uint32_t thread, uint32_t blockNum, uint32_t txInBlock, uint32_t opInTx, const operation& op)
+   {
+      auto impacted = getImpactedAccounts(op);
+      if(impacted.empty())
+         return;
+
+      auto& chunk = (*window)[(blockNum - firstBlock) / IMPORT_CHUNK_BLOCKS];
+      chunk.emplace_back();
+      auto& prepared = chunk.back();
+      prepared.impacted = std::move(impacted);
+
+      auto& obj = prepared.obj;
+      obj.trx_id = threads[thread].trxId;
+      obj.block = blockNum;
+      obj.trx_in_block = txInBlock;
+      obj.op_in_trx = opInTx;
+      obj.timestamp = threads[thread].timestamp;
+      auto size = fc::raw::pack_size(op);
+      obj.serialized_op.resize(size);
+      fc::datastream<char*> ds(obj.serialized_op.data(), size);
+      fc::raw::pack(ds, op);
+   };
+
+   steem::chain::block_log_scanner::scan_options options;
+   options.first_block = firstBlock;
+   options.last_block = lastBlock;
+   options.threads = _importThreads;
+   options.chunk_blocks = IMPORT_CHUNK_BLOCKS;
+
+   scanner.scan(options, visitor);
+}
+
+void account_history_rocksdb_plugin::impl::mergeImportWindow(import_window_t* window,
+   std::map<account_name_type, account_history_info>* ahInfos, std::map<int64_t, account_history_chunk_info>* openChunks,
+   const bfs::path& sstDir)
+{
+   sst_entries_t opById;
+   sst_entries_t opByBlock;
+   sst_entries_t ahOpById;
+   sst_entries_t ahChunkById;
+
+   for(auto& chunk : *window)
+   {
+      for(auto& prepared : chunk)
+      {
+         auto& obj = prepared.obj;
+
+         if(_lastTx != obj.trx_id)
+         {
+            ++_txNo;
+            _lastTx = obj.trx_id;
+         }
+
+         obj.id = _operationSeqId++;
+
+         auto serializedObj = dump(obj);
+         id_slice_t idSlice(obj.id);
+         addSstEntry(&opById, idSlice, Slice(serializedObj.data(), serializedObj.size()));
+
+         /// Import only has operations of the block log, none of them is virtual
+         op_by_block_num_slice_t blockLocSlice(block_op_id_pair(obj.block, (uint64_t)obj.id));
+         addSstEntry(&opByBlock, blockLocSlice, idSlice);
+
+         for(const auto& name : prepared.impacted)
+         {
+            auto infoItr = ahInfos->find(name);
+            uint32_t entryId = 0;
+
+            if(infoItr == ahInfos->end())
+            {
+               account_history_info ahInfo;
+               ahInfo.id = _accountHistorySeqId++;
+               ahInfo.newestEntryId = ahInfo.oldestEntryId = 0;
+               ahInfo.oldestEntryTimestamp = obj.timestamp;
+               infoItr = ahInfos->emplace(name, ahInfo).first;
+            }
+            else
+            {
+               entryId = ++infoItr->second.newestEntryId;
+            }
+
+            ah_op_by_id_slice_t ahInfoOpSlice(std::make_pair(infoItr->second.id, entryId));
+            addSstEntry(&ahOpById, ahInfoOpSlice, idSlice);
+
+            /// Completed chunks are written with the window, the open ones at the end of the import.
+            auto& openChunk = (*openChunks)[infoItr->second.id];
+            if(entryId != 0 && entryId % ACCOUNT_HISTORY_CHUNK_SIZE == 0)
+            {
+               auto serializedChunk = dump(openChunk);
+               ah_op_by_id_slice_t chunkSlice(std::make_pair(infoItr->second.id, entryId / ACCOUNT_HISTORY_CHUNK_SIZE - 1));
+               addSstEntry(&ahChunkById, chunkSlice, Slice(serializedChunk.data(), serializedChunk.size()));
+               openChunk = account_history_chunk_info();
+            }
+            openChunk.addOperation(obj);
+         }
+
+         ++_totalOps;
+      }
+
+      /// Release the memory of merged chunks early
+      std::vector<prepared_import_op>().swap(chunk);
+   }
+
+   ingestSstFile(OPERATION_BY_ID, &opById, sstDir);
+   ingestSstFile(OPERATION_BY_BLOCK, &opByBlock, sstDir);
+   ingestSstFile(AH_OPERATION_BY_ID, &ahOpById, sstDir);
+   ingestSstFile(AH_CHUNK_BY_ID, &ahChunkById, sstDir);
+}
+
+void account_history_rocksdb_plugin::impl::ingestSstFile(uint32_t column, sst_entries_t* entries, const bfs::path& sstDir)
+{
+   if(entries->empty())
+      return;
+
+   auto* handle = _columnHandles[column];
+   const Comparator* comparator = handle->GetComparator();
+
+   std::sort(entries->begin(), entries->end(),
+      [comparator](const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b)
+      {
+         return comparator->Compare(a.first, b.first) < 0;
+      });
+
+   /// The file is built with the table options of the column, its bloom filters and compression included.
+   Options options = _storage->GetOptions(handle);
+
+   auto file = (sstDir / (std::to_string(++_importFileNo) + ".sst")).string();
+
+   SstFileWriter writer(::rocksdb::EnvOptions(), options, handle);
+   auto s = writer.Open(file);
+   checkStatus(s);
+
+   for(const auto& entry : *entries)
+   {
+      s = writer.Put(entry.first, entry.second);
+      checkStatus(s);
+   }
+
+   s = writer.Finish();
+   checkStatus(s);
+
+   ::rocksdb::IngestExternalFileOptions ingestOptions;
+   ingestOptions.move_files = true;
+   s = _storage->IngestExternalFile(handle, { file }, ingestOptions);
+   checkStatus(s);
+
+   entries->clear();
+}
+
+void account_history_rocksdb_plugin::impl::importDataParallel(unsigned int blockLimit)
+{
+   auto blockLogFile = appbase::app().data_dir() / "blockchain" / "block_log";
+   steem::chain::block_log_scanner scanner(blockLogFile);
+
+   uint32_t lastBlock = scanner.head_block_num();
+   if(blockLimit != 0 && blockLimit < lastBlock)
+      lastBlock = blockLimit;
+
+   ilog("Starting parallel data import of ${n} blocks on ${t} threads...", ("n", lastBlock)("t", _importThreads));
+
+   _lastTx = transaction_id_type();
+   _txNo = 0;
+   _totalOps = 0;
+   _excludedOps = 0;
+
+   if(lastBlock == 0)
+      return;
+
+   auto sstDir = _storagePath / "import";
+   bfs::remove_all(sstDir);
+   bfs::create_directories(sstDir);
+
+   benchmark_dumper dumper;
+   dumper.initialize([](benchmark_dumper::database_object_sizeof_cntr_t&){}, "rocksdb_data_import_parallel.json");
+
+   std::map<account_name_type, account_history_info> ahInfos;
+   std::map<int64_t, account_history_chunk_info> openChunks;
+   import_window_t current;
+   import_window_t next;
+
+   uint32_t windowFirst = 1;
+   uint32_t windowLast = std::min(lastBlock, windowFirst + IMPORT_WINDOW_BLOCKS - 1);
+   scanImportWindow(scanner, windowFirst, windowLast, &current);
+
+   while(true)
+   {
+      uint32_t nextFirst = windowLast + 1;
+      uint32_t nextLast = std::min(lastBlock, windowLast + IMPORT_WINDOW_BLOCKS);
+
+      std::future<void> pendingScan;
+      if(nextFirst <= lastBlock)
+      {
+         pendingScan = std::async(std::launch::async, [&, nextFirst, nextLast]()
+         {
+            scanImportWindow(scanner, nextFirst, nextLast, &next);
+         });
+      }
+
+      mergeImportWindow(&current, &ahInfos, &openChunks, sstDir);
+
+      const auto& measure = dumper.measure(windowLast, [](benchmark_dumper::index_memory_details_cntr_t&, bool){});
+      ilog("RocksDb parallel data import processed blocks: ${n}, ${op} operations. Window time: ${rt} ms (real), ${ct} ms (cpu).",
+         ("n", windowLast)("op", _totalOps.load())("rt", measure.real_ms)("ct", measure.cpu_ms));
+
+      if(pendingScan.valid() == false)
+         break;
+
+      pendingScan.get();
+      std::swap(current, next);
+      windowLast = nextLast;
+   }
+
+   sst_entries_t ahInfoByName;
+   sst_entries_t ahChunkById;
+   for(const auto& info : ahInfos)
+   {
+      auto serializedInfo = dump(info.second);
+      ah_info_by_name_slice_t nameSlice(info.first.data);
+      addSstEntry(&ahInfoByName, nameSlice, Slice(serializedInfo.data(), serializedInfo.size()));
+
+      auto serializedChunk = dump(openChunks[info.second.id]);
+      ah_op_by_id_slice_t chunkSlice(std::make_pair(info.second.id, info.second.newestEntryId / ACCOUNT_HISTORY_CHUNK_SIZE));
+      addSstEntry(&ahChunkById, chunkSlice, Slice(serializedChunk.data(), serializedChunk.size()));
+   }
+   ingestSstFile(AH_INFO_BY_NAME, &ahInfoByName, sstDir);
+   ingestSstFile(AH_CHUNK_BY_ID, &ahChunkById, sstDir);
+
+   flushWriteBuffer();
+   bfs::remove_all(sstDir);
+
+   const auto& total = dumper.dump(true, [](benchmark_dumper::index_memory_details_cntr_t&, bool){});
+   ilog( "RocksDb parallel data import - Performance report at block ${n}. Elapsed time: ${rt} ms (real), ${ct} ms (cpu). Memory usage: ${cm} (current), ${pm} (peak) kilobytes.",
+      ("n", lastBlock)
+      ("rt", total.real_ms)
+      ("ct", total.cpu_ms)
+      ("cm", total.current_mem)
+      ("pm", total.peak_mem) );
+
+   printReport(lastBlock, "RocksDB parallel data import finished. ");
+}
+
 void account_history_rocksdb_plugin::impl::on_post_apply_operation(const operation_notification& n)
 {
    if( n.block % 10000 == 0 && n.trx_in_block == 0 && n.op_in_trx == 0 && n.virtual_op == 0 )
@@ -1344,10 +2345,10 @@ void account_history_rocksdb_plugin::impl::on_post_apply_operation(const operati
            " ${ep} operations have been filtered out due to configured options.\n"
            " ${ea} accounts have been filtered out due to configured options.",
          ("n", n.block)
-         ("tx", _txNo)
-         ("op", _totalOps)
+         ("tx", _txNo.load())
+         ("op", _totalOps.load())
          ("ep", _excludedOps)
-         ("ea", _excludedAccountCount)
+         ("ea", _excludedAccountCount.load())
          );
    }
 
@@ -1401,27 +2402,218 @@ void account_history_rocksdb_plugin::impl::on_irreversible_block( uint32_t block
 {
    if( _reindexing ) return;
 
-   if( block_num <= get_lib() ) return;
+   STATSD_START_TIMER( "account_history_rocksdb", "apply_time", "irreversible_block", 1.0f )
+
+   bool useWriter = _writerThread.joinable();
+
+   uint32_t written_lib = useWriter ? getWrittenLib() : get_lib();
+   removeVolatileOperations( written_lib );
+
+   uint32_t lib = useWriter ? _queuedLib : written_lib;
+   if( block_num <= lib ) return;
 
    const auto& volatile_idx = _mainDb.get_index< volatile_operation_index, by_block >();
-   auto itr = volatile_idx.begin();
 
-   vector< const volatile_operation_object* > to_delete;
+   auto block = std::make_shared< irreversible_block_ops >();
+   block->first_block_num = lib + 1;
+   block->block_num = block_num;
 
-   while( itr != volatile_idx.end() && itr->block <= block_num )
+   for( auto itr = volatile_idx.lower_bound( boost::make_tuple( lib + 1 ) );
+        itr != volatile_idx.end() && itr->block <= block_num; ++itr )
    {
-      rocksdb_operation_object obj( *itr );
-      importOperation( obj , itr->impacted );
-      to_delete.push_back( &(*itr) );
+      block->ops.emplace_back();
+      auto& op = block->ops.back();
+      op.obj = rocksdb_operation_object( *itr );
+      op.impacted.assign( itr->impacted.begin(), itr->impacted.end() );
+   }
+
+   if( useWriter )
+   {
+      enqueueIrreversibleBlock( block );
+      _queuedLib = block_num;
+      return;
+   }
+
+   try
+   {
+      writeIrreversibleBlock( *block );
+      flushWriteBuffer();
+   }
+   catch( const fc::exception& e )
+   {
+      _writeBuffer.Clear();
+      FC_THROW_EXCEPTION( steem::chain::plugin_exception, "Writing irreversible block ${b} to the account history storage failed: ${e}",
+         ("b", block_num)("e", e.to_detail_string()) );
+   }
+
+   removeVolatileOperations( block_num );
+}
+
+void account_history_rocksdb_plugin::impl::removeVolatileOperations( uint32_t lib )
+{
+   const auto& volatile_idx = _mainDb.get_index< volatile_operation_index, by_block >();
+   auto itr = volatile_idx.begin();
+
+   while( itr != volatile_idx.end() && itr->block <= lib )
+   {
+      const auto& o = *itr;
       ++itr;
+      _mainDb.remove( o );
+   }
+}
+
+void account_history_rocksdb_plugin::impl::writeIrreversibleBlock(const irreversible_block_ops& block)
+{
+   for(const auto& op : block.ops)
+   {
+      rocksdb_operation_object obj(op.obj);
+      importOperation(obj, op.impacted, false);
+   }
+
+   update_lib(block.block_num);
+}
+
+void account_history_rocksdb_plugin::impl::enqueueIrreversibleBlock(irreversible_block_ops_ptr block)
+{
+   std::unique_lock<std::mutex> lock(_writerMutex);
+
+   if(_writerQueue.size() >= _writerQueueSize)
+   {
+      STATSD_START_TIMER( "account_history_rocksdb", "apply_time", "writer_queue_full", 1.0f )
+      _writerQueueNotFull.wait(lock, [this]() { return _writerQueue.size() < _writerQueueSize || _writerError; });
+   }
+
+   /// Thrown out of the notification to stop the node, the unwritten operations stay in volatile_operation_index.
+   if(_writerError)
+      FC_THROW_EXCEPTION( steem::chain::plugin_exception, "Writing to the account history storage failed: ${e}",
+         ("e", _writerError->to_detail_string()) );
+
+   _writerQueue.push_back(std::move(block));
+   STATSD_GAUGE( "account_history_rocksdb", "writer", "queue_size", _writerQueue.size(), 1.0f )
+
+   lock.unlock();
+   _writerWakeUp.notify_one();
+}
+
+void account_history_rocksdb_plugin::impl::writerLoop()
+{
+   while(true)
+   {
+      irreversible_block_ops_ptr block;
+
+      {
+         std::unique_lock<std::mutex> lock(_writerMutex);
+         _writerWakeUp.wait(lock, [this]() { return _stopWriter || (_holdWriter == false && _writerQueue.empty() == false); });
+
+         if(_writerQueue.empty())
+            return;
+
+         block = _writerQueue.front();
+      }
+
+      try
+      {
+         STATSD_START_TIMER( "account_history_rocksdb", "write_time", "irreversible_block", 1.0f )
+         writeIrreversibleBlock(*block);
+
+         /// Stored in one batch and removed from the queue under the lock, so queries find the block either in
+         /// the queue or in the storage.
+         std::lock_guard<std::mutex> lock(_writerMutex);
+         flushWriteBuffer();
+         _writerQueue.pop_front();
+         _writtenLib = block->block_num;
+      }
+      catch(const fc::exception& e)
+      {
+         elog("Writing irreversible block ${b} to the account history storage failed: ${e}",
+            ("b", block->block_num)("e", e.to_detail_string()));
+
+         _writeBuffer.Clear();
+
+         std::lock_guard<std::mutex> lock(_writerMutex);
+         _writerError = e.dynamic_copy_exception();
+         _writerQueueNotFull.notify_all();
+         return;
+      }
+
+      _writerQueueNotFull.notify_all();
    }
+}
+
+void account_history_rocksdb_plugin::impl::startWriter()
+{
+   _queuedLib = get_lib();
+   _writtenLib = _queuedLib;
+   _stopWriter = false;
+   _writerError.reset();
+   _writerThread = std::thread([this]() { writerLoop(); });
+}
+
+void account_history_rocksdb_plugin::impl::stopWriter()
+{
+   if(_writerThread.joinable() == false)
+      return;
 
-   for( const volatile_operation_object* o : to_delete )
    {
-      _mainDb.remove( *o );
+      std::lock_guard<std::mutex> lock(_writerMutex);
+      _stopWriter = true;
    }
 
-   update_lib( block_num );
+   _writerWakeUp.notify_one();
+   _writerThread.join();
+
+   /// The writer stops with blocks left only after a failed write. Their operations are still in
+   /// volatile_operation_index and are queued again once the storage is reopened.
+   std::lock_guard<std::mutex> lock(_writerMutex);
+   if(_writerQueue.empty() == false)
+   {
+      wlog("${n} irreversible blocks were not written to the account history storage, they will be written after a restart.",
+         ("n", _writerQueue.size()));
+      _writerQueue.clear();
+   }
+}
+
+uint32_t account_history_rocksdb_plugin::impl::getWrittenLib() const
+{
+   std::lock_guard<std::mutex> lock(_writerMutex);
+   return _writtenLib;
+}
+
+void account_history_rocksdb_plugin::impl::holdWriter(bool hold)
+{
+   std::unique_lock<std::mutex> lock(_writerMutex);
+   _holdWriter = hold;
+
+   if(hold || _writerThread.joinable() == false)
+      return;
+
+   _writerWakeUp.notify_one();
+   _writerQueueNotFull.wait(lock, [this]() { return _writerQueue.empty() || _writerError; });
+}
+
+uint32_t account_history_rocksdb_plugin::impl::collectQueuedOperations(uint32_t blockRangeBegin, uint32_t blockRangeEnd,
+   bool virtualOnly, std::vector<rocksdb_operation_object>* ops) const
+{
+   std::lock_guard<std::mutex> lock(_writerMutex);
+
+   if(_writerQueue.empty())
+      return 0;
+
+   for(const auto& block : _writerQueue)
+   {
+      if(block->block_num < blockRangeBegin)
+         continue;
+      if(block->first_block_num >= blockRangeEnd)
+         break;
+
+      for(const auto& op : block->ops)
+      {
+         if(op.obj.block >= blockRangeBegin && op.obj.block < blockRangeEnd && (virtualOnly == false || op.obj.virtual_op))
+            ops->push_back(op.obj);
+      }
+   }
+
+   return _writerQueue.front()->first_block_num;
 }
 
 account_history_rocksdb_plugin::account_history_rocksdb_plugin()
@@ -1443,6 +2635,22 @@ void account_history_rocksdb_plugin::set_program_options(
       ("account-history-rocksdb-track-account-range", boost::program_options::value< std::vector<std::string> >()->composing()->multitoken(), "Defines a range of accounts to track as a json pair [\"from\",\"to\"] [from,to] Can be specified multiple times.")
       ("account-history-rocksdb-whitelist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly logged.")
       ("account-history-rocksdb-blacklist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly ignored.")
+      ("account-history-rocksdb-block-cache-size", bpo::value<uint32_t>()->default_value(256),
+         "Size in MB of the block cache shared by all column families. 0 uses the small per column family RocksDB default.")
+      ("account-history-rocksdb-bloom-filter-bits", bpo::value<uint32_t>()->default_value(10),
+         "Bits per key of the bloom filters, 0 disables them.")
+      ("account-history-rocksdb-partitioned-index", bpo::value<bool>()->default_value(false),
+         "Use partitioned indexes and filters, kept in the block cache instead of memory.")
+      ("account-history-rocksdb-prefix-extractor", bpo::value<bool>()->default_value(true),
+         "Build prefix bloom filters over block numbers and account history ids for the by block and per account scans.")
+      ("account-history-rocksdb-compression", bpo::value<std::string>(),
+         "Comma separated compression of each level, from level 0: none, snappy, zlib, bzip2, lz4, lz4hc, xpress or zstd. E.g. none,none,lz4,lz4,lz4,lz4,zstd. The RocksDB default when not set.")
+      ("account-history-rocksdb-operation-compression", bpo::value<std::string>(),
+         "Compression of the bottommost level of the operation column, which holds most of the storage. E.g. zstd.")
+      ("account-history-rocksdb-compression-dictionary-size", bpo::value<uint32_t>()->default_value(16384),
+         "Size in bytes of the dictionary sampled from the operations to prime the operation compression. 0 disables it. Needs zstd, zlib or lz4.")
+      ("account-history-rocksdb-writer-queue-size", bpo::value<uint32_t>()->default_value(100),
+         "Number of irreversible blocks a dedicated thread can be behind writing them to the storage. 0 writes them during block application.")
 
    ;
    command_line_options.add_options()
@@ -1450,6 +2658,14 @@ void account_history_rocksdb_plugin::set_program_options(
          "Allows to force immediate data import at plugin startup. By default storage is supplied during reindex process.")
       ("account-history-rocksdb-stop-import-at-block", bpo::value<uint32_t>()->default_value(0),
          "Allows to specify block number, the data import process should stop at.")
+      ("account-history-rocksdb-import-threads", bpo::value<uint32_t>()->default_value(0),
+         "Number of threads of the immediate data import. 0 imports sequentially, otherwise an empty storage is built from the block log in parallel.")
+      ("account-history-rocksdb-compact", bpo::bool_switch()->default_value(false),
+         "Rewrite the storage at startup, applying the current compression settings to the existing data.")
+      ("account-history-rocksdb-storage-report", bpo::bool_switch()->default_value(false),
+         "Report the size of the storage and the speed of a full operation scan at startup.")
+      ("account-history-rocksdb-read-benchmark", bpo::value<uint32_t>()->default_value(0),
+         "Number of accounts whose newest 100 operations are read at startup, with a cold and then a warm block cache. 0 disables the benchmark.")
    ;
 }
 
@@ -1459,6 +2675,9 @@ void account_history_rocksdb_plugin::plugin_initialize(const boost::program_opti
       _blockLimit = options.at("account-history-rocksdb-stop-import-at-block").as<uint32_t>();
 
    _doImmediateImport = options.at("account-history-rocksdb-immediate-import").as<bool>();
+   _readBenchmarkAccounts = options.at("account-history-rocksdb-read-benchmark").as<uint32_t>();
+   _doCompaction = options.at("account-history-rocksdb-compact").as<bool>();
+   _doStorageReport = options.at("account-history-rocksdb-storage-report").as<bool>();
 
    bfs::path dbPath;
 
@@ -1483,6 +2702,15 @@ void account_history_rocksdb_plugin::plugin_startup()
 
    if(_doImmediateImport)
       _my->importData(_blockLimit);
+
+   if(_doCompaction)
+      _my->compactStorage();
+
+   if(_doStorageReport)
+      _my->reportStorage();
+
+   if(_readBenchmarkAccounts != 0)
+      _my->runReadBenchmark(_readBenchmarkAccounts, 100);
 }
 
 void account_history_rocksdb_plugin::plugin_shutdown()
@@ -1494,7 +2722,14 @@ void account_history_rocksdb_plugin::plugin_shutdown()
 void account_history_rocksdb_plugin::find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
    std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
 {
-   _my->find_account_history_data(name, start, limit, processor);
+   _my->find_account_history_data(name, start, limit, account_history_filter(), processor);
+}
+
+fc::optional<uint64_t> account_history_rocksdb_plugin::find_account_history_data(const account_name_type& name,
+   uint64_t start, uint32_t limit, const account_history_filter& filter,
+   std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
+{
+   return _my->find_account_history_data(name, start, limit, filter, processor);
 }
 
 bool account_history_rocksdb_plugin::find_operation_object(size_t opId, rocksdb_operation_object* op) const
@@ -1502,6 +2737,11 @@ bool account_history_rocksdb_plugin::find_operation_object(size_t opId, rocksdb_
    return _my->find_operation_object(opId, op);
 }
 
+void account_history_rocksdb_plugin::hold_writer(bool hold)
+{
+   _my->holdWriter(hold);
+}
+
 void account_history_rocksdb_plugin::find_operations_by_block(size_t blockNum,
    std::function<void(const rocksdb_operation_object&)> processor) const
 {
@@ -1518,3 +2758,6 @@ uint32_t account_history_rocksdb_plugin::enum_operations_from_block_range(uint32
 
 FC_REFLECT( steem::plugins::account_history_rocksdb::account_history_info,
    (id)(oldestEntryId)(newestEntryId)(oldestEntryTimestamp) )
+
+FC_REFLECT( steem::plugins::account_history_rocksdb::account_history_chunk_info,
+   (opTypesLow)(opTypesHigh)(firstBlock)(lastBlock)(firstTimestamp)(lastTimestamp) )
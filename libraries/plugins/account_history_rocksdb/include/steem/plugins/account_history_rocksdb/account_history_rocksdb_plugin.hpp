@@ -5,6 +5,7 @@
 
 #include <appbase/application.hpp>
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -14,7 +15,65 @@ namespace plugins { namespace account_history_rocksdb {
 
 namespace bfs = boost::filesystem;
 
-
+/** Restricts the operations of an account history query. Unset (zero) members do not restrict anything.
+ *  Bit n of the operation filter selects the operation type n of steem::protocol::operation, the high
+ *  mask holding the types from 64. Block and time ranges include their begin and exclude their end.
+ */
+struct account_history_filter
+{
+   uint64_t                operation_filter_low = 0;
+   uint64_t                operation_filter_high = 0;
+   uint32_t                block_range_begin = 0;
+   uint32_t                block_range_end = 0;
+   fc::time_point_sec      time_range_begin;
+   fc::time_point_sec      time_range_end;
+
+   bool is_set() const
+   {
+      return operation_filter_low != 0 || operation_filter_high != 0 || block_range_begin != 0 || block_range_end != 0 ||
+         time_range_begin != fc::time_point_sec() || time_range_end != fc::time_point_sec();
+   }
+
+   bool matches_type(uint32_t type) const
+   {
+      if(operation_filter_low == 0 && operation_filter_high == 0)
+         return true;
+      if(type < 64)
+         return (operation_filter_low >> type) & 1;
+      return type < 128 && ((operation_filter_high >> (type - 64)) & 1);
+   }
+
+   /// False when none of the operation types in the masks is selected
+   bool matches_any_type(uint64_t typesLow, uint64_t typesHigh) const
+   {
+      if(operation_filter_low == 0 && operation_filter_high == 0)
+         return true;
+      return (typesLow & operation_filter_low) != 0 || (typesHigh & operation_filter_high) != 0;
+   }
+
+   bool is_before_range(uint32_t block, const fc::time_point_sec& timestamp) const
+   {
+      return block < block_range_begin || timestamp < time_range_begin;
+   }
+
+   bool is_after_range(uint32_t block, const fc::time_point_sec& timestamp) const
+   {
+      return (block_range_end != 0 && block >= block_range_end) ||
+         (time_range_end != fc::time_point_sec() && timestamp >= time_range_end);
+   }
+
+   bool matches(uint32_t type, uint32_t block, const fc::time_point_sec& timestamp) const
+   {
+      return matches_type(type) && is_before_range(block, timestamp) == false && is_after_range(block, timestamp) == false;
+   }
+
+   /// Entries a filtered query reads at most before returning where to resume, so rare matches do not scan the
+   /// whole history in one call.
+   static uint32_t scan_limit(uint32_t limit)
+   {
+      return std::max<uint32_t>(10 * limit, 1000);
+   }
+};
 
 class account_history_rocksdb_plugin final : public appbase::plugin< account_history_rocksdb_plugin >
 {
@@ -37,18 +96,34 @@ public:
 
    void find_account_history_data(const protocol::account_name_type& name, uint64_t start, uint32_t limit,
       std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
+   /** Like find_account_history_data, but returns only the operations matching the filter, going back from
+    *  start until limit of them are found. Chunks of the history holding none of the requested operation
+    *  types or out of the block and time ranges are skipped without reading their operations. At most
+    *  account_history_filter::scan_limit(limit) operations are read, when the scan stops there the entry
+    *  to resume from is returned.
+    */
+   fc::optional<uint64_t> find_account_history_data(const protocol::account_name_type& name, uint64_t start, uint32_t limit,
+      const account_history_filter& filter, std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
    bool find_operation_object(size_t opId, rocksdb_operation_object* data) const;
    void find_operations_by_block(size_t blockNum,
       std::function<void(const rocksdb_operation_object&)> processor) const;
    uint32_t enum_operations_from_block_range(uint32_t blockRangeBegin, uint32_t blockRangeEnd,
       std::function<void(const rocksdb_operation_object&)> processor) const;
 
+   /** Keeps irreversible blocks in the writer queue, for tests of the reads served from there. Releasing the
+    *  writer returns once the queued blocks are written.
+    */
+   void hold_writer(bool hold);
+
 private:
    class impl;
 
    std::unique_ptr<impl> _my;
    uint32_t              _blockLimit = 0;
    bool                  _doImmediateImport = false;
+   uint32_t              _readBenchmarkAccounts = 0;
+   bool                  _doCompaction = false;
+   bool                  _doStorageReport = false;
 };
 
 
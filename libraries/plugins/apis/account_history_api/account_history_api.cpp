@@ -7,6 +7,20 @@ namespace steem { namespace plugins { namespace account_history {
 
 namespace detail {
 
+account_history_rocksdb::account_history_filter make_account_history_filter( const get_account_history_args& args )
+{
+   account_history_rocksdb::account_history_filter filter;
+   filter.operation_filter_low = args.operation_filter_low.valid() ? *args.operation_filter_low : 0;
+   filter.operation_filter_high = args.operation_filter_high.valid() ? *args.operation_filter_high : 0;
+   filter.block_range_begin = args.block_range_begin.valid() ? *args.block_range_begin : 0;
+   filter.block_range_end = args.block_range_end.valid() ? *args.block_range_end : 0;
+   if( args.time_range_begin.valid() )
+      filter.time_range_begin = *args.time_range_begin;
+   if( args.time_range_end.valid() )
+      filter.time_range_end = *args.time_range_end;
+   return filter;
+}
+
 class abstract_account_history_api_impl
 {
    public:
@@ -18,6 +32,9 @@ class abstract_account_history_api_impl
       virtual get_account_history_return get_account_history( const get_account_history_args& ) = 0;
       virtual enum_virtual_ops_return enum_virtual_ops( const enum_virtual_ops_args& ) = 0;
 
+      /// True when the queries read their own store and never take the database lock
+      virtual bool is_lock_free()const { return false; }
+
       chain::database& _db;
 };
 
@@ -87,14 +104,18 @@ DEFINE_API_IMPL( account_history_api_chainbase_impl, get_transaction )
 
 DEFINE_API_IMPL( account_history_api_chainbase_impl, get_account_history )
 {
+   auto filter = make_account_history_filter( args );
+
    FC_ASSERT( args.limit <= 10000, "limit of ${l} is greater than maxmimum allowed", ("l",args.limit) );
-   FC_ASSERT( args.start >= args.limit, "start must be greater than limit" );
+   FC_ASSERT( filter.is_set() || args.start >= args.limit, "start must be greater than limit" );
 
    return _db.with_read_lock( [&]()
    {
       const auto& idx = _db.get_index< chain::account_history_index, chain::by_account >();
       auto itr = idx.lower_bound( boost::make_tuple( args.account, args.start ) );
       uint32_t n = 0;
+      uint32_t scan_limit = account_history_rocksdb::account_history_filter::scan_limit( args.limit );
+      uint32_t examined = 0;
 
       get_account_history_return result;
       while( true )
@@ -105,6 +126,31 @@ DEFINE_API_IMPL( account_history_api_chainbase_impl, get_account_history )
             break;
          if( n >= args.limit )
             break;
+
+         if( filter.is_set() )
+         {
+            /// Bounds the time spent under the read lock when the matching operations are rare
+            if( examined == scan_limit )
+            {
+               result.next_start = itr->sequence;
+               break;
+            }
+            ++examined;
+
+            api_operation_object temp = _db.get( itr->op );
+            if( filter.is_before_range( temp.block, temp.timestamp ) )
+               break;
+
+            if( filter.matches( temp.op.which(), temp.block, temp.timestamp ) )
+            {
+               result.history[ itr->sequence ] = std::move( temp );
+               ++n;
+            }
+
+            ++itr;
+            continue;
+         }
+
          result.history[ itr->sequence ] = _db.get( itr->op );
          ++itr;
          ++n;
@@ -131,6 +177,8 @@ class account_history_api_rocksdb_impl : public abstract_account_history_api_imp
       get_account_history_return get_account_history( const get_account_history_args& ) override;
       enum_virtual_ops_return enum_virtual_ops( const enum_virtual_ops_args& ) override;
 
+      bool is_lock_free()const override { return true; }
+
       const account_history_rocksdb::account_history_rocksdb_plugin& _dataSource;
 };
 
@@ -150,12 +198,14 @@ DEFINE_API_IMPL( account_history_api_rocksdb_impl, get_ops_in_block )
 
 DEFINE_API_IMPL( account_history_api_rocksdb_impl, get_account_history )
 {
+   auto filter = make_account_history_filter( args );
+
    FC_ASSERT( args.limit <= 10000, "limit of ${l} is greater than maxmimum allowed", ("l",args.limit) );
-   FC_ASSERT( args.start >= args.limit, "start must be greater than limit" );
+   FC_ASSERT( filter.is_set() || args.start >= args.limit, "start must be greater than limit" );
 
    get_account_history_return result;
 
-   _dataSource.find_account_history_data(args.account, args.start, args.limit,
+   result.next_start = _dataSource.find_account_history_data(args.account, args.start, args.limit, filter,
       [&result](unsigned int sequence, const account_history_rocksdb::rocksdb_operation_object& op)
       {
          result.history[sequence] = api_operation_object( op );
@@ -212,6 +262,11 @@ account_history_api::account_history_api()
 
 account_history_api::~account_history_api() {}
 
+bool account_history_api::is_lock_free()const
+{
+   return my->is_lock_free();
+}
+
 DEFINE_LOCKLESS_APIS( account_history_api ,
    (get_ops_in_block)
    (get_transaction)
@@ -6,6 +6,7 @@
 #include <steem/protocol/types.hpp>
 
 #include <fc/optional.hpp>
+#include <fc/io/json_writer.hpp>
 #include <fc/variant.hpp>
 #include <fc/vector.hpp>
 
@@ -64,16 +65,35 @@ struct get_transaction_args
 typedef steem::protocol::annotated_signed_transaction get_transaction_return;
 
 
+/** Operations of an account, going back from start.
+ *  \param operation_filter_low  - bit n selects the operation type n, for the types 0 to 63
+ *  \param operation_filter_high - bit n selects the operation type 64 + n
+ *  \param block_range_begin     - first block (inclusive) of the returned operations
+ *  \param block_range_end       - last block (exclusive) of the returned operations
+ *  \param time_range_begin      - oldest time (inclusive) of the returned operations
+ *  \param time_range_end        - newest time (exclusive) of the returned operations
+ *  With filters, limit counts the matching operations only and start may be lower than limit.
+ */
 struct get_account_history_args
 {
    steem::protocol::account_name_type   account;
    uint64_t                               start = -1;
    uint32_t                               limit = 1000;
+   fc::optional< uint64_t >               operation_filter_low;
+   fc::optional< uint64_t >               operation_filter_high;
+   fc::optional< uint32_t >               block_range_begin;
+   fc::optional< uint32_t >               block_range_end;
+   fc::optional< fc::time_point_sec >     time_range_begin;
+   fc::optional< fc::time_point_sec >     time_range_end;
 };
 
+/** \param next_start - set when a filtered query read its maximum of operations before finding limit of them,
+ *                      the start of the query continuing the scan
+ */
 struct get_account_history_return
 {
    std::map< uint32_t, api_operation_object > history;
+   fc::optional< uint64_t >                   next_start;
 };
 
 /** Allows to specify range of blocks to retrieve virtual operations for.
@@ -106,6 +126,9 @@ class account_history_api
          (enum_virtual_ops)
       )
 
+      /// Whether operations are read from account_history_rocksdb, without the database lock
+      bool is_lock_free()const;
+
    private:
       std::unique_ptr< detail::abstract_account_history_api_impl > my;
 };
@@ -114,24 +137,28 @@ class account_history_api
 
 FC_REFLECT( steem::plugins::account_history::api_operation_object,
    (trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(op) )
+FC_REFLECT_JSON_WRITER( steem::plugins::account_history::api_operation_object )
 
 FC_REFLECT( steem::plugins::account_history::get_ops_in_block_args,
    (block_num)(only_virtual) )
 
 FC_REFLECT( steem::plugins::account_history::get_ops_in_block_return,
    (ops) )
+FC_REFLECT_JSON_WRITER( steem::plugins::account_history::get_ops_in_block_return )
 
 FC_REFLECT( steem::plugins::account_history::get_transaction_args,
    (id) )
 
 FC_REFLECT( steem::plugins::account_history::get_account_history_args,
-   (account)(start)(limit) )
+   (account)(start)(limit)(operation_filter_low)(operation_filter_high)(block_range_begin)(block_range_end)(time_range_begin)(time_range_end) )
 
 FC_REFLECT( steem::plugins::account_history::get_account_history_return,
-   (history) )
+   (history)(next_start) )
+FC_REFLECT_JSON_WRITER( steem::plugins::account_history::get_account_history_return )
 
 FC_REFLECT( steem::plugins::account_history::enum_virtual_ops_args,
    (block_range_begin)(block_range_end) )
 
 FC_REFLECT( steem::plugins::account_history::enum_virtual_ops_return,
    (ops)(next_block_range_begin) )
+FC_REFLECT_JSON_WRITER( steem::plugins::account_history::enum_virtual_ops_return )
@@ -16,6 +16,12 @@ class block_api_impl
       DECLARE_API_IMPL(
          (get_block_header)
          (get_block)
+         (get_block_range)
+      )
+
+      DECLARE_IRREVERSIBLE_API_IMPL(
+         (get_block_header)
+         (get_block)
       )
 
       chain::database& _db;
@@ -68,9 +74,85 @@ DEFINE_API_IMPL( block_api_impl, get_block )
    return result;
 }
 
-DEFINE_READ_APIS( block_api,
+// Blocks in the block log are irreversible and are read without the database lock
+DEFINE_IRREVERSIBLE_API_IMPL( block_api_impl, get_block_header )
+{
+   const auto& log = _db.get_block_log();
+   if( args.block_num == 0 || args.block_num > log.head_block_num() )
+      return false;
+
+   auto block = log.read_block_by_num( args.block_num );
+
+   if( block )
+      result.header = *block;
+
+   return true;
+}
+
+DEFINE_IRREVERSIBLE_API_IMPL( block_api_impl, get_block )
+{
+   const auto& log = _db.get_block_log();
+   if( args.block_num == 0 || args.block_num > log.head_block_num() )
+      return false;
+
+   auto block = log.read_block_by_num( args.block_num );
+
+   if( block )
+      result.block = *block;
+
+   return true;
+}
+
+DEFINE_API_IMPL( block_api_impl, get_block_range )
+{
+   FC_ASSERT( args.count <= BLOCK_API_SINGLE_QUERY_LIMIT, "count cannot be greater than ${l}", ("l", BLOCK_API_SINGLE_QUERY_LIMIT) );
+   FC_ASSERT( args.starting_block_num > 0, "Block numbers start at 1" );
+
+   get_block_range_return result;
+   result.blocks.reserve( args.count );
+
+   uint64_t end = uint64_t( args.starting_block_num ) + args.count;
+   uint32_t block_num = args.starting_block_num;
+
+   // Irreversible blocks are read sequentially from the block log without the database lock
+   const auto& log = _db.get_block_log();
+   uint32_t log_head = log.head_block_num();
+   if( block_num <= log_head )
+   {
+      uint64_t pos = log.get_block_pos( block_num );
+      for( ; block_num < end && block_num <= log_head; ++block_num )
+      {
+         auto itr = log.read_block( pos );
+         result.blocks.emplace_back( itr.first );
+         pos = itr.second;
+      }
+   }
+
+   // Reversible blocks are in the fork database, which is only consistent under the read lock
+   if( block_num < end )
+   {
+      _db.with_read_lock( [&]()
+      {
+         for( ; block_num < end; ++block_num )
+         {
+            auto block = _db.fetch_block_by_number( block_num );
+            if( !block )
+               break;
+            result.blocks.emplace_back( *block );
+         }
+      });
+   }
+
+   return result;
+}
+
+DEFINE_IRREVERSIBLE_APIS( block_api,
    (get_block_header)
    (get_block)
 )
 
+DEFINE_LOCKLESS_APIS( block_api,
+   (get_block_range)
+)
+
 } } } // steem::plugins::block_api
@@ -5,6 +5,8 @@
 #include <steem/plugins/block_api/block_api_plugin.hpp>
 #include <steem/plugins/account_history_api/account_history_api_plugin.hpp>
 #include <steem/plugins/account_by_key_api/account_by_key_api_plugin.hpp>
+#include <steem/plugins/transaction_index_api/transaction_index_api_plugin.hpp>
+#include <steem/plugins/transaction_index_api/transaction_index_api.hpp>
 #include <steem/plugins/network_broadcast_api/network_broadcast_api_plugin.hpp>
 #include <steem/plugins/tags_api/tags_api_plugin.hpp>
 #include <steem/plugins/follow_api/follow_api_plugin.hpp>
@@ -133,6 +135,18 @@ namespace detail
             (get_market_history_buckets)
          )
 
+         DECLARE_IRREVERSIBLE_API_IMPL(
+            (get_block_header)
+            (get_block)
+            (get_ops_in_block)
+         )
+
+         bool is_irreversible( uint32_t block_num )const;
+
+         get_block_return to_legacy_block( const optional< block_api::api_signed_block_object >& b )const;
+
+         get_ops_in_block_return to_legacy_ops( const std::multiset< account_history::api_operation_object >& ops )const;
+
          void recursively_fetch_content( state& _state, tags::discussion& root, set<string>& referenced_accounts );
 
          void set_pending_payout( discussion& d );
@@ -147,6 +161,7 @@ namespace detail
          std::shared_ptr< block_api::block_api >                           _block_api;
          std::shared_ptr< account_history::account_history_api >           _account_history_api;
          std::shared_ptr< account_by_key::account_by_key_api >             _account_by_key_api;
+         std::shared_ptr< transaction_index_api::transaction_index_api >   _transaction_index_api;
          std::shared_ptr< network_broadcast_api::network_broadcast_api >   _network_broadcast_api;
          p2p::p2p_plugin*                                                  _p2p = nullptr;
          std::shared_ptr< tags::tags_api >                                 _tags_api;
@@ -731,8 +746,72 @@ namespace detail
    {
       CHECK_ARG_SIZE( 1 )
       FC_ASSERT( _block_api, "block_api_plugin not enabled." );
+      return to_legacy_block( _block_api->get_block( { args[0].as< uint32_t >() } ).block );
+   }
+
+   DEFINE_API_IMPL( condenser_api_impl, get_ops_in_block )
+   {
+      FC_ASSERT( args.size() == 1 || args.size() == 2, "Expected 1-2 arguments, was ${n}", ("n", args.size()) );
+      FC_ASSERT( _account_history_api, "account_history_api_plugin not enabled." );
+
+      return to_legacy_ops( _account_history_api->get_ops_in_block( { args[0].as< uint32_t >(), args[1].as< bool >() } ).ops );
+   }
+
+   /*
+    * Blocks up to the head of the block log are irreversible. block_api reads them from the block log and
+    * account_history_api from account_history_rocksdb, so they are served without the database lock.
+    */
+   bool condenser_api_impl::is_irreversible( uint32_t block_num )const
+   {
+      return block_num > 0 && block_num <= _db.get_block_log().head_block_num();
+   }
+
+   DEFINE_IRREVERSIBLE_API_IMPL( condenser_api_impl, get_block_header )
+   {
+      CHECK_ARG_SIZE( 1 )
+      FC_ASSERT( _block_api, "block_api_plugin not enabled." );
+
+      uint32_t block_num = args[0].as< uint32_t >();
+      if( !is_irreversible( block_num ) )
+         return false;
+
+      result = _block_api->get_block_header( { block_num }, true ).header;
+      return true;
+   }
+
+   DEFINE_IRREVERSIBLE_API_IMPL( condenser_api_impl, get_block )
+   {
+      CHECK_ARG_SIZE( 1 )
+      FC_ASSERT( _block_api, "block_api_plugin not enabled." );
+
+      uint32_t block_num = args[0].as< uint32_t >();
+      if( !is_irreversible( block_num ) )
+         return false;
+
+      result = to_legacy_block( _block_api->get_block( { block_num }, true ).block );
+      return true;
+   }
+
+   DEFINE_IRREVERSIBLE_API_IMPL( condenser_api_impl, get_ops_in_block )
+   {
+      FC_ASSERT( args.size() == 1 || args.size() == 2, "Expected 1-2 arguments, was ${n}", ("n", args.size()) );
+      FC_ASSERT( _account_history_api, "account_history_api_plugin not enabled." );
+
+      // The chainbase account history takes the read lock itself
+      if( !_account_history_api->is_lock_free() )
+         return false;
+
+      uint32_t block_num = args[0].as< uint32_t >();
+      if( !is_irreversible( block_num ) )
+         return false;
+
+      result = to_legacy_ops( _account_history_api->get_ops_in_block( { block_num, args[1].as< bool >() }, true ).ops );
+      return true;
+   }
+
+   get_block_return condenser_api_impl::to_legacy_block( const optional< block_api::api_signed_block_object >& b )const
+   {
       get_block_return result;
-      auto b = _block_api->get_block( { args[0].as< uint32_t >() } ).block;
 
       if( b )
       {
@@ -750,12 +829,8 @@ namespace detail
       return result;
    }
 
-   DEFINE_API_IMPL( condenser_api_impl, get_ops_in_block )
+   get_ops_in_block_return condenser_api_impl::to_legacy_ops( const std::multiset< account_history::api_operation_object >& ops )const
    {
-      FC_ASSERT( args.size() == 1 || args.size() == 2, "Expected 1-2 arguments, was ${n}", ("n", args.size()) );
-      FC_ASSERT( _account_history_api, "account_history_api_plugin not enabled." );
-
-      auto ops = _account_history_api->get_ops_in_block( { args[0].as< uint32_t >(), args[1].as< bool >() } ).ops;
       get_ops_in_block_return result;
 
       legacy_operation l_op;
@@ -1223,10 +1298,18 @@ namespace detail
       }).hex;
    }
 
+   /**
+    * Served by the transaction index when it is enabled, it does not need account history and takes
+    * the database lock only for transactions in reversible blocks. Both sources lock for themselves.
+    */
    DEFINE_API_IMPL( condenser_api_impl, get_transaction )
    {
       CHECK_ARG_SIZE( 1 )
-      FC_ASSERT( _account_history_api, "account_history_api_plugin not enabled." );
+
+      if( _transaction_index_api )
+         return legacy_signed_transaction( _transaction_index_api->get_transaction( { args[0].as< transaction_id_type >() } ) );
+
+      FC_ASSERT( _account_history_api, "Neither transaction_index_api_plugin nor account_history_api_plugin are enabled." );
 
       return legacy_signed_transaction( _account_history_api->get_transaction( { args[0].as< transaction_id_type >() } ) );
    }
@@ -1648,10 +1731,17 @@ namespace detail
 
    DEFINE_API_IMPL( condenser_api_impl, get_account_history )
    {
-      CHECK_ARG_SIZE( 3 )
+      FC_ASSERT( args.size() == 3 || args.size() == 5, "Expected 3 or 5 arguments, was ${n}", ("n", args.size()) );
       FC_ASSERT( _account_history_api, "account_history_api_plugin not enabled." );
 
-      auto history = _account_history_api->get_account_history( { args[0].as< account_name_type >(), args[1].as< uint64_t >(), args[2].as< uint32_t >() } ).history;
+      account_history::get_account_history_args history_args = { args[0].as< account_name_type >(), args[1].as< uint64_t >(), args[2].as< uint32_t >() };
+      if( args.size() == 5 )
+      {
+         history_args.operation_filter_low = args[3].as< uint64_t >();
+         history_args.operation_filter_high = args[4].as< uint64_t >();
+      }
+
+      auto history = _account_history_api->get_account_history( history_args ).history;
       get_account_history_return result;
 
       legacy_operation l_op;
@@ -2126,6 +2216,12 @@ void condenser_api::api_startup()
       my->_account_history_api = account_history->api;
    }
 
+   auto transaction_index = appbase::app().find_plugin< transaction_index_api::transaction_index_api_plugin >();
+   if( transaction_index != nullptr )
+   {
+      my->_transaction_index_api = transaction_index->api;
+   }
+
    auto network_broadcast = appbase::app().find_plugin< network_broadcast_api::network_broadcast_api_plugin >();
    if( network_broadcast != nullptr )
    {
@@ -2171,15 +2267,19 @@ DEFINE_LOCKLESS_APIS( condenser_api,
    (broadcast_transaction_synchronous)
    (broadcast_block)
    (get_market_history_buckets)
+   (get_transaction)
+)
+
+DEFINE_IRREVERSIBLE_APIS( condenser_api,
+   (get_block_header)
+   (get_block)
+   (get_ops_in_block)
 )
 
 DEFINE_READ_APIS( condenser_api,
    (get_trending_tags)
    (get_state)
    (get_active_witnesses)
-   (get_block_header)
-   (get_block)
-   (get_ops_in_block)
    (get_dynamic_global_properties)
    (get_chain_properties)
    (get_current_median_history_price)
@@ -2209,7 +2309,6 @@ DEFINE_READ_APIS( condenser_api,
    (get_witness_count)
    (get_open_orders)
    (get_transaction_hex)
-   (get_transaction)
    (get_required_signatures)
    (get_potential_signatures)
    (verify_authority)
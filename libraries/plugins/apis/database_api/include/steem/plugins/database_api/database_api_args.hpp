@@ -593,6 +593,7 @@ FC_REFLECT( steem::plugins::database_api::get_reward_funds_return,
 
 FC_REFLECT( steem::plugins::database_api::list_witnesses_return,
    (witnesses) )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::list_witnesses_return )
 
 FC_REFLECT( steem::plugins::database_api::find_witnesses_args,
    (owners) )
@@ -605,6 +606,7 @@ FC_REFLECT( steem::plugins::database_api::get_active_witnesses_return,
 
 FC_REFLECT( steem::plugins::database_api::list_accounts_return,
    (accounts) )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::list_accounts_return )
 
 FC_REFLECT( steem::plugins::database_api::find_accounts_args,
    (accounts) )
@@ -675,12 +677,14 @@ FC_REFLECT( steem::plugins::database_api::find_decline_voting_rights_requests_ar
 
 FC_REFLECT( steem::plugins::database_api::list_comments_return,
    (comments) )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::list_comments_return )
 
 FC_REFLECT( steem::plugins::database_api::find_comments_args,
    (comments) )
 
 FC_REFLECT( steem::plugins::database_api::list_votes_return,
    (votes) )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::list_votes_return )
 
 FC_REFLECT( steem::plugins::database_api::find_votes_args,
    (author)(permlink) )
@@ -10,6 +10,8 @@
 #include <steem/chain/witness_objects.hpp>
 #include <steem/chain/database.hpp>
 
+#include <fc/io/json_writer.hpp>
+
 namespace steem { namespace plugins { namespace database_api {
 
 using namespace steem::chain;
@@ -557,10 +559,12 @@ FC_REFLECT( steem::plugins::database_api::api_comment_object,
              (max_accepted_payout)(percent_steem_dollars)(allow_replies)(allow_votes)(allow_curation_rewards)
              (beneficiaries)
           )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::api_comment_object )
 
 FC_REFLECT( steem::plugins::database_api::api_comment_vote_object,
              (id)(voter)(author)(permlink)(weight)(rshares)(vote_percent)(last_update)(num_changes)
           )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::api_comment_vote_object )
 
 FC_REFLECT( steem::plugins::database_api::api_account_object,
              (id)(name)(owner)(active)(posting)(memo_key)(json_metadata)(proxy)(last_owner_update)(last_account_update)
@@ -580,6 +584,7 @@ FC_REFLECT( steem::plugins::database_api::api_account_object,
              (post_bandwidth)(pending_claimed_accounts)
              (is_smt)
           )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::api_account_object )
 
 FC_REFLECT( steem::plugins::database_api::api_owner_authority_history_object,
              (id)
@@ -624,6 +629,7 @@ FC_REFLECT( steem::plugins::database_api::api_witness_object,
              (hardfork_version_vote)(hardfork_time_vote)
              (available_witness_account_subsidies)
           )
+FC_REFLECT_JSON_WRITER( steem::plugins::database_api::api_witness_object )
 
 FC_REFLECT( steem::plugins::database_api::api_witness_schedule_object,
              (id)
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <steem/plugins/transaction_index_api/transaction_index_api_args.hpp>
+#include <steem/plugins/json_rpc/utility.hpp>
+
+namespace steem { namespace plugins { namespace transaction_index_api {
+
+namespace detail { class transaction_index_api_impl; }
+
+class transaction_index_api
+{
+public:
+   transaction_index_api();
+   ~transaction_index_api();
+
+   DECLARE_API(
+      (get_transaction)
+      (find_transaction)
+   )
+private:
+   std::unique_ptr< detail::transaction_index_api_impl > my;
+};
+
+} } } //steem::plugins::transaction_index_api
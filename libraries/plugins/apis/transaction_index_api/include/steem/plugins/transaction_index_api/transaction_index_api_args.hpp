@@ -0,0 +1,33 @@
+#pragma once
+
+#include <steem/protocol/types.hpp>
+#include <steem/protocol/transaction.hpp>
+
+#include <steem/plugins/json_rpc/utility.hpp>
+#include <steem/plugins/transaction_index/transaction_index_plugin.hpp>
+
+namespace steem { namespace plugins { namespace transaction_index_api {
+
+struct get_transaction_args
+{
+   chain::transaction_id_type id;
+};
+
+typedef protocol::annotated_signed_transaction get_transaction_return;
+
+struct find_transaction_args
+{
+   chain::transaction_id_type id;
+};
+
+struct find_transaction_return
+{
+   fc::optional< uint32_t > block_num;
+   fc::optional< uint32_t > trx_in_block;
+};
+
+} } } // steem::plugins::transaction_index_api
+
+FC_REFLECT( steem::plugins::transaction_index_api::get_transaction_args, (id) )
+FC_REFLECT( steem::plugins::transaction_index_api::find_transaction_args, (id) )
+FC_REFLECT( steem::plugins::transaction_index_api::find_transaction_return, (block_num)(trx_in_block) )
@@ -0,0 +1,34 @@
+#pragma once
+#include <steem/plugins/transaction_index/transaction_index_plugin.hpp>
+#include <steem/plugins/json_rpc/json_rpc_plugin.hpp>
+
+#include <appbase/application.hpp>
+
+namespace steem { namespace plugins { namespace transaction_index_api {
+
+#define STEEM_TRANSACTION_INDEX_API_PLUGIN_NAME "transaction_index_api"
+
+class transaction_index_api_plugin : public appbase::plugin< transaction_index_api_plugin >
+{
+   public:
+      transaction_index_api_plugin();
+      virtual ~transaction_index_api_plugin();
+
+      APPBASE_PLUGIN_REQUIRES(
+         (steem::plugins::json_rpc::json_rpc_plugin)
+         (steem::plugins::transaction_index::transaction_index_plugin)
+      )
+
+      static const std::string& name() { static std::string name = STEEM_TRANSACTION_INDEX_API_PLUGIN_NAME; return name; }
+
+      virtual void set_program_options(
+         boost::program_options::options_description& cli,
+         boost::program_options::options_description& cfg ) override;
+      virtual void plugin_initialize( const boost::program_options::variables_map& options ) override;
+      virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
+
+      std::shared_ptr< class transaction_index_api > api;
+};
+
+} } } // steem::plugins::transaction_index_api
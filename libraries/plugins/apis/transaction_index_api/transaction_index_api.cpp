@@ -0,0 +1,58 @@
+#include <steem/plugins/transaction_index_api/transaction_index_api_plugin.hpp>
+#include <steem/plugins/transaction_index_api/transaction_index_api.hpp>
+
+namespace steem { namespace plugins { namespace transaction_index_api {
+
+namespace detail {
+
+class transaction_index_api_impl
+{
+public:
+   transaction_index_api_impl() :
+      _tip( appbase::app().get_plugin< steem::plugins::transaction_index::transaction_index_plugin >() ) {}
+
+   DECLARE_API_IMPL(
+      (get_transaction)
+      (find_transaction)
+   )
+
+   transaction_index::transaction_index_plugin& _tip;
+};
+
+DEFINE_API_IMPL( transaction_index_api_impl, get_transaction )
+{
+   auto trx = _tip.get_transaction( args.id );
+   FC_ASSERT( trx.valid(), "Unknown Transaction ${t}", ("t", args.id) );
+   return *trx;
+}
+
+DEFINE_API_IMPL( transaction_index_api_impl, find_transaction )
+{
+   find_transaction_return result;
+
+   auto location = _tip.find_transaction( args.id );
+   if( location )
+   {
+      result.block_num = location->block_num;
+      result.trx_in_block = location->trx_in_block;
+   }
+
+   return result;
+}
+
+} // steem::plugins::transaction_index_api::detail
+
+transaction_index_api::transaction_index_api() : my( std::make_unique< detail::transaction_index_api_impl >() )
+{
+   JSON_RPC_REGISTER_API( STEEM_TRANSACTION_INDEX_API_PLUGIN_NAME );
+}
+
+transaction_index_api::~transaction_index_api() {}
+
+// The transaction index takes the database read lock only for reversible blocks
+DEFINE_LOCKLESS_APIS( transaction_index_api,
+   (get_transaction)
+   (find_transaction)
+)
+
+} } } // steem::plugins::transaction_index_api
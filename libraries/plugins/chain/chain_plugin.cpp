@@ -1,4 +1,5 @@
 #include <steem/chain/database_exceptions.hpp>
+#include <steem/chain/state_snapshot.hpp>
 
 #include <steem/plugins/chain/abstract_block_producer.hpp>
 #include <steem/plugins/chain/chain_plugin.hpp>
@@ -15,8 +16,13 @@
 #include <boost/thread/future.hpp>
 #include <boost/lockfree/queue.hpp>
 
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
 #include <thread>
 #include <memory>
+#include <mutex>
 #include <iostream>
 
 namespace steem { namespace plugins { namespace chain {
@@ -53,19 +59,75 @@ struct write_context
    bool                          success = true;
    fc::optional< fc::exception > except;
    promise_ptr                   prom_ptr;
+   fc::time_point                enqueued;
 };
 
 namespace detail {
 
+/**
+ * Histogram of durations with power of two microsecond buckets. Percentiles are reported as the upper
+ * bound of the bucket they fall in. Only used by the write processing thread.
+ */
+class write_lock_histogram
+{
+   public:
+      void record( const fc::microseconds& duration )
+      {
+         uint32_t b = 0;
+         while( b + 1 < _buckets.size() && ( int64_t(1) << b ) < duration.count() )
+            ++b;
+
+         ++_buckets[ b ];
+         ++_count;
+      }
+
+      fc::microseconds percentile( double p )const
+      {
+         if( _count == 0 )
+            return fc::microseconds( 0 );
+
+         uint64_t target = std::max< uint64_t >( 1, uint64_t( std::ceil( _count * p ) ) );
+         uint64_t seen = 0;
+         for( uint32_t b = 0; b < _buckets.size(); ++b )
+         {
+            seen += _buckets[ b ];
+            if( seen >= target )
+               return fc::microseconds( int64_t(1) << b );
+         }
+
+         return fc::microseconds( int64_t(1) << ( _buckets.size() - 1 ) );
+      }
+
+      uint64_t count()const { return _count; }
+
+      void reset()
+      {
+         _buckets.fill( 0 );
+         _count = 0;
+      }
+
+   private:
+      std::array< uint64_t, 32 > _buckets = {};
+      uint64_t                   _count = 0;
+};
+
 class chain_plugin_impl
 {
    public:
       chain_plugin_impl() : write_queue( 64 ) {}
-      ~chain_plugin_impl() { stop_write_processing(); }
+      ~chain_plugin_impl()
+      {
+         stop_write_processing();
+         stop_signature_recovery();
+      }
 
       void start_write_processing();
       void stop_write_processing();
 
+      void start_signature_recovery();
+      void stop_signature_recovery();
+      void recover_signature_keys( const signed_block& block );
+
       uint64_t                         shared_memory_size = 0;
       uint16_t                         shared_file_full_threshold = 0;
       uint16_t                         shared_file_scale_rate = 0;
@@ -79,16 +141,33 @@ class chain_plugin_impl
       bool                             benchmark_is_enabled =false;
       bool                             statsd_on_replay = false;
       uint32_t                         stop_replay_at = 0;
+      uint32_t                         replay_decode_threads = 0;
+      block_log_compression            block_log_codec = no_compression;
+      int                              block_log_compression_level = 0;
+      bfs::path                        load_snapshot;
+      bfs::path                        dump_snapshot;
+      uint32_t                         snapshot_threads = 4;
       uint32_t                         benchmark_interval = 0;
       uint32_t                         flush_interval = 0;
       flat_map<uint32_t,block_id_type> loaded_checkpoints;
 
       uint32_t allow_future_time = 5;
 
-      bool                             running = true;
+      std::atomic< bool >              running{ true };
       std::shared_ptr< std::thread >   write_processor_thread;
       boost::lockfree::queue< write_context* > write_queue;
       int16_t                          write_lock_hold_time = 500;
+      uint32_t                         write_lock_target_latency = 50;
+
+      std::mutex                       write_queue_mutex;
+      std::condition_variable          write_queue_cv;
+
+      void push_write( write_context& cxt );
+
+      uint32_t                         signature_recovery_threads = 4;
+      asio::io_service                 signature_recovery_ios;
+      std::unique_ptr< asio::io_service::work > signature_recovery_work;
+      std::vector< std::thread >       signature_recovery_pool;
 
       vector< string >                 loaded_plugins;
       fc::mutable_variant_object       plugin_state_opts;
@@ -217,6 +296,12 @@ void chain_plugin_impl::start_write_processing()
 
       request_promise_visitor prom_visitor;
 
+      write_lock_histogram wait_histogram;
+      write_lock_histogram hold_histogram;
+      fc::time_point last_report = fc::time_point::now();
+      int64_t write_latency_us = 0;
+      int64_t reader_yield_us = 0;
+
       /* This loop monitors the write request queue and performs writes to the database. These
        * can be blocks or pending transactions. Because the caller needs to know the success of
        * the write and any exceptions that are thrown, a write context is passed in the queue
@@ -230,38 +315,68 @@ void chain_plugin_impl::start_write_processing()
        * head block is within 1 minute of system time.
        *
        * Live mode needs to balance between processing pending writes and allowing readers access
-       * to the database. It will batch writes together as much as possible to minimize lock
-       * overhead but will willingly give up the write lock after 500ms. The thread then sleeps for
-       * 10ms. This allows time for readers to access the database as well as more writes to come
-       * in. When the node is live the rate at which writes come in is slower and busy waiting is
-       * not an optimal use of system resources when we could give CPU time to read threads.
+       * to the database. It batches writes together while no readers are waiting. When readers
+       * are blocked on the lock, it gives up the write lock between writes once it has held the
+       * lock for reader_yield_us, and it never holds the lock longer than write_lock_hold_time.
+       * reader_yield_us adapts to the time writes spend queued: it grows while writes miss
+       * write_lock_target_latency and shrinks back to zero once they meet it. Readers waiting when
+       * the hold time runs out are yielded to as well. After yielding, the thread waits briefly for
+       * the waiting readers to take the lock and reports to statsd whether they did. When the queue
+       * is empty, it sleeps on a condition variable until the next write arrives. A negative
+       * write_lock_hold_time (block producers) never yields to readers.
+       *
+       * Write lock wait and hold times are recorded in histograms and their p50 and p99 are
+       * reported to statsd every 10 seconds.
        */
       while( running )
       {
          if( !is_syncing )
             start = fc::time_point::now();
 
+         bool yielded = false;
+
          if( write_queue.pop( cxt ) )
          {
+            fc::time_point lock_requested = fc::time_point::now();
+            fc::time_point lock_acquired;
+
             db.with_write_lock( [&]()
             {
+               lock_acquired = fc::time_point::now();
                STATSD_START_TIMER( "chain", "lock_time", "write_lock", 1.0f )
                while( true )
                {
                   req_visitor.skip = cxt->skip;
                   req_visitor.except = &(cxt->except);
                   cxt->success = cxt->req_ptr.visit( req_visitor );
+                  fc::time_point enqueued = cxt->enqueued;
+                  // cxt may be destroyed by the caller once the promise is set
                   cxt->prom_ptr.visit( prom_visitor );
 
+                  fc::time_point now = fc::time_point::now();
+
                   if( is_syncing && start - db.head_block_time() < fc::minutes(1) )
                   {
-                     start = fc::time_point::now();
+                     start = now;
                      is_syncing = false;
                   }
 
-                  if( !is_syncing && write_lock_hold_time >= 0 && fc::time_point::now() - start > fc::milliseconds( write_lock_hold_time ) )
+                  if( !is_syncing && write_lock_hold_time >= 0 )
                   {
-                     break;
+                     write_latency_us += ( ( now - enqueued ).count() - write_latency_us ) / 8;
+
+                     // Readers waiting when the hold time runs out get the same window as an early yield
+                     bool readers_waiting = db.waiting_readers() > 0;
+                     if( readers_waiting && ( now - lock_acquired ).count() >= reader_yield_us )
+                     {
+                        yielded = true;
+                        break;
+                     }
+
+                     if( now - lock_acquired > fc::milliseconds( write_lock_hold_time ) )
+                     {
+                        break;
+                     }
                   }
 
                   if( !write_queue.pop( cxt ) )
@@ -270,10 +385,71 @@ void chain_plugin_impl::start_write_processing()
                   }
                }
             });
+
+            if( !is_syncing )
+            {
+               fc::time_point lock_released = fc::time_point::now();
+               wait_histogram.record( lock_acquired - lock_requested );
+               hold_histogram.record( lock_released - lock_acquired );
+               STATSD_TIMER( "chain", "lock_time", "write_lock_wait", lock_acquired - lock_requested, 1.0f )
+
+               // Writes missing their latency target hold the lock longer before yielding to readers
+               if( write_lock_hold_time >= 0 )
+               {
+                  int64_t max_yield_us = int64_t( write_lock_hold_time ) * 1000;
+                  if( write_latency_us > int64_t( write_lock_target_latency ) * 1000 )
+                     reader_yield_us = std::min( std::max< int64_t >( reader_yield_us * 2, 1000 ), max_yield_us );
+                  else
+                     reader_yield_us /= 2;
+               }
+            }
          }
 
          if( !is_syncing )
-            boost::this_thread::sleep_for( boost::chrono::milliseconds( 10 ) );
+         {
+            if( yielded )
+            {
+               // Give the readers that were waiting a chance to take the lock before writing again
+               fc::time_point yield_start = fc::time_point::now();
+               while( db.waiting_readers() > 0 && fc::time_point::now() - yield_start < fc::milliseconds( 1 ) )
+                  std::this_thread::yield();
+
+               // Reports whether the readers got in under write load, they are still waiting when the window was too short
+               if( db.waiting_readers() > 0 )
+               {
+                  STATSD_INCREMENT( "chain", "write_lock", "readers_not_admitted", 1.0f )
+               }
+               else
+               {
+                  STATSD_INCREMENT( "chain", "write_lock", "readers_admitted", 1.0f )
+               }
+            }
+            else
+            {
+               std::unique_lock< std::mutex > lock( write_queue_mutex );
+               write_queue_cv.wait_for( lock, std::chrono::milliseconds( 100 ), [&]()
+               {
+                  return !running || !write_queue.empty();
+               });
+            }
+
+            fc::time_point now = fc::time_point::now();
+            if( now - last_report > fc::seconds( 10 ) )
+            {
+               if( hold_histogram.count() )
+               {
+                  STATSD_GAUGE( "chain", "write_lock", "wait_p50", wait_histogram.percentile( 0.5 ).count(), 1.0f )
+                  STATSD_GAUGE( "chain", "write_lock", "wait_p99", wait_histogram.percentile( 0.99 ).count(), 1.0f )
+                  STATSD_GAUGE( "chain", "write_lock", "hold_p50", hold_histogram.percentile( 0.5 ).count(), 1.0f )
+                  STATSD_GAUGE( "chain", "write_lock", "hold_p99", hold_histogram.percentile( 0.99 ).count(), 1.0f )
+                  STATSD_GAUGE( "chain", "write_lock", "reader_yield_us", reader_yield_us, 1.0f )
+               }
+
+               wait_histogram.reset();
+               hold_histogram.reset();
+               last_report = now;
+            }
+         }
       }
    });
 }
@@ -282,12 +458,97 @@ void chain_plugin_impl::stop_write_processing()
 {
    running = false;
 
+   {
+      std::lock_guard< std::mutex > lock( write_queue_mutex );
+   }
+   write_queue_cv.notify_all();
+
    if( write_processor_thread )
       write_processor_thread->join();
 
    write_processor_thread.reset();
 }
 
+void chain_plugin_impl::push_write( write_context& cxt )
+{
+   cxt.enqueued = fc::time_point::now();
+   write_queue.push( &cxt );
+
+   // Taking the mutex orders the push before the processor's empty check, so the wakeup cannot be missed
+   {
+      std::lock_guard< std::mutex > lock( write_queue_mutex );
+   }
+   write_queue_cv.notify_one();
+}
+
+void chain_plugin_impl::start_signature_recovery()
+{
+   if( signature_recovery_threads == 0 )
+      return;
+
+   signature_recovery_work.reset( new asio::io_service::work( signature_recovery_ios ) );
+   for( uint32_t i = 0; i < signature_recovery_threads; ++i )
+      signature_recovery_pool.emplace_back( [this](){ signature_recovery_ios.run(); } );
+}
+
+void chain_plugin_impl::stop_signature_recovery()
+{
+   signature_recovery_work.reset();
+   signature_recovery_ios.stop();
+
+   for( auto& t : signature_recovery_pool )
+      t.join();
+
+   signature_recovery_pool.clear();
+}
+
+struct signature_recovery_batch
+{
+   signature_recovery_batch( const signed_block& b, uint32_t tasks ) : block( b ), pending( tasks ) {}
+
+   const signed_block&     block;
+   std::atomic< size_t >   next_trx{ 0 };
+   std::atomic< uint32_t > pending;
+   boost::promise< void >  done;
+};
+
+/* Recovers the signing keys of every transaction in the block into the database's signature key
+ * cache, so that applying the block under the write lock does not have to. The calling thread
+ * works alongside the pool and returns once every transaction has been processed.
+ */
+void chain_plugin_impl::recover_signature_keys( const signed_block& block )
+{
+   auto& cache = db.get_signature_key_cache();
+   const auto chain_id = db.get_chain_id();
+   size_t num_trx = block.transactions.size();
+
+   uint32_t tasks = std::min< size_t >( signature_recovery_pool.size(), num_trx > 0 ? num_trx - 1 : 0 );
+   // Shared with the pool so the promise outlives a task still returning from set_value()
+   auto batch = std::make_shared< signature_recovery_batch >( block, tasks );
+   auto done = batch->done.get_future();
+
+   auto recover_trxs = [&cache, chain_id]( signature_recovery_batch& b )
+   {
+      for( size_t i = b.next_trx++; i < b.block.transactions.size(); i = b.next_trx++ )
+         cache.recover( b.block.transactions[i], chain_id );
+   };
+
+   for( uint32_t i = 0; i < tasks; ++i )
+   {
+      signature_recovery_ios.post( [batch, recover_trxs]()
+      {
+         recover_trxs( *batch );
+         if( --batch->pending == 0 )
+            batch->done.set_value();
+      });
+   }
+
+   recover_trxs( *batch );
+
+   if( tasks > 0 )
+      done.wait();
+}
+
 } // detail
 
 
@@ -315,11 +576,25 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("flush-state-interval", bpo::value<uint32_t>(),
             "flush shared memory changes to disk every N blocks")
+         ("signature-recovery-threads", bpo::value<uint32_t>()->default_value(4),
+            "Number of threads recovering transaction signing keys before blocks are applied. 0 recovers keys on the write thread.")
+         ("write-lock-target-latency", bpo::value< uint32_t >()->default_value( 50 ),
+            "Target milliseconds a write waits in the queue. Writes missing it hold the write lock longer before yielding to readers.")
+         ("block-log-compression", bpo::value< string >()->default_value( "none" ),
+            "Compression used when a new block log is created: none, zstd or lz4. Existing logs keep their format, see convert_block_log.")
+         ("block-log-compression-level", bpo::value< int >()->default_value( 0 ), "Codec compression level, 0 uses the codec default")
+         ("read-only", bpo::bool_switch()->default_value( false ),
+            "Attach to the shared memory file and block log of another steemd on this host and only serve API requests. "
+            "Blocks and transactions are not accepted. Enable only API plugins and plugins whose state the writing node also keeps." )
          ;
    cli.add_options()
          ("replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain database and replay all blocks" )
          ("resync-blockchain", bpo::bool_switch()->default_value(false), "clear chain database and block log" )
          ("stop-replay-at-block", bpo::value<uint32_t>(), "Stop and exit after reaching given block number")
+         ("replay-decode-threads", bpo::value<uint32_t>()->default_value(2), "Number of threads decoding blocks ahead of the apply thread during replay. 0 disables the replay pipeline.")
+         ("load-snapshot", bpo::value< bfs::path >(), "Clear chain database, load the state snapshot in the given file and replay the remaining blocks" )
+         ("dump-snapshot", bpo::value< bfs::path >(), "Write a state snapshot to the given file after the database is opened" )
+         ("snapshot-threads", bpo::value< uint32_t >()->default_value( 4 ), "Number of threads dumping or loading snapshot indexes" )
          ("advanced-benchmark", "Make profiling for every plugin.")
          ("set-benchmark-interval", bpo::value<uint32_t>(), "Print time and memory usage every given number of blocks")
          ("dump-memory-details", bpo::bool_switch()->default_value(false), "Dump database objects memory usage info. Use set-benchmark-interval to set dump interval.")
@@ -355,6 +630,22 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
    my->resync              = options.at( "resync-blockchain").as<bool>();
    my->stop_replay_at      =
       options.count( "stop-replay-at-block" ) ? options.at( "stop-replay-at-block" ).as<uint32_t>() : 0;
+   my->replay_decode_threads = options.at( "replay-decode-threads" ).as< uint32_t >();
+   my->write_lock_target_latency = options.at( "write-lock-target-latency" ).as< uint32_t >();
+   if( options.count( "load-snapshot" ) )
+   {
+      my->load_snapshot = options.at( "load-snapshot" ).as< bfs::path >();
+      my->replay = true;
+   }
+   if( options.count( "dump-snapshot" ) )
+      my->dump_snapshot = options.at( "dump-snapshot" ).as< bfs::path >();
+   my->snapshot_threads = std::max( options.at( "snapshot-threads" ).as< uint32_t >(), 1u );
+   my->readonly = options.at( "read-only" ).as< bool >();
+   FC_ASSERT( !my->readonly || !( my->replay || my->resync ), "A read only node cannot replay or resync the blockchain" );
+   my->block_log_codec = block_log_format::from_string( options.at( "block-log-compression" ).as< string >() );
+   my->block_log_compression_level = options.at( "block-log-compression-level" ).as< int >();
+   FC_ASSERT( block_log_format::is_supported( my->block_log_codec ), "steemd was built without ${c} support",
+      ("c", options.at( "block-log-compression" ).as< string >()) );
    my->benchmark_interval  =
       options.count( "set-benchmark-interval" ) ? options.at( "set-benchmark-interval" ).as<uint32_t>() : 0;
    my->check_locks         = options.at( "check-locks" ).as< bool >();
@@ -365,6 +656,8 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
    else
       my->flush_interval = 10000;
 
+   my->signature_recovery_threads = options.at( "signature-recovery-threads" ).as< uint32_t >();
+
    if(options.count("checkpoint"))
    {
       auto cps = options.at("checkpoint").as<vector<string>>();
@@ -454,7 +747,14 @@ void chain_plugin::plugin_startup()
    db_open_args.shared_file_scale_rate = my->shared_file_scale_rate;
    db_open_args.do_validate_invariants = my->validate_invariants;
    db_open_args.stop_replay_at = my->stop_replay_at;
+   db_open_args.replay_decode_threads = my->replay_decode_threads;
+   db_open_args.block_log_codec = my->block_log_codec;
+   db_open_args.block_log_compression_level = my->block_log_compression_level;
    db_open_args.benchmark_is_enabled = my->benchmark_is_enabled;
+   db_open_args.snapshot_file = my->load_snapshot;
+   db_open_args.snapshot_threads = my->snapshot_threads;
+   if( my->readonly )
+      db_open_args.chainbase_flags |= chainbase::database::read_only;
 
    auto benchmark_lambda = [&dumper, &get_indexes_memory_details, dump_memory_details] ( uint32_t current_block_number,
       const chainbase::database::abstract_index_cntr_t& abstract_index_cntr )
@@ -491,6 +791,8 @@ void chain_plugin::plugin_startup()
 
    if(my->replay)
    {
+      if( my->load_snapshot != bfs::path() )
+         ilog( "Loading state snapshot ${f}", ("f", my->load_snapshot.generic_string()) );
       ilog("Replaying blockchain on user request.");
       uint32_t last_block_number = 0;
       db_open_args.benchmark = steem::chain::database::TBenchmark(my->benchmark_interval, benchmark_lambda);
@@ -534,8 +836,24 @@ void chain_plugin::plugin_startup()
    }
 
    ilog( "Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()) );
+
+   if( my->dump_snapshot != bfs::path() )
+   {
+      my->db.with_read_lock( [&]()
+      {
+         dump_state_snapshot( my->db, my->dump_snapshot, my->snapshot_threads );
+      });
+   }
+
    on_sync();
 
+   if( my->readonly )
+   {
+      ilog( "Serving reads from the state written by another node" );
+      return;
+   }
+
+   my->start_signature_recovery();
    my->start_write_processing();
 }
 
@@ -543,6 +861,7 @@ void chain_plugin::plugin_shutdown()
 {
    ilog("closing chain database");
    my->stop_write_processing();
+   my->stop_signature_recovery();
    my->db.close();
    ilog("database closed successfully");
 }
@@ -562,15 +881,22 @@ bool chain_plugin::accept_block( const steem::chain::signed_block& block, bool c
            ("p", block.witness) );
    }
 
+   FC_ASSERT( !my->readonly, "This node is read only and does not accept blocks" );
    check_time_in_block( block );
 
+   if( !my->signature_recovery_pool.empty() && !( skip & ( database::skip_transaction_signatures | database::skip_authority_check ) ) )
+   {
+      STATSD_START_TIMER( "chain", "signature_recovery", "block", 1.0f )
+      my->recover_signature_keys( block );
+   }
+
    boost::promise< void > prom;
    write_context cxt;
    cxt.req_ptr = &block;
    cxt.skip = skip;
    cxt.prom_ptr = &prom;
 
-   my->write_queue.push( &cxt );
+   my->push_write( cxt );
 
    prom.get_future().get();
 
@@ -581,12 +907,18 @@ bool chain_plugin::accept_block( const steem::chain::signed_block& block, bool c
 
 void chain_plugin::accept_transaction( const steem::chain::signed_transaction& trx )
 {
+   FC_ASSERT( !my->readonly, "This node is read only and does not accept transactions" );
+
+   // A lone transaction gains nothing from the pool, the calling thread is already off the write thread
+   if( !my->signature_recovery_pool.empty() )
+      my->db.get_signature_key_cache().recover( trx, my->db.get_chain_id() );
+
    boost::promise< void > prom;
    write_context cxt;
    cxt.req_ptr = &trx;
    cxt.prom_ptr = &prom;
 
-   my->write_queue.push( &cxt );
+   my->push_write( cxt );
 
    prom.get_future().get();
 
@@ -601,13 +933,15 @@ steem::chain::signed_block chain_plugin::generate_block(
    const fc::ecc::private_key& block_signing_private_key,
    uint32_t skip )
 {
+   FC_ASSERT( !my->readonly, "This node is read only and cannot generate blocks" );
+
    generate_block_request req( when, witness_owner, block_signing_private_key, skip );
    boost::promise< void > prom;
    write_context cxt;
    cxt.req_ptr = &req;
    cxt.prom_ptr = &prom;
 
-   my->write_queue.push( &cxt );
+   my->push_write( cxt );
 
    prom.get_future().get();
 
@@ -4,6 +4,8 @@
 
 #include <fc/variant.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/reflect/variant.hpp>
 #include <fc/exception/exception.hpp>
 
@@ -53,6 +55,10 @@
 #define JSON_RPC_PARSE_PARAMS_ERROR (-32002)
 #define JSON_RPC_ERROR_DURING_CALL  (-32003)
 
+#define JSON_RPC_DEFAULT_BATCH_MAX_SIZE 1000
+#define JSON_RPC_DEFAULT_BATCH_THREADS  8
+#define JSON_RPC_DEFAULT_CACHE_SIZE_MB  64
+
 namespace steem { namespace plugins { namespace json_rpc {
 
 using namespace appbase;
@@ -65,6 +71,43 @@ using namespace appbase;
  */
 typedef std::function< fc::variant(const fc::variant&) > api_method;
 
+/**
+ * @brief Writes the result of an api method straight to JSON
+ *
+ * Produces the same text as serializing the result of the matching
+ * api_method, without building a variant of the whole result.
+ */
+typedef std::function< void(const fc::variant&, fc::json_writer&) > api_stream_method;
+
+/**
+ * @brief Calls an api method with fc::raw packed args and returns the fc::raw packed result
+ */
+typedef std::function< std::vector< char >(const std::vector< char >&) > api_binary_method;
+
+/**
+ * @brief A call of the binary transport, fc::raw packed
+ *
+ * method is json_rpc_plugin::binary_method_id( "api.method" ).
+ */
+struct binary_rpc_request
+{
+   uint32_t             method = 0;
+   std::vector< char >  args;
+};
+
+/**
+ * @brief Response of the binary transport, fc::raw packed
+ *
+ * code is 0 on success, with the packed return value in result. Otherwise it is
+ * one of the JSON_RPC_* error codes and message describes the error.
+ */
+struct binary_rpc_response
+{
+   int32_t              code = 0;
+   std::vector< char >  result;
+   std::string          message;
+};
+
 /**
  * @brief An API, containing APIs and Methods
  *
@@ -100,9 +143,26 @@ class json_rpc_plugin : public appbase::plugin< json_rpc_plugin >
       virtual void plugin_startup() override;
       virtual void plugin_shutdown() override;
 
-      void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
+      void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig,
+         const api_stream_method& stream = api_stream_method(), const api_binary_method& binary = api_binary_method() );
+
+      /**
+       * Caches the serialized responses of method, given as api.method, by params. A response
+       * is served from the cache until blocks blocks have been applied after it was computed.
+       *
+       * Only use it for methods whose results change with blocks, not with pending transactions.
+       * Call it during plugin_initialize, before requests are processed.
+       */
+      void cache_api_method( const string& method, uint32_t blocks = 1 );
+
       string call( const string& body );
 
+      /// Calls a method with a packed binary_rpc_request and returns the packed binary_rpc_response
+      string call_binary( const string& body );
+
+      /// The id of method, given as api.method, in binary_rpc_request. The first 4 bytes of sha256( method ) as a little endian integer.
+      static uint32_t binary_method_id( const string& method );
+
    private:
       std::unique_ptr< detail::json_rpc_plugin_impl > my;
 };
@@ -130,7 +190,15 @@ namespace detail {
                {
                   return fc::variant( (plugin.*method)( args.as< Args >(), true ) );
                },
-               api_method_signature{ fc::variant( Args() ), fc::variant( Ret() ) } );
+               api_method_signature{ fc::variant( Args() ), fc::variant( Ret() ) },
+               [&plugin,method]( const fc::variant& args, fc::json_writer& w )
+               {
+                  fc::to_json( (plugin.*method)( args.as< Args >(), true ), w );
+               },
+               [&plugin,method]( const std::vector< char >& args ) -> std::vector< char >
+               {
+                  return fc::raw::pack_to_vector( (plugin.*method)( fc::raw::unpack_from_vector< Args >( args, 0 ), true ) );
+               } );
          }
 
       private:
@@ -143,3 +211,5 @@ namespace detail {
 } } } // steem::plugins::json_rpc
 
 FC_REFLECT( steem::plugins::json_rpc::api_method_signature, (args)(ret) )
+FC_REFLECT( steem::plugins::json_rpc::binary_rpc_request, (method)(args) )
+FC_REFLECT( steem::plugins::json_rpc::binary_rpc_response, (code)(result)(message) )
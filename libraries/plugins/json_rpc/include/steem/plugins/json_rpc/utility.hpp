@@ -2,6 +2,8 @@
 
 #include <type_traits>
 
+#include <steem/plugins/statsd/utility.hpp>
+
 #include <fc/reflect/reflect.hpp>
 #include <fc/macros.hpp>
 
@@ -42,12 +44,57 @@ BOOST_PP_SEQ_FOR_EACH( DECLARE_API_IMPL_HELPER, _, METHODS )
 #define DEFINE_API_IMPL( class, method )                                                        \
 BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _args )& args )   \
 
+/*
+ * Irreversible APIs mostly read data that can no longer change, such as blocks in the block log.
+ * Besides method, the impl defines method_irreversible, which fills result and returns true when it
+ * can be computed from irreversible data without the database lock. When it returns false, method
+ * is called under the read lock.
+ */
+#define DECLARE_IRREVERSIBLE_API_IMPL_HELPER( r, data, method ) \
+bool BOOST_PP_CAT( method, _irreversible )( const BOOST_PP_CAT( method, _args )& args, BOOST_PP_CAT( method, _return )& result );
+
+#define DECLARE_IRREVERSIBLE_API_IMPL( METHODS ) \
+BOOST_PP_SEQ_FOR_EACH( DECLARE_IRREVERSIBLE_API_IMPL_HELPER, _, METHODS )
+
+#define DEFINE_IRREVERSIBLE_API_IMPL( class, method )                                                                            \
+bool class :: BOOST_PP_CAT( method, _irreversible ) ( const BOOST_PP_CAT( method, _args )& args, BOOST_PP_CAT( method, _return )& result ) \
+
+/// Calls my->method under the read lock and reports the time spent waiting for the lock as jsonrpc.lock_wait.class.method
+#define CALL_WITH_READ_LOCK( class, method )                                                             \
+   auto lock_start = fc::time_point::now();                                                             \
+   return my->_db.with_read_lock( [&args, &lock_start, this]()                                         \
+   {                                                                                                    \
+      STATSD_TIMER( "jsonrpc", "lock_wait", BOOST_PP_STRINGIZE( class ) "." BOOST_PP_STRINGIZE( method ), \
+         fc::time_point::now() - lock_start, 1.0f );                                                   \
+      return my->method( args );                                                                        \
+   });
+
 #define DEFINE_READ_API_HELPER( r, class, method )                                                       \
 BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _args )& args, bool lock ) \
 {                                                                                                        \
    if( lock )                                                                                            \
    {                                                                                                     \
-      return my->_db.with_read_lock( [&args, this](){ return my->method( args ); });                     \
+      CALL_WITH_READ_LOCK( class, method )                                                               \
+   }                                                                                                     \
+   else                                                                                                  \
+   {                                                                                                     \
+      return my->method( args );                                                                         \
+   }                                                                                                     \
+}
+
+#define DEFINE_IRREVERSIBLE_API_HELPER( r, class, method )                                               \
+BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _args )& args, bool lock ) \
+{                                                                                                        \
+   if( lock )                                                                                            \
+   {                                                                                                     \
+      BOOST_PP_CAT( method, _return ) result;                                                            \
+      if( my->BOOST_PP_CAT( method, _irreversible )( args, result ) )                                    \
+      {                                                                                                  \
+         STATSD_INCREMENT( "jsonrpc", "lock_free", BOOST_PP_STRINGIZE( class ) "." BOOST_PP_STRINGIZE( method ), 1.0f ); \
+         return result;                                                                                  \
+      }                                                                                                  \
+                                                                                                         \
+      CALL_WITH_READ_LOCK( class, method )                                                               \
    }                                                                                                     \
    else                                                                                                  \
    {                                                                                                     \
@@ -84,6 +131,9 @@ BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _a
 #define DEFINE_LOCKLESS_APIS( class, METHODS ) \
    BOOST_PP_SEQ_FOR_EACH( DEFINE_LOCKLESS_API_HELPER, class, METHODS )
 
+#define DEFINE_IRREVERSIBLE_APIS( class, METHODS ) \
+   BOOST_PP_SEQ_FOR_EACH( DEFINE_IRREVERSIBLE_API_HELPER, class, METHODS )
+
 namespace steem { namespace plugins { namespace json_rpc {
 
 struct void_type {};
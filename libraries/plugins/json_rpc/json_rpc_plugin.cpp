@@ -3,15 +3,27 @@
 
 #include <steem/plugins/statsd/utility.hpp>
 
+#include <steem/plugins/chain/chain_plugin.hpp>
+#include <steem/chain/util/signal.hpp>
+
 #include <boost/algorithm/string.hpp>
+#include <boost/asio.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <fc/log/logger_config.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/macros.hpp>
 #include <fc/io/fstream.hpp>
+#include <fc/crypto/sha256.hpp>
 
 #include <chainbase/chainbase.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
 #define ENABLE_JSON_RPC_LOG
 
 namespace steem { namespace plugins { namespace json_rpc {
@@ -37,6 +49,55 @@ namespace detail
       fc::optional< fc::variant >      result;
       fc::optional< json_rpc_error >   error;
       fc::variant                      id;
+
+      /// JSON text of the result when it was written by an api_stream_method, takes the place of result
+      std::string                      result_json;
+   };
+
+   /// Writes a response like fc::json::to_string( response ), using result_json when it is set
+   void write_response( const json_rpc_response& response, fc::json_writer& w )
+   {
+      bool first = true;
+      w.write_raw( '{' );
+
+      w.next( first );
+      w.write_key( "jsonrpc", 7 );
+      w.write_string( response.jsonrpc );
+
+      if( response.result_json.size() )
+      {
+         w.next( first );
+         w.write_key( "result", 6 );
+         w.write_raw( response.result_json.data(), response.result_json.size() );
+      }
+      else if( response.result.valid() )
+      {
+         w.next( first );
+         w.write_key( "result", 6 );
+         w.write_variant( *response.result );
+      }
+
+      if( response.error.valid() )
+      {
+         w.next( first );
+         w.write_key( "error", 5 );
+         w.write_variant( fc::variant( *response.error ) );
+      }
+
+      w.next( first );
+      w.write_key( "id", 2 );
+      w.write_variant( response.id );
+
+      w.write_raw( '}' );
+   }
+
+   struct api_method_binding
+   {
+      api_method                                call;
+      api_stream_method                         stream;
+      api_binary_method                         binary;
+      /// Size of the last streamed result, reserved up front for the next one
+      std::shared_ptr< std::atomic< size_t > >  size_hint = std::make_shared< std::atomic< size_t > >( 0 );
    };
 
    typedef void_type             get_methods_args;
@@ -49,6 +110,66 @@ namespace detail
 
    typedef api_method_signature  get_signature_return;
 
+   typedef void_type             get_cache_stats_args;
+
+   struct get_cache_stats_return
+   {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t entries = 0;
+      uint64_t size = 0;
+   };
+
+   struct cached_response
+   {
+      std::shared_ptr< const std::string >   json;
+      /// Cache generation from which the entry is stale
+      uint64_t                               expires = 0;
+   };
+
+   /// Writes v with the members of every object sorted by name, so equal params give equal cache keys
+   void write_canonical( const fc::variant& v, fc::json_writer& w )
+   {
+      if( v.is_object() )
+      {
+         const auto& obj = v.get_object();
+         vector< const fc::variant_object::entry* > entries;
+         entries.reserve( obj.size() );
+         for( const auto& e : obj )
+            entries.push_back( &e );
+
+         std::sort( entries.begin(), entries.end(), []( const fc::variant_object::entry* a, const fc::variant_object::entry* b )
+         {
+            return a->key() < b->key();
+         });
+
+         bool first = true;
+         w.write_raw( '{' );
+         for( const auto* e : entries )
+         {
+            w.next( first );
+            w.write_key( e->key().data(), e->key().size() );
+            write_canonical( e->value(), w );
+         }
+         w.write_raw( '}' );
+      }
+      else if( v.is_array() )
+      {
+         bool first = true;
+         w.write_raw( '[' );
+         for( const auto& e : v.get_array() )
+         {
+            w.next( first );
+            write_canonical( e, w );
+         }
+         w.write_raw( ']' );
+      }
+      else
+      {
+         w.write_variant( v );
+      }
+   }
+
    class json_rpc_logger
    {
    public:
@@ -133,13 +254,22 @@ namespace detail
          json_rpc_plugin_impl();
          ~json_rpc_plugin_impl();
 
-         void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
+         void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig,
+            const api_stream_method& stream, const api_binary_method& binary );
 
-         api_method* find_api_method( std::string api, std::string method );
-         api_method* process_params( string method, const fc::variant_object& request, fc::variant& func_args, string* method_name );
+         api_method_binding* find_api_method( std::string api, std::string method );
+         api_method_binding* process_params( string method, const fc::variant_object& request, fc::variant& func_args, string* method_name );
          void rpc_id( const fc::variant_object& request, json_rpc_response& response );
          void rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response );
          json_rpc_response rpc( const fc::variant& message );
+         vector< json_rpc_response > rpc_batch( const vector< fc::variant >& messages );
+
+         void start_batch_pool();
+         void stop_batch_pool();
+
+         uint64_t cache_generation();
+         bool cache_find( const std::string& key, uint64_t generation, std::string& json );
+         void cache_store( const std::string& key, uint64_t expires, const std::string& json );
 
          void initialize();
 
@@ -151,25 +281,59 @@ namespace detail
 
          DECLARE_API(
             (get_methods)
-            (get_signature) )
+            (get_signature)
+            (get_cache_stats) )
 
-         map< string, api_description >                     _registered_apis;
+         map< string, map< string, api_method_binding > >   _registered_apis;
+         /// Methods by binary_method_id, pointing into _registered_apis
+         std::unordered_map< uint32_t, api_method_binding* > _binary_methods;
          vector< string >                                   _methods;
          map< string, map< string, api_method_signature > > _method_sigs;
          std::unique_ptr< json_rpc_logger >                 _logger;
+
+         uint32_t                                           _batch_max_size = JSON_RPC_DEFAULT_BATCH_MAX_SIZE;
+         uint32_t                                           _batch_threads = JSON_RPC_DEFAULT_BATCH_THREADS;
+         boost::thread_group                                _batch_pool;
+         boost::asio::io_service                            _batch_ios;
+         std::unique_ptr< boost::asio::io_service::work >   _batch_work;
+
+         /// Cached methods and the number of blocks their responses are kept for. Not modified after startup.
+         map< string, uint32_t >                            _cache_ttl;
+         uint64_t                                           _cache_max_size = 0;
+         std::unordered_map< string, cached_response >      _cache;
+         uint64_t                                           _cache_size = 0;
+         std::mutex                                         _cache_mutex;
+         std::atomic< uint64_t >                            _cache_block_count{ 0 };
+         std::atomic< uint64_t >                            _cache_hits{ 0 };
+         std::atomic< uint64_t >                            _cache_misses{ 0 };
+         steem::chain::database*                            _db = nullptr;
+         boost::signals2::connection                        _post_apply_block_conn;
    };
 
    json_rpc_plugin_impl::json_rpc_plugin_impl() {}
    json_rpc_plugin_impl::~json_rpc_plugin_impl() {}
 
-   void json_rpc_plugin_impl::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig )
+   void json_rpc_plugin_impl::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig,
+      const api_stream_method& stream, const api_binary_method& binary )
    {
-      _registered_apis[ api_name ][ method_name ] = api;
+      auto& binding = _registered_apis[ api_name ][ method_name ];
+      binding.call = api;
+      binding.stream = stream;
+      binding.binary = binary;
       _method_sigs[ api_name ][ method_name ] = sig;
 
       std::stringstream canonical_name;
       canonical_name << api_name << '.' << method_name;
       _methods.push_back( canonical_name.str() );
+
+      if( binary )
+      {
+         auto id = json_rpc_plugin::binary_method_id( canonical_name.str() );
+         auto itr = _binary_methods.find( id );
+         FC_ASSERT( itr == _binary_methods.end() || itr->second == &binding,
+            "Binary method id of ${m} collides with another method", ("m", canonical_name.str()) );
+         _binary_methods[ id ] = &binding;
+      }
    }
 
    void json_rpc_plugin_impl::initialize()
@@ -199,7 +363,96 @@ namespace detail
       return method_itr->second;
    }
 
-   api_method* json_rpc_plugin_impl::find_api_method( std::string api, std::string method )
+   get_cache_stats_return json_rpc_plugin_impl::get_cache_stats( const get_cache_stats_args& args, bool lock )
+   {
+      FC_UNUSED( lock )
+      get_cache_stats_return result;
+      result.hits = _cache_hits.load( std::memory_order_relaxed );
+      result.misses = _cache_misses.load( std::memory_order_relaxed );
+
+      std::lock_guard< std::mutex > guard( _cache_mutex );
+      result.entries = _cache.size();
+      result.size = _cache_size;
+      return result;
+   }
+
+   uint64_t json_rpc_plugin_impl::cache_generation()
+   {
+      // A read only node applies no blocks of its own, its head block advances with the writer
+      if( _db && _db->is_read_only() )
+         return _db->with_read_lock( [&]() { return _db->head_block_num(); } );
+
+      return _cache_block_count.load( std::memory_order_acquire );
+   }
+
+   bool json_rpc_plugin_impl::cache_find( const std::string& key, uint64_t generation, std::string& json )
+   {
+      std::shared_ptr< const std::string > cached;
+
+      {
+         std::lock_guard< std::mutex > guard( _cache_mutex );
+         auto itr = _cache.find( key );
+         if( itr == _cache.end() )
+            return false;
+
+         if( itr->second.expires <= generation )
+         {
+            _cache_size -= itr->first.size() + itr->second.json->size();
+            _cache.erase( itr );
+            return false;
+         }
+
+         cached = itr->second.json;
+      }
+
+      json = *cached;
+      return true;
+   }
+
+   void json_rpc_plugin_impl::cache_store( const std::string& key, uint64_t expires, const std::string& json )
+   {
+      uint64_t entry_size = key.size() + json.size();
+      if( entry_size > _cache_max_size )
+         return;
+
+      auto cached = std::make_shared< const std::string >( json );
+      uint64_t generation = cache_generation();
+
+      std::lock_guard< std::mutex > guard( _cache_mutex );
+
+      if( _cache_size + entry_size > _cache_max_size )
+      {
+         for( auto itr = _cache.begin(); itr != _cache.end(); )
+         {
+            if( itr->second.expires <= generation )
+            {
+               _cache_size -= itr->first.size() + itr->second.json->size();
+               itr = _cache.erase( itr );
+            }
+            else
+            {
+               ++itr;
+            }
+         }
+
+         // Everything still cached is current, starting over is cheaper than tracking use
+         if( _cache_size + entry_size > _cache_max_size )
+         {
+            _cache.clear();
+            _cache_size = 0;
+         }
+      }
+
+      auto& entry = _cache[ key ];
+      if( entry.json )
+         _cache_size -= key.size() + entry.json->size();
+
+      entry.json = cached;
+      entry.expires = expires;
+      _cache_size += entry_size;
+   }
+
+   api_method_binding* json_rpc_plugin_impl::find_api_method( std::string api, std::string method )
    {
       STATSD_START_TIMER( "jsonrpc", "overhead", "find_api_method", 1.0f );
       auto api_itr = _registered_apis.find( api );
@@ -211,10 +464,10 @@ namespace detail
       return &(method_itr->second);
    }
 
-   api_method* json_rpc_plugin_impl::process_params( string method, const fc::variant_object& request, fc::variant& func_args, string* method_name )
+   api_method_binding* json_rpc_plugin_impl::process_params( string method, const fc::variant_object& request, fc::variant& func_args, string* method_name )
    {
       STATSD_START_TIMER( "jsonrpc", "overhead", "process_params", 1.0f );
-      api_method* ret = nullptr;
+      api_method_binding* ret = nullptr;
 
       if( method == "call" )
       {
@@ -289,7 +542,7 @@ namespace detail
                if( ( method == "call" && request.contains( "params" ) ) || method != "call" )
                {
                   fc::variant func_args;
-                  api_method* call = nullptr;
+                  api_method_binding* call = nullptr;
                   string method_name;
 
                   try
@@ -306,7 +559,54 @@ namespace detail
                      if( call )
                      {
                         STATSD_START_TIMER( "jsonrpc", "api", method_name, 1.0f );
-                        response.result = (*call)( func_args );
+
+                        // The logger saves results as variants, so keep the variant path while it is enabled
+                        if( call->stream && !_logger )
+                        {
+                           auto ttl_itr = _cache_ttl.find( method_name );
+                           std::string cache_key;
+                           uint64_t generation = 0;
+
+                           if( ttl_itr != _cache_ttl.end() )
+                           {
+                              cache_key.reserve( 256 );
+                              cache_key = method_name;
+                              cache_key.push_back( ' ' );
+                              fc::json_writer key_writer( cache_key );
+                              write_canonical( func_args, key_writer );
+
+                              generation = cache_generation();
+                              if( cache_find( cache_key, generation, response.result_json ) )
+                              {
+                                 _cache_hits.fetch_add( 1, std::memory_order_relaxed );
+                                 STATSD_INCREMENT( "jsonrpc", "cache_hit", method_name, 1.0f );
+                              }
+                              else
+                              {
+                                 _cache_misses.fetch_add( 1, std::memory_order_relaxed );
+                                 STATSD_INCREMENT( "jsonrpc", "cache_miss", method_name, 1.0f );
+                              }
+                           }
+
+                           if( response.result_json.empty() )
+                           {
+                              std::string result;
+                              result.reserve( call->size_hint->load( std::memory_order_relaxed ) );
+                              fc::json_writer w( result );
+                              call->stream( func_args, w );
+                              call->size_hint->store( result.size(), std::memory_order_relaxed );
+
+                              // The generation is taken before the call, a block applied meanwhile only shortens the entry's life
+                              if( ttl_itr != _cache_ttl.end() )
+                                 cache_store( cache_key, generation + ttl_itr->second, result );
+
+                              response.result_json = std::move( result );
+                           }
+                        }
+                        else
+                        {
+                           response.result = call->call( func_args );
+                        }
                      }
                   }
                   catch( chainbase::lock_exception& e )
@@ -397,11 +697,97 @@ namespace detail
 
       return response;
    }
+
+   /**
+    * State of one batch shared by the calling thread and the pool threads helping it.
+    * Requests are claimed one at a time, so a slow call does not hold back the others.
+    */
+   struct batch_state
+   {
+      batch_state( const vector< fc::variant >& m ) : messages( m ), count( m.size() ), responses( m.size() ) {}
+
+      /// Only valid until the batch is done, helpers check count before touching it
+      const vector< fc::variant >&     messages;
+      const size_t                     count;
+      vector< json_rpc_response >      responses;
+      std::atomic< size_t >            next{ 0 };
+      size_t                           done = 0;
+      std::mutex                       mtx;
+      std::condition_variable          cv;
+   };
+
+   vector< json_rpc_response > json_rpc_plugin_impl::rpc_batch( const vector< fc::variant >& messages )
+   {
+      // The logger is not thread safe, so logged batches are processed in order
+      if( !_batch_work || messages.size() < 2 || _logger )
+      {
+         vector< json_rpc_response > responses;
+         responses.reserve( messages.size() );
+
+         for( auto& m : messages )
+            responses.push_back( rpc( m ) );
+
+         return responses;
+      }
+
+      STATSD_START_TIMER( "jsonrpc", "overhead", "rpc_batch", 1.0f );
+      auto state = std::make_shared< batch_state >( messages );
+
+      auto work = [this]( const std::shared_ptr< batch_state >& state )
+      {
+         size_t processed = 0;
+         for( size_t i = state->next++; i < state->count; i = state->next++ )
+         {
+            state->responses[i] = rpc( state->messages[i] );
+            ++processed;
+         }
+
+         if( processed )
+         {
+            std::lock_guard< std::mutex > lock( state->mtx );
+            state->done += processed;
+            if( state->done == state->count )
+               state->cv.notify_all();
+         }
+      };
+
+      // The calling thread works on the batch as well, so it completes even when the pool is busy.
+      // Helpers that start after the batch is done find nothing left to claim.
+      size_t helpers = std::min< size_t >( _batch_threads, messages.size() ) - 1;
+      for( size_t i = 0; i < helpers; ++i )
+         _batch_ios.post( [work, state]() { work( state ); } );
+
+      work( state );
+
+      std::unique_lock< std::mutex > lock( state->mtx );
+      state->cv.wait( lock, [&]() { return state->done == state->count; } );
+
+      return std::move( state->responses );
+   }
+
+   void json_rpc_plugin_impl::start_batch_pool()
+   {
+      if( _batch_threads < 2 )
+         return;
+
+      _batch_ios.reset();
+      _batch_work.reset( new boost::asio::io_service::work( _batch_ios ) );
+      for( uint32_t i = 0; i < _batch_threads - 1; ++i )
+         _batch_pool.create_thread( boost::bind( &boost::asio::io_service::run, &_batch_ios ) );
+   }
+
+   void json_rpc_plugin_impl::stop_batch_pool()
+   {
+      _batch_work.reset();
+      _batch_ios.stop();
+      _batch_pool.join_all();
+   }
 }
 
 using detail::json_rpc_error;
 using detail::json_rpc_response;
 using detail::json_rpc_logger;
+using detail::write_response;
 
 json_rpc_plugin::json_rpc_plugin() : my( new detail::json_rpc_plugin_impl() ) {}
 json_rpc_plugin::~json_rpc_plugin() {}
@@ -410,6 +796,14 @@ void json_rpc_plugin::set_program_options( options_description& , options_descri
 {
    cfg.add_options()
       ("log-json-rpc", bpo::value< string >(), "json-rpc log directory name.")
+      ("rpc-batch-max-size", bpo::value< uint32_t >()->default_value( JSON_RPC_DEFAULT_BATCH_MAX_SIZE ),
+         "Maximum number of requests in a JSON-RPC batch. 0 for no limit.")
+      ("rpc-batch-threads", bpo::value< uint32_t >()->default_value( JSON_RPC_DEFAULT_BATCH_THREADS ),
+         "Number of threads, including the one that received it, that process the requests of a JSON-RPC batch. 1 processes them in order.")
+      ("rpc-cache-method", bpo::value< vector< string > >()->composing(),
+         "Cache responses of an API method as api.method or api.method:blocks. Responses are kept until the given number of blocks, 1 by default, has been applied. Can be specified multiple times.")
+      ("rpc-cache-size-mb", bpo::value< uint32_t >()->default_value( JSON_RPC_DEFAULT_CACHE_SIZE_MB ),
+         "Maximum size of cached responses in MB.")
       ;
 }
 
@@ -428,18 +822,79 @@ void json_rpc_plugin::plugin_initialize( const variables_map& options )
       fc::create_directories(p);
       my->_logger.reset(new json_rpc_logger(dir_name));
    }
+
+   my->_batch_max_size = options.at( "rpc-batch-max-size" ).as< uint32_t >();
+   my->_batch_threads = options.at( "rpc-batch-threads" ).as< uint32_t >();
+   FC_ASSERT( my->_batch_threads > 0, "rpc-batch-threads must be greater than 0" );
+
+   my->_cache_max_size = uint64_t( options.at( "rpc-cache-size-mb" ).as< uint32_t >() ) * 1024 * 1024;
+
+   if( options.count( "rpc-cache-method" ) )
+   {
+      for( const auto& entry : options.at( "rpc-cache-method" ).as< vector< string > >() )
+      {
+         vector< string > v;
+         boost::split( v, entry, boost::is_any_of( ":" ) );
+         FC_ASSERT( v.size() == 1 || v.size() == 2, "Invalid rpc-cache-method ${m}, expected api.method or api.method:blocks", ("m", entry) );
+
+         uint32_t blocks = 1;
+         if( v.size() == 2 )
+         {
+            // lexical_cast accepts and wraps negative numbers, so only digits are let through
+            bool valid = !v[1].empty() && boost::all( v[1], boost::is_digit() );
+            if( valid )
+            {
+               try
+               {
+                  blocks = boost::lexical_cast< uint32_t >( v[1] );
+               }
+               catch( const boost::bad_lexical_cast& )
+               {
+                  valid = false;
+               }
+            }
+            FC_ASSERT( valid, "Invalid rpc-cache-method ${m}, blocks must be a positive number, was ${b}", ("m", entry)("b", v[1]) );
+         }
+
+         cache_api_method( v[0], blocks );
+      }
+   }
+
+   auto chain = appbase::app().find_plugin< steem::plugins::chain::chain_plugin >();
+   if( chain != nullptr )
+   {
+      my->_db = &chain->db();
+      my->_post_apply_block_conn = my->_db->add_post_apply_block_handler( [&]( const steem::chain::block_notification& note )
+      {
+         my->_cache_block_count.fetch_add( 1, std::memory_order_release );
+      }, *this, 0 );
+   }
 }
 
 void json_rpc_plugin::plugin_startup()
 {
    std::sort( my->_methods.begin(), my->_methods.end() );
+   my->start_batch_pool();
+}
+
+void json_rpc_plugin::plugin_shutdown()
+{
+   my->stop_batch_pool();
+   steem::chain::util::disconnect_signal( my->_post_apply_block_conn );
 }
 
-void json_rpc_plugin::plugin_shutdown() {}
+void json_rpc_plugin::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig,
+   const api_stream_method& stream, const api_binary_method& binary )
+{
+   my->add_api_method( api_name, method_name, api, sig, stream, binary );
+}
 
-void json_rpc_plugin::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig )
+void json_rpc_plugin::cache_api_method( const string& method, uint32_t blocks )
 {
-   my->add_api_method( api_name, method_name, api, sig );
+   FC_ASSERT( blocks > 0, "Responses of ${m} must be cached for at least one block", ("m", method) );
+   FC_ASSERT( std::count( method.begin(), method.end(), '.' ) == 1, "Invalid method name ${m}, expected api.method", ("m", method) );
+   my->_cache_ttl[ method ] = blocks;
+   ilog( "Caching responses of ${m} for ${b} block(s)", ("m", method)("b", blocks) );
 }
 
 string json_rpc_plugin::call( const string& message )
@@ -451,17 +906,35 @@ string json_rpc_plugin::call( const string& message )
 
       if( v.is_array() )
       {
-         vector< fc::variant > messages = v.as< vector< fc::variant > >();
-         vector< json_rpc_response > responses;
+         const vector< fc::variant >& messages = v.get_array();
 
-         if( messages.size() )
+         if( my->_batch_max_size && messages.size() > my->_batch_max_size )
          {
-            responses.reserve( messages.size() );
-
-            for( auto& m : messages )
-               responses.push_back( my->rpc( m ) );
-
-            return fc::json::to_string( responses );
+            json_rpc_response response;
+            response.error = json_rpc_error( JSON_RPC_INVALID_REQUEST, "Batch of " + std::to_string( messages.size() )
+               + " requests exceeds the maximum batch size of " + std::to_string( my->_batch_max_size ) );
+            return fc::json::to_string( response );
+         }
+         else if( messages.size() )
+         {
+            vector< json_rpc_response > responses = my->rpc_batch( messages );
+
+            size_t size = 2;
+            for( const auto& r : responses )
+               size += r.result_json.size() + 64;
+
+            std::string out;
+            out.reserve( size );
+            fc::json_writer w( out );
+            bool first = true;
+            w.write_raw( '[' );
+            for( const auto& r : responses )
+            {
+               w.next( first );
+               write_response( r, w );
+            }
+            w.write_raw( ']' );
+            return out;
          }
          else
          {
@@ -473,7 +946,12 @@ string json_rpc_plugin::call( const string& message )
       }
       else
       {
-         return fc::json::to_string( my->rpc( v ) );
+         auto response = my->rpc( v );
+         std::string out;
+         out.reserve( response.result_json.size() + 64 );
+         fc::json_writer w( out );
+         write_response( response, w );
+         return out;
       }
    }
    catch( fc::exception& e )
@@ -492,9 +970,72 @@ string json_rpc_plugin::call( const string& message )
 
 }
 
+string json_rpc_plugin::call_binary( const string& body )
+{
+   STATSD_START_TIMER( "jsonrpc", "overhead", "call_binary", 1.0f );
+   binary_rpc_response response;
+
+   try
+   {
+      binary_rpc_request request;
+      try
+      {
+         request = fc::raw::unpack_from_char_array< binary_rpc_request >( body.data(), body.size(), 0 );
+      }
+      catch( fc::exception& e )
+      {
+         response.code = JSON_RPC_PARSE_ERROR;
+         response.message = e.to_string();
+      }
+
+      if( response.code == 0 )
+      {
+         auto itr = my->_binary_methods.find( request.method );
+
+         if( itr == my->_binary_methods.end() )
+         {
+            response.code = JSON_RPC_METHOD_NOT_FOUND;
+            response.message = "Could not find method with id " + std::to_string( request.method );
+         }
+         else
+         {
+            response.result = itr->second->binary( request.args );
+         }
+      }
+   }
+   catch( fc::exception& e )
+   {
+      response.code = JSON_RPC_ERROR_DURING_CALL;
+      response.message = e.to_string();
+   }
+   catch( std::exception& e )
+   {
+      response.code = JSON_RPC_ERROR_DURING_CALL;
+      response.message = e.what();
+   }
+   catch( ... )
+   {
+      response.code = JSON_RPC_ERROR_DURING_CALL;
+      response.message = "Unknown exception";
+   }
+
+   string out( fc::raw::pack_size( response ), '\0' );
+   fc::datastream< char* > ds( &out[0], out.size() );
+   fc::raw::pack( ds, response );
+   return out;
+}
+
+uint32_t json_rpc_plugin::binary_method_id( const string& method )
+{
+   auto h = fc::sha256::hash( method );
+   const unsigned char* data = (const unsigned char*)h.data();
+   return uint32_t( data[0] ) | ( uint32_t( data[1] ) << 8 ) | ( uint32_t( data[2] ) << 16 ) | ( uint32_t( data[3] ) << 24 );
+}
+
 } } } // steem::plugins::json_rpc
 
 FC_REFLECT( steem::plugins::json_rpc::detail::json_rpc_error, (code)(message)(data) )
 FC_REFLECT( steem::plugins::json_rpc::detail::json_rpc_response, (jsonrpc)(result)(error)(id) )
 
 FC_REFLECT( steem::plugins::json_rpc::detail::get_signature_args, (method) )
+FC_REFLECT( steem::plugins::json_rpc::detail::get_cache_stats_return, (hits)(misses)(entries)(size) )
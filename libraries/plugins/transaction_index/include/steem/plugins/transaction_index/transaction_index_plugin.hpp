@@ -0,0 +1,57 @@
+#pragma once
+#include <steem/plugins/chain/chain_plugin.hpp>
+
+#include <appbase/application.hpp>
+
+namespace steem { namespace plugins { namespace transaction_index {
+
+#define STEEM_TRANSACTION_INDEX_PLUGIN_NAME "transaction_index"
+
+namespace detail { class transaction_index_impl; }
+
+struct transaction_location
+{
+   uint32_t block_num = 0;
+   uint32_t trx_in_block = 0;
+};
+
+/**
+ * Finds transactions by id without account history.
+ *
+ * Irreversible transactions are kept in a RocksDB store mapping the transaction id to its block
+ * number and position, looked up with a bloom filter and a hash index in about one disk read. The
+ * transaction itself is read from the block log. At startup the store catches up with the block log
+ * in one sequential scan, afterwards irreversible blocks are added as they become irreversible.
+ * Transactions in reversible blocks are kept in memory.
+ */
+class transaction_index_plugin : public appbase::plugin< transaction_index_plugin >
+{
+   public:
+      transaction_index_plugin();
+      virtual ~transaction_index_plugin();
+
+      APPBASE_PLUGIN_REQUIRES( (steem::plugins::chain::chain_plugin) )
+
+      static const std::string& name() { static std::string name = STEEM_TRANSACTION_INDEX_PLUGIN_NAME; return name; }
+
+      virtual void set_program_options( boost::program_options::options_description& cli, boost::program_options::options_description& cfg ) override;
+      virtual void plugin_initialize( const boost::program_options::variables_map& options ) override;
+      virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
+
+      /// The block and position of a transaction, reversible ones included
+      fc::optional< transaction_location > find_transaction( const protocol::transaction_id_type& id )const;
+
+      /// The transaction with its block number and position, nothing when it is unknown
+      fc::optional< protocol::annotated_signed_transaction > get_transaction( const protocol::transaction_id_type& id )const;
+
+      /// The last block in the RocksDB store
+      uint32_t last_indexed_block()const;
+
+   private:
+      std::unique_ptr< detail::transaction_index_impl > my;
+};
+
+} } } // steem::plugins::transaction_index
+
+FC_REFLECT( steem::plugins::transaction_index::transaction_location, (block_num)(trx_in_block) )
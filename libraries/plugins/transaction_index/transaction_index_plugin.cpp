@@ -0,0 +1,399 @@
+#include <steem/chain/steem_fwd.hpp>
+
+#include <steem/plugins/transaction_index/transaction_index_plugin.hpp>
+
+#include <steem/chain/database.hpp>
+#include <steem/chain/util/signal.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/slice.h>
+#include <rocksdb/write_batch.h>
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#define TRANSACTION_INDEX_PATH_KEY              "transaction-index-path"
+#define TRANSACTION_INDEX_CACHE_KEY             "transaction-index-cache-size"
+
+#define TRANSACTION_INDEX_LAST_BLOCK_KEY        "last_indexed_block"
+#define TRANSACTION_INDEX_BULK_BATCH_BLOCKS     10000
+
+namespace steem { namespace plugins { namespace transaction_index {
+
+namespace bfs = boost::filesystem;
+
+using steem::chain::block_notification;
+using steem::protocol::signed_block;
+using steem::protocol::transaction_id_type;
+
+using ::rocksdb::Slice;
+
+namespace detail {
+
+/*
+ * Keys of the store are the 20 bytes of transaction ids and the value is the packed
+ * transaction_location. The last indexed block number is stored under a key of a different length.
+ */
+class transaction_index_impl
+{
+public:
+   transaction_index_impl() : _db( appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db() ) {}
+   ~transaction_index_impl() { close(); }
+
+   void open( const bfs::path& path, uint32_t cache_mb );
+   void close();
+
+   void catch_up();
+   void load_reversible();
+
+   void on_post_apply_block( const block_notification& note );
+   void on_irreversible_block( uint32_t block_num );
+
+   void index_block( ::rocksdb::WriteBatch& batch, const signed_block& block, uint32_t block_num );
+   void write( ::rocksdb::WriteBatch& batch, uint32_t last_block, bool bulk );
+   void add_reversible( const signed_block& block, uint32_t block_num );
+
+   fc::optional< transaction_location > find( const transaction_id_type& id )const;
+   fc::optional< transaction_location > find_reversible( const transaction_id_type& id )const;
+
+   chain::database&                                                  _db;
+   std::unique_ptr< ::rocksdb::DB >                                  _storage;
+   std::atomic< uint32_t >                                           _last_indexed{ 0 };
+   /// Set by plugin_startup, read by the block handlers on the thread applying blocks
+   std::atomic< bool >                                               _started{ false };
+
+   mutable std::mutex                                                _reversible_mutex;
+   std::map< uint32_t, std::vector< transaction_id_type > >          _reversible_blocks;
+   std::unordered_map< transaction_id_type, transaction_location >   _reversible;
+
+   boost::signals2::connection                                       _post_apply_block_conn;
+   boost::signals2::connection                                       _irreversible_block_conn;
+};
+
+void transaction_index_impl::open( const bfs::path& path, uint32_t cache_mb )
+{
+   ::rocksdb::Options options;
+   options.create_if_missing = true;
+   options.IncreaseParallelism();
+   options.OptimizeLevelStyleCompaction();
+   // Bloom filters and a hash index, a lookup reads one block from disk
+   options.OptimizeForPointLookup( cache_mb );
+
+   ::rocksdb::DB* storage = nullptr;
+   auto s = ::rocksdb::DB::Open( options, path.string(), &storage );
+   FC_ASSERT( s.ok(), "Could not open the transaction index at ${p}: ${e}", ("p", path.string())("e", s.ToString()) );
+   _storage.reset( storage );
+
+   std::string value;
+   s = _storage->Get( ::rocksdb::ReadOptions(), TRANSACTION_INDEX_LAST_BLOCK_KEY, &value );
+   if( s.ok() )
+      _last_indexed = fc::raw::unpack_from_char_array< uint32_t >( value.data(), value.size(), 0 );
+   else
+      FC_ASSERT( s.IsNotFound(), "Could not read the transaction index: ${e}", ("e", s.ToString()) );
+
+   ilog( "Opened transaction index at ${p}, last indexed block ${n}", ("p", path.string())("n", _last_indexed.load()) );
+}
+
+void transaction_index_impl::close()
+{
+   chain::util::disconnect_signal( _post_apply_block_conn );
+   chain::util::disconnect_signal( _irreversible_block_conn );
+
+   if( _storage )
+   {
+      _storage->Flush( ::rocksdb::FlushOptions() );
+      _storage.reset();
+   }
+}
+
+void transaction_index_impl::index_block( ::rocksdb::WriteBatch& batch, const signed_block& block, uint32_t block_num )
+{
+   transaction_location location;
+   location.block_num = block_num;
+
+   for( const auto& trx : block.transactions )
+   {
+      auto id = trx.id();
+      auto value = fc::raw::pack_to_vector( location );
+      batch.Put( Slice( id.data(), id.data_size() ), Slice( value.data(), value.size() ) );
+      ++location.trx_in_block;
+   }
+}
+
+void transaction_index_impl::write( ::rocksdb::WriteBatch& batch, uint32_t last_block, bool bulk )
+{
+   auto value = fc::raw::pack_to_vector( last_block );
+   batch.Put( TRANSACTION_INDEX_LAST_BLOCK_KEY, Slice( value.data(), value.size() ) );
+
+   // The bulk scan is flushed when it is done and starts over from the last flushed block after a crash
+   ::rocksdb::WriteOptions options;
+   options.disableWAL = bulk;
+
+   auto s = _storage->Write( options, &batch );
+   FC_ASSERT( s.ok(), "Could not write to the transaction index: ${e}", ("e", s.ToString()) );
+   _last_indexed = last_block;
+}
+
+void transaction_index_impl::catch_up()
+{
+   const auto& log = _db.get_block_log();
+   uint32_t head = log.head_block_num();
+   uint32_t block_num = _last_indexed + 1;
+
+   if( block_num > head )
+      return;
+
+   ilog( "Indexing transactions of blocks ${f} to ${t} from the block log", ("f", block_num)("t", head) );
+   auto start = fc::time_point::now();
+
+   // Blocks are read sequentially, without seeking in the block log index
+   uint64_t pos = log.get_block_pos( block_num );
+   ::rocksdb::WriteBatch batch;
+
+   for( ; block_num <= head; ++block_num )
+   {
+      auto block = log.read_block( pos );
+      index_block( batch, block.first, block_num );
+      pos = block.second;
+
+      if( block_num % TRANSACTION_INDEX_BULK_BATCH_BLOCKS == 0 || block_num == head )
+      {
+         write( batch, block_num, true );
+         batch.Clear();
+      }
+
+      if( block_num % 1000000 == 0 )
+         ilog( "Indexed transactions up to block ${n}", ("n", block_num) );
+   }
+
+   auto s = _storage->Flush( ::rocksdb::FlushOptions() );
+   FC_ASSERT( s.ok(), "Could not flush the transaction index: ${e}", ("e", s.ToString()) );
+
+   ilog( "Indexed transactions up to block ${n} in ${s} seconds",
+      ("n", head)("s", ( fc::time_point::now() - start ).count() / 1000000) );
+}
+
+void transaction_index_impl::add_reversible( const signed_block& block, uint32_t block_num )
+{
+   std::vector< transaction_id_type > ids;
+   ids.reserve( block.transactions.size() );
+   for( const auto& trx : block.transactions )
+      ids.push_back( trx.id() );
+
+   std::lock_guard< std::mutex > lock( _reversible_mutex );
+
+   // A block applied again at the same height replaces the blocks of the abandoned fork
+   for( auto itr = _reversible_blocks.lower_bound( block_num ); itr != _reversible_blocks.end(); )
+   {
+      for( const auto& id : itr->second )
+         _reversible.erase( id );
+      itr = _reversible_blocks.erase( itr );
+   }
+
+   transaction_location location;
+   location.block_num = block_num;
+   for( const auto& id : ids )
+   {
+      _reversible[ id ] = location;
+      ++location.trx_in_block;
+   }
+
+   _reversible_blocks[ block_num ] = std::move( ids );
+}
+
+void transaction_index_impl::load_reversible()
+{
+   _db.with_read_lock( [&]()
+   {
+      for( uint32_t block_num = _last_indexed + 1; block_num <= _db.head_block_num(); ++block_num )
+      {
+         auto block = _db.fetch_block_by_number( block_num );
+         if( block )
+            add_reversible( *block, block_num );
+      }
+   });
+}
+
+void transaction_index_impl::on_post_apply_block( const block_notification& note )
+{
+   if( _started )
+      add_reversible( note.block, note.block_num );
+}
+
+void transaction_index_impl::on_irreversible_block( uint32_t block_num )
+{
+   if( !_started || block_num <= _last_indexed )
+      return;
+
+   ::rocksdb::WriteBatch batch;
+   for( uint32_t i = _last_indexed + 1; i <= block_num; ++i )
+   {
+      auto block = _db.fetch_block_by_number( i );
+      FC_ASSERT( block.valid(), "Could not find irreversible block ${n}", ("n", i) );
+      index_block( batch, *block, i );
+   }
+
+   write( batch, block_num, false );
+
+   // Transactions are in the store before they leave the reversible ones, so lookups always find them
+   std::lock_guard< std::mutex > lock( _reversible_mutex );
+   for( auto itr = _reversible_blocks.begin(); itr != _reversible_blocks.end() && itr->first <= block_num; )
+   {
+      for( const auto& id : itr->second )
+         _reversible.erase( id );
+      itr = _reversible_blocks.erase( itr );
+   }
+}
+
+fc::optional< transaction_location > transaction_index_impl::find( const transaction_id_type& id )const
+{
+   std::string value;
+   auto s = _storage->Get( ::rocksdb::ReadOptions(), Slice( id.data(), id.data_size() ), &value );
+
+   if( s.IsNotFound() )
+      return {};
+
+   FC_ASSERT( s.ok(), "Could not read the transaction index: ${e}", ("e", s.ToString()) );
+   return fc::raw::unpack_from_char_array< transaction_location >( value.data(), value.size(), 0 );
+}
+
+fc::optional< transaction_location > transaction_index_impl::find_reversible( const transaction_id_type& id )const
+{
+   std::lock_guard< std::mutex > lock( _reversible_mutex );
+   auto itr = _reversible.find( id );
+   if( itr == _reversible.end() )
+      return {};
+
+   return itr->second;
+}
+
+} // detail
+
+transaction_index_plugin::transaction_index_plugin() {}
+transaction_index_plugin::~transaction_index_plugin() {}
+
+void transaction_index_plugin::set_program_options( boost::program_options::options_description& cli, boost::program_options::options_description& cfg )
+{
+   cfg.add_options()
+      ( TRANSACTION_INDEX_PATH_KEY, boost::program_options::value< bfs::path >()->default_value( "blockchain/transaction-index" ),
+         "The location of the transaction index. Relative paths are in the data directory." )
+      ( TRANSACTION_INDEX_CACHE_KEY, boost::program_options::value< uint32_t >()->default_value( 256 ),
+         "MB of block cache for transaction index lookups." )
+      ;
+}
+
+void transaction_index_plugin::plugin_initialize( const boost::program_options::variables_map& options )
+{
+   try
+   {
+      ilog( "transaction_index: plugin_initialize() begin" );
+
+      my = std::make_unique< detail::transaction_index_impl >();
+
+      bfs::path path = options.at( TRANSACTION_INDEX_PATH_KEY ).as< bfs::path >();
+      if( path.is_relative() )
+         path = appbase::app().data_dir() / path;
+
+      my->open( path, options.at( TRANSACTION_INDEX_CACHE_KEY ).as< uint32_t >() );
+
+      my->_post_apply_block_conn = my->_db.add_post_apply_block_handler(
+         [&]( const block_notification& note ) { try { my->on_post_apply_block( note ); } FC_LOG_AND_RETHROW() }, *this, 0 );
+      my->_irreversible_block_conn = my->_db.add_irreversible_block_handler(
+         [&]( uint32_t block_num ) { try { my->on_irreversible_block( block_num ); } FC_LOG_AND_RETHROW() }, *this, 0 );
+
+      ilog( "transaction_index: plugin_initialize() end" );
+   } FC_CAPTURE_AND_RETHROW()
+}
+
+void transaction_index_plugin::plugin_startup()
+{
+   try
+   {
+      ilog( "transaction_index: plugin_startup() begin" );
+
+      // Blocks replayed by the chain plugin are indexed by the block log scan
+      my->catch_up();
+      my->_started = true;
+      my->load_reversible();
+
+      ilog( "transaction_index: plugin_startup() end" );
+   } FC_CAPTURE_AND_RETHROW()
+}
+
+void transaction_index_plugin::plugin_shutdown()
+{
+   my->close();
+}
+
+fc::optional< transaction_location > transaction_index_plugin::find_transaction( const protocol::transaction_id_type& id )const
+{
+   auto location = my->find_reversible( id );
+   if( location )
+      return location;
+
+   return my->find( id );
+}
+
+fc::optional< protocol::annotated_signed_transaction > transaction_index_plugin::get_transaction( const protocol::transaction_id_type& id )const
+{
+   auto make_result = [&]( const signed_block& block, const transaction_location& location ) -> fc::optional< protocol::annotated_signed_transaction >
+   {
+      if( location.trx_in_block >= block.transactions.size() || block.transactions[ location.trx_in_block ].id() != id )
+         return {};
+
+      protocol::annotated_signed_transaction result( block.transactions[ location.trx_in_block ] );
+      result.block_num = location.block_num;
+      result.transaction_num = location.trx_in_block;
+      return result;
+   };
+
+   // Reversible blocks are checked first, their transactions are indexed before they are removed from memory
+   auto location = my->find_reversible( id );
+   if( location )
+   {
+      auto block = my->_db.with_read_lock( [&]()
+      {
+         return my->_db.fetch_block_by_number( location->block_num );
+      });
+
+      // The block can be gone after a fork switch
+      if( block )
+      {
+         auto result = make_result( *block, *location );
+         if( result )
+            return result;
+      }
+   }
+
+   location = my->find( id );
+   if( location )
+   {
+      const auto& log = my->_db.get_block_log();
+      fc::optional< signed_block > block;
+
+      // A block is indexed just before the database appends it to the block log
+      if( location->block_num <= log.head_block_num() )
+         block = log.read_block_by_num( location->block_num );
+      else
+         block = my->_db.with_read_lock( [&]() { return my->_db.fetch_block_by_number( location->block_num ); } );
+
+      FC_ASSERT( block.valid(), "Could not read block ${n} of transaction ${t}", ("n", location->block_num)("t", id) );
+      return make_result( *block, *location );
+   }
+
+   return {};
+}
+
+uint32_t transaction_index_plugin::last_indexed_block()const
+{
+   return my->_last_indexed;
+}
+
+} } } // steem::plugins::transaction_index
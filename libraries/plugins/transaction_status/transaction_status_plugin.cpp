@@ -217,7 +217,7 @@ void transaction_status_impl::rebuild_state()
       FC_ASSERT( block.valid(), "Could not read block ${n}", ("n", block_num) );
 
       for ( const auto& e : block->transactions )
-         _db.create< transaction_status_object >( [&]( transaction_status_object& obj )
+         _db.bulk_create< transaction_status_object >( [&]( transaction_status_object& obj )
          {
             obj.transaction_id = e.id();
             obj.block_num = block_num;
@@ -0,0 +1,133 @@
+#include <steem/plugins/webserver/http_request_parser.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace steem { namespace plugins { namespace webserver {
+
+http_request_parser::result http_request_parser::next( http_request& request )
+{
+   if( _error_status )
+      return error;
+
+   if( !_head )
+   {
+      size_t header_end = _in.find( "\r\n\r\n" );
+      if( header_end == std::string::npos )
+      {
+         if( _in.size() > STEEM_WEBSERVER_MAX_HEADER_SIZE )
+            return fail( 431 );
+         return need_more;
+      }
+
+      request_head head;
+      head.header_size = header_end + 4;
+      if( !parse_head( header_end, head ) )
+         return error;
+
+      _head = head;
+
+      if( head.expect_continue && _in.size() < head.header_size + head.content_length )
+         return send_continue;
+   }
+
+   if( _in.size() < _head->header_size + _head->content_length )
+      return need_more;
+
+   request.body = _in.substr( _head->header_size, _head->content_length );
+   request.keep_alive = _head->keep_alive;
+   request.binary = _head->binary;
+   _in.erase( 0, _head->header_size + _head->content_length );
+   _head.reset();
+
+   return request_ready;
+}
+
+http_request_parser::result http_request_parser::fail( uint16_t status )
+{
+   _error_status = status;
+   return error;
+}
+
+bool http_request_parser::parse_head( size_t header_end, request_head& head )
+{
+   size_t line_end = _in.find( "\r\n" );
+   std::string request_line = _in.substr( 0, line_end );
+
+   size_t version_pos = request_line.rfind( ' ' );
+   if( version_pos == std::string::npos || request_line.compare( version_pos + 1, 5, "HTTP/" ) != 0 )
+   {
+      fail( 400 );
+      return false;
+   }
+
+   // HTTP/1.0 connections are closed after the response unless the client asks otherwise
+   bool http_1_0 = request_line.compare( version_pos + 1, std::string::npos, "HTTP/1.0" ) == 0;
+   head.keep_alive = !http_1_0;
+
+   // Requests to /binary carry a packed binary_rpc_request instead of JSON
+   size_t target_pos = request_line.find( ' ' );
+   if( target_pos != version_pos && request_line.compare( target_pos + 1, version_pos - target_pos - 1, "/binary" ) == 0 )
+   {
+      if( !_enable_binary )
+      {
+         fail( 404 );
+         return false;
+      }
+      head.binary = true;
+   }
+
+   for( size_t pos = line_end + 2; pos < header_end; )
+   {
+      size_t end = _in.find( "\r\n", pos );
+      size_t colon = _in.find( ':', pos );
+      if( colon == std::string::npos || colon > end )
+      {
+         fail( 400 );
+         return false;
+      }
+
+      std::string name = _in.substr( pos, colon - pos );
+      std::string value = boost::algorithm::trim_copy( _in.substr( colon + 1, end - colon - 1 ) );
+      pos = end + 2;
+
+      if( boost::algorithm::iequals( name, "Content-Length" ) )
+      {
+         try
+         {
+            head.content_length = boost::lexical_cast< size_t >( value );
+         }
+         catch( const boost::bad_lexical_cast& )
+         {
+            fail( 400 );
+            return false;
+         }
+
+         if( head.content_length > STEEM_WEBSERVER_MAX_BODY_SIZE )
+         {
+            fail( 413 );
+            return false;
+         }
+      }
+      else if( boost::algorithm::iequals( name, "Connection" ) )
+      {
+         if( boost::algorithm::ifind_first( value, "close" ) )
+            head.keep_alive = false;
+         else if( boost::algorithm::ifind_first( value, "keep-alive" ) )
+            head.keep_alive = true;
+      }
+      else if( boost::algorithm::iequals( name, "Expect" ) )
+      {
+         head.expect_continue = boost::algorithm::iequals( value, "100-continue" );
+      }
+      else if( boost::algorithm::iequals( name, "Transfer-Encoding" ) )
+      {
+         fail( 411 );
+         return false;
+      }
+   }
+
+   return true;
+}
+
+} } } // steem::plugins::webserver
@@ -0,0 +1,67 @@
+#pragma once
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <string>
+
+#define STEEM_WEBSERVER_MAX_HEADER_SIZE   ( 64 * 1024 )
+#define STEEM_WEBSERVER_MAX_BODY_SIZE     ( 32 * 1024 * 1024 )
+
+namespace steem { namespace plugins { namespace webserver {
+
+/// A complete request read from an HTTP connection
+struct http_request
+{
+   std::string body;
+   bool        keep_alive = true;
+   bool        binary = false;
+};
+
+/**
+ * Splits the bytes read from an HTTP/1.x connection into requests.
+ *
+ * Bytes are appended as they are read, next() then returns the requests they complete, several of
+ * them when the client pipelines. Only requests with a Content-Length body are accepted, chunked
+ * transfer encoding is refused. After an error the connection must be closed, the parser does not
+ * resynchronize.
+ */
+class http_request_parser
+{
+   public:
+      enum result
+      {
+         need_more,        ///< The next request is not complete yet
+         request_ready,    ///< A request was returned
+         send_continue,    ///< The client waits for 100 Continue before sending the body
+         error             ///< Malformed or refused request, reply with error_status() and close
+      };
+
+      http_request_parser( bool enable_binary ) : _enable_binary( enable_binary ) {}
+
+      void append( const char* data, size_t size ) { _in.append( data, size ); }
+
+      result next( http_request& request );
+
+      /// The HTTP status of the last error
+      uint16_t error_status()const { return _error_status; }
+
+   private:
+      struct request_head
+      {
+         size_t   header_size = 0;
+         size_t   content_length = 0;
+         bool     keep_alive = true;
+         bool     expect_continue = false;
+         bool     binary = false;
+      };
+
+      bool parse_head( size_t header_end, request_head& head );
+      result fail( uint16_t status );
+
+      std::string                      _in;
+      boost::optional< request_head >  _head;
+      bool                             _enable_binary = false;
+      uint16_t                         _error_status = 0;
+};
+
+} } } // steem::plugins::webserver
@@ -0,0 +1,163 @@
+#pragma once
+#include <steem/chain/database.hpp>
+
+#include <fc/container/flat.hpp>
+#include <fc/variant.hpp>
+
+#include <boost/asio.hpp>
+
+#include <websocketpp/message_buffer/message.hpp>
+#include <websocketpp/message_buffer/alloc.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#define STEEM_SUBSCRIPTION_MAX_ACCOUNTS 1000
+
+namespace steem { namespace plugins { namespace webserver {
+
+namespace detail { struct operation_entry; }
+
+typedef websocketpp::message_buffer::message< websocketpp::message_buffer::alloc::con_msg_manager > ws_message;
+
+/**
+ * The client end of subscriptions, implemented by the websocket server for its connections.
+ *
+ * client identifies the connection. A client has at most one subscription per stream, subscribing
+ * again replaces its filters.
+ */
+class subscriber
+{
+   public:
+      subscriber( const void* c ) : client( c ) {}
+      virtual ~subscriber() {}
+
+      /// Bytes queued for the client and not yet written
+      virtual size_t buffered_amount() = 0;
+
+      /// Queues a prepared websocket frame, shared with all other subscribers of the notification
+      virtual void send( const ws_message::ptr& frame ) = 0;
+
+      /// Closes the connection of a client that does not keep up
+      virtual void drop( const std::string& reason ) = 0;
+
+      /// Subscriptions of closed connections are removed on the next notification
+      virtual bool is_open() = 0;
+
+      const void* const client;
+};
+
+/**
+ * Parameters of subscription_api.subscribe
+ *
+ * stream is blocks, irreversible_blocks or operations. Operations are those of applied blocks,
+ * including virtual operations, and can be filtered by the accounts they impact and by their type,
+ * given like transfer or transfer_operation. Empty filters match everything.
+ */
+struct subscribe_args
+{
+   std::string                                        stream;
+   fc::flat_set< steem::protocol::account_name_type > accounts;
+   std::vector< std::string >                         operation_types;
+};
+
+struct unsubscribe_args
+{
+   std::string                                        stream;
+};
+
+/**
+ * Pushes new blocks, irreversible blocks and operations to websocket clients.
+ *
+ * Clients send JSON-RPC requests for subscription_api.subscribe and subscription_api.unsubscribe and
+ * receive subscription_api.notice messages:
+ *
+ *    {"jsonrpc":"2.0","method":"subscription_api.notice","params":{"stream":"blocks","block_num":...,"block_id":...,"block":{...}}}
+ *    {"jsonrpc":"2.0","method":"subscription_api.notice","params":{"stream":"operations","operation":{"trx_id":...,"block":...,"op":...}}}
+ *
+ * The blocks stream follows the head block and repeats block numbers when the node switches forks.
+ * The irreversible_blocks stream sends every block once, in order.
+ *
+ * The database signals only copy what a notification needs. Each notification is serialized once
+ * on a strand of the given io_service, in block order, and the same websocket frame is queued on
+ * every matching connection. A client with more than max_buffered bytes queued is dropped.
+ */
+class subscription_hub
+{
+   public:
+      subscription_hub( chain::database& db, boost::asio::io_service& ios, size_t max_buffered );
+      ~subscription_hub();
+
+      void connect_signals( const appbase::abstract_plugin& plugin );
+      void disconnect_signals();
+
+      /// Whether a websocket message is a request for this hub and not for json_rpc_plugin
+      static bool is_subscription_request( const std::string& message, fc::variant& request );
+
+      /// Handles a subscription_api request and returns the JSON-RPC response
+      std::string call( const std::shared_ptr< subscriber >& s, const fc::variant& request );
+
+      void subscribe( const std::shared_ptr< subscriber >& s, const subscribe_args& args );
+      void unsubscribe( const void* client, const std::string& stream );
+
+      /// Removes all subscriptions of a closed connection
+      void remove( const void* client );
+
+      size_t subscriber_count();
+
+      /// A websocket text frame with payload, ready to be written to any connection
+      static ws_message::ptr make_frame( const std::string& payload );
+
+   private:
+      struct subscription
+      {
+         std::shared_ptr< subscriber >                      sub;
+         bool                                               blocks = false;
+         bool                                               irreversible_blocks = false;
+         bool                                               operations = false;
+         fc::flat_set< steem::protocol::account_name_type > accounts;
+         std::vector< bool >                                operation_types;
+      };
+
+      void on_pre_apply_block( const chain::block_notification& note );
+      void on_post_apply_operation( const chain::operation_notification& note );
+      void on_post_apply_block( const chain::block_notification& note );
+      void on_irreversible_block( uint32_t block_num );
+
+      void notify_block( const std::string& stream, const std::shared_ptr< steem::protocol::signed_block >& block, uint32_t block_num );
+      void notify_operations( const std::shared_ptr< std::vector< detail::operation_entry > >& ops );
+
+      /// Serializes payload once when a subscription passes filter and queues it on all of them
+      template< typename Payload, typename Filter >
+      void fan_out( Payload&& payload, Filter&& filter );
+
+      void remove( const std::shared_ptr< subscriber >& s );
+      void update_counts();
+
+      chain::database&                                         _db;
+      boost::asio::io_service::strand                          _strand;
+      size_t                                                   _max_buffered;
+
+      std::mutex                                               _mutex;
+      std::map< const void*, subscription >                    _subscriptions;
+      std::atomic< uint32_t >                                  _block_subscribers{ 0 };
+      std::atomic< uint32_t >                                  _irreversible_subscribers{ 0 };
+      std::atomic< uint32_t >                                  _operation_subscribers{ 0 };
+
+      // Only used on the write thread
+      bool                                                     _in_block = false;
+      std::shared_ptr< std::vector< detail::operation_entry > > _block_ops;
+      uint32_t                                                 _last_irreversible = 0;
+
+      boost::signals2::connection                              _pre_apply_block_conn;
+      boost::signals2::connection                              _post_apply_operation_conn;
+      boost::signals2::connection                              _post_apply_block_conn;
+      boost::signals2::connection                              _irreversible_block_conn;
+};
+
+} } } // steem::plugins::webserver
+
+FC_REFLECT( steem::plugins::webserver::subscribe_args, (stream)(accounts)(operation_types) )
+FC_REFLECT( steem::plugins::webserver::unsubscribe_args, (stream) )
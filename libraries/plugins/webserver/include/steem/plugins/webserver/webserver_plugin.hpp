@@ -23,9 +23,16 @@ using namespace appbase;
   * thread.  The callback can be called from any thread and will
   * automatically propagate the call to the http thread.
   *
-  * The HTTP service will run in its own thread with its own io_service to
-  * make sure that HTTP request processing does not interfer with other
-  * plugins.
+  * Socket IO runs on webserver-io-threads threads, each with its own
+  * io_service to make sure that HTTP request processing does not interfer
+  * with other plugins. Where SO_REUSEPORT is supported every IO thread has
+  * its own listeners, otherwise the first thread accepts connections.
+  *
+  * HTTP connections on their own endpoint are kept alive and may pipeline
+  * requests, which are answered in order.
+  *
+  * With webserver-enable-subscriptions, websocket clients can subscribe to
+  * blocks and operations, see subscription_hub.
   */
 class webserver_plugin : public appbase::plugin< webserver_plugin >
 {
@@ -0,0 +1,481 @@
+#include <steem/plugins/webserver/subscription_hub.hpp>
+
+#include <steem/plugins/json_rpc/json_rpc_plugin.hpp>
+
+#include <steem/chain/util/impacted.hpp>
+#include <steem/chain/util/signal.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <websocketpp/frame.hpp>
+
+namespace steem { namespace plugins { namespace webserver {
+
+namespace detail
+{
+   struct operation_entry
+   {
+      operation_entry() {}
+      operation_entry( const chain::operation_notification& note ) :
+         trx_id( note.trx_id ),
+         block( note.block ),
+         trx_in_block( note.trx_in_block ),
+         op_in_trx( note.op_in_trx ),
+         virtual_op( note.virtual_op ),
+         op( note.op )
+      {}
+
+      protocol::transaction_id_type trx_id;
+      uint32_t                      block = 0;
+      uint32_t                      trx_in_block = 0;
+      uint32_t                      op_in_trx = 0;
+      uint32_t                      virtual_op = 0;
+      fc::time_point_sec            timestamp;
+      protocol::operation           op;
+   };
+} } } } // steem::plugins::webserver::detail
+
+FC_REFLECT( steem::plugins::webserver::detail::operation_entry,
+   (trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(op) )
+
+namespace steem { namespace plugins { namespace webserver {
+
+namespace detail
+{
+   // Tags of the operation types by name, with and without the _operation suffix
+   const std::map< std::string, int64_t >& operation_tags()
+   {
+      static std::map< std::string, int64_t > tags = []()
+      {
+         std::map< std::string, int64_t > result;
+         for( int64_t i = 0; i < protocol::operation::count(); ++i )
+         {
+            protocol::operation op;
+            op.set_which( i );
+            std::string name;
+            op.visit( fc::get_static_variant_name( name ) );
+            result[ name ] = i;
+
+            const std::string suffix = "_operation";
+            if( name.size() > suffix.size() && name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0 )
+               result[ name.substr( 0, name.size() - suffix.size() ) ] = i;
+         }
+         return result;
+      }();
+
+      return tags;
+   }
+
+   std::string notice( const fc::mutable_variant_object& params )
+   {
+      return fc::json::to_string( fc::mutable_variant_object()
+         ( "jsonrpc", "2.0" )
+         ( "method", "subscription_api.notice" )
+         ( "params", params ) );
+   }
+}
+
+subscription_hub::subscription_hub( chain::database& db, boost::asio::io_service& ios, size_t max_buffered ) :
+   _db( db ), _strand( ios ), _max_buffered( max_buffered ) {}
+
+subscription_hub::~subscription_hub()
+{
+   disconnect_signals();
+}
+
+void subscription_hub::connect_signals( const appbase::abstract_plugin& plugin )
+{
+   _pre_apply_block_conn = _db.add_pre_apply_block_handler(
+      [&]( const chain::block_notification& note ){ on_pre_apply_block( note ); }, plugin );
+   _post_apply_operation_conn = _db.add_post_apply_operation_handler(
+      [&]( const chain::operation_notification& note ){ on_post_apply_operation( note ); }, plugin );
+   _post_apply_block_conn = _db.add_post_apply_block_handler(
+      [&]( const chain::block_notification& note ){ on_post_apply_block( note ); }, plugin );
+   _irreversible_block_conn = _db.add_irreversible_block_handler(
+      [&]( uint32_t block_num ){ on_irreversible_block( block_num ); }, plugin );
+}
+
+void subscription_hub::disconnect_signals()
+{
+   chain::util::disconnect_signal( _pre_apply_block_conn );
+   chain::util::disconnect_signal( _post_apply_operation_conn );
+   chain::util::disconnect_signal( _post_apply_block_conn );
+   chain::util::disconnect_signal( _irreversible_block_conn );
+}
+
+bool subscription_hub::is_subscription_request( const std::string& message, fc::variant& request )
+{
+   // Most messages are for json_rpc_plugin and are not parsed twice
+   if( message.find( "subscription_api." ) == std::string::npos )
+      return false;
+
+   try
+   {
+      request = fc::json::from_string( message );
+   }
+   catch( const fc::exception& )
+   {
+      return false;
+   }
+
+   if( !request.is_object() )
+      return false;
+
+   const auto& obj = request.get_object();
+   auto method = obj.find( "method" );
+   return method != obj.end() && method->value().is_string()
+      && method->value().get_string().compare( 0, 17, "subscription_api." ) == 0;
+}
+
+std::string subscription_hub::call( const std::shared_ptr< subscriber >& s, const fc::variant& request )
+{
+   const auto& obj = request.get_object();
+
+   fc::mutable_variant_object response;
+   response( "jsonrpc", "2.0" );
+
+   try
+   {
+      const std::string& method = obj[ "method" ].get_string();
+      fc::variant params = obj.contains( "params" ) ? obj[ "params" ] : fc::variant( fc::variant_object() );
+
+      if( method == "subscription_api.subscribe" )
+      {
+         auto args = params.as< subscribe_args >();
+         subscribe( s, args );
+         response( "result", fc::mutable_variant_object( "stream", args.stream ) );
+      }
+      else if( method == "subscription_api.unsubscribe" )
+      {
+         auto args = params.as< unsubscribe_args >();
+         unsubscribe( s->client, args.stream );
+         response( "result", fc::mutable_variant_object( "stream", args.stream ) );
+      }
+      else
+      {
+         response( "error", fc::mutable_variant_object()
+            ( "code", JSON_RPC_METHOD_NOT_FOUND )
+            ( "message", "Could not find method " + method ) );
+      }
+   }
+   catch( const fc::exception& e )
+   {
+      response( "error", fc::mutable_variant_object()
+         ( "code", JSON_RPC_ERROR_DURING_CALL )
+         ( "message", e.to_string() ) );
+   }
+
+   if( obj.contains( "id" ) )
+      response( "id", obj[ "id" ] );
+
+   return fc::json::to_string( response );
+}
+
+void subscription_hub::subscribe( const std::shared_ptr< subscriber >& s, const subscribe_args& args )
+{
+   FC_ASSERT( args.stream == "blocks" || args.stream == "irreversible_blocks" || args.stream == "operations",
+      "Unknown stream ${s}, expected blocks, irreversible_blocks or operations", ("s", args.stream) );
+   FC_ASSERT( args.stream == "operations" || ( args.accounts.empty() && args.operation_types.empty() ),
+      "Only the operations stream can be filtered" );
+   FC_ASSERT( args.accounts.size() <= STEEM_SUBSCRIPTION_MAX_ACCOUNTS,
+      "Cannot filter by more than ${n} accounts", ("n", STEEM_SUBSCRIPTION_MAX_ACCOUNTS) );
+
+   std::vector< bool > types;
+   if( args.operation_types.size() )
+   {
+      const auto& tags = detail::operation_tags();
+      types.resize( protocol::operation::count() );
+
+      for( const auto& name : args.operation_types )
+      {
+         auto itr = tags.find( name );
+         FC_ASSERT( itr != tags.end(), "Unknown operation type ${t}", ("t", name) );
+         types[ itr->second ] = true;
+      }
+   }
+
+   std::lock_guard< std::mutex > lock( _mutex );
+   auto& sub = _subscriptions[ s->client ];
+
+   // The address of a closed connection can be reused by a new one
+   if( !sub.sub || !sub.sub->is_open() )
+   {
+      sub = subscription();
+      sub.sub = s;
+   }
+
+   if( args.stream == "blocks" )
+   {
+      sub.blocks = true;
+   }
+   else if( args.stream == "irreversible_blocks" )
+   {
+      sub.irreversible_blocks = true;
+   }
+   else
+   {
+      sub.operations = true;
+      sub.accounts = args.accounts;
+      sub.operation_types = std::move( types );
+   }
+
+   update_counts();
+}
+
+void subscription_hub::unsubscribe( const void* client, const std::string& stream )
+{
+   FC_ASSERT( stream == "blocks" || stream == "irreversible_blocks" || stream == "operations",
+      "Unknown stream ${s}, expected blocks, irreversible_blocks or operations", ("s", stream) );
+
+   std::lock_guard< std::mutex > lock( _mutex );
+   auto itr = _subscriptions.find( client );
+   if( itr == _subscriptions.end() )
+      return;
+
+   if( stream == "blocks" )
+   {
+      itr->second.blocks = false;
+   }
+   else if( stream == "irreversible_blocks" )
+   {
+      itr->second.irreversible_blocks = false;
+   }
+   else
+   {
+      itr->second.operations = false;
+      itr->second.accounts.clear();
+      itr->second.operation_types.clear();
+   }
+
+   if( !itr->second.blocks && !itr->second.irreversible_blocks && !itr->second.operations )
+      _subscriptions.erase( itr );
+
+   update_counts();
+}
+
+void subscription_hub::remove( const void* client )
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   if( _subscriptions.erase( client ) )
+      update_counts();
+}
+
+void subscription_hub::remove( const std::shared_ptr< subscriber >& s )
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   auto itr = _subscriptions.find( s->client );
+   if( itr != _subscriptions.end() && itr->second.sub == s )
+   {
+      _subscriptions.erase( itr );
+      update_counts();
+   }
+}
+
+size_t subscription_hub::subscriber_count()
+{
+   std::lock_guard< std::mutex > lock( _mutex );
+   return _subscriptions.size();
+}
+
+ws_message::ptr subscription_hub::make_frame( const std::string& payload )
+{
+   namespace frame = websocketpp::frame;
+
+   // Frames from the server are not masked, so the same bytes can be written to every connection
+   ws_message::ptr msg( new ws_message( ws_message::con_msg_man_ptr(), frame::opcode::text, 0 ) );
+   msg->set_header( frame::prepare_header(
+      frame::basic_header( frame::opcode::text, payload.size(), true, false ),
+      frame::extended_header( payload.size() ) ) );
+   msg->set_payload( payload );
+   msg->set_prepared( true );
+   return msg;
+}
+
+void subscription_hub::update_counts()
+{
+   uint32_t blocks = 0, irreversible = 0, operations = 0;
+   for( const auto& entry : _subscriptions )
+   {
+      blocks += entry.second.blocks;
+      irreversible += entry.second.irreversible_blocks;
+      operations += entry.second.operations;
+   }
+
+   _block_subscribers = blocks;
+   _irreversible_subscribers = irreversible;
+   _operation_subscribers = operations;
+}
+
+void subscription_hub::on_pre_apply_block( const chain::block_notification& note )
+{
+   // Operations of pending transactions are applied outside of blocks and are not sent
+   _in_block = true;
+   _block_ops.reset();
+}
+
+void subscription_hub::on_post_apply_operation( const chain::operation_notification& note )
+{
+   if( !_in_block || _operation_subscribers == 0 )
+      return;
+
+   if( !_block_ops )
+      _block_ops = std::make_shared< std::vector< detail::operation_entry > >();
+
+   _block_ops->emplace_back( note );
+}
+
+void subscription_hub::on_post_apply_block( const chain::block_notification& note )
+{
+   _in_block = false;
+
+   if( _block_subscribers > 0 )
+   {
+      auto block = std::make_shared< protocol::signed_block >( note.block );
+      uint32_t block_num = note.block_num;
+      _strand.post( [this, block, block_num]()
+      {
+         notify_block( "blocks", block, block_num );
+      });
+   }
+
+   if( _block_ops )
+   {
+      auto ops = std::move( _block_ops );
+      for( auto& op : *ops )
+         op.timestamp = note.block.timestamp;
+
+      _strand.post( [this, ops]()
+      {
+         notify_operations( ops );
+      });
+   }
+}
+
+void subscription_hub::on_irreversible_block( uint32_t block_num )
+{
+   // The database notifies the previous last irreversible block again
+   if( block_num <= _last_irreversible )
+      return;
+
+   _last_irreversible = block_num;
+   if( _irreversible_subscribers == 0 )
+      return;
+
+   auto block = _db.fetch_block_by_number( block_num );
+   if( !block )
+      return;
+
+   auto copy = std::make_shared< protocol::signed_block >( std::move( *block ) );
+   _strand.post( [this, copy, block_num]()
+   {
+      notify_block( "irreversible_blocks", copy, block_num );
+   });
+}
+
+void subscription_hub::notify_block( const std::string& stream, const std::shared_ptr< protocol::signed_block >& block, uint32_t block_num )
+{
+   bool irreversible = stream == "irreversible_blocks";
+
+   fan_out(
+      [&]()
+      {
+         return detail::notice( fc::mutable_variant_object()
+            ( "stream", stream )
+            ( "block_num", block_num )
+            ( "block_id", block->id() )
+            ( "block", *block ) );
+      },
+      [irreversible]( const subscription& s )
+      {
+         return irreversible ? s.irreversible_blocks : s.blocks;
+      });
+}
+
+void subscription_hub::notify_operations( const std::shared_ptr< std::vector< detail::operation_entry > >& ops )
+{
+   fc::flat_set< protocol::account_name_type > impacted;
+
+   for( const auto& entry : *ops )
+   {
+      impacted.clear();
+      steem::app::operation_get_impacted_accounts( entry.op, impacted );
+      int64_t which = entry.op.which();
+
+      fan_out(
+         [&]()
+         {
+            return detail::notice( fc::mutable_variant_object()
+               ( "stream", "operations" )
+               ( "operation", entry ) );
+         },
+         [&]( const subscription& s )
+         {
+            if( !s.operations )
+               return false;
+
+            if( s.operation_types.size() && !s.operation_types[ which ] )
+               return false;
+
+            if( s.accounts.empty() )
+               return true;
+
+            for( const auto& account : impacted )
+            {
+               if( s.accounts.count( account ) )
+                  return true;
+            }
+
+            return false;
+         });
+   }
+}
+
+template< typename Payload, typename Filter >
+void subscription_hub::fan_out( Payload&& payload, Filter&& filter )
+{
+   std::vector< std::shared_ptr< subscriber > > targets;
+
+   {
+      std::lock_guard< std::mutex > lock( _mutex );
+      for( const auto& entry : _subscriptions )
+      {
+         if( filter( entry.second ) )
+            targets.push_back( entry.second.sub );
+      }
+   }
+
+   if( targets.empty() )
+      return;
+
+   ws_message::ptr frame;
+
+   try
+   {
+      frame = make_frame( payload() );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Could not serialize subscription notice: ${e}", ("e", e.to_detail_string()) );
+      return;
+   }
+
+   for( const auto& target : targets )
+   {
+      if( !target->is_open() )
+      {
+         remove( target );
+      }
+      else if( target->buffered_amount() > _max_buffered )
+      {
+         target->drop( "subscriber too slow" );
+         remove( target );
+      }
+      else
+      {
+         target->send( frame );
+      }
+   }
+}
+
+} } } // steem::plugins::webserver
@@ -1,4 +1,6 @@
 #include <steem/plugins/webserver/webserver_plugin.hpp>
+#include <steem/plugins/webserver/http_request_parser.hpp>
+#include <steem/plugins/webserver/subscription_hub.hpp>
 
 #include <steem/plugins/chain/chain_plugin.hpp>
 
@@ -20,6 +22,12 @@
 #include <websocketpp/logger/stub.hpp>
 #include <websocketpp/logger/syslog.hpp>
 
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <array>
+#include <atomic>
+#include <deque>
 #include <thread>
 #include <memory>
 #include <iostream>
@@ -79,6 +87,108 @@ namespace detail {
 
 using websocket_server_type = websocketpp::server< detail::asio_with_stub_log >;
 
+#ifdef SO_REUSEPORT
+#define STEEM_WEBSERVER_REUSE_PORT
+typedef asio::detail::socket_option::boolean< SOL_SOCKET, SO_REUSEPORT > reuse_port;
+#endif
+
+#define STEEM_WEBSERVER_MAX_PIPELINED     16
+
+class webserver_plugin_impl;
+
+/**
+ * An HTTP/1.1 connection served by the io_service of one IO thread.
+ *
+ * Requests are read and parsed on the IO thread and called on the thread pool. Several requests of
+ * a connection can be in the thread pool at once, their responses are written in request order as
+ * they complete. The response text is built in the thread pool and written asynchronously, so the
+ * IO thread never waits for an API call or a slow client.
+ */
+class http_connection : public std::enable_shared_from_this< http_connection >
+{
+   public:
+      http_connection( asio::io_service& ios, webserver_plugin_impl& impl, bool enable_binary ) :
+         _ios( ios ), _socket( ios ), _idle_timer( ios ), _impl( impl ), _parser( enable_binary ) {}
+
+      tcp::socket& socket() { return _socket; }
+
+      /// Starts reading requests, on the thread of the connection's io_service
+      void start();
+
+   private:
+      struct response
+      {
+         std::string text;
+         bool        ready = false;
+         bool        close = false;
+      };
+
+      void read();
+      void arm_idle_timer();
+      void on_read( const boost::system::error_code& ec, size_t bytes );
+      void parse_requests();
+      void call( std::string body, bool keep_alive, bool binary );
+      void reply_error( websocketpp::http::status_code::value status );
+      void write();
+      void on_write( const boost::system::error_code& ec, size_t count );
+      void close();
+
+      static std::string format_response( websocketpp::http::status_code::value status, const std::string& body, const char* content_type, bool keep_alive );
+
+      asio::io_service&                         _ios;
+      tcp::socket                               _socket;
+      asio::deadline_timer                      _idle_timer;
+      webserver_plugin_impl&                    _impl;
+
+      std::array< char, 16 * 1024 >             _read_buffer;
+      http_request_parser                       _parser;
+      bool                                      _reading = false;
+      bool                                      _writing = false;
+      bool                                      _closing = false;
+
+      /// Responses in request order, the front ones are being written while _writing is set
+      std::deque< shared_ptr< response > >     _responses;
+};
+
+/// A websocket connection receiving subscription notices
+class ws_subscriber : public subscriber
+{
+   public:
+      ws_subscriber( const websocket_server_type::connection_ptr& con ) : subscriber( con.get() ), _con( con ) {}
+
+      virtual size_t buffered_amount() override
+      {
+         auto con = _con.lock();
+         return con ? con->get_buffered_amount() : 0;
+      }
+
+      virtual void send( const ws_message::ptr& frame ) override
+      {
+         auto con = _con.lock();
+         if( con )
+            con->send( frame );
+      }
+
+      virtual void drop( const std::string& reason ) override
+      {
+         auto con = _con.lock();
+         if( con )
+         {
+            websocketpp::lib::error_code ec;
+            con->close( websocketpp::close::status::policy_violation, reason, ec );
+         }
+      }
+
+      virtual bool is_open() override
+      {
+         auto con = _con.lock();
+         return con && con->get_state() == websocketpp::session::state::open;
+      }
+
+   private:
+      websocket_server_type::connection_type::weak_ptr _con;
+};
+
 class webserver_plugin_impl
 {
    public:
@@ -89,21 +199,35 @@ class webserver_plugin_impl
             thread_pool.create_thread( boost::bind( &asio::io_service::run, &thread_pool_ios ) );
       }
 
+      /// An io_service run by one thread, with its own listeners when SO_REUSEPORT is available
+      struct io_thread
+      {
+         asio::io_service                             ios;
+         std::unique_ptr< asio::io_service::work >    work;
+         std::unique_ptr< tcp::acceptor >             http_acceptor;
+         std::unique_ptr< websocket_server_type >     ws_server;
+         std::thread                                  thread;
+      };
+
       void start_webserver();
       void stop_webserver();
 
+      void start_ws_server( io_thread& io, bool serve_http );
+      void start_http_acceptor( io_thread& io );
+      void accept_http( io_thread& io );
+
       void handle_ws_message( websocket_server_type*, connection_hdl, detail::websocket_server_type::message_ptr );
+      void handle_ws_close( websocket_server_type*, connection_hdl );
       void handle_http_message( websocket_server_type*, connection_hdl );
 
-      shared_ptr< std::thread >  http_thread;
-      asio::io_service           http_ios;
       optional< tcp::endpoint >  http_endpoint;
-      websocket_server_type      http_server;
-
-      shared_ptr< std::thread >  ws_thread;
-      asio::io_service           ws_ios;
       optional< tcp::endpoint >  ws_endpoint;
-      websocket_server_type      ws_server;
+
+      uint32_t                                     io_thread_count = 1;
+      uint32_t                                     keep_alive_timeout = 0;
+      bool                                         enable_binary_rpc = false;
+      std::vector< std::unique_ptr< io_thread > >  io_threads;
+      std::atomic< uint32_t >                      next_io_thread{ 0 };
 
       boost::thread_group        thread_pool;
       asio::io_service           thread_pool_ios;
@@ -111,97 +235,395 @@ class webserver_plugin_impl
 
       plugins::json_rpc::json_rpc_plugin* api;
       boost::signals2::connection         chain_sync_con;
+
+      bool                                enable_subscriptions = false;
+      uint32_t                            subscription_max_buffer_mb = 0;
+      std::unique_ptr< subscription_hub > subscriptions;
 };
 
-void webserver_plugin_impl::start_webserver()
+void http_connection::start()
 {
-   if( ws_endpoint )
+   auto self = shared_from_this();
+   _ios.dispatch( [self]()
    {
-      ws_thread = std::make_shared<std::thread>( [&]()
-      {
-         ilog( "start processing ws thread" );
-         try
-         {
-            ws_server.clear_access_channels( websocketpp::log::alevel::all );
-            ws_server.clear_error_channels( websocketpp::log::elevel::all );
-            ws_server.init_asio( &ws_ios );
-            ws_server.set_reuse_addr( true );
+      boost::system::error_code ec;
+      self->_socket.set_option( tcp::no_delay( true ), ec );
+      self->read();
+   });
+}
 
-            ws_server.set_message_handler( boost::bind( &webserver_plugin_impl::handle_ws_message, this, &ws_server, _1, _2 ) );
+void http_connection::read()
+{
+   if( _closing )
+      return;
 
-            if( http_endpoint && http_endpoint == ws_endpoint )
-            {
-               ws_server.set_http_handler( boost::bind( &webserver_plugin_impl::handle_http_message, this, &ws_server, _1 ) );
-               ilog( "start listening for http requests" );
-            }
+   // A read may still be pending from before the last response was written, the timer is armed regardless
+   if( _responses.empty() )
+      arm_idle_timer();
 
-            ilog( "start listening for ws requests" );
-            ws_server.listen( *ws_endpoint );
-            ws_server.start_accept();
+   if( _reading || _responses.size() >= STEEM_WEBSERVER_MAX_PIPELINED )
+      return;
 
-            ws_ios.run();
-            ilog( "ws io service exit" );
-         }
-         catch( ... )
+   _reading = true;
+   auto self = shared_from_this();
+   _socket.async_read_some( asio::buffer( _read_buffer ), [self]( const boost::system::error_code& ec, size_t bytes )
+   {
+      self->on_read( ec, bytes );
+   });
+}
+
+void http_connection::arm_idle_timer()
+{
+   // Idle keep-alive connections are closed after the timeout, re-arming cancels the previous wait
+   auto self = shared_from_this();
+   _idle_timer.expires_from_now( boost::posix_time::seconds( std::max< uint32_t >( _impl.keep_alive_timeout, 1 ) ) );
+   _idle_timer.async_wait( [self]( const boost::system::error_code& ec )
+   {
+      if( !ec && self->_responses.empty() )
+         self->close();
+   });
+}
+
+void http_connection::on_read( const boost::system::error_code& ec, size_t bytes )
+{
+   _reading = false;
+   _idle_timer.cancel();
+
+   if( ec )
+   {
+      // The client is gone, responses still in the thread pool are dropped
+      if( _responses.empty() || ec != asio::error::eof )
+         close();
+      else
+         _closing = true;
+      return;
+   }
+
+   _parser.append( _read_buffer.data(), bytes );
+   parse_requests();
+   read();
+}
+
+void http_connection::parse_requests()
+{
+   while( !_closing && _responses.size() < STEEM_WEBSERVER_MAX_PIPELINED )
+   {
+      http_request request;
+      switch( _parser.next( request ) )
+      {
+         case http_request_parser::need_more:
+            return;
+         case http_request_parser::error:
+            reply_error( websocketpp::http::status_code::value( _parser.error_status() ) );
+            return;
+         case http_request_parser::send_continue:
          {
-            elog( "error thrown from http io service" );
+            auto interim = std::make_shared< response >();
+            interim->text = "HTTP/1.1 100 Continue\r\n\r\n";
+            interim->ready = true;
+            _responses.push_back( interim );
+            write();
+            break;
          }
-      });
+         case http_request_parser::request_ready:
+            call( std::move( request.body ), request.keep_alive && _impl.keep_alive_timeout > 0, request.binary );
+            break;
+      }
    }
+}
 
-   if( http_endpoint && ( ( ws_endpoint && ws_endpoint != http_endpoint ) || !ws_endpoint ) )
+void http_connection::call( std::string body, bool keep_alive, bool binary )
+{
+   auto slot = std::make_shared< response >();
+   slot->close = !keep_alive;
+   _responses.push_back( slot );
+
+   // A request with Connection: close is the last one read
+   if( !keep_alive )
+      _closing = true;
+
+   // The pending call keeps the connection alive, read() stops reading once it is closing or the pipeline is full
+   auto self = shared_from_this();
+   auto request = std::make_shared< std::string >( std::move( body ) );
+   auto* api = _impl.api;
+
+   _impl.thread_pool_ios.post( [self, slot, request, api, keep_alive, binary]()
    {
-      http_thread = std::make_shared<std::thread>( [&]()
+      std::string text;
+
+      try
       {
-         ilog( "start processing http thread" );
-         try
-         {
-            http_server.clear_access_channels( websocketpp::log::alevel::all );
-            http_server.clear_error_channels( websocketpp::log::elevel::all );
-            http_server.init_asio( &http_ios );
-            http_server.set_reuse_addr( true );
+         if( binary )
+            text = format_response( websocketpp::http::status_code::ok, api->call_binary( *request ), "application/octet-stream", keep_alive );
+         else
+            text = format_response( websocketpp::http::status_code::ok, api->call( *request ), "application/json", keep_alive );
+      }
+      catch( fc::exception& e )
+      {
+         edump( (e) );
+         text = format_response( websocketpp::http::status_code::not_found, "Could not call API", nullptr, keep_alive );
+      }
+      catch( const std::exception& e )
+      {
+         std::stringstream s;
+         s << "unknown exception: " << e.what();
+         text = format_response( websocketpp::http::status_code::internal_server_error, s.str(), nullptr, keep_alive );
+      }
+      catch( ... )
+      {
+         text = format_response( websocketpp::http::status_code::internal_server_error, "unknown error occurred", nullptr, keep_alive );
+      }
 
-            http_server.set_http_handler( boost::bind( &webserver_plugin_impl::handle_http_message, this, &http_server, _1 ) );
+      auto response_text = std::make_shared< std::string >( std::move( text ) );
+      self->_ios.post( [self, slot, response_text]()
+      {
+         slot->text = std::move( *response_text );
+         slot->ready = true;
+         self->write();
+      });
+   });
+}
+
+void http_connection::reply_error( websocketpp::http::status_code::value status )
+{
+   auto slot = std::make_shared< response >();
+   slot->text = format_response( status, websocketpp::http::status_code::get_string( status ), nullptr, false );
+   slot->ready = true;
+   slot->close = true;
+   _responses.push_back( slot );
+   _closing = true;
+   write();
+}
+
+std::string http_connection::format_response( websocketpp::http::status_code::value status, const std::string& body, const char* content_type, bool keep_alive )
+{
+   std::string text;
+   text.reserve( body.size() + 128 );
+   text += "HTTP/1.1 ";
+   text += std::to_string( status );
+   text += ' ';
+   text += websocketpp::http::status_code::get_string( status );
+   text += "\r\nContent-Length: ";
+   text += std::to_string( body.size() );
+   if( content_type )
+   {
+      text += "\r\nContent-Type: ";
+      text += content_type;
+   }
+   text += keep_alive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+   text += body;
+   return text;
+}
 
-            ilog( "start listening for http requests" );
-            http_server.listen( *http_endpoint );
-            http_server.start_accept();
+void http_connection::write()
+{
+   if( _writing )
+      return;
+
+   // All consecutive completed responses at the front go out in one write
+   std::vector< asio::const_buffer > buffers;
+   for( const auto& r : _responses )
+   {
+      if( !r->ready )
+         break;
+      buffers.push_back( asio::buffer( r->text ) );
+      if( r->close )
+         break;
+   }
+
+   if( buffers.empty() )
+      return;
+
+   _writing = true;
+   auto self = shared_from_this();
+   size_t count = buffers.size();
+   asio::async_write( _socket, buffers, [self, count]( const boost::system::error_code& ec, size_t )
+   {
+      self->on_write( ec, count );
+   });
+}
+
+void http_connection::on_write( const boost::system::error_code& ec, size_t count )
+{
+   _writing = false;
+
+   if( ec )
+   {
+      close();
+      return;
+   }
 
-            http_ios.run();
-            ilog( "http io service exit" );
+   bool close_after = false;
+   for( size_t i = 0; i < count; ++i )
+   {
+      close_after = _responses.front()->close;
+      _responses.pop_front();
+   }
+
+   if( close_after || ( _closing && _responses.empty() ) )
+   {
+      close();
+      return;
+   }
+
+   write();
+   parse_requests();
+   read();
+}
+
+void http_connection::close()
+{
+   _closing = true;
+   _idle_timer.cancel();
+
+   boost::system::error_code ec;
+   _socket.shutdown( tcp::socket::shutdown_both, ec );
+   _socket.close( ec );
+}
+
+void webserver_plugin_impl::start_webserver()
+{
+   bool shared_endpoint = http_endpoint && ws_endpoint && *http_endpoint == *ws_endpoint;
+
+   for( uint32_t i = 0; i < io_thread_count; ++i )
+   {
+      io_threads.emplace_back( new io_thread() );
+      io_threads.back()->work.reset( new asio::io_service::work( io_threads.back()->ios ) );
+   }
+
+   for( size_t i = 0; i < io_threads.size(); ++i )
+   {
+#ifndef STEEM_WEBSERVER_REUSE_PORT
+      // Without SO_REUSEPORT the first IO thread listens and HTTP connections are spread over all threads
+      if( i > 0 )
+         break;
+#endif
+
+      try
+      {
+         if( ws_endpoint )
+            start_ws_server( *io_threads[i], shared_endpoint );
+
+         if( http_endpoint && !shared_endpoint )
+            start_http_acceptor( *io_threads[i] );
+      }
+      catch( const std::exception& e )
+      {
+         elog( "error starting webserver listener: ${e}", ("e", e.what()) );
+      }
+   }
+
+   for( size_t i = 0; i < io_threads.size(); ++i )
+   {
+      io_thread& io = *io_threads[i];
+      io.thread = std::thread( [&io, i]()
+      {
+         ilog( "start processing webserver io thread ${i}", ("i", i) );
+         try
+         {
+            io.ios.run();
+            ilog( "webserver io service ${i} exit", ("i", i) );
          }
          catch( ... )
          {
-            elog( "error thrown from http io service" );
+            elog( "error thrown from webserver io service ${i}", ("i", i) );
          }
       });
    }
 }
 
-void webserver_plugin_impl::stop_webserver()
+void webserver_plugin_impl::start_ws_server( io_thread& io, bool serve_http )
 {
-   if( ws_server.is_listening() )
-   ws_server.stop_listening();
+   io.ws_server.reset( new websocket_server_type() );
+   websocket_server_type& server = *io.ws_server;
+
+   server.clear_access_channels( websocketpp::log::alevel::all );
+   server.clear_error_channels( websocketpp::log::elevel::all );
+   server.init_asio( &io.ios );
+   server.set_reuse_addr( true );
+#ifdef STEEM_WEBSERVER_REUSE_PORT
+   server.set_tcp_pre_bind_handler( []( websocket_server_type::acceptor_ptr acceptor )
+   {
+      acceptor->set_option( reuse_port( true ) );
+      return websocketpp::lib::error_code();
+   });
+#endif
 
-   if( http_server.is_listening() )
-      http_server.stop_listening();
+   server.set_message_handler( boost::bind( &webserver_plugin_impl::handle_ws_message, this, &server, _1, _2 ) );
 
-   thread_pool_ios.stop();
-   thread_pool.join_all();
+   if( subscriptions )
+   {
+      server.set_close_handler( boost::bind( &webserver_plugin_impl::handle_ws_close, this, &server, _1 ) );
+      server.set_fail_handler( boost::bind( &webserver_plugin_impl::handle_ws_close, this, &server, _1 ) );
+   }
 
-   if( ws_thread )
+   // HTTP on the websocket endpoint is answered by websocketpp, which closes the connection after each response
+   if( serve_http )
    {
-      ws_ios.stop();
-      ws_thread->join();
-      ws_thread.reset();
+      server.set_http_handler( boost::bind( &webserver_plugin_impl::handle_http_message, this, &server, _1 ) );
+      ilog( "start listening for http requests" );
    }
 
-   if( http_thread )
+   ilog( "start listening for ws requests" );
+   server.listen( *ws_endpoint );
+   server.start_accept();
+}
+
+void webserver_plugin_impl::start_http_acceptor( io_thread& io )
+{
+   io.http_acceptor.reset( new tcp::acceptor( io.ios ) );
+   tcp::acceptor& acceptor = *io.http_acceptor;
+
+   acceptor.open( http_endpoint->protocol() );
+   acceptor.set_option( tcp::acceptor::reuse_address( true ) );
+#ifdef STEEM_WEBSERVER_REUSE_PORT
+   acceptor.set_option( reuse_port( true ) );
+#endif
+   acceptor.bind( *http_endpoint );
+   acceptor.listen( asio::socket_base::max_connections );
+
+   ilog( "start listening for http requests" );
+   accept_http( io );
+}
+
+void webserver_plugin_impl::accept_http( io_thread& io )
+{
+#ifdef STEEM_WEBSERVER_REUSE_PORT
+   io_thread& target = io;
+#else
+   io_thread& target = *io_threads[ next_io_thread++ % io_threads.size() ];
+#endif
+
+   auto con = std::make_shared< http_connection >( target.ios, *this, enable_binary_rpc );
+   io.http_acceptor->async_accept( con->socket(), [this, &io, con]( const boost::system::error_code& ec )
+   {
+      if( ec == asio::error::operation_aborted )
+         return;
+
+      if( ec )
+         wlog( "error accepting http connection: ${e}", ("e", ec.message()) );
+      else
+         con->start();
+
+      accept_http( io );
+   });
+}
+
+void webserver_plugin_impl::stop_webserver()
+{
+   thread_pool_ios.stop();
+   thread_pool.join_all();
+
+   // Listeners, connections and their pending handlers are destroyed with the io_services
+   for( auto& io : io_threads )
    {
-      http_ios.stop();
-      http_thread->join();
-      http_thread.reset();
+      io->work.reset();
+      io->ios.stop();
+      if( io->thread.joinable() )
+         io->thread.join();
    }
+
+   io_threads.clear();
 }
 
 void webserver_plugin_impl::handle_ws_message( websocket_server_type* server, connection_hdl hdl, detail::websocket_server_type::message_ptr msg )
@@ -212,8 +634,15 @@ void webserver_plugin_impl::handle_ws_message( websocket_server_type* server, co
    {
       try
       {
-         if( msg->get_opcode() == websocketpp::frame::opcode::text )
+         fc::variant request;
+
+         if( msg->get_opcode() == websocketpp::frame::opcode::text && subscriptions
+            && subscription_hub::is_subscription_request( msg->get_payload(), request ) )
+            con->send( subscriptions->call( std::make_shared< ws_subscriber >( con ), request ) );
+         else if( msg->get_opcode() == websocketpp::frame::opcode::text )
             con->send( api->call( msg->get_payload() ) );
+         else if( msg->get_opcode() == websocketpp::frame::opcode::binary && enable_binary_rpc )
+            con->send( api->call_binary( msg->get_payload() ), websocketpp::frame::opcode::binary );
          else
             con->send( "error: string payload expected" );
       }
@@ -242,6 +671,11 @@ void webserver_plugin_impl::handle_ws_message( websocket_server_type* server, co
    });
 }
 
+void webserver_plugin_impl::handle_ws_close( websocket_server_type* server, connection_hdl hdl )
+{
+   subscriptions->remove( server->get_con_from_hdl( hdl ).get() );
+}
+
 void webserver_plugin_impl::handle_http_message( websocket_server_type* server, connection_hdl hdl )
 {
    auto con = server->get_con_from_hdl( hdl );
@@ -301,6 +735,16 @@ void webserver_plugin::set_program_options( options_description&, options_descri
       ("rpc-endpoint", bpo::value< string >(), "Local http and websocket endpoint for webserver requests. Deprecated in favor of webserver-http-endpoint and webserver-ws-endpoint" )
       ("webserver-thread-pool-size", bpo::value<thread_pool_size_t>()->default_value(32),
        "Number of threads used to handle queries. Default: 32.")
+      ("webserver-io-threads", bpo::value< uint32_t >()->default_value( 0 ),
+       "Number of threads accepting connections and doing socket IO, each with its own listener where SO_REUSEPORT is supported. Default: 0, one per core.")
+      ("webserver-http-keep-alive-timeout", bpo::value< uint32_t >()->default_value( 60 ),
+       "Seconds an idle HTTP connection is kept open for further requests, 0 closes every connection after one response. Default: 60.")
+      ("webserver-enable-binary-rpc", bpo::value< bool >()->default_value( false ),
+       "Accept fc::raw packed binary_rpc_request bodies on the /binary path of the HTTP endpoint and as binary websocket messages.")
+      ("webserver-enable-subscriptions", bpo::value< bool >()->default_value( false ),
+       "Let websocket clients subscribe to new blocks, irreversible blocks and operations with subscription_api.subscribe.")
+      ("webserver-subscription-max-buffer", bpo::value< uint32_t >()->default_value( 16 ),
+       "MB of notices queued for a websocket subscriber before it is disconnected as too slow. Default: 16.")
       ;
 }
 
@@ -311,6 +755,15 @@ void webserver_plugin::plugin_initialize( const variables_map& options )
    ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
    my.reset(new detail::webserver_plugin_impl(thread_pool_size));
 
+   my->io_thread_count = options.at( "webserver-io-threads" ).as< uint32_t >();
+   if( my->io_thread_count == 0 )
+      my->io_thread_count = std::max< uint32_t >( std::thread::hardware_concurrency(), 1 );
+   my->keep_alive_timeout = options.at( "webserver-http-keep-alive-timeout" ).as< uint32_t >();
+   my->enable_binary_rpc = options.at( "webserver-enable-binary-rpc" ).as< bool >();
+   my->enable_subscriptions = options.at( "webserver-enable-subscriptions" ).as< bool >();
+   my->subscription_max_buffer_mb = options.at( "webserver-subscription-max-buffer" ).as< uint32_t >();
+   ilog( "configured with ${n} io threads", ("n", my->io_thread_count) );
+
    if( options.count( "webserver-http-endpoint" ) )
    {
       auto http_endpoint = options.at( "webserver-http-endpoint" ).as< string >();
@@ -357,6 +810,13 @@ void webserver_plugin::plugin_startup()
    FC_ASSERT( my->api != nullptr, "Could not find API Register Plugin" );
 
    plugins::chain::chain_plugin* chain = appbase::app().find_plugin< plugins::chain::chain_plugin >();
+
+   if( my->enable_subscriptions )
+   {
+      FC_ASSERT( chain != nullptr, "webserver-enable-subscriptions requires the chain plugin" );
+      my->subscriptions.reset( new subscription_hub( chain->db(), my->thread_pool_ios, size_t( my->subscription_max_buffer_mb ) * 1024 * 1024 ) );
+      my->subscriptions->connect_signals( *this );
+   }
    if( chain != nullptr && chain->get_state() != appbase::abstract_plugin::started )
    {
       ilog( "Waiting for chain plugin to start" );
@@ -373,6 +833,9 @@ void webserver_plugin::plugin_startup()
 
 void webserver_plugin::plugin_shutdown()
 {
+   if( my->subscriptions )
+      my->subscriptions->disconnect_signals();
+
    my->stop_webserver();
 }
 
@@ -0,0 +1,137 @@
+#include <steem/chain/steem_fwd.hpp>
+
+#include <steem/plugins/block_api/block_api_args.hpp>
+#include <steem/plugins/account_history_api/account_history_api.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <functional>
+#include <iostream>
+
+/*
+ * Compares the cost of the JSON and the binary (fc::raw) RPC transports for API results.
+ *
+ *    binary_rpc_benchmark [iterations] [transactions per block] [operations per history]
+ *
+ * For each payload, a round trip encodes the result the way the node does and decodes it into the
+ * API type the way a C++ client would:
+ *
+ *    json     fc::json::to_string( fc::variant( r ) ), then fc::json::from_string( s ).as< T >()
+ *    binary   fc::raw::pack_to_vector( r ), then fc::raw::unpack_from_vector< T >( v )
+ *
+ *    get_block             a signed block of transfers
+ *    get_account_history   transfers and votes
+ */
+
+using namespace steem::protocol;
+using namespace steem::plugins;
+
+template< typename T >
+void run( const std::string& name, uint32_t iterations, const T& result )
+{
+   std::string json = fc::json::to_string( fc::variant( result ) );
+   std::vector< char > binary = fc::raw::pack_to_vector( result );
+   FC_ASSERT( fc::raw::pack_to_vector( fc::raw::unpack_from_vector< T >( binary, 0 ) ) == binary, "binary round trip of ${n} differs", ("n", name) );
+
+   auto measure = [&]( const std::string& mode, size_t size, const std::function< void() >& round_trip )
+   {
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < iterations; ++i )
+         round_trip();
+      auto elapsed = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+
+      std::cout << name << " " << mode << ": " << size << " bytes, " << iterations << " round trips in " << elapsed / 1000
+         << " ms, " << double( iterations ) * 1000000 / elapsed << " per sec\n";
+   };
+
+   measure( "json", json.size(), [&]()
+   {
+      fc::json::from_string( fc::json::to_string( fc::variant( result ) ) ).as< T >();
+   });
+
+   measure( "binary", binary.size(), [&]()
+   {
+      fc::raw::unpack_from_vector< T >( fc::raw::pack_to_vector( result ), 0 );
+   });
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t iterations = argc > 1 ? boost::lexical_cast< uint32_t >( argv[1] ) : 1000;
+      uint32_t trx_per_block = argc > 2 ? boost::lexical_cast< uint32_t >( argv[2] ) : 100;
+      uint32_t ops = argc > 3 ? boost::lexical_cast< uint32_t >( argv[3] ) : 100;
+
+      FC_ASSERT( trx_per_block > 0, "A block needs at least one transaction" );
+
+      auto key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "binary_rpc_benchmark" ) ) );
+
+      signed_block b;
+      b.timestamp = fc::time_point_sec( 1500000000 );
+      b.witness = "initminer";
+      for( uint32_t i = 0; i < trx_per_block; ++i )
+      {
+         signed_transaction trx;
+         transfer_operation op;
+         op.from = "alice";
+         op.to = "bob";
+         op.amount = asset( i + 1, STEEM_SYMBOL );
+         op.memo = "payment " + std::to_string( i );
+         trx.operations.push_back( op );
+         trx.ref_block_num = i;
+         trx.expiration = b.timestamp + 60;
+         trx.sign( key, STEEM_CHAIN_ID, fc::ecc::fc_canonical );
+         b.transactions.push_back( trx );
+      }
+      b.transaction_merkle_root = b.calculate_merkle_root();
+      b.sign( key, fc::ecc::fc_canonical );
+
+      block_api::get_block_return block;
+      block.block = block_api::api_signed_block_object( b );
+      run( "get_block", iterations, block );
+
+      account_history::get_account_history_return history;
+      for( uint32_t i = 0; i < ops; ++i )
+      {
+         account_history::api_operation_object op;
+         op.trx_id = b.transactions[ i % b.transactions.size() ].id();
+         op.block = 1000000 + i;
+         op.trx_in_block = i % 50;
+         op.timestamp = fc::time_point_sec( 1500000000 + 3 * i );
+
+         if( i % 2 )
+         {
+            transfer_operation t;
+            t.from = "alice";
+            t.to = "bob";
+            t.amount = asset( i, STEEM_SYMBOL );
+            t.memo = "payment " + std::to_string( i );
+            op.op = t;
+         }
+         else
+         {
+            vote_operation v;
+            v.voter = "alice";
+            v.author = "bob";
+            v.permlink = "a-post-about-the-number-" + std::to_string( i );
+            v.weight = STEEM_100_PERCENT;
+            op.op = v;
+         }
+
+         history.history[ i ] = op;
+      }
+      run( "get_account_history", iterations, history );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,132 @@
+#include <steem/chain/block_log.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <thread>
+
+/*
+ * Measures concurrent random reads from block_log while another thread appends.
+ *
+ *    block_log_read_benchmark [reader threads] [prefilled blocks] [appended blocks] [transactions per block]
+ *
+ * A temporary block log is filled with synthetic unsigned blocks. Reader threads then call
+ * read_block_by_num() on random blocks up to the current head while one appender thread adds
+ * more blocks. Reads and appends per second are reported for the duration of the append phase.
+ */
+
+using namespace steem::protocol;
+
+signed_block make_block( const signed_block& previous, uint32_t trx_per_block )
+{
+   signed_block b;
+   b.previous = previous.id();
+   b.timestamp = previous.timestamp + 3;
+   b.witness = "initminer";
+
+   for( uint32_t i = 0; i < trx_per_block; ++i )
+   {
+      signed_transaction trx;
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( i + 1, STEEM_SYMBOL );
+      op.memo = "block_log_read_benchmark";
+      trx.operations.push_back( op );
+      trx.ref_block_num = b.block_num() & 0xffff;
+      trx.expiration = b.timestamp + 60;
+      trx.signatures.push_back( signature_type() );
+      b.transactions.push_back( trx );
+   }
+
+   return b;
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t readers = argc > 1 ? boost::lexical_cast< uint32_t >( argv[1] ) : 4;
+      uint32_t prefill = argc > 2 ? boost::lexical_cast< uint32_t >( argv[2] ) : 100000;
+      uint32_t appended = argc > 3 ? boost::lexical_cast< uint32_t >( argv[3] ) : 20000;
+      uint32_t trx_per_block = argc > 4 ? boost::lexical_cast< uint32_t >( argv[4] ) : 10;
+
+      FC_ASSERT( prefill > 0, "At least one block must be prefilled" );
+
+      fc::temp_directory temp_dir( fc::temp_directory_path() );
+      steem::chain::block_log log;
+      log.open( temp_dir.path() / "block_log" );
+
+      signed_block head;
+      head.witness = "initminer";
+      head.timestamp = fc::time_point_sec( STEEM_GENESIS_TIME );
+      log.append( head );
+      for( uint32_t i = 1; i < prefill; ++i )
+      {
+         head = make_block( head, trx_per_block );
+         log.append( head );
+      }
+      std::cout << "prefilled " << prefill << " blocks\n";
+
+      std::atomic< bool > running( true );
+      std::vector< uint64_t > reads( readers, 0 );
+      std::vector< std::thread > threads;
+
+      for( uint32_t t = 0; t < readers; ++t )
+      {
+         threads.emplace_back( [&, t]()
+         {
+            std::mt19937 rng( t );
+            uint64_t count = 0;
+            while( running.load( std::memory_order_relaxed ) )
+            {
+               uint32_t head_num = log.head_block_num();
+               uint32_t num = std::uniform_int_distribution< uint32_t >( 1, head_num )( rng );
+               auto b = log.read_block_by_num( num );
+               FC_ASSERT( b && b->block_num() == num );
+               ++count;
+            }
+            reads[t] = count;
+         });
+      }
+
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < appended; ++i )
+      {
+         head = make_block( head, trx_per_block );
+         log.append( head );
+      }
+      auto append_elapsed = fc::time_point::now() - start;
+
+      // Keep reading for a moment if appending was too quick to measure
+      if( append_elapsed < fc::seconds( 1 ) )
+         std::this_thread::sleep_for( std::chrono::microseconds( ( fc::seconds( 1 ) - append_elapsed ).count() ) );
+
+      running = false;
+      for( auto& t : threads )
+         t.join();
+      auto elapsed = fc::time_point::now() - start;
+
+      uint64_t total_reads = 0;
+      for( auto r : reads )
+         total_reads += r;
+
+      std::cout << "appended " << appended << " blocks in " << append_elapsed.count() / 1000 << " ms, "
+         << double( appended ) * 1000000.0 / std::max< int64_t >( append_elapsed.count(), 1 ) << " blocks/sec\n"
+         << readers << " readers: " << total_reads << " reads in " << elapsed.count() / 1000 << " ms, "
+         << double( total_reads ) * 1000000.0 / elapsed.count() << " reads/sec ("
+         << ( readers ? double( total_reads ) * 1000000.0 / elapsed.count() / readers : 0 ) << " per thread)\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
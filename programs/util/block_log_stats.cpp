@@ -0,0 +1,140 @@
+#include <steem/chain/block_log_scanner.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+/*
+ * Reports operation statistics of a block log, scanned on several threads.
+ *
+ *    block_log_stats <block_log> [threads] [first block] [last block]
+ *
+ * Prints the number of blocks, transactions and operations, the scan throughput and, for every
+ * operation type, its count and serialized size. Each scan thread counts into its own table, the
+ * tables are merged after the scan.
+ */
+
+using namespace steem::chain;
+
+struct op_type_stats
+{
+   uint64_t count = 0;
+   uint64_t bytes = 0;
+};
+
+struct thread_stats
+{
+   std::vector< op_type_stats >  ops = std::vector< op_type_stats >( operation::count() );
+   uint64_t                      empty_blocks = 0;
+   uint32_t                      largest_block = 0;
+   size_t                        largest_block_transactions = 0;
+};
+
+std::string operation_name( int64_t which )
+{
+   std::string name;
+   operation op;
+   op.set_which( which );
+   op.visit( fc::get_static_variant_name( name ) );
+   return name;
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      if( argc < 2 )
+      {
+         std::cerr << "Usage: " << argv[0] << " <block_log> [threads] [first block] [last block]\n";
+         return 1;
+      }
+
+      fc::path block_log_file( argv[1] );
+      block_log_scanner scanner( block_log_file );
+
+      block_log_scanner::scan_options options;
+      options.threads = argc > 2 ? boost::lexical_cast< uint32_t >( argv[2] ) : 0;
+      options.first_block = argc > 3 ? boost::lexical_cast< uint32_t >( argv[3] ) : 1;
+      options.last_block = argc > 4 ? boost::lexical_cast< uint32_t >( argv[4] ) : scanner.head_block_num();
+
+      uint32_t threads = options.threads ? options.threads : std::max( std::thread::hardware_concurrency(), 1u );
+      std::vector< thread_stats > per_thread( threads );
+
+      block_log_scan_visitor visitor;
+      visitor.on_block = [&]( uint32_t thread, uint32_t block_num, const signed_block& b )
+      {
+         auto& s = per_thread[ thread ];
+         if( b.transactions.empty() )
+            ++s.empty_blocks;
+         else if( b.transactions.size() > s.largest_block_transactions )
+         {
+            s.largest_block = block_num;
+            s.largest_block_transactions = b.transactions.size();
+         }
+      };
+      visitor.on_operation = [&]( uint32_t thread, uint32_t block_num, uint32_t trx_in_block, uint32_t op_in_trx, const operation& op )
+      {
+         auto& s = per_thread[ thread ].ops[ op.which() ];
+         ++s.count;
+         s.bytes += fc::raw::pack_size( op );
+      };
+
+      std::cout << "Scanning blocks " << options.first_block << " to " << options.last_block << " of a v"
+         << scanner.get_format_version() << " block log on " << threads << " threads\n";
+
+      auto stats = scanner.scan( options, visitor );
+
+      thread_stats total;
+      for( const auto& s : per_thread )
+      {
+         for( size_t i = 0; i < s.ops.size(); ++i )
+         {
+            total.ops[i].count += s.ops[i].count;
+            total.ops[i].bytes += s.ops[i].bytes;
+         }
+         total.empty_blocks += s.empty_blocks;
+         if( s.largest_block_transactions > total.largest_block_transactions )
+         {
+            total.largest_block = s.largest_block;
+            total.largest_block_transactions = s.largest_block_transactions;
+         }
+      }
+
+      std::cout << stats.blocks << " blocks (" << total.empty_blocks << " empty), " << stats.transactions << " transactions, "
+         << stats.operations << " operations\n"
+         << "Largest block " << total.largest_block << " with " << total.largest_block_transactions << " transactions\n"
+         << "Scanned " << stats.bytes / ( 1024 * 1024 ) << " MB in " << stats.elapsed_us / 1000 << " ms, "
+         << stats.mb_per_sec() << " MB/sec, " << stats.blocks_per_sec() << " blocks/sec, " << stats.chunks << " chunks\n\n";
+
+      std::vector< int64_t > order;
+      for( size_t i = 0; i < total.ops.size(); ++i )
+      {
+         if( total.ops[i].count )
+            order.push_back( i );
+      }
+      std::sort( order.begin(), order.end(), [&]( int64_t a, int64_t b ) { return total.ops[a].count > total.ops[b].count; } );
+
+      std::cout << std::left << std::setw( 48 ) << "operation" << std::right << std::setw( 14 ) << "count"
+         << std::setw( 10 ) << "%" << std::setw( 16 ) << "bytes" << std::setw( 12 ) << "avg bytes" << "\n";
+      for( auto i : order )
+      {
+         const auto& s = total.ops[i];
+         std::cout << std::left << std::setw( 48 ) << operation_name( i ) << std::right << std::setw( 14 ) << s.count
+            << std::setw( 10 ) << std::fixed << std::setprecision( 2 ) << 100.0 * s.count / std::max< uint64_t >( stats.operations, 1 )
+            << std::setw( 16 ) << s.bytes << std::setw( 12 ) << std::setprecision( 1 ) << double( s.bytes ) / s.count << "\n";
+      }
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
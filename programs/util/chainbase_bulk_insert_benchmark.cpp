@@ -0,0 +1,92 @@
+#include <steem/chain/transaction_object.hpp>
+
+#include <fc/crypto/ripemd160.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <functional>
+#include <iostream>
+
+/*
+ * Compares object insertion rates of chainbase create<> against bulk_create<>.
+ *
+ *    chainbase_bulk_insert_benchmark [objects] [objects per undo session]
+ *
+ * transaction_objects, which have an ordered, a hashed and an ordered non-unique index, are inserted
+ * into a fresh temporary database for each mode:
+ *
+ *    create/session   create<> inside undo sessions that are pushed, as during block application
+ *    create           create<> without undo state
+ *    bulk_create      reserve() followed by bulk_create<>
+ */
+
+using namespace steem::chain;
+
+void fill( transaction_object& o, uint64_t i )
+{
+   o.trx_id = transaction_id_type( fc::ripemd160::hash( (const char*)&i, sizeof( i ) ) );
+   o.expiration = fc::time_point_sec( STEEM_GENESIS_TIME ) + uint32_t( i % 3600 );
+   o.packed_trx.resize( 128 );
+}
+
+void run( const std::string& mode, uint64_t count, const std::function< void( chainbase::database&, uint64_t ) >& insert )
+{
+   fc::temp_directory temp_dir( fc::temp_directory_path() );
+   chainbase::database db;
+   db.open( temp_dir.path(), 0, uint64_t( 512 ) * count + ( 64 << 20 ) );
+   db.add_index< transaction_index >();
+
+   auto start = fc::time_point::now();
+   insert( db, count );
+   auto elapsed = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+
+   FC_ASSERT( db.count< transaction_object >() == count );
+   std::cout << mode << ": " << count << " objects in " << elapsed / 1000 << " ms, "
+      << double( count ) * 1000000.0 / elapsed << " objects/sec\n";
+
+   db.close();
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint64_t count = argc > 1 ? boost::lexical_cast< uint64_t >( argv[1] ) : 1000000;
+      uint64_t per_session = argc > 2 ? boost::lexical_cast< uint64_t >( argv[2] ) : 100;
+      FC_ASSERT( per_session > 0, "Undo sessions must hold at least one object" );
+
+      run( "create/session", count, [&]( chainbase::database& db, uint64_t n )
+      {
+         for( uint64_t i = 0; i < n; )
+         {
+            auto session = db.start_undo_session();
+            for( uint64_t end = std::min( n, i + per_session ); i < end; ++i )
+               db.create< transaction_object >( [&]( transaction_object& o ) { fill( o, i ); } );
+            session.push();
+            db.commit( db.revision() );
+         }
+      });
+
+      run( "create", count, []( chainbase::database& db, uint64_t n )
+      {
+         for( uint64_t i = 0; i < n; ++i )
+            db.create< transaction_object >( [&]( transaction_object& o ) { fill( o, i ); } );
+      });
+
+      run( "bulk_create", count, []( chainbase::database& db, uint64_t n )
+      {
+         db.get_mutable_index< transaction_index >().reserve( n );
+         for( uint64_t i = 0; i < n; ++i )
+            db.bulk_create< transaction_object >( [&]( transaction_object& o ) { fill( o, i ); } );
+      });
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
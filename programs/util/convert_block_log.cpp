@@ -0,0 +1,97 @@
+#include <steem/chain/block_log.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+
+/*
+ * Converts a block log between the raw (v1) and compressed (v2) formats.
+ *
+ *    convert_block_log <input block_log> <output block_log> [none|zstd|lz4] [level]
+ *
+ * The output must not exist. A codec of none writes a v1 log, which converts a compressed log back
+ * to the raw format. After converting, both logs are read end to end to compare sequential read
+ * throughput. Use replay_benchmark on each log to compare the replay pipeline.
+ */
+
+using steem::chain::block_log;
+
+double read_all( const block_log& log, uint32_t head )
+{
+   auto start = fc::time_point::now();
+   auto itr = log.read_block( log.get_block_pos( 1 ) );
+   while( itr.first.block_num() != head )
+      itr = log.read_block( itr.second );
+   auto elapsed = fc::time_point::now() - start;
+   return double( head ) * 1000000.0 / std::max< int64_t >( elapsed.count(), 1 );
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      if( argc < 3 )
+      {
+         std::cerr << "Usage: " << argv[0] << " <input block_log> <output block_log> [none|zstd|lz4] [level]\n";
+         return 1;
+      }
+
+      fc::path input_file( argv[1] );
+      fc::path output_file( argv[2] );
+      auto codec = steem::chain::block_log_format::from_string( argc > 3 ? argv[3] : "zstd" );
+      int level = argc > 4 ? boost::lexical_cast< int >( argv[4] ) : 0;
+
+      FC_ASSERT( fc::exists( input_file ), "Input block log does not exist", ("file", input_file) );
+      FC_ASSERT( !fc::exists( output_file ), "Output block log already exists", ("file", output_file) );
+
+      block_log input;
+      input.open( input_file );
+      FC_ASSERT( input.head(), "Input block log is empty" );
+      uint32_t head = input.head()->block_num();
+
+      block_log output;
+      output.set_compression( codec, level );
+      output.open( output_file );
+
+      std::cout << "Converting " << head << " blocks from v" << input.get_format_version() << " to v"
+         << output.get_format_version() << " (" << steem::chain::block_log_format::to_string( codec ) << ")\n";
+
+      auto start = fc::time_point::now();
+      auto itr = input.read_block( input.get_block_pos( 1 ) );
+      while( true )
+      {
+         output.append( itr.first );
+
+         uint32_t num = itr.first.block_num();
+         if( num % 1000000 == 0 )
+            std::cout << "   " << num << " of " << head << "\n";
+         if( num == head )
+            break;
+
+         itr = input.read_block( itr.second );
+      }
+      output.flush();
+      auto elapsed = fc::time_point::now() - start;
+
+      uint64_t input_size = fc::file_size( input_file );
+      uint64_t output_size = fc::file_size( output_file );
+      std::cout << "Converted in " << elapsed.count() / 1000000 << " s\n"
+         << "   input:  " << input_size << " bytes\n"
+         << "   output: " << output_size << " bytes ("
+         << double( output_size ) * 100.0 / std::max< uint64_t >( input_size, 1 ) << "%)\n";
+
+      std::cout << "Sequential read_block() throughput\n"
+         << "   input:  " << read_all( input, head ) << " blocks/sec\n"
+         << "   output: " << read_all( output, head ) << " blocks/sec\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,98 @@
+#include <fc/io/json.hpp>
+#include <fc/io/json_fast.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/variant_object.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <functional>
+#include <iostream>
+
+/*
+ * Compares fc::json::from_string, which parses well formed input with fc::json_fast, against the
+ * legacy stream parser.
+ *
+ *    json_parse_benchmark [iterations] [elements per document]
+ *
+ * Documents:
+ *
+ *    batch_request         a JSON-RPC batch of condenser_api calls
+ *    broadcast_transaction a network_broadcast_api call with a transaction of transfers
+ *    large_object          an object with 2 KB string values, like a list of comment bodies
+ */
+
+void run( const std::string& name, uint32_t iterations, const std::string& json )
+{
+   FC_ASSERT( fc::json::to_string( fc::json::from_string( json ) ) == fc::json::to_string( fc::json::from_string_legacy( json ) ),
+      "results of ${n} differ", ("n", name) );
+
+   auto measure = [&]( const std::string& mode, const std::function< fc::variant( const std::string& ) >& parse )
+   {
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < iterations; ++i )
+         parse( json );
+      auto elapsed = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+
+      std::cout << name << " " << mode << ": " << iterations << " documents of " << json.size() << " bytes in "
+         << elapsed / 1000 << " ms, " << double( json.size() ) * iterations / elapsed << " MB/sec\n";
+   };
+
+   measure( "legacy", []( const std::string& s ) { return fc::json::from_string_legacy( s ); } );
+   measure( fc::json_fast::scan_backend(), []( const std::string& s ) { return fc::json::from_string( s ); } );
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t iterations = argc > 1 ? boost::lexical_cast< uint32_t >( argv[1] ) : 1000;
+      uint32_t elements = argc > 2 ? boost::lexical_cast< uint32_t >( argv[2] ) : 100;
+
+      fc::variants batch;
+      for( uint32_t i = 0; i < elements; ++i )
+      {
+         batch.push_back( fc::mutable_variant_object()
+            ( "jsonrpc", "2.0" )
+            ( "method", "condenser_api.get_accounts" )
+            ( "params", fc::variants{ fc::variants{ "account" + std::to_string( i ), "alice", "bob" } } )
+            ( "id", i ) );
+      }
+      run( "batch_request", iterations, fc::json::to_string( batch ) );
+
+      fc::variants operations;
+      for( uint32_t i = 0; i < elements; ++i )
+      {
+         operations.push_back( fc::variants{ "transfer", fc::mutable_variant_object()
+            ( "from", "alice" )
+            ( "to", "bob" )
+            ( "amount", fc::mutable_variant_object()( "amount", std::to_string( i ) )( "precision", 3 )( "nai", "@@000000021" ) )
+            ( "memo", "payment " + std::to_string( i ) ) } );
+      }
+      fc::mutable_variant_object trx;
+      trx( "ref_block_num", 12345 )
+         ( "ref_block_prefix", 2750155807u )
+         ( "expiration", "2018-03-01T00:00:00" )
+         ( "operations", operations )
+         ( "extensions", fc::variants() )
+         ( "signatures", fc::variants{ "1f" + std::string( 128, 'a' ) } );
+      run( "broadcast_transaction", iterations, fc::json::to_string( fc::mutable_variant_object()
+         ( "jsonrpc", "2.0" )
+         ( "method", "network_broadcast_api.broadcast_transaction" )
+         ( "params", fc::mutable_variant_object()( "trx", trx ) )
+         ( "id", 1 ) ) );
+
+      fc::mutable_variant_object large;
+      for( uint32_t i = 0; i < elements; ++i )
+         large( "body" + std::to_string( i ), std::string( 2048, 'x' ) + "\n\"quoted\" line\n" );
+      run( "large_object", iterations, fc::json::to_string( large ) );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,140 @@
+#include <steem/plugins/database_api/database_api_args.hpp>
+#include <steem/plugins/account_history_api/account_history_api.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <functional>
+#include <iostream>
+
+/*
+ * Compares JSON serialization of API responses through fc::variant against fc::json_writer.
+ *
+ *    json_writer_benchmark [iterations] [objects per response]
+ *
+ * Each payload is serialized the way json_rpc_plugin did before, fc::json::to_string( fc::variant( r ) ),
+ * and with fc::to_json_string( r, size_hint ), the hint being the size of the previous result:
+ *
+ *    list_comments      database_api comments with 2 KB bodies
+ *    list_accounts      database_api accounts
+ *    get_account_history   transfers and votes, the operations themselves still go through fc::variant
+ */
+
+using namespace steem::protocol;
+using namespace steem::plugins;
+
+void run( const std::string& name, uint32_t iterations, const std::function< std::string() >& variant_path,
+   const std::function< std::string( size_t ) >& writer_path )
+{
+   std::string expected = variant_path();
+   FC_ASSERT( writer_path( 0 ) == expected, "json_writer output of ${n} differs from the variant path", ("n", name) );
+
+   auto measure = [&]( const std::string& mode, const std::function< size_t() >& serialize )
+   {
+      uint64_t bytes = 0;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < iterations; ++i )
+         bytes += serialize();
+      auto elapsed = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+
+      std::cout << name << " " << mode << ": " << iterations << " responses of " << expected.size() << " bytes in "
+         << elapsed / 1000 << " ms, " << double( bytes ) / elapsed << " MB/sec\n";
+   };
+
+   measure( "variant", [&]() { return variant_path().size(); } );
+   measure( "json_writer", [&]() { return writer_path( expected.size() ).size(); } );
+}
+
+template< typename T >
+void run( const std::string& name, uint32_t iterations, const T& response )
+{
+   run( name, iterations,
+      [&]() { return fc::json::to_string( fc::variant( response ) ); },
+      [&]( size_t hint ) { return fc::to_json_string( response, hint ); } );
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t iterations = argc > 1 ? boost::lexical_cast< uint32_t >( argv[1] ) : 1000;
+      uint32_t objects = argc > 2 ? boost::lexical_cast< uint32_t >( argv[2] ) : 100;
+
+      database_api::list_comments_return comments;
+      for( uint32_t i = 0; i < objects; ++i )
+      {
+         database_api::api_comment_object c;
+         c.id = i;
+         c.author = "author" + std::to_string( i % 10 );
+         c.permlink = "a-post-about-the-number-" + std::to_string( i );
+         c.category = "steem";
+         c.parent_permlink = "steem";
+         c.title = "A post about the number " + std::to_string( i );
+         c.body = std::string( 2048, 'x' ) + "\n\"quoted\" line\n";
+         c.json_metadata = "{\"tags\":[\"steem\",\"benchmark\"],\"app\":\"steemit/0.1\"}";
+         c.net_rshares = int64_t( i ) << 34;
+         c.abs_rshares = int64_t( i ) << 34;
+         c.total_payout_value = asset( i, SBD_SYMBOL );
+         c.max_accepted_payout = asset( 1000000000, SBD_SYMBOL );
+         c.root_author = c.author;
+         c.root_permlink = c.permlink;
+         comments.comments.push_back( c );
+      }
+      run( "list_comments", iterations, comments );
+
+      database_api::list_accounts_return accounts;
+      for( uint32_t i = 0; i < objects; ++i )
+      {
+         database_api::api_account_object a;
+         a.id = i;
+         a.name = "account" + std::to_string( i );
+         a.json_metadata = "{\"profile\":{\"name\":\"Account " + std::to_string( i ) + "\",\"about\":\"benchmark\"}}";
+         a.balance = asset( int64_t( i ) * 1000, STEEM_SYMBOL );
+         a.vesting_shares = asset( int64_t( i ) << 36, VESTS_SYMBOL );
+         a.post_count = i;
+         accounts.accounts.push_back( a );
+      }
+      run( "list_accounts", iterations, accounts );
+
+      account_history::get_account_history_return history;
+      for( uint32_t i = 0; i < objects; ++i )
+      {
+         account_history::api_operation_object op;
+         op.block = 1000000 + i;
+         op.trx_in_block = i % 50;
+         op.timestamp = fc::time_point_sec( 1500000000 + 3 * i );
+
+         if( i % 2 )
+         {
+            transfer_operation t;
+            t.from = "alice";
+            t.to = "bob";
+            t.amount = asset( i, STEEM_SYMBOL );
+            t.memo = "payment " + std::to_string( i );
+            op.op = t;
+         }
+         else
+         {
+            vote_operation v;
+            v.voter = "alice";
+            v.author = "bob";
+            v.permlink = "a-post-about-the-number-" + std::to_string( i );
+            v.weight = STEEM_100_PERCENT;
+            op.op = v;
+         }
+
+         history.history[ i ] = op;
+      }
+      run( "get_account_history", iterations, history );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,82 @@
+#include <steem/chain/block_log.hpp>
+#include <steem/chain/replay_pipeline.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+
+/*
+ * Measures the stages of the replay pipeline that do not touch chain state.
+ *
+ *    replay_benchmark <path to block_log> [decode threads] [last block]
+ *
+ * Blocks are read and decoded exactly as during --replay-blockchain, but are discarded
+ * instead of being applied. The serial block_log::read_block() loop that replay uses
+ * when the pipeline is disabled is measured first as a baseline.
+ */
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      if( argc < 2 )
+      {
+         std::cerr << "Usage: " << argv[0] << " <block_log> [decode_threads] [last_block]\n";
+         return 1;
+      }
+
+      fc::path block_log_file( argv[1] );
+      uint32_t decode_threads = argc > 2 ? boost::lexical_cast< uint32_t >( argv[2] ) : 2;
+      uint32_t last_block = argc > 3 ? boost::lexical_cast< uint32_t >( argv[3] ) : 0;
+
+      uint32_t head_block = 0;
+      {
+         // Opening the log rebuilds a missing or stale index
+         steem::chain::block_log log;
+         log.open( block_log_file );
+         FC_ASSERT( log.head(), "Block log is empty" );
+         head_block = log.head()->block_num();
+
+         if( last_block == 0 || last_block > head_block )
+            last_block = head_block;
+
+         auto start = fc::time_point::now();
+         auto itr = log.read_block( log.get_block_pos( 1 ) );
+         while( itr.first.block_num() != last_block )
+         {
+            itr.first.id();
+            for( const auto& trx : itr.first.transactions )
+               trx.id();
+            itr = log.read_block( itr.second );
+         }
+         auto elapsed = fc::time_point::now() - start;
+
+         std::cout << "serial read_block(): " << last_block << " blocks in " << elapsed.count() / 1000 << " ms, "
+            << double( last_block ) * 1000000.0 / elapsed.count() << " blocks/sec\n";
+      }
+
+      steem::chain::replay_pipeline pipeline( block_log_file, 1, last_block, decode_threads );
+      while( !pipeline.done() )
+         pipeline.next();
+      pipeline.stop();
+
+      auto stats = pipeline.get_stats();
+      std::cout << "pipeline: " << last_block << " blocks in " << stats.elapsed_us / 1000 << " ms, "
+         << double( last_block ) * 1000000.0 / stats.elapsed_us << " blocks/sec\n"
+         << "   read stage:   " << stats.read.blocks_per_sec() << " blocks/sec\n"
+         << "   decode stage: " << stats.decode.blocks_per_sec() * decode_threads << " blocks/sec ("
+         << stats.decode.blocks_per_sec() << " per thread, " << decode_threads << " threads)\n"
+         << "   consumer waited " << stats.apply_wait_us / 1000 << " ms\n";
+      std::cout << fc::json::to_pretty_string( stats ) << "\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,159 @@
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/time.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/asio.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * HTTP load test for the webserver plugin of a running steemd.
+ *
+ *    rpc_load_test [host] [port] [connections] [pipeline depth] [seconds] [method]
+ *
+ * Each connection is kept alive and sends pipeline depth requests of method (by default
+ * database_api.get_dynamic_global_properties) before reading their responses, then repeats until
+ * the time is up. Requests per second, failed requests and the latency of a round of requests are
+ * reported. A depth of 1 measures keep-alive without pipelining.
+ *
+ *    steemd --webserver-http-endpoint=127.0.0.1:8090 --webserver-io-threads=4 &
+ *    rpc_load_test 127.0.0.1 8090 64 8 30
+ */
+
+namespace asio = boost::asio;
+using boost::asio::ip::tcp;
+
+struct load_stats
+{
+   std::atomic< uint64_t >    requests{ 0 };
+   std::atomic< uint64_t >    failures{ 0 };
+   std::mutex                 latency_mutex;
+   std::vector< int64_t >     latencies;
+};
+
+// Reads one response, returns false when the status is not 200
+bool read_response( tcp::socket& socket, asio::streambuf& in )
+{
+   size_t header_size = asio::read_until( socket, in, "\r\n\r\n" );
+   std::string head( asio::buffers_begin( in.data() ), asio::buffers_begin( in.data() ) + header_size );
+   in.consume( header_size );
+
+   size_t content_length = 0;
+   std::vector< std::string > lines;
+   boost::algorithm::split( lines, head, boost::algorithm::is_any_of( "\n" ) );
+   for( auto& line : lines )
+   {
+      boost::algorithm::trim( line );
+      if( boost::algorithm::istarts_with( line, "Content-Length:" ) )
+         content_length = boost::lexical_cast< size_t >( boost::algorithm::trim_copy( line.substr( 15 ) ) );
+   }
+
+   if( in.size() < content_length )
+      asio::read( socket, in, asio::transfer_exactly( content_length - in.size() ) );
+   in.consume( content_length );
+
+   return lines.size() > 0 && lines[0].find( " 200 " ) != std::string::npos;
+}
+
+void run_connection( const tcp::endpoint& endpoint, uint32_t depth, const std::string& request, fc::time_point end, load_stats& stats )
+{
+   asio::io_service ios;
+   tcp::socket socket( ios );
+   socket.connect( endpoint );
+   socket.set_option( tcp::no_delay( true ) );
+
+   std::string round;
+   for( uint32_t i = 0; i < depth; ++i )
+      round += request;
+
+   asio::streambuf in;
+   std::vector< int64_t > latencies;
+
+   while( fc::time_point::now() < end )
+   {
+      auto start = fc::time_point::now();
+      asio::write( socket, asio::buffer( round ) );
+
+      for( uint32_t i = 0; i < depth; ++i )
+      {
+         if( !read_response( socket, in ) )
+            stats.failures++;
+      }
+
+      latencies.push_back( ( fc::time_point::now() - start ).count() );
+      stats.requests += depth;
+   }
+
+   std::lock_guard< std::mutex > lock( stats.latency_mutex );
+   stats.latencies.insert( stats.latencies.end(), latencies.begin(), latencies.end() );
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+      uint16_t port = argc > 2 ? boost::lexical_cast< uint16_t >( argv[2] ) : 8090;
+      uint32_t connections = argc > 3 ? boost::lexical_cast< uint32_t >( argv[3] ) : 64;
+      uint32_t depth = argc > 4 ? boost::lexical_cast< uint32_t >( argv[4] ) : 8;
+      uint32_t seconds = argc > 5 ? boost::lexical_cast< uint32_t >( argv[5] ) : 30;
+      std::string method = argc > 6 ? argv[6] : "database_api.get_dynamic_global_properties";
+
+      FC_ASSERT( connections > 0 && depth > 0, "connections and pipeline depth must be greater than 0" );
+
+      std::string body = "{\"jsonrpc\":\"2.0\",\"method\":\"" + method + "\",\"params\":{},\"id\":1}";
+      std::string request = "POST / HTTP/1.1\r\nHost: " + host + "\r\nContent-Type: application/json\r\nContent-Length: "
+         + std::to_string( body.size() ) + "\r\n\r\n" + body;
+
+      tcp::endpoint endpoint( asio::ip::address::from_string( host ), port );
+      load_stats stats;
+      auto start = fc::time_point::now();
+      auto end = start + fc::seconds( seconds );
+
+      std::vector< std::thread > threads;
+      for( uint32_t i = 0; i < connections; ++i )
+      {
+         threads.emplace_back( [&]()
+         {
+            try
+            {
+               run_connection( endpoint, depth, request, end, stats );
+            }
+            catch( const std::exception& e )
+            {
+               elog( "connection failed: ${e}", ("e", e.what()) );
+            }
+         });
+      }
+
+      for( auto& t : threads )
+         t.join();
+
+      auto elapsed = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+      std::sort( stats.latencies.begin(), stats.latencies.end() );
+      auto percentile = [&]( double p ) -> int64_t
+      {
+         return stats.latencies.empty() ? 0 : stats.latencies[ size_t( p * ( stats.latencies.size() - 1 ) ) ];
+      };
+
+      std::cout << stats.requests.load() << " requests over " << connections << " connections, pipeline depth " << depth
+         << ", in " << elapsed / 1000 << " ms: " << double( stats.requests.load() ) * 1000000 / elapsed << " req/sec, "
+         << stats.failures.load() << " failed\n";
+      std::cout << "round latency p50 " << percentile( 0.5 ) << " us, p99 " << percentile( 0.99 ) << " us, max "
+         << percentile( 1.0 ) << " us\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
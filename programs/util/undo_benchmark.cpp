@@ -0,0 +1,116 @@
+#include <steem/chain/account_object.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+#include <random>
+
+/*
+ * Measures undo bookkeeping of an undo heavy block workload.
+ *
+ *    undo_benchmark [blocks] [transactions per block] [accounts modified per transaction] [accounts]
+ *
+ * Each block is an undo session holding one squashed session per transaction. A transaction modifies
+ * random account_objects and account_authority_objects, creates an account and removes an older one.
+ * Blocks are pushed and committed once they are 21 revisions old, like reversible blocks.
+ *
+ * For every block the benchmark reports the undo records logged and the shared segment allocations
+ * the undo logs made. The map and set based undo state this replaced allocated a node for every
+ * record and every created id, which is reported for comparison.
+ */
+
+using namespace steem::chain;
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t blocks = argc > 1 ? boost::lexical_cast< uint32_t >( argv[1] ) : 10000;
+      uint32_t trx_per_block = argc > 2 ? boost::lexical_cast< uint32_t >( argv[2] ) : 50;
+      uint32_t modified_per_trx = argc > 3 ? boost::lexical_cast< uint32_t >( argv[3] ) : 4;
+      uint32_t accounts = argc > 4 ? boost::lexical_cast< uint32_t >( argv[4] ) : 100000;
+
+      fc::temp_directory temp_dir( fc::temp_directory_path() );
+      chainbase::database db;
+      db.open( temp_dir.path(), 0, uint64_t( 2048 ) << 20 );
+      db.add_index< account_index >();
+      db.add_index< account_authority_index >();
+
+      uint64_t next_name = 0;
+      auto create_account = [&]()
+      {
+         std::string name = "a" + std::to_string( next_name++ );
+         db.create< account_object >( [&]( account_object& a ) { a.name = name; } );
+         db.create< account_authority_object >( [&]( account_authority_object& a )
+         {
+            a.account = name;
+            a.owner.weight_threshold = 1;
+            a.owner.add_authority( public_key_type(), 1 );
+         });
+      };
+
+      for( uint32_t i = 0; i < accounts; ++i )
+         create_account();
+
+      const auto& account_idx = db.get_index< account_index >();
+      const auto& authority_idx = db.get_index< account_authority_index >();
+      std::mt19937 rng( 0 );
+      uint64_t oldest = 0;
+      uint64_t creates = 0;
+
+      auto start = fc::time_point::now();
+      for( uint32_t b = 0; b < blocks; ++b )
+      {
+         auto block = db.start_undo_session();
+
+         for( uint32_t t = 0; t < trx_per_block; ++t )
+         {
+            auto trx = db.start_undo_session();
+            std::uniform_int_distribution< uint64_t > pick( oldest, next_name - 1 );
+
+            for( uint32_t m = 0; m < modified_per_trx; ++m )
+            {
+               auto id = pick( rng );
+               db.modify( db.get( account_object::id_type( id ) ), [&]( account_object& a ) { a.balance.amount += 1; } );
+               db.modify( db.get( account_authority_object::id_type( id ) ), [&]( account_authority_object& a )
+               {
+                  a.last_owner_update = fc::time_point_sec( b );
+               });
+            }
+
+            create_account();
+            db.remove( db.get( account_object::id_type( oldest ) ) );
+            db.remove( db.get( account_authority_object::id_type( oldest ) ) );
+            ++oldest;
+            creates += 2;
+
+            trx.squash();
+         }
+
+         block.push();
+         if( db.revision() > 21 )
+            db.commit( db.revision() - 21 );
+      }
+      auto elapsed = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+
+      uint64_t records = account_idx.get_undo_statistics().records + authority_idx.get_undo_statistics().records;
+      uint64_t allocations = account_idx.get_undo_statistics().allocations + authority_idx.get_undo_statistics().allocations;
+
+      std::cout << blocks << " blocks in " << elapsed / 1000 << " ms, " << double( blocks ) * 1000000.0 / elapsed << " blocks/sec\n"
+         << "undo records per block:              " << double( records ) / blocks << "\n"
+         << "undo log allocations per block:      " << double( allocations ) / blocks << "\n"
+         << "map/set undo node allocations/block: " << double( records + creates ) / blocks << "\n";
+
+      db.close();
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -336,10 +336,12 @@ using smt_database_fixture_for_plugin = t_smt_database_fixture< database_fixture
 struct json_rpc_database_fixture : public database_fixture
 {
    private:
+      void review_answer( fc::variant& answer, int64_t code, bool is_warning, bool is_fail, fc::optional< fc::variant > id );
+
+   protected:
       steem::plugins::json_rpc::json_rpc_plugin* rpc_plugin;
 
       fc::variant get_answer( std::string& request );
-      void review_answer( fc::variant& answer, int64_t code, bool is_warning, bool is_fail, fc::optional< fc::variant > id );
 
    public:
 
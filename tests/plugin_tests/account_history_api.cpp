@@ -0,0 +1,142 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+#include <steem/protocol/steem_operations.hpp>
+
+#include <steem/plugins/account_history/account_history_plugin.hpp>
+#include <steem/plugins/account_history_api/account_history_api_plugin.hpp>
+#include <steem/plugins/account_history_api/account_history_api.hpp>
+#include <steem/plugins/account_history_rocksdb/account_history_rocksdb_plugin.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+
+BOOST_FIXTURE_TEST_SUITE( account_history_api, database_fixture );
+
+BOOST_AUTO_TEST_CASE( filtered_history )
+{
+   using namespace steem::plugins::account_history;
+
+   try
+   {
+      appbase::app().register_plugin< account_history_plugin >();
+      appbase::app().register_plugin< account_history_api_plugin >();
+      db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+      init_account_pub_key = init_account_priv_key.get_public_key();
+
+      int test_argc = 1;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0] };
+
+      db_plugin->logging = false;
+      appbase::app().initialize<
+         account_history_plugin,
+         account_history_api_plugin,
+         steem::plugins::debug_node::debug_node_plugin >( test_argc, (char**)test_argv );
+
+      db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+      BOOST_REQUIRE( db );
+
+      auto& api = *appbase::app().get_plugin< account_history_api_plugin >().api;
+
+      open_database();
+
+      generate_block();
+      db->set_hardfork( STEEM_NUM_HARDFORKS );
+      generate_block();
+
+      ACTORS( (alice)(bob) );
+      fund( "alice", ASSET( "10000.000 TESTS" ) );
+      generate_block();
+
+      vest( "alice", "alice", ASSET( "1.000 TESTS" ) );
+      generate_block();
+      uint32_t vest_block = db->head_block_num();
+
+      const uint32_t transfer_count = 1100;
+      for( uint32_t i = 0; i < transfer_count; ++i )
+      {
+         transfer( "alice", "bob", ASSET( "0.001 TESTS" ) );
+         if( i % 100 == 99 )
+            generate_block();
+      }
+      generate_block();
+
+      const uint64_t transfer_filter = uint64_t( 1 ) << operation::tag< transfer_operation >::value;
+      const uint64_t vesting_filter = uint64_t( 1 ) << operation::tag< transfer_to_vesting_operation >::value;
+
+      BOOST_TEST_MESSAGE( "--- Unfiltered history still needs start above limit" );
+      STEEM_REQUIRE_THROW( api.get_account_history( { "alice", 5, 10 } ), fc::assert_exception );
+
+      auto all = api.get_account_history( { "alice", uint64_t( -1 ), 10000 } ).history;
+      BOOST_REQUIRE( all.size() > transfer_count + 1 );
+      uint32_t newest = all.rbegin()->first;
+
+      BOOST_TEST_MESSAGE( "--- Operation type filter" );
+      get_account_history_args args = { "alice", uint64_t( -1 ), 3 };
+      args.operation_filter_low = transfer_filter;
+      auto result = api.get_account_history( args );
+      BOOST_REQUIRE( result.history.size() == 3 );
+      BOOST_REQUIRE( !result.next_start.valid() );
+      BOOST_REQUIRE( result.history.begin()->first == newest - 2 );
+      for( const auto& entry : result.history )
+         BOOST_REQUIRE( entry.second.op.which() == operation::tag< transfer_operation >::value );
+
+      BOOST_TEST_MESSAGE( "--- Filtered history may start below limit" );
+      uint32_t vest_entry = 0;
+      for( const auto& entry : all )
+      {
+         if( entry.second.op.which() == operation::tag< transfer_to_vesting_operation >::value )
+            vest_entry = entry.first;
+      }
+      args = { "alice", vest_entry, vest_entry + 5 };
+      args.operation_filter_low = vesting_filter;
+      result = api.get_account_history( args );
+      BOOST_REQUIRE( result.history.size() == 1 );
+      BOOST_REQUIRE( result.history.begin()->first == vest_entry );
+
+      BOOST_TEST_MESSAGE( "--- Block range filter" );
+      args = { "alice", vest_entry + 10, 100 };
+      args.block_range_begin = vest_block;
+      args.block_range_end = vest_block + 1;
+      result = api.get_account_history( args );
+      BOOST_REQUIRE( result.history.size() == 1 );
+      BOOST_REQUIRE( result.history.begin()->first == vest_entry );
+      BOOST_REQUIRE( result.history.begin()->second.block == vest_block );
+      BOOST_REQUIRE( !result.next_start.valid() );
+
+      BOOST_TEST_MESSAGE( "--- Time range filter" );
+      args = { "alice", uint64_t( -1 ), 10 };
+      args.time_range_begin = all.rbegin()->second.timestamp;
+      result = api.get_account_history( args );
+      BOOST_REQUIRE( result.history.size() == 10 );
+      for( const auto& entry : result.history )
+         BOOST_REQUIRE( entry.second.timestamp >= *args.time_range_begin );
+
+      BOOST_TEST_MESSAGE( "--- Scan bounded per call, resumed from next_start" );
+      args = { "alice", uint64_t( -1 ), 1 };
+      args.operation_filter_low = vesting_filter;
+      result = api.get_account_history( args );
+      BOOST_REQUIRE( result.history.empty() );
+      BOOST_REQUIRE( result.next_start.valid() );
+      BOOST_REQUIRE( *result.next_start == newest - steem::plugins::account_history_rocksdb::account_history_filter::scan_limit( 1 ) );
+
+      uint32_t calls = 1;
+      while( result.history.empty() && result.next_start.valid() )
+      {
+         args.start = *result.next_start;
+         result = api.get_account_history( args );
+         ++calls;
+      }
+
+      BOOST_REQUIRE( calls == 2 );
+      BOOST_REQUIRE( result.history.size() == 1 );
+      BOOST_REQUIRE( result.history.begin()->first == vest_entry );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -0,0 +1,475 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+#include <steem/protocol/steem_operations.hpp>
+
+#include <steem/plugins/account_history_rocksdb/account_history_rocksdb_plugin.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using namespace steem::plugins::account_history_rocksdb;
+
+typedef std::vector< std::pair< uint32_t, rocksdb_operation_object > > history_t;
+
+/// Entries summarized by one account history chunk, ACCOUNT_HISTORY_CHUNK_SIZE of the plugin
+static const uint32_t chunk_size = 1000;
+
+static history_t get_history( const account_history_rocksdb_plugin& ah, const account_name_type& name, uint64_t start,
+   uint32_t limit, const account_history_filter& filter = account_history_filter() )
+{
+   history_t history;
+   ah.find_account_history_data( name, start, limit, filter,
+      [&]( unsigned int entry, const rocksdb_operation_object& op )
+      {
+         history.emplace_back( entry, op );
+      } );
+   return history;
+}
+
+static bool same_history( const history_t& a, const history_t& b )
+{
+   if( a.size() != b.size() )
+      return false;
+
+   for( size_t i = 0; i < a.size(); ++i )
+   {
+      if( a[i].first != b[i].first || a[i].second.block != b[i].second.block ||
+          a[i].second.trx_in_block != b[i].second.trx_in_block || a[i].second.op_in_trx != b[i].second.op_in_trx ||
+          a[i].second.serialized_op != b[i].second.serialized_op )
+         return false;
+   }
+
+   return true;
+}
+
+/// Reads limit matching entries back from start, resuming from next_start like an API client
+static history_t get_filtered_history( const account_history_rocksdb_plugin& ah, const account_name_type& name, uint64_t start,
+   uint32_t limit, const account_history_filter& filter, uint32_t* calls )
+{
+   history_t history;
+   fc::optional< uint64_t > next_start = start;
+   *calls = 0;
+
+   while( next_start.valid() && history.size() < limit )
+   {
+      ++*calls;
+      next_start = ah.find_account_history_data( name, *next_start, limit - history.size(), filter,
+         [&]( unsigned int entry, const rocksdb_operation_object& op )
+         {
+            history.emplace_back( entry, op );
+         } );
+   }
+
+   return history;
+}
+
+/// The filtered history read from the complete, newest first, history of an account
+static history_t brute_force_filter( const history_t& all, uint64_t start, uint32_t limit, const account_history_filter& filter )
+{
+   history_t history;
+   for( const auto& entry : all )
+   {
+      if( history.size() == limit )
+         break;
+      if( entry.first > start )
+         continue;
+
+      auto type = fc::raw::unpack_from_buffer< operation >( entry.second.serialized_op ).which();
+      if( filter.matches( type, entry.second.block, entry.second.timestamp ) )
+         history.push_back( entry );
+   }
+   return history;
+}
+
+/// Writes a block log without account history, then imports it into new account_history_rocksdb storages
+struct block_log_import_fixture : public database_fixture
+{
+   fc::temp_directory   app_dir;
+   std::string          app_path;
+   database::open_args  args;
+
+   block_log_import_fixture() : app_dir( steem::utilities::temp_directory_path() ), app_path( app_dir.path().string() )
+   {
+      args.data_dir = app_dir.path() / "blockchain";
+      args.shared_mem_dir = args.data_dir;
+      args.initial_supply = INITIAL_TEST_SUPPLY;
+      args.shared_file_size = 1024 * 1024 * 32;
+   }
+
+   /// Opens a new chain in app_dir at the latest hardfork
+   void open_chain()
+   {
+      db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+      init_account_pub_key = init_account_priv_key.get_public_key();
+
+      int test_argc = 3;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0], "-d", app_path.c_str() };
+
+      db_plugin->logging = false;
+      appbase::app().initialize< steem::plugins::debug_node::debug_node_plugin >( test_argc, (char**)test_argv );
+
+      db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+      db->_log_hardforks = false;
+      db->open( args );
+
+      generate_block();
+      db->set_hardfork( STEEM_NUM_HARDFORKS );
+      generate_block();
+   }
+
+   /// Makes the generated blocks irreversible, so they are in the block log, and closes the chain
+   void close_chain()
+   {
+      generate_blocks( STEEM_MAX_WITNESSES + 1 );
+      db->close();
+      appbase::reset();
+   }
+
+   /// Reopens the chain, with account_history_rocksdb importing the block log into storage
+   account_history_rocksdb_plugin& import( const char* storage, const char* threads )
+   {
+      appbase::app().register_plugin< account_history_rocksdb_plugin >();
+      db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+
+      int test_argc = 9;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0],
+                                  "-d", app_path.c_str(),
+                                  "--account-history-rocksdb-path", storage,
+                                  "--account-history-rocksdb-immediate-import",
+                                  "--account-history-rocksdb-import-threads", threads,
+                                  "--account-history-rocksdb-writer-queue-size=0" };
+
+      db_plugin->logging = false;
+      appbase::app().initialize<
+         account_history_rocksdb_plugin,
+         steem::plugins::debug_node::debug_node_plugin >( test_argc, (char**)test_argv );
+
+      db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+      db->open( args );
+
+      auto& ah = appbase::app().get_plugin< account_history_rocksdb_plugin >();
+      ah.plugin_startup();
+      return ah;
+   }
+
+   void close_import( account_history_rocksdb_plugin& ah )
+   {
+      ah.plugin_shutdown();
+      db->close();
+      appbase::reset();
+   }
+};
+
+BOOST_FIXTURE_TEST_SUITE( account_history_rocksdb, database_fixture );
+
+BOOST_AUTO_TEST_CASE( queued_history )
+{
+   try
+   {
+      fc::temp_directory storage_dir( steem::utilities::temp_directory_path() );
+      std::string storage_path = storage_dir.path().string();
+
+      appbase::app().register_plugin< account_history_rocksdb_plugin >();
+      db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+      init_account_pub_key = init_account_priv_key.get_public_key();
+
+      int test_argc = 5;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0],
+                                  "--account-history-rocksdb-path",
+                                  storage_path.c_str(),
+                                  "--account-history-rocksdb-writer-queue-size",
+                                  "100" };
+
+      db_plugin->logging = false;
+      appbase::app().initialize<
+         account_history_rocksdb_plugin,
+         steem::plugins::debug_node::debug_node_plugin >( test_argc, (char**)test_argv );
+
+      db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+      BOOST_REQUIRE( db );
+
+      auto& ah = appbase::app().get_plugin< account_history_rocksdb_plugin >();
+
+      open_database();
+      ah.plugin_startup();
+
+      generate_block();
+      db->set_hardfork( STEEM_NUM_HARDFORKS );
+      generate_block();
+
+      ACTORS( (alice)(bob) );
+      fund( "alice", ASSET( "1000.000 TESTS" ) );
+      generate_blocks( STEEM_MAX_WITNESSES + 1 );
+
+      ah.hold_writer( false );
+      history_t stored = get_history( ah, "alice", std::numeric_limits< uint64_t >::max(), 1000 );
+      BOOST_REQUIRE( stored.size() > 0 );
+
+      BOOST_TEST_MESSAGE( "--- Irreversible blocks held in the writer queue" );
+      ah.hold_writer( true );
+
+      for( int i = 0; i < 5; ++i )
+      {
+         transfer( "alice", "bob", ASSET( "1.000 TESTS" ) );
+         generate_block();
+      }
+
+      generate_blocks( STEEM_MAX_WITNESSES + 1 );
+      BOOST_REQUIRE( db->get_dynamic_global_properties().last_irreversible_block_num > stored.front().second.block + 5 );
+
+      history_t queued = get_history( ah, "alice", std::numeric_limits< uint64_t >::max(), 1000 );
+      BOOST_REQUIRE( queued.size() == stored.size() + 5 );
+
+      for( size_t i = 0; i < queued.size(); ++i )
+         BOOST_REQUIRE( queued[i].first == queued.size() - 1 - i );
+
+      for( size_t i = 0; i < 5; ++i )
+      {
+         auto op = fc::raw::unpack_from_buffer< operation >( queued[i].second.serialized_op );
+         BOOST_REQUIRE( op.which() == operation::tag< transfer_operation >::value );
+         BOOST_REQUIRE( op.get< transfer_operation >().to == "bob" );
+      }
+
+      BOOST_REQUIRE( same_history( history_t( queued.begin() + 5, queued.end() ), stored ) );
+
+      BOOST_TEST_MESSAGE( "--- Page across the queued and the stored entries" );
+      uint32_t newest = queued.front().first;
+      history_t page = get_history( ah, "alice", newest - 3, 3 );
+      BOOST_REQUIRE( same_history( page, history_t( queued.begin() + 3, queued.begin() + 7 ) ) );
+
+      BOOST_TEST_MESSAGE( "--- Filtered read of the queue" );
+      account_history_filter filter;
+      filter.operation_filter_low = uint64_t( 1 ) << operation::tag< transfer_operation >::value;
+      history_t transfers = get_history( ah, "alice", std::numeric_limits< uint64_t >::max(), 3, filter );
+      BOOST_REQUIRE( same_history( transfers, history_t( queued.begin(), queued.begin() + 3 ) ) );
+
+      BOOST_TEST_MESSAGE( "--- Same history once written" );
+      ah.hold_writer( false );
+      history_t written = get_history( ah, "alice", std::numeric_limits< uint64_t >::max(), 1000 );
+      BOOST_REQUIRE( same_history( written, queued ) );
+
+      ah.plugin_shutdown();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( parallel_import, block_log_import_fixture )
+{
+   try
+   {
+      struct storage_contents
+      {
+         std::vector< rocksdb_operation_object > ops_by_block;
+         std::map< account_name_type, history_t > histories;
+      };
+
+      /// Imports the block log into a new storage and reads back all of its operations and account histories.
+      auto import_contents = [&]( const char* storage, const char* threads, storage_contents* contents )
+      {
+         auto begin = fc::time_point::now();
+         auto& ah = import( storage, threads );
+         BOOST_TEST_MESSAGE( std::string( "Import on " ) + threads + " threads: " +
+            std::to_string( ( fc::time_point::now() - begin ).count() / 1000 ) + " ms" );
+
+         for( uint32_t block = 1; block <= db->head_block_num(); ++block )
+         {
+            ah.find_operations_by_block( block, [&]( const rocksdb_operation_object& op )
+            {
+               contents->ops_by_block.push_back( op );
+            } );
+         }
+
+         const auto& accounts = db->get_index< account_index, by_name >();
+         for( const auto& account : accounts )
+            contents->histories[ account.name ] = get_history( ah, account.name, std::numeric_limits< uint64_t >::max(), 1000000 );
+
+         close_import( ah );
+      };
+
+      BOOST_TEST_MESSAGE( "--- Block log spanning several import chunks" );
+      open_chain();
+
+      ACTORS( (alice)(bob)(carol) );
+      fund( "alice", ASSET( "1000.000 TESTS" ) );
+      fund( "bob", ASSET( "1000.000 TESTS" ) );
+
+      for( int i = 0; i < 12; ++i )
+      {
+         transfer( "alice", "bob", ASSET( "1.000 TESTS" ) );
+         transfer( "bob", "carol", ASSET( "1.000 TESTS" ) );
+         vest( "alice", "carol", ASSET( "1.000 TESTS" ) );
+         generate_blocks( 100 );
+      }
+
+      close_chain();
+
+      storage_contents sequential;
+      storage_contents parallel;
+      import_contents( "ah-sequential", "0", &sequential );
+      import_contents( "ah-parallel", "4", &parallel );
+
+      BOOST_TEST_MESSAGE( "--- Same operations by block" );
+      BOOST_REQUIRE( sequential.ops_by_block.size() > 36 );
+      BOOST_REQUIRE( sequential.ops_by_block.size() == parallel.ops_by_block.size() );
+      for( size_t i = 0; i < sequential.ops_by_block.size(); ++i )
+      {
+         const auto& s = sequential.ops_by_block[i];
+         const auto& p = parallel.ops_by_block[i];
+         BOOST_REQUIRE( s.id == p.id );
+         BOOST_REQUIRE( s.trx_id == p.trx_id );
+         BOOST_REQUIRE( s.block == p.block );
+         BOOST_REQUIRE( s.trx_in_block == p.trx_in_block );
+         BOOST_REQUIRE( s.op_in_trx == p.op_in_trx );
+         BOOST_REQUIRE( s.timestamp == p.timestamp );
+         BOOST_REQUIRE( s.serialized_op == p.serialized_op );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Same account histories" );
+      BOOST_REQUIRE( sequential.histories.size() == parallel.histories.size() );
+      BOOST_REQUIRE( sequential.histories[ "carol" ].size() > 24 );
+      for( const auto& history : sequential.histories )
+      {
+         const auto& other = parallel.histories[ history.first ];
+         BOOST_REQUIRE( same_history( history.second, other ) );
+         for( size_t i = 0; i < other.size(); ++i )
+            BOOST_REQUIRE( history.second[i].second.id == other[i].second.id );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( chunk_filters, block_log_import_fixture )
+{
+   try
+   {
+      const uint64_t max_start = std::numeric_limits< uint64_t >::max();
+      const uint32_t savings_type = operation::tag< transfer_to_savings_operation >::value;
+      const uint32_t transfer_type = operation::tag< transfer_operation >::value;
+
+      BOOST_TEST_MESSAGE( "--- History of several chunks, savings only in a middle chunk and in the open one" );
+      open_chain();
+
+      ACTORS( (alice)(bob) );
+      fund( "alice", ASSET( "10000.000 TESTS" ) );
+      generate_block();
+
+      auto transfers = [&]( uint32_t count )
+      {
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            transfer( "alice", "bob", asset( i % 1000 + 1, STEEM_SYMBOL ) );
+            if( i % 10 == 9 )
+               generate_block();
+         }
+         generate_block();
+      };
+
+      /// No fixture helper creates this operation type, so it is only where the test puts it
+      auto save = [&]()
+      {
+         transfer_to_savings_operation op;
+         op.from = "alice";
+         op.to = "alice";
+         op.amount = ASSET( "1.000 TESTS" );
+         trx.operations.push_back( op );
+         trx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+         db->push_transaction( trx, ~0 );
+         trx.clear();
+      };
+
+      transfers( 1295 );
+      for( int i = 0; i < 3; ++i )
+         save();
+      generate_block();
+      uint32_t save_block = db->head_block_num();
+      fc::time_point_sec save_time = db->head_block_time();
+
+      transfers( 2200 );
+      save();
+      generate_block();
+
+      close_chain();
+
+      auto check_filters = [&]( const account_history_rocksdb_plugin& ah )
+      {
+         history_t all = get_history( ah, "alice", max_start, 1000000 );
+         BOOST_REQUIRE( all.front().first == all.size() - 1 );
+         BOOST_REQUIRE( all.size() / chunk_size == 3 );
+
+         account_history_filter filter;
+         uint32_t calls = 0;
+
+         BOOST_TEST_MESSAGE( "--- Type filter skips the chunks without the type, resuming from next_start" );
+         filter.operation_filter_low = uint64_t( 1 ) << savings_type;
+         history_t savings = get_filtered_history( ah, "alice", max_start, 10, filter, &calls );
+         BOOST_REQUIRE( same_history( savings, brute_force_filter( all, max_start, 10, filter ) ) );
+         BOOST_REQUIRE( savings.size() == 4 );
+         BOOST_REQUIRE( savings[0].first / chunk_size == 3 );
+         for( size_t i = 1; i < savings.size(); ++i )
+            BOOST_REQUIRE( savings[i].first / chunk_size == 1 );
+         // The open chunk and the end of chunk 1 fill the first scan, the rest of chunk 1 the second. Reading
+         // chunks 0 and 2 would take two more.
+         BOOST_REQUIRE( calls == 2 );
+
+         BOOST_TEST_MESSAGE( "--- Type filter starting in a skipped chunk" );
+         uint64_t middle = 2 * chunk_size + chunk_size / 2;
+         history_t page = get_filtered_history( ah, "alice", middle, 2, filter, &calls );
+         BOOST_REQUIRE( same_history( page, brute_force_filter( all, middle, 2, filter ) ) );
+         BOOST_REQUIRE( page.size() == 2 );
+         BOOST_REQUIRE( calls == 1 );
+
+         BOOST_TEST_MESSAGE( "--- Block range skips the later chunks" );
+         filter = account_history_filter();
+         filter.block_range_begin = save_block;
+         filter.block_range_end = save_block + 1;
+         history_t in_block = get_filtered_history( ah, "alice", max_start, 100, filter, &calls );
+         BOOST_REQUIRE( same_history( in_block, brute_force_filter( all, max_start, 100, filter ) ) );
+         BOOST_REQUIRE( in_block.size() == 3 );
+         BOOST_REQUIRE( calls == 1 );
+
+         BOOST_TEST_MESSAGE( "--- Time range skips the later chunks" );
+         filter = account_history_filter();
+         filter.time_range_begin = save_time;
+         filter.time_range_end = save_time + STEEM_BLOCK_INTERVAL;
+         history_t in_time = get_filtered_history( ah, "alice", max_start, 100, filter, &calls );
+         BOOST_REQUIRE( same_history( in_time, in_block ) );
+         BOOST_REQUIRE( calls == 1 );
+
+         BOOST_TEST_MESSAGE( "--- Type and block range together" );
+         filter.time_range_begin = fc::time_point_sec();
+         filter.time_range_end = fc::time_point_sec();
+         filter.operation_filter_low = uint64_t( 1 ) << transfer_type;
+         filter.block_range_begin = save_block - 20;
+         filter.block_range_end = save_block + 20;
+         history_t around = get_filtered_history( ah, "alice", max_start, 1000, filter, &calls );
+         BOOST_REQUIRE( same_history( around, brute_force_filter( all, max_start, 1000, filter ) ) );
+         BOOST_REQUIRE( around.size() > 300 );
+
+         BOOST_TEST_MESSAGE( "--- Common type from the open chunk" );
+         filter = account_history_filter();
+         filter.operation_filter_low = uint64_t( 1 ) << transfer_type;
+         history_t latest = get_filtered_history( ah, "alice", max_start, 5, filter, &calls );
+         BOOST_REQUIRE( same_history( latest, brute_force_filter( all, max_start, 5, filter ) ) );
+         BOOST_REQUIRE( latest.size() == 5 );
+      };
+
+      BOOST_TEST_MESSAGE( "--- Chunk summaries written per operation" );
+      auto& sequential = import( "ah-sequential", "0" );
+      check_filters( sequential );
+      close_import( sequential );
+
+      BOOST_TEST_MESSAGE( "--- Chunk summaries merged by the parallel import, completed chunks and the open one" );
+      auto& parallel = import( "ah-parallel", "4" );
+      check_filters( parallel );
+      close_import( parallel );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
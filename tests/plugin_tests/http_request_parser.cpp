@@ -0,0 +1,167 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/plugins/webserver/http_request_parser.hpp>
+
+using namespace steem::plugins::webserver;
+
+namespace
+{
+   void append( http_request_parser& parser, const std::string& text )
+   {
+      parser.append( text.data(), text.size() );
+   }
+
+   std::string post( const std::string& body, const std::string& headers = "", const std::string& version = "HTTP/1.1" )
+   {
+      return "POST / " + version + "\r\nHost: localhost\r\nContent-Length: " + std::to_string( body.size() ) + "\r\n" + headers + "\r\n" + body;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE( http_request_parser_tests )
+
+BOOST_AUTO_TEST_CASE( keep_alive )
+{
+   http_request_parser parser( false );
+   http_request request;
+
+   BOOST_TEST_MESSAGE( "--- HTTP/1.1 keeps the connection by default" );
+   append( parser, post( "{}" ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( request.body == "{}" );
+   BOOST_REQUIRE( request.keep_alive );
+   BOOST_REQUIRE( !request.binary );
+
+   BOOST_TEST_MESSAGE( "--- Connection: close" );
+   append( parser, post( "{}", "Connection: close\r\n" ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( !request.keep_alive );
+
+   BOOST_TEST_MESSAGE( "--- HTTP/1.0 closes by default" );
+   append( parser, post( "{}", "", "HTTP/1.0" ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( !request.keep_alive );
+
+   BOOST_TEST_MESSAGE( "--- HTTP/1.0 with Connection: keep-alive" );
+   append( parser, post( "{}", "Connection: Keep-Alive\r\n", "HTTP/1.0" ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( request.keep_alive );
+
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::need_more );
+}
+
+BOOST_AUTO_TEST_CASE( pipelining )
+{
+   http_request_parser parser( false );
+   http_request request;
+
+   std::string first = post( "{\"id\":1}" );
+   std::string second = post( "{\"id\":2}" );
+   std::string third = post( "{\"id\":3}", "Connection: close\r\n" );
+
+   BOOST_TEST_MESSAGE( "--- Requests in one read, the last one split" );
+   append( parser, first + second + third.substr( 0, 20 ) );
+
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( request.body == "{\"id\":1}" );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( request.body == "{\"id\":2}" );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::need_more );
+
+   append( parser, third.substr( 20, third.size() - 21 ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::need_more );
+
+   append( parser, third.substr( third.size() - 1 ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( request.body == "{\"id\":3}" );
+   BOOST_REQUIRE( !request.keep_alive );
+}
+
+BOOST_AUTO_TEST_CASE( expect_continue )
+{
+   http_request_parser parser( false );
+   http_request request;
+
+   std::string text = post( "{\"id\":1}", "Expect: 100-continue\r\n" );
+   size_t header_size = text.find( "\r\n\r\n" ) + 4;
+
+   append( parser, text.substr( 0, header_size ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::send_continue );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::need_more );
+
+   append( parser, text.substr( header_size ) );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+   BOOST_REQUIRE( request.body == "{\"id\":1}" );
+
+   BOOST_TEST_MESSAGE( "--- No 100 Continue when the body came with the header" );
+   append( parser, text );
+   BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+}
+
+BOOST_AUTO_TEST_CASE( errors )
+{
+   http_request request;
+
+   BOOST_TEST_MESSAGE( "--- Oversized header" );
+   {
+      http_request_parser parser( false );
+      append( parser, "POST / HTTP/1.1\r\nX-Padding: " + std::string( STEEM_WEBSERVER_MAX_HEADER_SIZE, 'a' ) );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::error );
+      BOOST_REQUIRE( parser.error_status() == 431 );
+   }
+
+   BOOST_TEST_MESSAGE( "--- Header below the limit is waited for" );
+   {
+      http_request_parser parser( false );
+      append( parser, "POST / HTTP/1.1\r\nX-Padding: " + std::string( 1024, 'a' ) );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::need_more );
+   }
+
+   BOOST_TEST_MESSAGE( "--- Oversized body" );
+   {
+      http_request_parser parser( false );
+      append( parser, "POST / HTTP/1.1\r\nContent-Length: " + std::to_string( STEEM_WEBSERVER_MAX_BODY_SIZE + 1 ) + "\r\n\r\n" );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::error );
+      BOOST_REQUIRE( parser.error_status() == 413 );
+   }
+
+   BOOST_TEST_MESSAGE( "--- Chunked transfer encoding" );
+   {
+      http_request_parser parser( false );
+      append( parser, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n" );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::error );
+      BOOST_REQUIRE( parser.error_status() == 411 );
+   }
+
+   BOOST_TEST_MESSAGE( "--- Malformed request line and header" );
+   {
+      http_request_parser parser( false );
+      append( parser, "garbage\r\n\r\n" );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::error );
+      BOOST_REQUIRE( parser.error_status() == 400 );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::error );
+   }
+   {
+      http_request_parser parser( false );
+      append( parser, "POST / HTTP/1.1\r\nno colon\r\n\r\n" );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::error );
+      BOOST_REQUIRE( parser.error_status() == 400 );
+   }
+
+   BOOST_TEST_MESSAGE( "--- Binary requests only when enabled" );
+   {
+      http_request_parser parser( false );
+      append( parser, "POST /binary HTTP/1.1\r\nContent-Length: 0\r\n\r\n" );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::error );
+      BOOST_REQUIRE( parser.error_status() == 404 );
+   }
+   {
+      http_request_parser parser( true );
+      append( parser, "POST /binary HTTP/1.1\r\nContent-Length: 0\r\n\r\n" );
+      BOOST_REQUIRE( parser.next( request ) == http_request_parser::request_ready );
+      BOOST_REQUIRE( request.binary );
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -0,0 +1,214 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+#include <steem/protocol/steem_operations.hpp>
+
+#include <steem/plugins/account_history/account_history_plugin.hpp>
+#include <steem/plugins/account_history_api/account_history_api_plugin.hpp>
+#include <steem/plugins/account_history_api/account_history_api.hpp>
+#include <steem/plugins/account_history_rocksdb/account_history_rocksdb_plugin.hpp>
+#include <steem/plugins/block_api/block_api_plugin.hpp>
+#include <steem/plugins/block_api/block_api.hpp>
+#include <steem/plugins/condenser_api/condenser_api_plugin.hpp>
+#include <steem/plugins/condenser_api/condenser_api.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include <future>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using steem::plugins::condenser_api::condenser_api_plugin;
+
+/**
+ * Runs the call on another thread while this one holds the write lock. Returns false when the call
+ * gave up waiting for the read lock.
+ */
+template< typename Call >
+static bool served_without_lock( database& db, Call&& call )
+{
+   return db.with_write_lock( [&]()
+   {
+      return std::async( std::launch::async, [&]()
+      {
+         try
+         {
+            call();
+            return true;
+         }
+         catch( const chainbase::lock_exception& )
+         {
+            return false;
+         }
+      } ).get();
+   });
+}
+
+template< typename T >
+static std::string to_json( const T& value )
+{
+   return fc::json::to_string( fc::variant( value ) );
+}
+
+BOOST_FIXTURE_TEST_SUITE( irreversible_apis, database_fixture );
+
+BOOST_AUTO_TEST_CASE( chainbase_history )
+{
+   try
+   {
+      appbase::app().register_plugin< steem::plugins::account_history::account_history_plugin >();
+      appbase::app().register_plugin< steem::plugins::account_history::account_history_api_plugin >();
+      appbase::app().register_plugin< steem::plugins::block_api::block_api_plugin >();
+      appbase::app().register_plugin< condenser_api_plugin >();
+      db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+      init_account_pub_key = init_account_priv_key.get_public_key();
+
+      int test_argc = 1;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0] };
+
+      db_plugin->logging = false;
+      appbase::app().initialize<
+         steem::plugins::account_history::account_history_plugin,
+         steem::plugins::account_history::account_history_api_plugin,
+         steem::plugins::block_api::block_api_plugin,
+         condenser_api_plugin,
+         steem::plugins::debug_node::debug_node_plugin >( test_argc, (char**)test_argv );
+
+      db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+      BOOST_REQUIRE( db );
+
+      auto& block = *appbase::app().get_plugin< steem::plugins::block_api::block_api_plugin >().api;
+      auto& condenser = *appbase::app().get_plugin< condenser_api_plugin >().api;
+
+      open_database();
+      appbase::app().get_plugin< condenser_api_plugin >().plugin_startup();
+
+      generate_block();
+      db->set_hardfork( STEEM_NUM_HARDFORKS );
+      generate_block();
+
+      ACTORS( (alice)(bob) );
+      fund( "alice", ASSET( "1000.000 TESTS" ) );
+      transfer( "alice", "bob", ASSET( "1.000 TESTS" ) );
+      generate_block();
+      uint32_t transfer_block = db->head_block_num();
+
+      generate_blocks( STEEM_MAX_WITNESSES + 1 );
+      BOOST_REQUIRE( db->get_block_log().head_block_num() >= transfer_block );
+      BOOST_REQUIRE( db->get_block_log().head_block_num() < db->head_block_num() );
+
+      BOOST_TEST_MESSAGE( "--- Irreversible blocks are read from the block log" );
+      auto expected_block = block.get_block( { transfer_block }, true );
+      steem::plugins::block_api::get_block_return block_result;
+      BOOST_REQUIRE( served_without_lock( *db, [&]() { block_result = block.get_block( { transfer_block }, true ); } ) );
+      BOOST_REQUIRE( block_result.block.valid() );
+      BOOST_REQUIRE( to_json( block_result ) == to_json( expected_block ) );
+
+      steem::plugins::block_api::get_block_header_return header_result;
+      BOOST_REQUIRE( served_without_lock( *db, [&]() { header_result = block.get_block_header( { transfer_block }, true ); } ) );
+      BOOST_REQUIRE( header_result.header.valid() );
+      BOOST_REQUIRE( header_result.header->previous == expected_block.block->previous );
+
+      auto expected_legacy_block = condenser.get_block( { fc::variant( transfer_block ) }, true );
+      steem::plugins::condenser_api::get_block_return legacy_block_result;
+      BOOST_REQUIRE( served_without_lock( *db, [&]() { legacy_block_result = condenser.get_block( { fc::variant( transfer_block ) }, true ); } ) );
+      BOOST_REQUIRE( to_json( legacy_block_result ) == to_json( expected_legacy_block ) );
+
+      BOOST_TEST_MESSAGE( "--- Reversible blocks wait for the read lock" );
+      uint32_t head = db->head_block_num();
+      BOOST_REQUIRE( !served_without_lock( *db, [&]() { block.get_block( { head }, true ); } ) );
+      BOOST_REQUIRE( !served_without_lock( *db, [&]() { condenser.get_block_header( { fc::variant( head ) }, true ); } ) );
+      BOOST_REQUIRE( block.get_block( { head }, true ).block.valid() );
+
+      BOOST_TEST_MESSAGE( "--- Chainbase account history always waits for the read lock" );
+      BOOST_REQUIRE( !appbase::app().get_plugin< steem::plugins::account_history::account_history_api_plugin >().api->is_lock_free() );
+      BOOST_REQUIRE( !served_without_lock( *db, [&]()
+      {
+         condenser.get_ops_in_block( { fc::variant( transfer_block ), fc::variant( false ) }, true );
+      } ) );
+      BOOST_REQUIRE( condenser.get_ops_in_block( { fc::variant( transfer_block ), fc::variant( false ) }, true ).size() > 0 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( rocksdb_history )
+{
+   try
+   {
+      fc::temp_directory storage_dir( steem::utilities::temp_directory_path() );
+      std::string storage_path = storage_dir.path().string();
+
+      appbase::app().register_plugin< steem::plugins::account_history_rocksdb::account_history_rocksdb_plugin >();
+      appbase::app().register_plugin< steem::plugins::account_history::account_history_api_plugin >();
+      appbase::app().register_plugin< steem::plugins::block_api::block_api_plugin >();
+      appbase::app().register_plugin< condenser_api_plugin >();
+      db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+      init_account_pub_key = init_account_priv_key.get_public_key();
+
+      int test_argc = 3;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0],
+                                  "--account-history-rocksdb-path",
+                                  storage_path.c_str() };
+
+      db_plugin->logging = false;
+      appbase::app().initialize<
+         steem::plugins::account_history_rocksdb::account_history_rocksdb_plugin,
+         steem::plugins::account_history::account_history_api_plugin,
+         steem::plugins::block_api::block_api_plugin,
+         condenser_api_plugin,
+         steem::plugins::debug_node::debug_node_plugin >( test_argc, (char**)test_argv );
+
+      db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+      BOOST_REQUIRE( db );
+
+      auto& ah = appbase::app().get_plugin< steem::plugins::account_history_rocksdb::account_history_rocksdb_plugin >();
+      auto& condenser = *appbase::app().get_plugin< condenser_api_plugin >().api;
+
+      open_database();
+      ah.plugin_startup();
+      appbase::app().get_plugin< condenser_api_plugin >().plugin_startup();
+
+      generate_block();
+      db->set_hardfork( STEEM_NUM_HARDFORKS );
+      generate_block();
+
+      ACTORS( (alice)(bob) );
+      fund( "alice", ASSET( "1000.000 TESTS" ) );
+      transfer( "alice", "bob", ASSET( "1.000 TESTS" ) );
+      generate_block();
+      uint32_t transfer_block = db->head_block_num();
+
+      generate_blocks( STEEM_MAX_WITNESSES + 1 );
+      BOOST_REQUIRE( db->get_block_log().head_block_num() >= transfer_block );
+
+      BOOST_TEST_MESSAGE( "--- Irreversible operations are read from account_history_rocksdb" );
+      BOOST_REQUIRE( appbase::app().get_plugin< steem::plugins::account_history::account_history_api_plugin >().api->is_lock_free() );
+
+      steem::plugins::condenser_api::get_ops_in_block_args args = { fc::variant( transfer_block ), fc::variant( false ) };
+      auto expected = condenser.get_ops_in_block( args, true );
+      steem::plugins::condenser_api::get_ops_in_block_return result;
+      BOOST_REQUIRE( served_without_lock( *db, [&]() { result = condenser.get_ops_in_block( args, true ); } ) );
+      BOOST_REQUIRE( to_json( result ) == to_json( expected ) );
+
+      bool found_transfer = false;
+      for( const auto& op : result )
+         found_transfer |= op.op.which() == steem::plugins::condenser_api::legacy_operation::tag< steem::plugins::condenser_api::legacy_transfer_operation >::value;
+      BOOST_REQUIRE( found_transfer );
+
+      BOOST_TEST_MESSAGE( "--- Reversible operations wait for the read lock" );
+      uint32_t head = db->head_block_num();
+      BOOST_REQUIRE( !served_without_lock( *db, [&]()
+      {
+         condenser.get_ops_in_block( { fc::variant( head ), fc::variant( false ) }, true );
+      } ) );
+
+      ah.plugin_shutdown();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -1,10 +1,13 @@
 #ifdef IS_TEST_NET
+#include <steem/chain/steem_fwd.hpp>
+
 #include <boost/test/unit_test.hpp>
 
 #include <steem/chain/account_object.hpp>
 #include <steem/chain/comment_object.hpp>
 #include <steem/protocol/steem_operations.hpp>
 #include <steem/plugins/json_rpc/json_rpc_plugin.hpp>
+#include <steem/plugins/database_api/database_api_args.hpp>
 
 #include "../db_fixture/database_fixture.hpp"
 
@@ -287,6 +290,15 @@ BOOST_AUTO_TEST_CASE( positive_validation )
 
       request = "{\"jsonrpc\": \"2.0\", \"method\": \"block_api.get_block\", \"params\": {\"block_num\":0}, \"id\": 11}";
       make_positive_request( request );
+
+      request = "{\"jsonrpc\": \"2.0\", \"method\": \"block_api.get_block_range\", \"params\": {\"starting_block_num\":1, \"count\":10}, \"id\": 12}";
+      make_positive_request( request );
+
+      request = "{\"jsonrpc\": \"2.0\", \"method\": \"call\", \"params\": [\"block_api\",\"get_block_range\", {\"starting_block_num\":1000000, \"count\":10} ], \"id\": 13}";
+      make_positive_request( request );
+
+      request = "{\"jsonrpc\": \"2.0\", \"method\": \"block_api.get_block_range\", \"params\": {\"starting_block_num\":1, \"count\":1001}, \"id\": 14}";
+      make_request( request, JSON_RPC_ERROR_DURING_CALL );
    }
    FC_LOG_AND_RETHROW()
 }
@@ -312,5 +324,139 @@ BOOST_AUTO_TEST_CASE( semantics_validation )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( batch_validation )
+{
+   try
+   {
+      // Starting the plugin starts the pool that processes batches concurrently
+      rpc_plugin->plugin_startup();
+
+      std::string request = "[";
+      for( int i = 0; i < 100; ++i )
+      {
+         if( i )
+            request += ",";
+
+         if( i % 3 == 0 )
+            request += "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":{\"accounts\":[\"initminer\"]}, \"id\":" + std::to_string( i ) + "}";
+         else if( i % 3 == 1 )
+            request += "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block\", \"params\":{\"block_num\":1}, \"id\":" + std::to_string( i ) + "}";
+         else
+            request += "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.no_such_method\", \"id\":" + std::to_string( i ) + "}";
+      }
+      request += "]";
+
+      fc::variant answer = get_answer( request );
+      BOOST_REQUIRE( answer.is_array() );
+      BOOST_REQUIRE_EQUAL( answer.get_array().size(), 100 );
+
+      for( int i = 0; i < 100; ++i )
+      {
+         const auto& response = answer.get_array()[i];
+         BOOST_REQUIRE_EQUAL( response[ "id" ].as_int64(), i );
+         BOOST_REQUIRE_EQUAL( response.get_object().contains( "result" ), i % 3 != 2 );
+         BOOST_REQUIRE_EQUAL( response.get_object().contains( "error" ), i % 3 == 2 );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Test batch larger than rpc-batch-max-size" );
+      request = "[";
+      for( int i = 0; i <= JSON_RPC_DEFAULT_BATCH_MAX_SIZE; ++i )
+         request += std::string( i ? "," : "" ) + "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.get_dynamic_global_properties\", \"id\":1}";
+      request += "]";
+      make_request( request, JSON_RPC_INVALID_REQUEST );
+
+      rpc_plugin->plugin_shutdown();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( response_cache )
+{
+   try
+   {
+      rpc_plugin->cache_api_method( "database_api.find_accounts", 1 );
+
+      std::string request = "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":{\"accounts\":[\"initminer\"]}, \"id\":1}";
+      std::string call_style = "{\"jsonrpc\":\"2.0\", \"method\":\"call\", \"params\":[\"database_api\", \"find_accounts\", {\"accounts\":[\"initminer\"]}], \"id\":2}";
+      std::string stats = "{\"jsonrpc\":\"2.0\", \"method\":\"jsonrpc.get_cache_stats\", \"id\":3}";
+
+      auto check_stats = [&]( uint64_t hits, uint64_t misses )
+      {
+         auto result = get_answer( stats )[ "result" ];
+         BOOST_REQUIRE_EQUAL( result[ "hits" ].as_uint64(), hits );
+         BOOST_REQUIRE_EQUAL( result[ "misses" ].as_uint64(), misses );
+      };
+
+      auto first = get_answer( request )[ "result" ];
+      check_stats( 0, 1 );
+
+      BOOST_TEST_MESSAGE( "--- Test the same call is served from the cache" );
+      BOOST_REQUIRE( fc::json::to_string( get_answer( call_style )[ "result" ] ) == fc::json::to_string( first ) );
+      check_stats( 1, 1 );
+
+      BOOST_TEST_MESSAGE( "--- Test responses expire with the next block" );
+      fund( "initminer", ASSET( "1.000 TESTS" ) );
+      generate_block();
+      auto second = get_answer( request )[ "result" ];
+      check_stats( 1, 2 );
+      BOOST_REQUIRE( fc::json::to_string( second ) != fc::json::to_string( first ) );
+
+      BOOST_TEST_MESSAGE( "--- Test different params are cached separately" );
+      request = "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":{\"accounts\":[\"initminer\", \"initminer1\"]}, \"id\":4}";
+      BOOST_REQUIRE_EQUAL( get_answer( request )[ "result" ][ "accounts" ].get_array().size(), 2 );
+      check_stats( 1, 3 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( binary_rpc )
+{
+   try
+   {
+      using steem::plugins::json_rpc::json_rpc_plugin;
+      using steem::plugins::json_rpc::binary_rpc_request;
+      using steem::plugins::json_rpc::binary_rpc_response;
+      namespace database_api = steem::plugins::database_api;
+
+      auto call_binary = [&]( const std::string& body )
+      {
+         auto out = rpc_plugin->call_binary( body );
+         return fc::raw::unpack_from_char_array< binary_rpc_response >( out.data(), out.size(), 0 );
+      };
+
+      auto call = [&]( uint32_t method, const std::vector< char >& args )
+      {
+         binary_rpc_request request;
+         request.method = method;
+         request.args = args;
+         auto packed = fc::raw::pack_to_vector( request );
+         return call_binary( std::string( packed.begin(), packed.end() ) );
+      };
+
+      BOOST_TEST_MESSAGE( "--- Test a binary call returns the packed result of the JSON call" );
+      database_api::find_accounts_args args;
+      args.accounts = { "initminer", "alice" };
+      auto response = call( json_rpc_plugin::binary_method_id( "database_api.find_accounts" ), fc::raw::pack_to_vector( args ) );
+      BOOST_REQUIRE_EQUAL( response.code, 0 );
+
+      auto result = fc::raw::unpack_from_vector< database_api::find_accounts_return >( response.result, 0 );
+      BOOST_REQUIRE_EQUAL( result.accounts.size(), 1 );
+      std::string request = "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":{\"accounts\":[\"initminer\", \"alice\"]}, \"id\":1}";
+      auto expected = get_answer( request )[ "result" ];
+      BOOST_REQUIRE( fc::json::to_string( fc::variant( result ) ) == fc::json::to_string( expected ) );
+
+      BOOST_TEST_MESSAGE( "--- Test unknown method ids" );
+      response = call( json_rpc_plugin::binary_method_id( "database_api.no_such_method" ), std::vector< char >() );
+      BOOST_REQUIRE_EQUAL( response.code, JSON_RPC_METHOD_NOT_FOUND );
+
+      BOOST_TEST_MESSAGE( "--- Test malformed requests and args" );
+      BOOST_REQUIRE_EQUAL( call_binary( "\x01" ).code, JSON_RPC_PARSE_ERROR );
+      response = call( json_rpc_plugin::binary_method_id( "database_api.find_accounts" ), std::vector< char >( 1, char( 0x80 ) ) );
+      BOOST_REQUIRE_EQUAL( response.code, JSON_RPC_ERROR_DURING_CALL );
+      BOOST_REQUIRE( response.message.size() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
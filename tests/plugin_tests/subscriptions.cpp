@@ -0,0 +1,214 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+
+#include <steem/plugins/webserver/subscription_hub.hpp>
+
+#include <fc/io/json.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+using namespace steem::plugins::webserver;
+
+namespace
+{
+   class test_subscriber : public subscriber
+   {
+      public:
+         test_subscriber() : subscriber( this ) {}
+
+         virtual size_t buffered_amount() override { return buffered; }
+
+         virtual void send( const ws_message::ptr& frame ) override
+         {
+            frames.push_back( frame );
+            notices.push_back( fc::json::from_string( frame->get_payload() )[ "params" ] );
+         }
+
+         virtual void drop( const std::string& reason ) override { dropped = true; }
+
+         virtual bool is_open() override { return !dropped; }
+
+         size_t                           buffered = 0;
+         bool                             dropped = false;
+         std::vector< ws_message::ptr >   frames;
+         fc::variants                     notices;
+   };
+
+   fc::variant request( const std::string& method, const fc::variant& params )
+   {
+      return fc::mutable_variant_object()( "jsonrpc", "2.0" )( "method", method )( "params", params )( "id", 1 );
+   }
+}
+
+BOOST_FIXTURE_TEST_SUITE( subscriptions, clean_database_fixture )
+
+BOOST_AUTO_TEST_CASE( subscription_streams )
+{
+   try
+   {
+      boost::asio::io_service ios;
+      subscription_hub hub( *db, ios, 1024 * 1024 );
+      hub.connect_signals( appbase::app().get_plugin< steem::plugins::chain::chain_plugin >() );
+
+      ACTORS( (alice)(bob)(sam) )
+      fund( "alice", ASSET( "100.000 TESTS" ) );
+      generate_block();
+
+      auto blocks = std::make_shared< test_subscriber >();
+      auto bob_transfers = std::make_shared< test_subscriber >();
+      auto rewards = std::make_shared< test_subscriber >();
+
+      BOOST_TEST_MESSAGE( "--- Subscribing" );
+      auto response = fc::json::from_string( hub.call( blocks, request( "subscription_api.subscribe", fc::mutable_variant_object( "stream", "blocks" ) ) ) );
+      BOOST_REQUIRE( !response.get_object().contains( "error" ) );
+      BOOST_REQUIRE( response[ "id" ].as_int64() == 1 );
+      hub.call( blocks, request( "subscription_api.subscribe", fc::mutable_variant_object( "stream", "irreversible_blocks" ) ) );
+
+      hub.subscribe( bob_transfers, subscribe_args{ "operations", { "bob" }, { "transfer" } } );
+      hub.subscribe( rewards, subscribe_args{ "operations", {}, { "producer_reward_operation" } } );
+      BOOST_REQUIRE( hub.subscriber_count() == 3 );
+
+      transfer( "alice", "bob", ASSET( "1.000 TESTS" ) );
+      transfer( "alice", "sam", ASSET( "1.000 TESTS" ) );
+      generate_block();
+      ios.run();
+      ios.reset();
+
+      BOOST_TEST_MESSAGE( "--- Checking notices" );
+      fc::variants head_notices;
+      for( const auto& n : blocks->notices )
+      {
+         if( n[ "stream" ].as_string() == "blocks" )
+            head_notices.push_back( n );
+      }
+      BOOST_REQUIRE( head_notices.size() == 1 );
+      BOOST_REQUIRE( head_notices[0][ "block_num" ].as< uint32_t >() == db->head_block_num() );
+      BOOST_REQUIRE( head_notices[0][ "block" ][ "transactions" ].get_array().size() == 2 );
+
+      BOOST_REQUIRE( bob_transfers->notices.size() == 1 );
+      auto op = bob_transfers->notices[0][ "operation" ];
+      BOOST_REQUIRE( op[ "block" ].as< uint32_t >() == db->head_block_num() );
+      BOOST_REQUIRE( op[ "op" ].as< operation >().get< transfer_operation >().to == "bob" );
+
+      BOOST_REQUIRE( rewards->notices.size() == 1 );
+      BOOST_REQUIRE( rewards->notices[0][ "operation" ][ "virtual_op" ].as< uint32_t >() > 0 );
+      BOOST_REQUIRE( rewards->notices[0][ "operation" ][ "op" ].as< operation >().which() == operation::tag< producer_reward_operation >::value );
+
+      BOOST_TEST_MESSAGE( "--- Irreversible blocks are sent once and in order" );
+      generate_blocks( 30 );
+      ios.run();
+      ios.reset();
+
+      uint32_t last_irreversible = 0;
+      for( const auto& n : blocks->notices )
+      {
+         if( n[ "stream" ].as_string() != "irreversible_blocks" )
+            continue;
+
+         uint32_t block_num = n[ "block_num" ].as< uint32_t >();
+         BOOST_REQUIRE( last_irreversible == 0 || block_num == last_irreversible + 1 );
+         BOOST_REQUIRE( n[ "block" ].as< signed_block >().id() == n[ "block_id" ].as< block_id_type >() );
+         last_irreversible = block_num;
+      }
+      BOOST_REQUIRE( last_irreversible > 0 );
+      BOOST_REQUIRE( last_irreversible <= db->get_dynamic_global_properties().last_irreversible_block_num );
+
+      BOOST_TEST_MESSAGE( "--- Notices are serialized once" );
+      BOOST_REQUIRE( rewards->frames.size() > 1 );
+      auto other = std::make_shared< test_subscriber >();
+      hub.subscribe( other, subscribe_args{ "operations", {}, { "producer_reward" } } );
+      size_t reward_count = rewards->frames.size();
+      generate_block();
+      ios.run();
+      ios.reset();
+      BOOST_REQUIRE( rewards->frames.size() == reward_count + 1 );
+      BOOST_REQUIRE( other->frames.size() == 1 );
+      BOOST_REQUIRE( rewards->frames.back() == other->frames.back() );
+
+      BOOST_TEST_MESSAGE( "--- Unsubscribing" );
+      hub.call( blocks, request( "subscription_api.unsubscribe", fc::mutable_variant_object( "stream", "blocks" ) ) );
+      hub.call( blocks, request( "subscription_api.unsubscribe", fc::mutable_variant_object( "stream", "irreversible_blocks" ) ) );
+      size_t block_count = blocks->notices.size();
+      generate_block();
+      ios.run();
+      ios.reset();
+      BOOST_REQUIRE( blocks->notices.size() == block_count );
+      BOOST_REQUIRE( hub.subscriber_count() == 3 );
+
+      hub.disconnect_signals();
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( subscription_slow_consumer )
+{
+   try
+   {
+      boost::asio::io_service ios;
+      subscription_hub hub( *db, ios, 1024 );
+      hub.connect_signals( appbase::app().get_plugin< steem::plugins::chain::chain_plugin >() );
+
+      auto fast = std::make_shared< test_subscriber >();
+      auto slow = std::make_shared< test_subscriber >();
+      slow->buffered = 4096;
+
+      hub.subscribe( fast, subscribe_args{ "blocks", {}, {} } );
+      hub.subscribe( slow, subscribe_args{ "blocks", {}, {} } );
+
+      generate_block();
+      ios.run();
+      ios.reset();
+
+      BOOST_REQUIRE( fast->notices.size() == 1 );
+      BOOST_REQUIRE( slow->notices.empty() );
+      BOOST_REQUIRE( slow->dropped );
+      BOOST_REQUIRE( hub.subscriber_count() == 1 );
+
+      hub.disconnect_signals();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( subscription_requests )
+{
+   try
+   {
+      boost::asio::io_service ios;
+      subscription_hub hub( *db, ios, 1024 );
+      auto s = std::make_shared< test_subscriber >();
+
+      fc::variant r;
+      BOOST_REQUIRE( !subscription_hub::is_subscription_request( "{\"jsonrpc\":\"2.0\",\"method\":\"database_api.get_config\",\"id\":1}", r ) );
+      BOOST_REQUIRE( !subscription_hub::is_subscription_request( "{\"method\":\"call\",\"params\":[\"subscription_api.x\"]}", r ) );
+      BOOST_REQUIRE( subscription_hub::is_subscription_request( "{\"jsonrpc\":\"2.0\",\"method\":\"subscription_api.subscribe\",\"id\":1}", r ) );
+
+      auto error_code = [&]( const fc::variant& req )
+      {
+         auto response = fc::json::from_string( hub.call( s, req ) );
+         return response.get_object().contains( "error" ) ? response[ "error" ][ "code" ].as_int64() : 0;
+      };
+
+      BOOST_REQUIRE( error_code( request( "subscription_api.subscribe", fc::mutable_variant_object( "stream", "votes" ) ) ) == JSON_RPC_ERROR_DURING_CALL );
+      BOOST_REQUIRE( error_code( request( "subscription_api.subscribe", fc::mutable_variant_object( "stream", "blocks" )( "accounts", fc::variants{ "alice" } ) ) ) == JSON_RPC_ERROR_DURING_CALL );
+      BOOST_REQUIRE( error_code( request( "subscription_api.subscribe", fc::mutable_variant_object( "stream", "operations" )( "operation_types", fc::variants{ "no_such" } ) ) ) == JSON_RPC_ERROR_DURING_CALL );
+      BOOST_REQUIRE( error_code( request( "subscription_api.list", fc::variant_object() ) ) == JSON_RPC_METHOD_NOT_FOUND );
+      BOOST_REQUIRE( hub.subscriber_count() == 0 );
+
+      BOOST_REQUIRE( error_code( request( "subscription_api.subscribe", fc::mutable_variant_object( "stream", "operations" )( "operation_types", fc::variants{ "vote", "comment_operation" } ) ) ) == 0 );
+      BOOST_REQUIRE( hub.subscriber_count() == 1 );
+
+      // A frame header for a payload needing the 16 bit length
+      auto frame = subscription_hub::make_frame( std::string( 200, 'x' ) );
+      BOOST_REQUIRE( frame->get_prepared() );
+      BOOST_REQUIRE( frame->get_header() == std::string( "\x81\x7e\x00\xc8", 4 ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
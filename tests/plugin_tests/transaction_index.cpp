@@ -0,0 +1,108 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/chain/account_object.hpp>
+#include <steem/protocol/steem_operations.hpp>
+
+#include <steem/plugins/transaction_index/transaction_index_plugin.hpp>
+#include <steem/plugins/transaction_index_api/transaction_index_api_plugin.hpp>
+#include <steem/plugins/transaction_index_api/transaction_index_api.hpp>
+
+#include <steem/utilities/tempdir.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace steem::chain;
+using namespace steem::protocol;
+
+BOOST_FIXTURE_TEST_SUITE( transaction_index, database_fixture );
+
+BOOST_AUTO_TEST_CASE( transaction_index_test )
+{
+   using namespace steem::plugins::transaction_index;
+
+   try
+   {
+      fc::temp_directory index_dir( steem::utilities::temp_directory_path() );
+      std::string index_path = index_dir.path().string();
+
+      appbase::app().register_plugin< transaction_index_plugin >();
+      appbase::app().register_plugin< steem::plugins::transaction_index_api::transaction_index_api_plugin >();
+      db_plugin = &appbase::app().register_plugin< steem::plugins::debug_node::debug_node_plugin >();
+      init_account_pub_key = init_account_priv_key.get_public_key();
+
+      int test_argc = 3;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0],
+                                  "--transaction-index-path",
+                                  index_path.c_str() };
+
+      db_plugin->logging = false;
+      appbase::app().initialize<
+         steem::plugins::transaction_index_api::transaction_index_api_plugin,
+         steem::plugins::debug_node::debug_node_plugin >( test_argc, (char**)test_argv );
+
+      db = &appbase::app().get_plugin< steem::plugins::chain::chain_plugin >().db();
+      BOOST_REQUIRE( db );
+
+      auto& index = appbase::app().get_plugin< transaction_index_plugin >();
+      auto& api = *appbase::app().get_plugin< steem::plugins::transaction_index_api::transaction_index_api_plugin >().api;
+
+      open_database();
+      index.plugin_startup();
+
+      generate_block();
+      db->set_hardfork( STEEM_NUM_HARDFORKS );
+      generate_block();
+
+      ACTORS( (alice)(bob) );
+      fund( "alice", ASSET( "1000.000 TESTS" ) );
+      generate_block();
+
+      BOOST_TEST_MESSAGE( "--- Transaction in a reversible block" );
+      signed_transaction tx;
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = ASSET( "5.000 TESTS" );
+      tx.operations.push_back( op );
+      tx.set_expiration( db->head_block_time() + STEEM_MAX_TIME_UNTIL_EXPIRATION );
+      sign( tx, alice_private_key );
+      db->push_transaction( tx, 0 );
+
+      BOOST_REQUIRE( !index.find_transaction( tx.id() ).valid() );
+      BOOST_REQUIRE( !api.find_transaction( { tx.id() } ).block_num.valid() );
+
+      generate_block();
+      uint32_t tx_block = db->head_block_num();
+
+      auto location = index.find_transaction( tx.id() );
+      BOOST_REQUIRE( location.valid() );
+      BOOST_REQUIRE( location->block_num == tx_block );
+      BOOST_REQUIRE( location->trx_in_block == 0 );
+
+      auto trx = api.get_transaction( { tx.id() } );
+      BOOST_REQUIRE( trx.transaction_id == tx.id() );
+      BOOST_REQUIRE( trx.block_num == tx_block );
+      BOOST_REQUIRE( trx.operations.size() == 1 );
+      BOOST_REQUIRE( trx.operations[0].get< transfer_operation >().to == "bob" );
+
+      BOOST_TEST_MESSAGE( "--- Transaction in an irreversible block" );
+      generate_blocks( STEEM_MAX_WITNESSES + 1 );
+      BOOST_REQUIRE( db->get_dynamic_global_properties().last_irreversible_block_num >= tx_block );
+      BOOST_REQUIRE( index.last_indexed_block() == db->get_dynamic_global_properties().last_irreversible_block_num );
+
+      trx = api.get_transaction( { tx.id() } );
+      BOOST_REQUIRE( trx.transaction_id == tx.id() );
+      BOOST_REQUIRE( trx.block_num == tx_block );
+      BOOST_REQUIRE( trx.transaction_num == 0 );
+
+      BOOST_TEST_MESSAGE( "--- Unknown transaction" );
+      transaction_id_type unknown;
+      BOOST_REQUIRE( !index.get_transaction( unknown ).valid() );
+      STEEM_REQUIRE_THROW( api.get_transaction( { unknown } ), fc::assert_exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
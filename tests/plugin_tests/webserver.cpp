@@ -0,0 +1,139 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <steem/plugins/json_rpc/json_rpc_plugin.hpp>
+#include <steem/plugins/webserver/webserver_plugin.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <fc/time.hpp>
+
+#include <chrono>
+#include <thread>
+
+using boost::asio::ip::tcp;
+
+namespace
+{
+   /// Finds a local port nothing listens on
+   uint16_t free_port()
+   {
+      boost::asio::io_service ios;
+      tcp::acceptor acceptor( ios, tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) );
+      return acceptor.local_endpoint().port();
+   }
+
+   /// Connects to the webserver, retrying while its IO threads start listening
+   void connect( tcp::socket& socket, uint16_t port )
+   {
+      tcp::endpoint endpoint( boost::asio::ip::address_v4::loopback(), port );
+      boost::system::error_code ec;
+
+      for( int i = 0; i < 50; ++i )
+      {
+         socket.connect( endpoint, ec );
+         if( !ec )
+            return;
+         socket.close();
+         std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+      }
+
+      BOOST_FAIL( "Could not connect to the webserver: " + ec.message() );
+   }
+
+   /// Reads one response and returns its header
+   std::string read_response( tcp::socket& socket, boost::asio::streambuf& buffer )
+   {
+      size_t header_size = boost::asio::read_until( socket, buffer, "\r\n\r\n" );
+      std::string header( boost::asio::buffers_begin( buffer.data() ), boost::asio::buffers_begin( buffer.data() ) + header_size );
+      buffer.consume( header_size );
+
+      size_t length_pos = header.find( "Content-Length: " );
+      BOOST_REQUIRE( length_pos != std::string::npos );
+      size_t length = boost::lexical_cast< size_t >( header.substr( length_pos + 16, header.find( "\r\n", length_pos ) - length_pos - 16 ) );
+
+      if( buffer.size() < length )
+         boost::asio::read( socket, buffer, boost::asio::transfer_exactly( length - buffer.size() ) );
+      buffer.consume( length );
+
+      return header;
+   }
+
+   /// Waits up to timeout for the server to close the connection, returns false when it stayed open
+   bool wait_for_close( tcp::socket& socket, boost::asio::io_service& ios, boost::posix_time::time_duration timeout )
+   {
+      bool closed = false;
+      bool timed_out = false;
+      char byte;
+
+      boost::asio::deadline_timer timer( ios, timeout );
+      timer.async_wait( [&]( const boost::system::error_code& ec )
+      {
+         if( !ec )
+         {
+            timed_out = true;
+            socket.cancel();
+         }
+      });
+      socket.async_read_some( boost::asio::buffer( &byte, 1 ), [&]( const boost::system::error_code& ec, size_t )
+      {
+         closed = !timed_out && ( ec == boost::asio::error::eof || ec == boost::asio::error::connection_reset );
+         timer.cancel();
+      });
+
+      ios.reset();
+      ios.run();
+      return closed;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE( webserver )
+
+BOOST_AUTO_TEST_CASE( keep_alive_timeout )
+{
+   try
+   {
+      uint16_t port = free_port();
+      std::string endpoint = "127.0.0.1:" + std::to_string( port );
+
+      appbase::app().register_plugin< steem::plugins::json_rpc::json_rpc_plugin >();
+      appbase::app().register_plugin< steem::plugins::webserver::webserver_plugin >();
+
+      int test_argc = 9;
+      const char* test_argv[] = { boost::unit_test::framework::master_test_suite().argv[0],
+                                  "--webserver-http-endpoint", endpoint.c_str(),
+                                  "--webserver-http-keep-alive-timeout", "1",
+                                  "--webserver-io-threads", "1",
+                                  "--webserver-thread-pool-size", "1" };
+
+      appbase::app().initialize< steem::plugins::webserver::webserver_plugin >( test_argc, (char**)test_argv );
+      appbase::app().startup();
+
+      boost::asio::io_service ios;
+      tcp::socket socket( ios );
+      connect( socket, port );
+
+      BOOST_TEST_MESSAGE( "--- One request on a keep-alive connection" );
+      std::string body = "{\"jsonrpc\":\"2.0\",\"method\":\"jsonrpc.get_methods\",\"id\":1}";
+      std::string request = "POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + std::to_string( body.size() ) + "\r\n\r\n" + body;
+      boost::asio::write( socket, boost::asio::buffer( request ) );
+
+      boost::asio::streambuf buffer;
+      std::string header = read_response( socket, buffer );
+      BOOST_REQUIRE( header.find( "HTTP/1.1 200" ) == 0 );
+      BOOST_REQUIRE( header.find( "Connection: keep-alive" ) != std::string::npos );
+
+      BOOST_TEST_MESSAGE( "--- Closed by the server once idle past the timeout" );
+      auto start = fc::time_point::now();
+      BOOST_REQUIRE( wait_for_close( socket, ios, boost::posix_time::seconds( 5 ) ) );
+      BOOST_REQUIRE( fc::time_point::now() - start >= fc::milliseconds( 900 ) );
+
+      appbase::app().shutdown();
+      appbase::reset();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
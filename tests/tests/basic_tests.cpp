@@ -28,6 +28,7 @@
 #include <steem/protocol/protocol.hpp>
 
 #include <steem/protocol/steem_operations.hpp>
+#include <steem/protocol/exceptions.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/hex.hpp>
@@ -128,6 +129,64 @@ BOOST_AUTO_TEST_CASE( valid_name_test )
    BOOST_CHECK( !is_valid_account_name( "none.of.these.labels.has.more.than-63.chars--but.still.not.valid" ) );
 }
 
+BOOST_AUTO_TEST_CASE( signature_key_cache_recovery )
+{
+   try
+   {
+      auto alice_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "alice" ) ) );
+      auto bob_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "bob" ) ) );
+
+      signed_transaction trx;
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( 1, STEEM_SYMBOL );
+      trx.operations.push_back( op );
+      trx.set_expiration( fc::time_point_sec( 1000 ) );
+      trx.sign( alice_key, db->get_chain_id(), fc::ecc::bip_0062 );
+      trx.sign( bob_key, db->get_chain_id(), fc::ecc::bip_0062 );
+
+      steem::chain::signature_key_cache cache( 2 );
+      flat_set< public_key_type > keys;
+
+      BOOST_TEST_MESSAGE( "--- Cache misses before recovery" );
+      BOOST_REQUIRE( !cache.find( trx.id(), trx, fc::ecc::bip_0062, keys ) );
+
+      BOOST_TEST_MESSAGE( "--- Recovered keys match get_signature_keys" );
+      BOOST_REQUIRE( cache.recover( trx, db->get_chain_id() ) );
+      BOOST_REQUIRE( cache.find( trx.id(), trx, fc::ecc::bip_0062, keys ) );
+      BOOST_REQUIRE( keys == trx.get_signature_keys( db->get_chain_id(), fc::ecc::bip_0062 ) );
+
+      BOOST_TEST_MESSAGE( "--- Changed signatures miss" );
+      signed_transaction stripped = trx;
+      stripped.signatures.pop_back();
+      BOOST_REQUIRE( !cache.find( stripped.id(), stripped, fc::ecc::bip_0062, keys ) );
+
+      BOOST_TEST_MESSAGE( "--- Duplicate signatures are not cached" );
+      signed_transaction dup = stripped;
+      dup.set_expiration( fc::time_point_sec( 2000 ) );
+      dup.signatures.clear();
+      dup.sign( alice_key, db->get_chain_id(), fc::ecc::bip_0062 );
+      dup.signatures.push_back( dup.signatures.back() );
+      BOOST_REQUIRE( !cache.recover( dup, db->get_chain_id() ) );
+      BOOST_REQUIRE( !cache.find( dup.id(), dup, fc::ecc::bip_0062, keys ) );
+      STEEM_REQUIRE_THROW( dup.get_signature_keys( db->get_chain_id(), fc::ecc::bip_0062 ), tx_duplicate_sig );
+
+      BOOST_TEST_MESSAGE( "--- Oldest entries are evicted" );
+      for( uint32_t i = 0; i < 2; ++i )
+      {
+         signed_transaction other = stripped;
+         other.set_expiration( fc::time_point_sec( 3000 + i ) );
+         other.signatures.clear();
+         other.sign( bob_key, db->get_chain_id(), fc::ecc::bip_0062 );
+         BOOST_REQUIRE( cache.recover( other, db->get_chain_id() ) );
+      }
+      BOOST_REQUIRE_EQUAL( cache.size(), 2u );
+      BOOST_REQUIRE( !cache.find( trx.id(), trx, fc::ecc::bip_0062, keys ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( merkle_root )
 {
    signed_block block;
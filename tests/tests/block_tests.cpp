@@ -29,6 +29,8 @@
 #include <steem/chain/database.hpp>
 #include <steem/chain/steem_objects.hpp>
 #include <steem/chain/history_object.hpp>
+#include <steem/chain/state_snapshot.hpp>
+#include <steem/chain/block_log_scanner.hpp>
 
 #include <steem/plugins/account_history/account_history_plugin.hpp>
 #include <steem/plugins/witness/block_producer.hpp>
@@ -37,6 +39,9 @@
 
 #include <fc/crypto/digest.hpp>
 
+#include <atomic>
+#include <thread>
+
 #include "../db_fixture/database_fixture.hpp"
 
 using namespace steem;
@@ -129,6 +134,462 @@ BOOST_AUTO_TEST_CASE( generate_empty_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( replay_pipeline_blocks )
+{
+   try {
+      fc::temp_directory data_dir( steem::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "init_key" ) ) );
+      uint32_t last_irreversible = 0;
+
+      {
+         database db;
+         witness::block_producer bp( db );
+         db._log_hardforks = false;
+         open_test_database( db, data_dir.path() );
+
+         while( last_irreversible < 100 )
+         {
+            bp.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+            last_irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+         }
+         db.close();
+      }
+
+      BOOST_TEST_MESSAGE( "Decoding the block log through a ring smaller than the log" );
+      {
+         block_log log;
+         log.open( data_dir.path() / "block_log" );
+         uint32_t head = log.head()->block_num();
+         BOOST_REQUIRE( head >= last_irreversible );
+         log.flush();
+
+         steem::chain::replay_pipeline pipeline( data_dir.path() / "block_log", 1, head, 3, 8 );
+         for( uint32_t n = 1; n <= head; ++n )
+         {
+            BOOST_REQUIRE( !pipeline.done() );
+            const auto& next = pipeline.next();
+            auto expected = log.read_block_by_num( n );
+            BOOST_REQUIRE( expected.valid() );
+            BOOST_REQUIRE_EQUAL( next.block.block_num(), n );
+            BOOST_REQUIRE( next.ids.block_id == expected->id() );
+            BOOST_REQUIRE_EQUAL( next.ids.transaction_ids.size(), expected->transactions.size() );
+            BOOST_REQUIRE( fc::raw::pack_to_vector( next.block ) == fc::raw::pack_to_vector( *expected ) );
+         }
+         BOOST_REQUIRE( pipeline.done() );
+
+         auto stats = pipeline.get_stats();
+         BOOST_REQUIRE_EQUAL( stats.decode.blocks, head );
+         BOOST_REQUIRE_EQUAL( stats.read.blocks, head );
+      }
+
+      BOOST_TEST_MESSAGE( "Reindexing through the replay pipeline" );
+      {
+         database db;
+         db._log_hardforks = false;
+         database::open_args args;
+         args.data_dir = data_dir.path();
+         args.shared_mem_dir = data_dir.path();
+         args.initial_supply = INITIAL_TEST_SUPPLY;
+         args.shared_file_size = TEST_SHARED_MEM_SIZE;
+         args.replay_decode_threads = 2;
+         uint32_t last_block = db.reindex( args );
+
+         auto head = db.fetch_block_by_number( last_block );
+         BOOST_REQUIRE( head.valid() );
+         BOOST_REQUIRE_EQUAL( db.head_block_num(), last_block );
+         BOOST_REQUIRE( db.head_block_id() == head->id() );
+         db.close();
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_log_concurrent_reads )
+{
+   try {
+      fc::temp_directory data_dir( steem::utilities::temp_directory_path() );
+      block_log log;
+      log.open( data_dir.path() / "block_log" );
+      BOOST_REQUIRE_EQUAL( log.head_block_num(), 0 );
+      BOOST_REQUIRE( log.get_block_pos( 1 ) == block_log::npos );
+
+      const uint32_t num_blocks = 2000;
+      std::vector< signed_block > blocks( num_blocks );
+      for( uint32_t i = 0; i < num_blocks; ++i )
+      {
+         blocks[i].witness = "initminer";
+         blocks[i].timestamp = fc::time_point_sec( STEEM_GENESIS_TIME ) + 3 * i;
+         if( i > 0 )
+            blocks[i].previous = blocks[i-1].id();
+      }
+
+      BOOST_TEST_MESSAGE( "Reading blocks while they are appended" );
+      std::atomic< bool > done( false );
+      std::atomic< uint32_t > failures( 0 );
+      std::vector< std::thread > readers;
+      for( uint32_t t = 0; t < 4; ++t )
+      {
+         readers.emplace_back( [&]()
+         {
+            while( !done )
+            {
+               uint32_t head = log.head_block_num();
+               for( uint32_t n = head; n > 0 && n + 10 > head; --n )
+               {
+                  auto b = log.read_block_by_num( n );
+                  if( !b || b->id() != blocks[ n - 1 ].id() )
+                     ++failures;
+               }
+            }
+         });
+      }
+
+      for( const auto& b : blocks )
+         log.append( b );
+      done = true;
+      for( auto& t : readers )
+         t.join();
+
+      BOOST_REQUIRE_EQUAL( failures.load(), 0 );
+      BOOST_REQUIRE_EQUAL( log.head_block_num(), num_blocks );
+      BOOST_REQUIRE( log.read_head().id() == blocks.back().id() );
+
+      BOOST_TEST_MESSAGE( "Rebuilding a missing index on open" );
+      log.close();
+      fc::remove_all( data_dir.path() / "block_log.index" );
+      log.open( data_dir.path() / "block_log" );
+      BOOST_REQUIRE_EQUAL( log.head_block_num(), num_blocks );
+
+      auto itr = log.read_block( 0 );
+      for( uint32_t n = 1; n <= num_blocks; ++n )
+      {
+         BOOST_REQUIRE( itr.first.id() == blocks[ n - 1 ].id() );
+         BOOST_REQUIRE_EQUAL( log.get_block_pos( n ), n == 1 ? 0 : log.get_block_pos( n - 1 ) + fc::raw::pack_size( blocks[ n - 2 ] ) + 8 );
+         if( n < num_blocks )
+            itr = log.read_block( itr.second );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_log_compressed_format )
+{
+   try {
+      for( auto codec : { zstd_compression, lz4_compression } )
+      {
+         if( !block_log_format::is_supported( codec ) )
+         {
+            BOOST_TEST_MESSAGE( "Skipping unsupported codec " + block_log_format::to_string( codec ) );
+            continue;
+         }
+
+         BOOST_TEST_MESSAGE( "Writing a " + block_log_format::to_string( codec ) + " compressed block log" );
+         fc::temp_directory data_dir( steem::utilities::temp_directory_path() );
+         const uint32_t num_blocks = 500;
+         std::vector< signed_block > blocks( num_blocks );
+         for( uint32_t i = 0; i < num_blocks; ++i )
+         {
+            blocks[i].witness = "initminer";
+            blocks[i].timestamp = fc::time_point_sec( STEEM_GENESIS_TIME ) + 3 * i;
+            if( i > 0 )
+               blocks[i].previous = blocks[i-1].id();
+
+            // Mix small empty blocks, which may be stored raw, with compressible ones
+            for( uint32_t t = 0; t < ( i % 2 ) * 20; ++t )
+            {
+               signed_transaction trx;
+               transfer_operation op;
+               op.from = "alice";
+               op.to = "bob";
+               op.amount = ASSET( "1.000 TESTS" );
+               op.memo = "a memo that repeats in every transaction of the block";
+               trx.operations.push_back( op );
+               blocks[i].transactions.push_back( trx );
+            }
+         }
+
+         block_log log;
+         log.set_compression( codec );
+         log.open( data_dir.path() / "block_log" );
+         BOOST_REQUIRE_EQUAL( log.get_format_version(), 2 );
+         BOOST_REQUIRE( !log.head() );
+         for( const auto& b : blocks )
+            log.append( b );
+
+         uint64_t raw_size = 0;
+         for( const auto& b : blocks )
+            raw_size += fc::raw::pack_size( b ) + 8;
+         BOOST_REQUIRE_LT( fc::file_size( data_dir.path() / "block_log" ), raw_size );
+
+         for( uint32_t n = 1; n <= num_blocks; ++n )
+            BOOST_REQUIRE( log.read_block_by_num( n )->id() == blocks[ n - 1 ].id() );
+
+         BOOST_TEST_MESSAGE( "Reopening without compression and rebuilding the index" );
+         log.close();
+         fc::remove_all( data_dir.path() / "block_log.index" );
+         block_log reopened;
+         reopened.open( data_dir.path() / "block_log" );
+         BOOST_REQUIRE_EQUAL( reopened.get_format_version(), 2 );
+         BOOST_REQUIRE( reopened.read_head().id() == blocks.back().id() );
+
+         auto itr = reopened.read_block( reopened.get_block_pos( 1 ) );
+         for( uint32_t n = 1; n < num_blocks; ++n )
+         {
+            BOOST_REQUIRE( itr.first.id() == blocks[ n - 1 ].id() );
+            BOOST_REQUIRE_EQUAL( itr.second, reopened.get_block_pos( n + 1 ) );
+            itr = reopened.read_block( itr.second );
+         }
+         reopened.flush();
+
+         BOOST_TEST_MESSAGE( "Decoding the compressed log through the replay pipeline" );
+         steem::chain::replay_pipeline pipeline( data_dir.path() / "block_log", 1, num_blocks, 2, 16 );
+         for( uint32_t n = 1; n <= num_blocks; ++n )
+            BOOST_REQUIRE( pipeline.next().ids.block_id == blocks[ n - 1 ].id() );
+         BOOST_REQUIRE( pipeline.done() );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_log_scanner_chunks )
+{
+   try {
+      fc::temp_directory data_dir( steem::utilities::temp_directory_path() );
+      const uint32_t num_blocks = 1000;
+      std::vector< signed_block > blocks( num_blocks );
+      uint64_t num_transactions = 0;
+      for( uint32_t i = 0; i < num_blocks; ++i )
+      {
+         blocks[i].witness = "initminer";
+         blocks[i].timestamp = fc::time_point_sec( STEEM_GENESIS_TIME ) + 3 * i;
+         if( i > 0 )
+            blocks[i].previous = blocks[i-1].id();
+
+         for( uint32_t t = 0; t < i % 4; ++t )
+         {
+            signed_transaction trx;
+            transfer_operation op;
+            op.from = "alice";
+            op.to = "bob";
+            op.amount = asset( i * 4 + t + 1, STEEM_SYMBOL );
+            trx.operations.push_back( op );
+            trx.operations.push_back( op );
+            blocks[i].transactions.push_back( trx );
+            ++num_transactions;
+         }
+      }
+
+      {
+         block_log log;
+         log.open( data_dir.path() / "block_log" );
+         for( const auto& b : blocks )
+            log.append( b );
+         log.close();
+      }
+
+      block_log_scanner scanner( data_dir.path() / "block_log" );
+      BOOST_REQUIRE_EQUAL( scanner.head_block_num(), num_blocks );
+      BOOST_REQUIRE_EQUAL( scanner.get_format_version(), 1 );
+
+      BOOST_TEST_MESSAGE( "Scanning unordered with a chunk size not dividing the range" );
+      {
+         block_log_scanner::scan_options options;
+         options.first_block = 2;
+         options.threads = 4;
+         options.chunk_blocks = 37;
+
+         std::vector< std::atomic< uint32_t > > seen( num_blocks + 1 );
+         std::atomic< uint64_t > ops( 0 );
+         std::atomic< uint32_t > bad_ids( 0 );
+
+         block_log_scan_visitor visitor;
+         visitor.on_block = [&]( uint32_t thread, uint32_t block_num, const signed_block& b )
+         {
+            if( thread < 4 && b.id() == blocks[ block_num - 1 ].id() )
+               ++seen[ block_num ];
+         };
+         visitor.on_transaction = [&]( uint32_t thread, uint32_t block_num, uint32_t trx_in_block, const transaction_id_type& id, const signed_transaction& trx )
+         {
+            if( id != blocks[ block_num - 1 ].transactions[ trx_in_block ].id() )
+               ++bad_ids;
+         };
+         visitor.on_operation = [&]( uint32_t thread, uint32_t block_num, uint32_t trx_in_block, uint32_t op_in_trx, const operation& op )
+         {
+            ++ops;
+         };
+
+         auto stats = scanner.scan( options, visitor );
+         BOOST_REQUIRE_EQUAL( stats.blocks, num_blocks - 1 );
+         BOOST_REQUIRE_EQUAL( stats.transactions, num_transactions );
+         BOOST_REQUIRE_EQUAL( stats.operations, 2 * num_transactions );
+         BOOST_REQUIRE_EQUAL( stats.chunks, ( num_blocks - 2 ) / 37 + 1 );
+         BOOST_REQUIRE_EQUAL( ops.load(), 2 * num_transactions );
+         BOOST_REQUIRE_EQUAL( bad_ids.load(), 0 );
+         BOOST_REQUIRE_EQUAL( seen[1].load(), 0 );
+         for( uint32_t n = 2; n <= num_blocks; ++n )
+            BOOST_REQUIRE_EQUAL( seen[n].load(), 1 );
+      }
+
+      BOOST_TEST_MESSAGE( "Scanning in order with few pending chunks" );
+      {
+         block_log_scanner::scan_options options;
+         options.last_block = num_blocks - 1;
+         options.threads = 3;
+         options.chunk_blocks = 10;
+         options.delivery = block_log_scanner::ordered;
+         options.max_pending_chunks = 2;
+
+         uint32_t next = 1;
+         block_log_scan_visitor visitor;
+         visitor.on_block = [&]( uint32_t thread, uint32_t block_num, const signed_block& b )
+         {
+            BOOST_REQUIRE_EQUAL( thread, 0 );
+            BOOST_REQUIRE_EQUAL( block_num, next++ );
+            BOOST_REQUIRE( b.id() == blocks[ block_num - 1 ].id() );
+         };
+
+         auto stats = scanner.scan( options, visitor );
+         BOOST_REQUIRE_EQUAL( next, num_blocks );
+         BOOST_REQUIRE_EQUAL( stats.blocks, num_blocks - 1 );
+      }
+
+      BOOST_TEST_MESSAGE( "Visitor exceptions stop the scan" );
+      {
+         block_log_scanner::scan_options options;
+         options.chunk_blocks = 50;
+
+         for( auto delivery : { block_log_scanner::unordered, block_log_scanner::ordered } )
+         {
+            options.delivery = delivery;
+            block_log_scan_visitor visitor;
+            visitor.on_block = [&]( uint32_t thread, uint32_t block_num, const signed_block& b )
+            {
+               FC_ASSERT( block_num != 500 );
+            };
+            STEEM_REQUIRE_THROW( scanner.scan( options, visitor ), fc::assert_exception );
+         }
+
+         options.first_block = num_blocks + 1;
+         STEEM_REQUIRE_THROW( scanner.scan( options, block_log_scan_visitor() ), fc::assert_exception );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( state_snapshot_round_trip )
+{
+   try {
+      fc::temp_directory data_dir( steem::utilities::temp_directory_path() );
+      fc::temp_directory snapshot_dir( steem::utilities::temp_directory_path() );
+      fc::temp_directory replay_dir( steem::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "init_key" ) ) );
+      auto snapshot_file = snapshot_dir.path() / "state.snapshot";
+
+      {
+         database db;
+         witness::block_producer bp( db );
+         db._log_hardforks = false;
+         open_test_database( db, data_dir.path() );
+
+         while( db.get_dynamic_global_properties().last_irreversible_block_num < 60 )
+            bp.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+         db.close();
+      }
+
+      auto replay_args = [&]( const fc::path& shared_mem_dir )
+      {
+         database::open_args args;
+         args.data_dir = data_dir.path();
+         args.shared_mem_dir = shared_mem_dir;
+         args.initial_supply = INITIAL_TEST_SUPPLY;
+         args.shared_file_size = TEST_SHARED_MEM_SIZE;
+         return args;
+      };
+
+      BOOST_TEST_MESSAGE( "Dumping a snapshot part way through the block log" );
+      {
+         database db;
+         db._log_hardforks = false;
+         auto args = replay_args( snapshot_dir.path() );
+         args.stop_replay_at = 30;
+         BOOST_REQUIRE_EQUAL( db.reindex( args ), 30u );
+
+         auto manifest = db.with_read_lock( [&]()
+         {
+            return dump_state_snapshot( db, snapshot_file, 3 );
+         });
+         BOOST_REQUIRE_EQUAL( manifest.head_block_num, 30u );
+         BOOST_REQUIRE( manifest.head_block_id == db.head_block_id() );
+         BOOST_REQUIRE_EQUAL( manifest.sections.size(), db.get_abstract_index_cntr().size() );
+         db.close();
+      }
+
+      snapshot_manifest expected;
+      {
+         database db;
+         db._log_hardforks = false;
+         db.reindex( replay_args( replay_dir.path() ) );
+         expected = db.with_read_lock( [&]()
+         {
+            return dump_state_snapshot( db, replay_dir.path() / "expected.snapshot", 1 );
+         });
+         db.close();
+      }
+
+      BOOST_TEST_MESSAGE( "Loading the snapshot and replaying the rest of the block log" );
+      {
+         database db;
+         db._log_hardforks = false;
+         auto args = replay_args( snapshot_dir.path() );
+         args.snapshot_file = snapshot_file;
+         args.snapshot_threads = 3;
+         db.reindex( args );
+
+         auto actual = db.with_read_lock( [&]()
+         {
+            return dump_state_snapshot( db, snapshot_dir.path() / "actual.snapshot", 2 );
+         });
+         BOOST_REQUIRE_EQUAL( actual.head_block_num, expected.head_block_num );
+         BOOST_REQUIRE( actual.head_block_id == expected.head_block_id );
+         BOOST_REQUIRE_EQUAL( actual.sections.size(), expected.sections.size() );
+         for( size_t i = 0; i < actual.sections.size(); ++i )
+         {
+            BOOST_TEST_MESSAGE( "Comparing " + actual.sections[i].name );
+            BOOST_REQUIRE_EQUAL( actual.sections[i].name, expected.sections[i].name );
+            BOOST_REQUIRE_EQUAL( actual.sections[i].object_count, expected.sections[i].object_count );
+            BOOST_REQUIRE( actual.sections[i].checksum == expected.sections[i].checksum );
+         }
+         db.close();
+      }
+
+      BOOST_TEST_MESSAGE( "Rejecting a corrupt snapshot" );
+      {
+         std::fstream f( snapshot_file.generic_string(), std::ios::in | std::ios::out | std::ios::binary );
+         f.seekp( 64 );
+         char c = 0x5a;
+         f.write( &c, 1 );
+         f.close();
+
+         database db;
+         db._log_hardforks = false;
+         auto args = replay_args( snapshot_dir.path() );
+         args.snapshot_file = snapshot_file;
+         STEEM_REQUIRE_THROW( db.reindex( args ), fc::exception );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( undo_block )
 {
    try {
@@ -29,9 +29,12 @@
 
 #include <steem/plugins/condenser_api/condenser_api_legacy_asset.hpp>
 #include <steem/plugins/condenser_api/condenser_api_legacy_objects.hpp>
+#include <steem/plugins/database_api/database_api_args.hpp>
+#include <steem/plugins/account_history_api/account_history_api.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/elliptic.hpp>
+#include <fc/io/json_writer.hpp>
 #include <fc/reflect/variant.hpp>
 
 #include "../db_fixture/database_fixture.hpp"
@@ -733,6 +736,59 @@ BOOST_AUTO_TEST_CASE( unpack_clear_test )
    FC_LOG_AND_RETHROW();
 }
 
+template< typename T >
+void check_json_writer( const T& v )
+{
+   BOOST_REQUIRE_EQUAL( fc::to_json_string( v ), fc::json::to_string( fc::variant( v ) ) );
+   BOOST_REQUIRE_EQUAL( fc::to_json_string( v, 0, fc::json::legacy_generator ), fc::json::to_string( fc::variant( v ), fc::json::legacy_generator ) );
+}
+
+BOOST_AUTO_TEST_CASE( json_writer_test )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "Testing primitives and containers" );
+      check_json_writer( uint64_t( 1 ) << 40 );
+      check_json_writer( -( int64_t( 1 ) << 40 ) );
+      check_json_writer( std::string( "quote \" backslash \\ newline \n control \x01 utf8 \xc3\xa9" ) );
+      check_json_writer( std::vector< fc::optional< uint32_t > >{ 1, fc::optional< uint32_t >(), 3 } );
+      check_json_writer( std::map< std::string, int32_t >{ { "a", 1 }, { "b", -2 } } );
+      check_json_writer( std::map< uint32_t, std::string >{ { 1, "a" }, { 2, "b" } } );
+      check_json_writer( std::vector< char >{ 'a', 'b', 0 } );
+
+      BOOST_TEST_MESSAGE( "Testing database_api objects" );
+      ACTORS( (alice) )
+      generate_block();
+
+      steem::plugins::database_api::api_account_object account( db->get_account( "alice" ), *db );
+      account.json_metadata = "{\"profile\":\"\\u00e9\\n\"}";
+      check_json_writer( account );
+
+      steem::plugins::database_api::list_witnesses_return witnesses;
+      witnesses.witnesses.emplace_back( db->get_witness( STEEM_INIT_MINER_NAME ) );
+      check_json_writer( witnesses );
+
+      BOOST_TEST_MESSAGE( "Testing account_history_api objects" );
+      transfer_operation transfer;
+      transfer.from = "alice";
+      transfer.to = STEEM_INIT_MINER_NAME;
+      transfer.amount = ASSET( "1.000 TESTS" );
+      transfer.memo = "memo \"with\" escapes\t";
+
+      steem::plugins::account_history::api_operation_object op;
+      op.block = 10;
+      op.timestamp = db->head_block_time();
+      op.op = transfer;
+
+      steem::plugins::account_history::get_account_history_return history;
+      history.history[ 0 ] = op;
+      history.history[ 1 ] = op;
+      check_json_writer( history );
+      check_json_writer( steem::plugins::account_history::get_account_history_return() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( unpack_recursion_test )
 {
    try
@@ -378,6 +378,47 @@ BOOST_AUTO_TEST_CASE( undo_different_indexes )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( undo_log_allocations )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "--- Testing: undo_log_allocations" );
+
+      undo_db udb( *db );
+      undo_scenario< account_object > ao( *db );
+      const auto& idx = db->get_index< account_index >();
+
+      std::vector< const account_object* > accounts;
+      for( int i = 0; i < 200; ++i )
+         accounts.push_back( &ao.create( [&]( account_object& obj ){ obj.name = "name" + std::to_string( i ); } ) );
+
+      ao.remember_old_values< account_index >();
+      auto before = idx.get_undo_statistics();
+      udb.undo_begin();
+
+      BOOST_TEST_MESSAGE( "--- 200 objects modified twice, 10 of them removed, 10 created" );
+      for( const auto* a : accounts )
+      {
+         ao.modify( *a, [&]( account_object& obj ){ obj.proxy = "proxy00"; } );
+         ao.modify( *a, [&]( account_object& obj ){ obj.can_vote = false; } );
+      }
+      for( int i = 0; i < 10; ++i )
+      {
+         ao.remove( *accounts[ i * 20 ] );
+         ao.create( [&]( account_object& obj ){ obj.name = "new" + std::to_string( i ); } );
+      }
+
+      auto during = idx.get_undo_statistics();
+      udb.undo_end();
+      BOOST_REQUIRE( ao.check< account_index >() );
+
+      // The map and set based undo state allocated a node per record and created id, 210 here
+      BOOST_REQUIRE_EQUAL( during.records - before.records, 200u );
+      BOOST_REQUIRE_LT( during.allocations - before.allocations, 16u );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( undo_generate_blocks )
 {
    try